@@ -23,6 +23,7 @@ using tr1::bind;
 using tr1::bad_function_call;
 using tr1::ref;
 using tr1::cref;
+using tr1::hash;
 namespace placeholders = tr1::placeholders;
 }
 
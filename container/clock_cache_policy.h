@@ -0,0 +1,307 @@
+// Copyright (c) 2026, The Toft Authors.
+// All rights reserved.
+//
+// Allocation free CLOCK cache policy for LruCache.
+
+#ifndef TOFT_CONTAINER_CLOCK_CACHE_POLICY_H_
+#define TOFT_CONTAINER_CLOCK_CACHE_POLICY_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <utility>
+#include <vector>
+
+#include "toft/base/functional.h"
+#include "toft/base/uncopyable.h"
+
+#include "thirdparty/glog/logging.h"
+
+namespace toft {
+
+// Cache policy for LruCache which approximates LRU with the CLOCK algorithm.
+//
+// All entries live in a flat slot array allocated in constructor, and are
+// located by an open addressing (linear probing) hash index of slot numbers,
+// so Get/Put/Remove never allocate memory except what is done by copying
+// KeyType and ValueType themselves. Both types must be default constructible
+// and assignable.
+//
+// The number of slots is max_entries. If it's 0, capacity is taken as the
+// number of entries, which must be no more than kMaxImplicitEntries, so
+// max_entries is required when the capacity is in bytes, for example, a
+// 256M block cache of 4K blocks needs max_entries about 64K, not 256M slots.
+//
+// Usage:
+//   LruCache<int, int, Mutex, ClockCachePolicy<int, int> > cache(1024);
+template<typename KeyType,
+         typename ValueType,
+         typename HashType = std::hash<KeyType> >
+class ClockCachePolicy {
+    TOFT_DECLARE_UNCOPYABLE(ClockCachePolicy);
+
+public:
+    typedef std::vector<std::pair<KeyType, ValueType> > EvictedList;
+
+    static const size_t kMaxImplicitEntries = 1024 * 1024;
+
+    ClockCachePolicy(size_t capacity, size_t max_entries);
+
+    bool Get(const KeyType& key, ValueType* value);
+    size_t Put(const KeyType& key, const ValueType& value, size_t charge,
+               EvictedList* evicted);
+    bool Remove(const KeyType& key);
+
+    bool HasKey(const KeyType& key) const {
+        return FindIndex(key, Hash(key)) != kNotFound;
+    }
+
+    void Clear();
+
+    size_t Size() const {
+        return size_;
+    }
+
+    size_t Charge() const {
+        return charge_;
+    }
+
+    size_t Capacity() const {
+        return capacity_;
+    }
+
+private:
+    static const uint32_t kEmpty = 0xFFFFFFFFU;
+    static const size_t kNotFound = static_cast<size_t>(-1);
+
+    struct Slot {
+        Slot() : hash(0), charge(0), used(false), referenced(false) {}
+        KeyType key;
+        ValueType value;
+        size_t hash;
+        size_t charge;
+        bool used;
+        bool referenced;
+    };
+
+    size_t Hash(const KeyType& key) const {
+        // Scramble the hash value, since std::hash of integers is identity.
+        return static_cast<size_t>(
+            static_cast<uint64_t>(hasher_(key)) * 0x9E3779B97F4A7C15ULL >> 16);
+    }
+
+    // Return position in index_ of the key, or kNotFound.
+    size_t FindIndex(const KeyType& key, size_t hash) const;
+
+    // Remove the entry at position pos of index_, keep the probe sequences
+    // of other entries unbroken by shifting them backward.
+    void EraseIndex(size_t pos);
+
+    // Release the slot and put it into free list.
+    void ReleaseSlot(uint32_t slot_index);
+
+    // Choose a victim slot by the CLOCK algorithm and release it.
+    void Evict(EvictedList* evicted);
+
+private:
+    HashType hasher_;
+    std::vector<Slot> slots_;
+    std::vector<uint32_t> index_;  // Size is power of 2.
+    size_t index_mask_;
+    std::vector<uint32_t> free_slots_;
+    size_t capacity_;
+    size_t size_;
+    size_t charge_;
+    size_t hand_;
+};
+
+template<typename KeyType, typename ValueType, typename HashType>
+const size_t ClockCachePolicy<KeyType, ValueType, HashType>::kMaxImplicitEntries;
+
+template<typename KeyType, typename ValueType, typename HashType>
+const uint32_t ClockCachePolicy<KeyType, ValueType, HashType>::kEmpty;
+
+template<typename KeyType, typename ValueType, typename HashType>
+const size_t ClockCachePolicy<KeyType, ValueType, HashType>::kNotFound;
+
+template<typename KeyType, typename ValueType, typename HashType>
+ClockCachePolicy<KeyType, ValueType, HashType>::ClockCachePolicy(size_t capacity,
+                                                                 size_t max_entries)
+    : index_mask_(0), capacity_(capacity), size_(0), charge_(0), hand_(0) {
+    if (max_entries == 0) {
+        CHECK_LE(capacity, kMaxImplicitEntries)
+            << "max_entries must be set for a large capacity, such as in bytes";
+    }
+    size_t num_slots = max_entries > 0 ? max_entries : capacity;
+    CHECK_LT(num_slots, static_cast<size_t>(kEmpty)) << "too many entries";
+    slots_.resize(num_slots);
+    // Keep load factor of the index no more than 0.5.
+    size_t index_size = 1;
+    while (index_size < num_slots * 2)
+        index_size <<= 1;
+    index_.assign(index_size, kEmpty);
+    index_mask_ = index_size - 1;
+    free_slots_.reserve(num_slots);
+    for (size_t i = num_slots; i > 0; --i)
+        free_slots_.push_back(static_cast<uint32_t>(i - 1));
+}
+
+template<typename KeyType, typename ValueType, typename HashType>
+size_t ClockCachePolicy<KeyType, ValueType, HashType>::FindIndex(
+        const KeyType& key, size_t hash) const {
+    for (size_t pos = hash & index_mask_; ; pos = (pos + 1) & index_mask_) {
+        uint32_t slot = index_[pos];
+        if (slot == kEmpty)
+            return kNotFound;
+        if (slots_[slot].hash == hash && slots_[slot].key == key)
+            return pos;
+    }
+}
+
+template<typename KeyType, typename ValueType, typename HashType>
+bool ClockCachePolicy<KeyType, ValueType, HashType>::Get(const KeyType& key,
+                                                         ValueType* value) {
+    size_t pos = FindIndex(key, Hash(key));
+    if (pos == kNotFound)
+        return false;
+    Slot& slot = slots_[index_[pos]];
+    slot.referenced = true;
+    *value = slot.value;
+    return true;
+}
+
+template<typename KeyType, typename ValueType, typename HashType>
+size_t ClockCachePolicy<KeyType, ValueType, HashType>::Put(const KeyType& key,
+                                                           const ValueType& value,
+                                                           size_t charge,
+                                                           EvictedList* evicted) {
+    if (slots_.empty())
+        return 0;
+
+    size_t hash = Hash(key);
+    size_t pos = FindIndex(key, hash);
+    if (pos != kNotFound) {
+        Slot& slot = slots_[index_[pos]];
+        if (slot.charge == charge) {
+            slot.value = value;
+            slot.referenced = true;
+            return 0;
+        }
+        uint32_t slot_index = index_[pos];
+        EraseIndex(pos);
+        ReleaseSlot(slot_index);
+    }
+
+    size_t num_evicted = 0;
+    while ((charge_ + charge > capacity_ || free_slots_.empty()) && size_ > 0) {
+        Evict(evicted);
+        ++num_evicted;
+    }
+
+    uint32_t slot_index = free_slots_.back();
+    free_slots_.pop_back();
+    Slot& slot = slots_[slot_index];
+    slot.key = key;
+    slot.value = value;
+    slot.hash = hash;
+    slot.charge = charge;
+    slot.used = true;
+    // New entry is not referenced, so that an one-shot entry can be evicted
+    // before the ones which are hit again.
+    slot.referenced = false;
+    ++size_;
+    charge_ += charge;
+
+    for (pos = hash & index_mask_; index_[pos] != kEmpty; pos = (pos + 1) & index_mask_) {}
+    index_[pos] = slot_index;
+    return num_evicted;
+}
+
+template<typename KeyType, typename ValueType, typename HashType>
+bool ClockCachePolicy<KeyType, ValueType, HashType>::Remove(const KeyType& key) {
+    size_t pos = FindIndex(key, Hash(key));
+    if (pos == kNotFound)
+        return false;
+    uint32_t slot_index = index_[pos];
+    EraseIndex(pos);
+    ReleaseSlot(slot_index);
+    return true;
+}
+
+template<typename KeyType, typename ValueType, typename HashType>
+void ClockCachePolicy<KeyType, ValueType, HashType>::ReleaseSlot(uint32_t slot_index) {
+    Slot& slot = slots_[slot_index];
+    slot.used = false;
+    slot.referenced = false;
+    slot.value = ValueType();  // Release resources held by the value.
+    free_slots_.push_back(slot_index);
+    --size_;
+    charge_ -= slot.charge;
+}
+
+template<typename KeyType, typename ValueType, typename HashType>
+void ClockCachePolicy<KeyType, ValueType, HashType>::Clear() {
+    free_slots_.clear();
+    for (size_t i = slots_.size(); i > 0; --i) {
+        Slot& slot = slots_[i - 1];
+        if (slot.used) {
+            slot.used = false;
+            slot.referenced = false;
+            slot.value = ValueType();
+        }
+        free_slots_.push_back(static_cast<uint32_t>(i - 1));
+    }
+    index_.assign(index_.size(), kEmpty);
+    size_ = 0;
+    charge_ = 0;
+    hand_ = 0;
+}
+
+template<typename KeyType, typename ValueType, typename HashType>
+void ClockCachePolicy<KeyType, ValueType, HashType>::EraseIndex(size_t pos) {
+    for (;;) {
+        index_[pos] = kEmpty;
+        size_t next = pos;
+        for (;;) {
+            next = (next + 1) & index_mask_;
+            if (index_[next] == kEmpty)
+                return;
+            size_t home = slots_[index_[next]].hash & index_mask_;
+            // The entry can not be moved if its home position is cyclically
+            // in (pos, next].
+            bool in_range = pos <= next ? (pos < home && home <= next)
+                                        : (pos < home || home <= next);
+            if (!in_range)
+                break;
+        }
+        index_[pos] = index_[next];
+        pos = next;
+    }
+}
+
+template<typename KeyType, typename ValueType, typename HashType>
+void ClockCachePolicy<KeyType, ValueType, HashType>::Evict(EvictedList* evicted) {
+    DCHECK_GT(size_, 0U);
+    // At least one slot is used, so at most two rounds are needed.
+    for (;;) {
+        Slot& slot = slots_[hand_];
+        uint32_t slot_index = static_cast<uint32_t>(hand_);
+        if (++hand_ == slots_.size())
+            hand_ = 0;
+        if (!slot.used)
+            continue;
+        if (slot.referenced) {
+            slot.referenced = false;
+            continue;
+        }
+        if (evicted != NULL)
+            evicted->push_back(std::make_pair(slot.key, slot.value));
+        EraseIndex(FindIndex(slot.key, slot.hash));
+        ReleaseSlot(slot_index);
+        return;
+    }
+}
+
+}  // namespace toft
+
+#endif  // TOFT_CONTAINER_CLOCK_CACHE_POLICY_H_
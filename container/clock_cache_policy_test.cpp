@@ -0,0 +1,205 @@
+// Copyright (c) 2026, The Toft Authors.
+// All rights reserved.
+//
+// Tests of ClockCachePolicy.
+
+#include "toft/container/clock_cache_policy.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "toft/base/random.h"
+#include "toft/container/lru_cache.h"
+
+#include "thirdparty/gtest/gtest.h"
+
+namespace toft {
+
+typedef LruCache<int, int, Mutex, ClockCachePolicy<int, int> > ClockCache;
+
+TEST(ClockCachePolicyTest, Normal) {
+    ClockCache cache(5);
+    cache.Put(2, 2);
+    cache.Put(1, 1);
+    cache.Put(3, 3);
+    EXPECT_EQ(1, cache.GetOrDefault(1));
+    EXPECT_EQ(3, cache.GetOrDefault(3));
+    EXPECT_EQ(2, cache.GetOrDefault(2));
+    EXPECT_FALSE(cache.HasKey(4));
+}
+
+TEST(ClockCachePolicyTest, SameKey) {
+    ClockCache cache(4);
+    cache.Put(1, 1);
+    cache.Put(1, 2);
+    cache.Put(3, 3);
+    EXPECT_EQ(2U, cache.Size());
+    EXPECT_EQ(2, cache.GetOrDefault(1));
+    EXPECT_EQ(3, cache.GetOrDefault(3));
+}
+
+TEST(ClockCachePolicyTest, Size) {
+    ClockCache cache(2);
+    EXPECT_EQ(0U, cache.Size());
+    EXPECT_EQ(2U, cache.Capacity());
+    EXPECT_TRUE(cache.IsEmpty());
+    EXPECT_FALSE(cache.IsFull());
+
+    cache.Put(1, 1);
+    cache.Put(2, 2);
+    EXPECT_EQ(2U, cache.Size());
+    EXPECT_TRUE(cache.IsFull());
+
+    cache.Put(3, 3);
+    EXPECT_EQ(2U, cache.Size());
+    EXPECT_TRUE(cache.IsFull());
+    EXPECT_TRUE(cache.HasKey(3));
+
+    cache.Clear();
+    EXPECT_TRUE(cache.IsEmpty());
+    cache.Put(4, 4);
+    EXPECT_EQ(4, cache.GetOrDefault(4));
+}
+
+TEST(ClockCachePolicyTest, Remove) {
+    ClockCache cache(2);
+    cache.Put(1, 1);
+    EXPECT_TRUE(cache.Remove(1));
+    EXPECT_EQ(0U, cache.Size());
+    EXPECT_FALSE(cache.Remove(2));
+    EXPECT_FALSE(cache.HasKey(1));
+}
+
+TEST(ClockCachePolicyTest, ZeroCapacity) {
+    ClockCache cache(0);
+    cache.Put(1, 1);
+    EXPECT_EQ(0U, cache.Size());
+    EXPECT_FALSE(cache.HasKey(1));
+}
+
+TEST(ClockCachePolicyTest, ReferencedSurvive) {
+    ClockCache cache(3);
+    cache.Put(1, 1);
+    cache.Put(2, 2);
+    cache.Put(3, 3);
+    // Give key 1 and 3 a second chance.
+    EXPECT_EQ(1, cache.GetOrDefault(1));
+    EXPECT_EQ(3, cache.GetOrDefault(3));
+    cache.Put(4, 4);
+    EXPECT_TRUE(cache.HasKey(1));
+    EXPECT_FALSE(cache.HasKey(2));
+    EXPECT_TRUE(cache.HasKey(3));
+    EXPECT_TRUE(cache.HasKey(4));
+}
+
+TEST(ClockCachePolicyTest, StringKey) {
+    LruCache<std::string, std::string, Mutex,
+             ClockCachePolicy<std::string, std::string> > cache(2);
+    cache.Put("a", "1");
+    cache.Put("b", "2");
+    EXPECT_EQ("1", cache.GetOrDefault("a"));
+    cache.Put("c", "3");
+    EXPECT_TRUE(cache.HasKey("a"));
+    EXPECT_FALSE(cache.HasKey("b"));
+    EXPECT_EQ("3", cache.GetOrDefault("c"));
+}
+
+TEST(ClockCachePolicyTest, Charge) {
+    // 10 bytes and at most 4 entries.
+    ClockCache cache(10, 4);
+    cache.Put(1, 1, 4);
+    cache.Put(2, 2, 4);
+    EXPECT_EQ(8U, cache.Charge());
+    EXPECT_EQ(1, cache.GetOrDefault(1));
+
+    cache.Put(3, 3, 4);
+    EXPECT_EQ(8U, cache.Charge());
+    EXPECT_TRUE(cache.HasKey(1));
+    EXPECT_FALSE(cache.HasKey(2));
+    EXPECT_TRUE(cache.HasKey(3));
+
+    for (int i = 10; i < 20; ++i)
+        cache.Put(i, i, 1);
+    EXPECT_EQ(4U, cache.Size());
+    EXPECT_EQ(4U, cache.Charge());
+
+    cache.Put(100, 100, 20);
+    EXPECT_EQ(1U, cache.Size());
+    EXPECT_EQ(20U, cache.Charge());
+
+    CacheStats stats;
+    cache.GetStats(&stats);
+    EXPECT_EQ(1U, stats.hits);
+    // Key 2, then key 1, 3 and 10~15, then 16~19.
+    EXPECT_EQ(1U + 8 + 4, stats.evictions);
+}
+
+TEST(ClockCachePolicyTest, ByteCapacity) {
+    // 256M bytes of 4K blocks.
+    ClockCache cache(256 << 20, 64 << 10);
+    for (int i = 0; i < 100000; ++i)
+        cache.Put(i, i, 4096);
+    EXPECT_EQ(64U << 10, cache.Size());
+    EXPECT_EQ(256U << 20, cache.Charge());
+
+    // Too many slots without max_entries.
+    EXPECT_DEATH(ClockCache(256 << 20), "max_entries");
+}
+
+static void OnEvicted(std::vector<int>* evicted, const int& key, const int& value) {
+    EXPECT_EQ(key, value);
+    evicted->push_back(key);
+}
+
+TEST(ClockCachePolicyTest, EvictionCallback) {
+    std::vector<int> evicted;
+    ClockCache cache(3);
+    cache.SetEvictionCallback(
+        std::bind(OnEvicted, &evicted, std::placeholders::_1, std::placeholders::_2));
+    for (int i = 0; i < 10; ++i)
+        cache.Put(i, i);
+    ASSERT_EQ(7U, evicted.size());
+    for (int i = 0; i < 7; ++i)
+        EXPECT_EQ(i, evicted[i]);
+}
+
+// Compare with a std::map after random operations, the cache must always
+// return the latest value of the keys it holds.
+TEST(ClockCachePolicyTest, RandomOperations) {
+    const int kCapacity = 100;
+    ClockCache cache(kCapacity);
+    std::map<int, int> latest;
+    Random random(12345);
+    for (int i = 0; i < 100000; ++i) {
+        int key = random.Uniform(300);
+        switch (random.Uniform(3)) {
+        case 0:
+            cache.Put(key, i);
+            latest[key] = i;
+            break;
+        case 1:
+            cache.Remove(key);
+            latest.erase(key);
+            break;
+        default: {
+                int value;
+                if (cache.Get(key, &value)) {
+                    ASSERT_TRUE(latest.count(key)) << key;
+                    ASSERT_EQ(latest[key], value) << key;
+                }
+            }
+            break;
+        }
+        ASSERT_LE(cache.Size(), static_cast<size_t>(kCapacity));
+    }
+
+    size_t count = 0;
+    for (int key = 0; key < 300; ++key) {
+        if (cache.HasKey(key))
+            ++count;
+    }
+    EXPECT_EQ(cache.Size(), count);
+}
+
+}  // namespace toft
@@ -11,7 +11,9 @@
 #include <list>
 #include <map>
 #include <utility>
+#include <vector>
 
+#include "toft/base/functional.h"
 #include "toft/base/uncopyable.h"
 #include "toft/system/threading/mutex.h"
 
@@ -19,13 +21,187 @@
 
 namespace toft {
 
-//  It is not thread safe.
-template<typename KeyType, typename ValueType, typename LockType = Mutex>
+// Counters of a cache, see LruCache::GetStats.
+struct CacheStats {
+    CacheStats() : hits(0), misses(0), evictions(0), size(0), charge(0), capacity(0) {}
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;   // Entries evicted for capacity.
+    size_t size;          // Number of entries.
+    size_t charge;        // Total charge of entries.
+    size_t capacity;      // Max total charge.
+};
+
+// The default cache policy of LruCache, exact LRU implemented by a std::map
+// index and a std::list ordered by recency.
+//
+// A cache policy is the not thread safe storage engine of LruCache, it must
+// provide the following members:
+//   typedef std::vector<std::pair<KeyType, ValueType> > EvictedList;
+//   Policy(size_t capacity, size_t max_entries);
+//   bool Get(const KeyType& key, ValueType* value);  // update recency
+//   // Evict entries to make room, evicted entries are appended to evicted
+//   // if it's not NULL, return the number of evicted entries.
+//   size_t Put(const KeyType& key, const ValueType& value, size_t charge,
+//              EvictedList* evicted);
+//   bool Remove(const KeyType& key);
+//   bool HasKey(const KeyType& key) const;
+//   void Clear();
+//   size_t Size() const;      // number of entries
+//   size_t Charge() const;    // total charge of entries
+//   size_t Capacity() const;  // max total charge
+//
+// The capacity is the limit of total charge, and max_entries is the limit
+// of entry number, 0 means the same as capacity, which doesn't matter if
+// every entry is charged at least 1.
+//
+// The just inserted entry is never evicted by its own Put, even if its
+// charge exceeds the capacity.
+//
+// See container/clock_cache_policy.h for an allocation free alternative.
+template<typename KeyType, typename ValueType>
+class LruListPolicy {
+    TOFT_DECLARE_UNCOPYABLE(LruListPolicy);
+
+public:
+    typedef std::vector<std::pair<KeyType, ValueType> > EvictedList;
+
+    LruListPolicy(size_t capacity, size_t max_entries)
+        : capacity_(capacity),
+          max_entries_(max_entries > 0 ? max_entries : capacity),
+          charge_(0) {}
+
+    bool Get(const KeyType &key, ValueType* value);
+    size_t Put(const KeyType &key, const ValueType& value, size_t charge,
+               EvictedList* evicted);
+    bool Remove(const KeyType &key);
+
+    bool HasKey(const KeyType& key) const {
+        return index_.find(key) != index_.end();
+    }
+
+    void Clear() {
+        value_list_.clear();
+        index_.clear();
+        charge_ = 0;
+    }
+
+    size_t Size() const {
+        return index_.size();
+    }
+
+    size_t Charge() const {
+        return charge_;
+    }
+
+    size_t Capacity() const {
+        return capacity_;
+    }
+
+private:
+    struct Entry {
+        Entry(const KeyType& k, const ValueType& v, size_t c) : key(k), value(v), charge(c) {}
+        KeyType key;
+        ValueType value;
+        size_t charge;
+    };
+    typedef std::list<Entry> List;
+    typedef std::map<KeyType, typename List::iterator> Map;
+
+    void Erase(typename Map::iterator iter);
+
+    List value_list_;
+    Map index_;
+    size_t capacity_;
+    size_t max_entries_;
+    size_t charge_;
+};
+
+template<typename KeyType, typename ValueType>
+bool LruListPolicy<KeyType, ValueType>::Get(const KeyType &key, ValueType* value) {
+    typename Map::iterator iter = index_.find(key);
+    if (iter != index_.end()) {
+        value_list_.splice(value_list_.begin(), value_list_, iter->second);
+
+        // Update index.
+        iter->second = value_list_.begin();
+        *value = iter->second->value;
+        return true;
+    }
+    return false;
+}
+
+template<typename KeyType, typename ValueType>
+size_t LruListPolicy<KeyType, ValueType>::Put(const KeyType &key,
+                                              const ValueType& value,
+                                              size_t charge,
+                                              EvictedList* evicted) {
+    {
+        // Remove if exists
+        typename Map::iterator iter = index_.find(key);
+        if (iter != index_.end()) {
+            // The inserted value is the same with the one to be deleted.
+            if (iter->second->value == value && iter->second->charge == charge)
+                return 0;
+            Erase(iter);
+        }
+    }
+
+    // Insert to list
+    value_list_.push_front(Entry(key, value, charge));
+    charge_ += charge;
+
+    // Update index
+    index_[key] = value_list_.begin();
+
+    // Check overflow
+    size_t num_evicted = 0;
+    while ((charge_ > capacity_ || index_.size() > max_entries_) && index_.size() > 1) {
+        typename List::iterator iter = value_list_.end();
+        --iter;
+        if (evicted != NULL)
+            evicted->push_back(std::make_pair(iter->key, iter->value));
+        Erase(index_.find(iter->key));
+        ++num_evicted;
+    }
+    return num_evicted;
+}
+
+template<typename KeyType, typename ValueType>
+bool LruListPolicy<KeyType, ValueType>::Remove(const KeyType &key) {
+    typename Map::iterator iter = index_.find(key);
+    if (iter == index_.end())
+        return false;
+    Erase(iter);
+    return true;
+}
+
+template<typename KeyType, typename ValueType>
+void LruListPolicy<KeyType, ValueType>::Erase(typename Map::iterator iter) {
+    charge_ -= iter->second->charge;
+    value_list_.erase(iter->second);
+    index_.erase(iter);
+}
+
+// Thread safe cache, all operations are serialized by LockType, the storage
+// and eviction are delegated to PolicyType.
+//
+// Every entry has a charge, 1 by default, and entries are evicted when the
+// total charge exceeds the capacity. For example, a cache of data blocks
+// can be limited in bytes by using block size as charge.
+template<typename KeyType,
+         typename ValueType,
+         typename LockType = Mutex,
+         typename PolicyType = LruListPolicy<KeyType, ValueType> >
 class LruCache {
     TOFT_DECLARE_UNCOPYABLE(LruCache);
 
 public:
-    explicit LruCache(size_t capacity);
+    // Called with entries evicted for capacity, out of the cache lock.
+    typedef std::function<void (const KeyType&, const ValueType&)> EvictionCallback;
+
+    // See LruListPolicy for the meaning of capacity and max_entries.
+    explicit LruCache(size_t capacity, size_t max_entries = 0);
 
     ~LruCache();
 
@@ -39,81 +215,99 @@ public:
 
     // Saves value in cache.
     // If the key already exists, the new value will replace the old one.
-    void Put(const KeyType &key, const ValueType& value);
+    void Put(const KeyType &key, const ValueType& value) {
+        Put(key, value, 1);
+    }
+
+    // Saves value with the specified charge in cache.
+    void Put(const KeyType &key, const ValueType& value, size_t charge);
 
     // Remove by key
     bool Remove(const KeyType &key) {
         typename LockType::Locker locker(&m_mutex);
-        return InternalRemove(key);
+        return policy_.Remove(key);
     }
 
     bool HasKey(const KeyType& key) const {
         typename LockType::Locker locker(&m_mutex);
-        return index_.find(key) != index_.end();
+        return policy_.HasKey(key);
     }
 
     // Clear all values
     void Clear();
 
+    // Should be set before the cache is used.
+    void SetEvictionCallback(const EvictionCallback& callback) {
+        typename LockType::Locker locker(&m_mutex);
+        eviction_callback_ = callback;
+    }
+
     size_t Size() const {
         typename LockType::Locker locker(&m_mutex);
-        return value_list_.size();
+        return policy_.Size();
+    }
+
+    // Total charge of all entries
+    size_t Charge() const {
+        typename LockType::Locker locker(&m_mutex);
+        return policy_.Charge();
     }
 
     size_t Capacity() const {
         typename LockType::Locker locker(&m_mutex);
-        return capacity_;
+        return policy_.Capacity();
     }
 
     bool IsEmpty() const {
         typename LockType::Locker locker(&m_mutex);
-        return value_list_.empty();
+        return policy_.Size() == 0;
     }
 
     bool IsFull() const {
         typename LockType::Locker locker(&m_mutex);
-        return index_.size() == capacity_;
+        return policy_.Charge() >= policy_.Capacity();
     }
 
-private:
-    bool InternalRemove(const KeyType &key);
+    void GetStats(CacheStats* stats) const;
+    void ResetStats();
 
 private:
-    typedef std::list<std::pair<KeyType, ValueType> > List;
-    typedef std::map<KeyType, typename List::iterator> Map;
     mutable LockType m_mutex;
-    List value_list_;
-    Map index_;
-    size_t capacity_;
+    PolicyType policy_;
+    EvictionCallback eviction_callback_;
+    uint64_t hits_;
+    uint64_t misses_;
+    uint64_t evictions_;
 };
 
-template<typename KeyType, typename ValueType, typename LockType>
-LruCache<KeyType, ValueType, LockType>::LruCache(size_t capacity)
-                : capacity_(capacity) {
+template<typename KeyType, typename ValueType, typename LockType, typename PolicyType>
+LruCache<KeyType, ValueType, LockType, PolicyType>::LruCache(size_t capacity,
+                                                             size_t max_entries)
+                : policy_(capacity, max_entries),
+                  hits_(0),
+                  misses_(0),
+                  evictions_(0) {
 }
 
-template<typename KeyType, typename ValueType, typename LockType>
-LruCache<KeyType, ValueType, LockType>::~LruCache() {
+template<typename KeyType, typename ValueType, typename LockType, typename PolicyType>
+LruCache<KeyType, ValueType, LockType, PolicyType>::~LruCache() {
     Clear();
 }
 
-template<typename KeyType, typename ValueType, typename LockType>
-bool LruCache<KeyType, ValueType, LockType>::Get(const KeyType &key, ValueType* value) {
+template<typename KeyType, typename ValueType, typename LockType, typename PolicyType>
+bool LruCache<KeyType, ValueType, LockType, PolicyType>::Get(const KeyType &key,
+                                                             ValueType* value) {
     typename LockType::Locker locker(&m_mutex);
-    typename Map::iterator iter = index_.find(key);
-    if (iter != index_.end()) {
-        value_list_.splice(value_list_.begin(), value_list_, iter->second);
-
-        // Update index.
-        iter->second = value_list_.begin();
-        *value = iter->second->second;
+    if (policy_.Get(key, value)) {
+        ++hits_;
         return true;
     }
+    ++misses_;
     return false;
 }
 
-template<typename KeyType, typename ValueType, typename LockType>
-ValueType LruCache<KeyType, ValueType, LockType>::GetOrDefault(
+template<typename KeyType, typename ValueType, typename LockType, typename PolicyType>
+ValueType LruCache<KeyType, ValueType, LockType, PolicyType>::GetOrDefault(
         const KeyType &key,
         const ValueType& default_value) {
     ValueType value;
@@ -122,51 +316,49 @@ ValueType LruCache<KeyType, ValueType, LockType>::GetOrDefault(
     return default_value;
 }
 
-template<typename KeyType, typename ValueType, typename LockType>
-void LruCache<KeyType, ValueType, LockType>::Put(const KeyType &key,
-                                                 const ValueType& value) {
-    typename LockType::Locker locker(&m_mutex);
+template<typename KeyType, typename ValueType, typename LockType, typename PolicyType>
+void LruCache<KeyType, ValueType, LockType, PolicyType>::Put(const KeyType &key,
+                                                             const ValueType& value,
+                                                             size_t charge) {
+    typename PolicyType::EvictedList evicted;
+    EvictionCallback callback;
     {
-        // Remove if exists
-        typename Map::iterator iter = index_.find(key);
-        if (iter != index_.end()) {
-            // The inserted value is the same with the one to be deleted.
-            if (iter->second->second == value)
-                return;
-            InternalRemove(key);
-        }
+        typename LockType::Locker locker(&m_mutex);
+        bool has_callback = static_cast<bool>(eviction_callback_);
+        evictions_ += policy_.Put(key, value, charge, has_callback ? &evicted : NULL);
+        if (evicted.empty())
+            return;
+        callback = eviction_callback_;
     }
 
-    // Insert to list
-    value_list_.push_front(std::make_pair(key, value));
-
-    // Update index
-    typename List::iterator iter = value_list_.begin();
-    index_[key] = iter;
+    // Out of lock, the callback may access the cache.
+    for (size_t i = 0; i < evicted.size(); ++i)
+        callback(evicted[i].first, evicted[i].second);
+}
 
-    // Check overflow
-    if (index_.size() > capacity_) {
-        iter = value_list_.end();
-        --iter;
-        InternalRemove(iter->first);
-    }
+template<typename KeyType, typename ValueType, typename LockType, typename PolicyType>
+void LruCache<KeyType, ValueType, LockType, PolicyType>::Clear() {
+    typename LockType::Locker locker(&m_mutex);
+    policy_.Clear();
 }
 
-template<typename KeyType, typename ValueType, typename LockType>
-bool LruCache<KeyType, ValueType, LockType>::InternalRemove(const KeyType &key) {
-    typename Map::iterator iter = index_.find(key);
-    if (iter == index_.end())
-        return false;
-    value_list_.erase(iter->second);
-    index_.erase(iter);
-    return true;
+template<typename KeyType, typename ValueType, typename LockType, typename PolicyType>
+void LruCache<KeyType, ValueType, LockType, PolicyType>::GetStats(CacheStats* stats) const {
+    typename LockType::Locker locker(&m_mutex);
+    stats->hits = hits_;
+    stats->misses = misses_;
+    stats->evictions = evictions_;
+    stats->size = policy_.Size();
+    stats->charge = policy_.Charge();
+    stats->capacity = policy_.Capacity();
 }
 
-template<typename KeyType, typename ValueType, typename LockType>
-void LruCache<KeyType, ValueType, LockType>::Clear() {
+template<typename KeyType, typename ValueType, typename LockType, typename PolicyType>
+void LruCache<KeyType, ValueType, LockType, PolicyType>::ResetStats() {
     typename LockType::Locker locker(&m_mutex);
-    value_list_.clear();
-    index_.clear();
+    hits_ = 0;
+    misses_ = 0;
+    evictions_ = 0;
 }
 
 }  // namespace toft
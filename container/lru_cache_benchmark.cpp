@@ -0,0 +1,143 @@
+// Copyright (c) 2026, The Toft Authors.
+// All rights reserved.
+//
+// Get and Put of LruCache, ShardedLruCache and ClockCachePolicy from many threads.
+
+#include "toft/container/clock_cache_policy.h"
+#include "toft/container/lru_cache.h"
+#include "toft/container/sharded_lru_cache.h"
+
+#include "thirdparty/benchmark/benchmark.h"
+
+namespace {
+
+const int kCapacity = 1 << 16;
+// Twice of capacity, so that about half of the Gets miss.
+const int kKeySpace = kCapacity * 2;
+
+toft::LruCache<int, int> g_lru_cache(kCapacity);
+toft::ShardedLruCache<int, int> g_sharded_lru_cache(kCapacity, 6);
+toft::LruCache<int, int, toft::Mutex, toft::ClockCachePolicy<int, int> >
+    g_clock_cache(kCapacity);
+toft::ShardedLruCache<int, int, toft::Mutex, std::hash<int>,
+                      toft::ClockCachePolicy<int, int> >
+    g_sharded_clock_cache(kCapacity, 6);
+
+// Each thread walks the key space with a different odd stride, to spread
+// the accesses over the whole cache.
+inline int NextKey(int key, int thread_index) {
+    return (key + 2 * thread_index + 7919) % kKeySpace;
+}
+
+// Fill the cache with half of the key space, the benchmark loop of all
+// threads starts after thread 0 finishes this.
+template <typename CacheType>
+void Prefill(benchmark::State& state, CacheType* cache) {
+    if (state.thread_index() == 0 && cache->Size() == 0) {
+        for (int i = 0; i < kKeySpace; i += 2)
+            cache->Put(i, i);
+    }
+}
+
+}  // namespace
+
+template <typename CacheType>
+static void CacheGet(benchmark::State& state, CacheType* cache) {
+    Prefill(state, cache);
+    int key = state.thread_index() * 997;
+    int value;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(cache->Get(key, &value));
+        key = NextKey(key, state.thread_index());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+template <typename CacheType>
+static void CachePut(benchmark::State& state, CacheType* cache) {
+    int key = state.thread_index() * 997;
+    for (auto _ : state) {
+        cache->Put(key, key);
+        key = NextKey(key, state.thread_index());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// 90% Get and 10% Put, which is the typical pattern of a block cache.
+template <typename CacheType>
+static void CacheMixed(benchmark::State& state, CacheType* cache) {
+    Prefill(state, cache);
+    int key = state.thread_index() * 997;
+    int value;
+    int n = 0;
+    for (auto _ : state) {
+        if (++n % 10 == 0) {
+            cache->Put(key, key);
+        } else {
+            benchmark::DoNotOptimize(cache->Get(key, &value));
+        }
+        key = NextKey(key, state.thread_index());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+static void LruCacheGet(benchmark::State& state) {
+    CacheGet(state, &g_lru_cache);
+}
+
+static void LruCachePut(benchmark::State& state) {
+    CachePut(state, &g_lru_cache);
+}
+
+static void LruCacheMixed(benchmark::State& state) {
+    CacheMixed(state, &g_lru_cache);
+}
+
+static void ShardedLruCacheGet(benchmark::State& state) {
+    CacheGet(state, &g_sharded_lru_cache);
+}
+
+static void ShardedLruCachePut(benchmark::State& state) {
+    CachePut(state, &g_sharded_lru_cache);
+}
+
+static void ShardedLruCacheMixed(benchmark::State& state) {
+    CacheMixed(state, &g_sharded_lru_cache);
+}
+
+static void ClockCacheGet(benchmark::State& state) {
+    CacheGet(state, &g_clock_cache);
+}
+
+static void ClockCachePut(benchmark::State& state) {
+    CachePut(state, &g_clock_cache);
+}
+
+static void ClockCacheMixed(benchmark::State& state) {
+    CacheMixed(state, &g_clock_cache);
+}
+
+static void ShardedClockCacheGet(benchmark::State& state) {
+    CacheGet(state, &g_sharded_clock_cache);
+}
+
+static void ShardedClockCachePut(benchmark::State& state) {
+    CachePut(state, &g_sharded_clock_cache);
+}
+
+static void ShardedClockCacheMixed(benchmark::State& state) {
+    CacheMixed(state, &g_sharded_clock_cache);
+}
+
+BENCHMARK(LruCacheGet)->ThreadRange(1, 32)->UseRealTime();
+BENCHMARK(LruCachePut)->ThreadRange(1, 32)->UseRealTime();
+BENCHMARK(LruCacheMixed)->ThreadRange(1, 32)->UseRealTime();
+BENCHMARK(ShardedLruCacheGet)->ThreadRange(1, 32)->UseRealTime();
+BENCHMARK(ShardedLruCachePut)->ThreadRange(1, 32)->UseRealTime();
+BENCHMARK(ShardedLruCacheMixed)->ThreadRange(1, 32)->UseRealTime();
+BENCHMARK(ClockCacheGet)->ThreadRange(1, 32)->UseRealTime();
+BENCHMARK(ClockCachePut)->ThreadRange(1, 32)->UseRealTime();
+BENCHMARK(ClockCacheMixed)->ThreadRange(1, 32)->UseRealTime();
+BENCHMARK(ShardedClockCacheGet)->ThreadRange(1, 32)->UseRealTime();
+BENCHMARK(ShardedClockCachePut)->ThreadRange(1, 32)->UseRealTime();
+BENCHMARK(ShardedClockCacheMixed)->ThreadRange(1, 32)->UseRealTime();
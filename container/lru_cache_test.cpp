@@ -5,6 +5,9 @@
 
 #include "toft/container/lru_cache.h"
 
+#include <string>
+#include <vector>
+
 #include "toft/base/closure.h"
 #include "toft/system/threading/thread_pool.h"
 #include "toft/system/time/clock.h"
@@ -90,6 +93,101 @@ TEST(LruCacheTest, Overflow) {
     EXPECT_EQ(4, cache.GetOrDefault(4));
 }
 
+TEST(LruCacheTest, Charge) {
+    LruCache<int, int> cache(10);
+    cache.Put(1, 1, 4);
+    cache.Put(2, 2, 4);
+    EXPECT_EQ(8U, cache.Charge());
+    EXPECT_FALSE(cache.IsFull());
+    EXPECT_EQ(1, cache.GetOrDefault(1));
+
+    // Key 2 is the least recently used one.
+    cache.Put(3, 3, 4);
+    EXPECT_EQ(2U, cache.Size());
+    EXPECT_EQ(8U, cache.Charge());
+    EXPECT_TRUE(cache.HasKey(1));
+    EXPECT_FALSE(cache.HasKey(2));
+    EXPECT_TRUE(cache.HasKey(3));
+
+    // Replace with a different charge.
+    cache.Put(3, 3, 6);
+    EXPECT_EQ(10U, cache.Charge());
+    EXPECT_TRUE(cache.IsFull());
+
+    // An entry larger than capacity is kept until next Put.
+    cache.Put(4, 4, 20);
+    EXPECT_EQ(1U, cache.Size());
+    EXPECT_EQ(20U, cache.Charge());
+    EXPECT_TRUE(cache.HasKey(4));
+
+    EXPECT_TRUE(cache.Remove(4));
+    EXPECT_EQ(0U, cache.Charge());
+}
+
+TEST(LruCacheTest, MaxEntries) {
+    LruCache<int, int> cache(100, 2);
+    cache.Put(1, 1, 0);
+    cache.Put(2, 2, 0);
+    cache.Put(3, 3, 0);
+    EXPECT_EQ(2U, cache.Size());
+    EXPECT_FALSE(cache.HasKey(1));
+}
+
+static void OnEvicted(std::vector<std::pair<int, std::string> >* evicted,
+                      const int& key, const std::string& value) {
+    evicted->push_back(std::make_pair(key, value));
+}
+
+TEST(LruCacheTest, EvictionCallback) {
+    std::vector<std::pair<int, std::string> > evicted;
+    LruCache<int, std::string> cache(2);
+    cache.SetEvictionCallback(
+        std::bind(OnEvicted, &evicted, std::placeholders::_1, std::placeholders::_2));
+    cache.Put(1, "a");
+    cache.Put(2, "b");
+    cache.Put(2, "c");
+    EXPECT_TRUE(cache.Remove(2));
+    EXPECT_TRUE(evicted.empty());
+
+    cache.Put(3, "d");
+    cache.Put(4, "e");
+    ASSERT_EQ(1U, evicted.size());
+    EXPECT_EQ(1, evicted[0].first);
+    EXPECT_EQ("a", evicted[0].second);
+
+    cache.Put(5, "f", 2);
+    ASSERT_EQ(3U, evicted.size());
+    EXPECT_EQ(3, evicted[1].first);
+    EXPECT_EQ(4, evicted[2].first);
+}
+
+TEST(LruCacheTest, Stats) {
+    LruCache<int, int> cache(2);
+    cache.Put(1, 1);
+    cache.Put(2, 2);
+    cache.Put(3, 3);
+    int value;
+    EXPECT_FALSE(cache.Get(1, &value));
+    EXPECT_TRUE(cache.Get(2, &value));
+    EXPECT_TRUE(cache.Get(3, &value));
+
+    CacheStats stats;
+    cache.GetStats(&stats);
+    EXPECT_EQ(2U, stats.hits);
+    EXPECT_EQ(1U, stats.misses);
+    EXPECT_EQ(1U, stats.evictions);
+    EXPECT_EQ(2U, stats.size);
+    EXPECT_EQ(2U, stats.charge);
+    EXPECT_EQ(2U, stats.capacity);
+
+    cache.ResetStats();
+    cache.GetStats(&stats);
+    EXPECT_EQ(0U, stats.hits);
+    EXPECT_EQ(0U, stats.misses);
+    EXPECT_EQ(0U, stats.evictions);
+    EXPECT_EQ(2U, stats.size);
+}
+
 static void SetCache(LruCache<int, int> *cache, int multiplier) {
     for (int i = 2; i < 1000; ++i) {
         cache->Put(i, i * multiplier);
@@ -0,0 +1,247 @@
+// Copyright (c) 2026, The Toft Authors.
+// All rights reserved.
+//
+// Thread safe LRU cache split into independently locked shards.
+
+#ifndef TOFT_CONTAINER_SHARDED_LRU_CACHE_H_
+#define TOFT_CONTAINER_SHARDED_LRU_CACHE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <new>
+
+#include "toft/base/functional.h"
+#include "toft/base/uncopyable.h"
+#include "toft/container/lru_cache.h"
+#include "toft/system/threading/mutex.h"
+
+#include "thirdparty/glog/logging.h"
+
+namespace toft {
+
+// A thread safe LRU cache which splits the key space into 2^shard_bits
+// independent LruCache shards, each protected by its own lock, so readers
+// and writers of different keys rarely contend with each other.
+//
+// The total capacity is divided evenly among shards and eviction happens
+// per shard, so the cache as a whole is only approximately LRU. PolicyType
+// is the storage engine of each shard, see LruCache.
+template<typename KeyType,
+         typename ValueType,
+         typename LockType = Mutex,
+         typename HashType = std::hash<KeyType>,
+         typename PolicyType = LruListPolicy<KeyType, ValueType> >
+class ShardedLruCache {
+    TOFT_DECLARE_UNCOPYABLE(ShardedLruCache);
+
+public:
+    static const int kDefaultShardBits = 4;
+    static const int kMaxShardBits = 16;
+
+    typedef typename LruCache<KeyType, ValueType, LockType, PolicyType>::EvictionCallback
+        EvictionCallback;
+
+    // Both capacity and max_entries are divided among shards, see LruCache.
+    explicit ShardedLruCache(size_t capacity,
+                             int shard_bits = kDefaultShardBits,
+                             size_t max_entries = 0);
+
+    ~ShardedLruCache();
+
+    // Gets the value from the cache and also update the cache.
+    // Return false if no value found.
+    bool Get(const KeyType& key, ValueType* value) {
+        return GetShard(key)->Get(key, value);
+    }
+
+    // Get the value from the cache if exist, return default_value otherwise.
+    ValueType GetOrDefault(const KeyType& key,
+                           const ValueType& default_value = ValueType()) {
+        return GetShard(key)->GetOrDefault(key, default_value);
+    }
+
+    // Saves value in cache.
+    // If the key already exists, the new value will replace the old one.
+    void Put(const KeyType& key, const ValueType& value) {
+        GetShard(key)->Put(key, value);
+    }
+
+    // Saves value with the specified charge in cache.
+    void Put(const KeyType& key, const ValueType& value, size_t charge) {
+        GetShard(key)->Put(key, value, charge);
+    }
+
+    bool Remove(const KeyType& key) {
+        return GetShard(key)->Remove(key);
+    }
+
+    bool HasKey(const KeyType& key) const {
+        return GetShard(key)->HasKey(key);
+    }
+
+    // Clear all shards, one by one.
+    void Clear();
+
+    // Should be set before the cache is used.
+    void SetEvictionCallback(const EvictionCallback& callback);
+
+    // The following aggregate values are summed over all shards without a
+    // global lock, so they are only a snapshot under concurrent updates.
+    size_t Size() const;
+    size_t Charge() const;
+    size_t Capacity() const;
+    bool IsEmpty() const;
+    void GetStats(CacheStats* stats) const;
+    void ResetStats();
+
+    size_t ShardCount() const {
+        return m_num_shards;
+    }
+
+    // Size of the given shard, mainly for test and monitoring.
+    size_t ShardSize(size_t shard_index) const {
+        CHECK_LT(shard_index, m_num_shards);
+        return ShardAt(shard_index)->Size();
+    }
+
+private:
+    typedef LruCache<KeyType, ValueType, LockType, PolicyType> Shard;
+
+    // Shards are placed in one cache line aligned memory block, each padded
+    // to whole cache lines, to avoid false sharing between the locks and
+    // lists of adjacent shards.
+    static const size_t kCacheLineSize = 64;
+    static const size_t kShardStride =
+        (sizeof(Shard) + kCacheLineSize - 1) / kCacheLineSize * kCacheLineSize;
+
+    Shard* ShardAt(size_t index) const {
+        return reinterpret_cast<Shard*>(m_shard_memory + index * kShardStride);
+    }
+
+    size_t ShardIndex(const KeyType& key) const {
+        // Scramble the hash value, since std::hash of integers is identity.
+        if (m_shard_bits == 0)
+            return 0;
+        uint64_t h = static_cast<uint64_t>(m_hasher(key)) * 0x9E3779B97F4A7C15ULL;
+        return static_cast<size_t>(h >> (64 - m_shard_bits));
+    }
+
+    Shard* GetShard(const KeyType& key) const {
+        return ShardAt(ShardIndex(key));
+    }
+
+private:
+    HashType m_hasher;
+    int m_shard_bits;
+    size_t m_num_shards;
+    char* m_shard_memory;
+};
+
+template<typename KeyType, typename ValueType, typename LockType, typename HashType,
+         typename PolicyType>
+ShardedLruCache<KeyType, ValueType, LockType, HashType, PolicyType>::ShardedLruCache(
+        size_t capacity, int shard_bits, size_t max_entries)
+    : m_shard_bits(shard_bits),
+      m_num_shards(static_cast<size_t>(1) << shard_bits),
+      m_shard_memory(NULL) {
+    CHECK(shard_bits >= 0 && shard_bits <= kMaxShardBits)
+        << "invalid shard bits: " << shard_bits;
+    // Round up, so the aggregate capacity is never less than requested.
+    size_t per_shard_capacity = (capacity + m_num_shards - 1) / m_num_shards;
+    size_t per_shard_max_entries = (max_entries + m_num_shards - 1) / m_num_shards;
+    void* memory = NULL;
+    CHECK_EQ(0, posix_memalign(&memory, kCacheLineSize, m_num_shards * kShardStride));
+    m_shard_memory = static_cast<char*>(memory);
+    for (size_t i = 0; i < m_num_shards; ++i)
+        new (ShardAt(i)) Shard(per_shard_capacity, per_shard_max_entries);
+}
+
+template<typename KeyType, typename ValueType, typename LockType, typename HashType,
+         typename PolicyType>
+ShardedLruCache<KeyType, ValueType, LockType, HashType, PolicyType>::~ShardedLruCache() {
+    for (size_t i = 0; i < m_num_shards; ++i)
+        ShardAt(i)->~Shard();
+    free(m_shard_memory);
+}
+
+template<typename KeyType, typename ValueType, typename LockType, typename HashType,
+         typename PolicyType>
+void ShardedLruCache<KeyType, ValueType, LockType, HashType, PolicyType>::Clear() {
+    for (size_t i = 0; i < m_num_shards; ++i)
+        ShardAt(i)->Clear();
+}
+
+template<typename KeyType, typename ValueType, typename LockType, typename HashType,
+         typename PolicyType>
+size_t ShardedLruCache<KeyType, ValueType, LockType, HashType, PolicyType>::Size() const {
+    size_t size = 0;
+    for (size_t i = 0; i < m_num_shards; ++i)
+        size += ShardAt(i)->Size();
+    return size;
+}
+
+template<typename KeyType, typename ValueType, typename LockType, typename HashType,
+         typename PolicyType>
+void ShardedLruCache<KeyType, ValueType, LockType, HashType, PolicyType>::SetEvictionCallback(
+        const EvictionCallback& callback) {
+    for (size_t i = 0; i < m_num_shards; ++i)
+        ShardAt(i)->SetEvictionCallback(callback);
+}
+
+template<typename KeyType, typename ValueType, typename LockType, typename HashType,
+         typename PolicyType>
+size_t ShardedLruCache<KeyType, ValueType, LockType, HashType, PolicyType>::Charge() const {
+    size_t charge = 0;
+    for (size_t i = 0; i < m_num_shards; ++i)
+        charge += ShardAt(i)->Charge();
+    return charge;
+}
+
+template<typename KeyType, typename ValueType, typename LockType, typename HashType,
+         typename PolicyType>
+size_t ShardedLruCache<KeyType, ValueType, LockType, HashType, PolicyType>::Capacity() const {
+    size_t capacity = 0;
+    for (size_t i = 0; i < m_num_shards; ++i)
+        capacity += ShardAt(i)->Capacity();
+    return capacity;
+}
+
+template<typename KeyType, typename ValueType, typename LockType, typename HashType,
+         typename PolicyType>
+bool ShardedLruCache<KeyType, ValueType, LockType, HashType, PolicyType>::IsEmpty() const {
+    for (size_t i = 0; i < m_num_shards; ++i) {
+        if (!ShardAt(i)->IsEmpty())
+            return false;
+    }
+    return true;
+}
+
+template<typename KeyType, typename ValueType, typename LockType, typename HashType,
+         typename PolicyType>
+void ShardedLruCache<KeyType, ValueType, LockType, HashType, PolicyType>::GetStats(
+        CacheStats* stats) const {
+    *stats = CacheStats();
+    for (size_t i = 0; i < m_num_shards; ++i) {
+        CacheStats shard_stats;
+        ShardAt(i)->GetStats(&shard_stats);
+        stats->hits += shard_stats.hits;
+        stats->misses += shard_stats.misses;
+        stats->evictions += shard_stats.evictions;
+        stats->size += shard_stats.size;
+        stats->charge += shard_stats.charge;
+        stats->capacity += shard_stats.capacity;
+    }
+}
+
+template<typename KeyType, typename ValueType, typename LockType, typename HashType,
+         typename PolicyType>
+void ShardedLruCache<KeyType, ValueType, LockType, HashType, PolicyType>::ResetStats() {
+    for (size_t i = 0; i < m_num_shards; ++i)
+        ShardAt(i)->ResetStats();
+}
+
+}  // namespace toft
+
+#endif  // TOFT_CONTAINER_SHARDED_LRU_CACHE_H_
@@ -0,0 +1,140 @@
+// Copyright (c) 2026, The Toft Authors.
+// All rights reserved.
+//
+// Tests of ShardedLruCache.
+
+#include "toft/container/sharded_lru_cache.h"
+
+#include <string>
+
+#include "toft/base/closure.h"
+#include "toft/system/threading/thread_pool.h"
+#include "toft/system/time/clock.h"
+
+#include "thirdparty/glog/logging.h"
+#include "thirdparty/gtest/gtest.h"
+
+namespace toft {
+
+TEST(ShardedLruCacheTest, Normal) {
+    ShardedLruCache<int, int> cache(64);
+    cache.Put(2, 2);
+    cache.Put(1, 1);
+    cache.Put(3, 3);
+    EXPECT_EQ(1, cache.GetOrDefault(1));
+    EXPECT_EQ(3, cache.GetOrDefault(3));
+    EXPECT_EQ(2, cache.GetOrDefault(2));
+    EXPECT_FALSE(cache.HasKey(4));
+    EXPECT_TRUE(cache.HasKey(3));
+
+    int value = 0;
+    EXPECT_TRUE(cache.Get(2, &value));
+    EXPECT_EQ(2, value);
+    EXPECT_FALSE(cache.Get(5, &value));
+}
+
+TEST(ShardedLruCacheTest, StringKey) {
+    ShardedLruCache<std::string, int> cache(64, 2);
+    cache.Put("hello", 1);
+    cache.Put("world", 2);
+    cache.Put("hello", 3);
+    EXPECT_EQ(3, cache.GetOrDefault("hello"));
+    EXPECT_EQ(2, cache.GetOrDefault("world"));
+    EXPECT_EQ(2U, cache.Size());
+}
+
+TEST(ShardedLruCacheTest, Size) {
+    ShardedLruCache<int, int> cache(100, 2);
+    EXPECT_EQ(4U, cache.ShardCount());
+    // Capacity is rounded up to a multiple of shard number.
+    EXPECT_EQ(100U, cache.Capacity());
+    EXPECT_EQ(0U, cache.Size());
+    EXPECT_TRUE(cache.IsEmpty());
+
+    for (int i = 0; i < 10; ++i)
+        cache.Put(i, i);
+    EXPECT_EQ(10U, cache.Size());
+    EXPECT_FALSE(cache.IsEmpty());
+
+    size_t total = 0;
+    for (size_t i = 0; i < cache.ShardCount(); ++i)
+        total += cache.ShardSize(i);
+    EXPECT_EQ(cache.Size(), total);
+
+    cache.Clear();
+    EXPECT_EQ(0U, cache.Size());
+    EXPECT_TRUE(cache.IsEmpty());
+}
+
+TEST(ShardedLruCacheTest, Remove) {
+    ShardedLruCache<int, int> cache(16);
+    cache.Put(1, 1);
+    EXPECT_TRUE(cache.Remove(1));
+    EXPECT_EQ(0U, cache.Size());
+    EXPECT_FALSE(cache.Remove(2));
+}
+
+TEST(ShardedLruCacheTest, PerShardEviction) {
+    ShardedLruCache<int, int> cache(32, 3);
+    EXPECT_EQ(32U, cache.Capacity());
+    for (int i = 0; i < 10000; ++i)
+        cache.Put(i, i);
+    // Every shard is bounded by its own capacity.
+    for (size_t i = 0; i < cache.ShardCount(); ++i)
+        EXPECT_LE(cache.ShardSize(i), 4U);
+    EXPECT_LE(cache.Size(), cache.Capacity());
+    // The most recently put key is always kept.
+    EXPECT_TRUE(cache.HasKey(9999));
+}
+
+TEST(ShardedLruCacheTest, ChargeAndStats) {
+    ShardedLruCache<int, int> cache(1000, 2);
+    for (int i = 0; i < 100; ++i)
+        cache.Put(i, i, 10);
+    EXPECT_LE(cache.Charge(), 1000U);
+    int value;
+    for (int i = 0; i < 100; ++i)
+        cache.Get(i, &value);
+
+    CacheStats stats;
+    cache.GetStats(&stats);
+    EXPECT_EQ(100U, stats.hits + stats.misses);
+    EXPECT_EQ(100U, stats.size + stats.evictions);
+    EXPECT_EQ(cache.Charge(), stats.charge);
+    EXPECT_EQ(1000U, stats.capacity);
+}
+
+static void SetThread(ShardedLruCache<int, int> *cache) {
+    int64_t now = RealtimeClock.MicroSeconds();
+    int multiplier = 1;
+    while (RealtimeClock.MicroSeconds() - now < 500) {
+        for (int i = 2; i < 1000; ++i)
+            cache->Put(i, i * multiplier);
+        ++multiplier;
+    }
+}
+
+static void ReadThread(ShardedLruCache<int, int> *cache) {
+    int64_t now = RealtimeClock.MicroSeconds();
+    int value;
+    while (RealtimeClock.MicroSeconds() - now < 500) {
+        for (int i = 2; i < 1000; ++i) {
+            if (cache->Get(i, &value)) {
+                ASSERT_EQ(0, value % i);
+            }
+        }
+    }
+}
+
+TEST(ShardedLruCacheTest, MultiThread) {
+    ShardedLruCache<int, int> cache(900);
+    ThreadPool pool(7);
+    for (int i = 0; i < 2; ++i) {
+        pool.AddTask(NewClosure(SetThread, &cache));
+    }
+    for (int i = 0; i < 5; ++i) {
+        pool.AddTask(NewClosure(ReadThread, &cache));
+    }
+}
+
+}  // namespace toft
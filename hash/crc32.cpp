@@ -11,12 +11,16 @@
 // This implementation is based on the sample implementation in RFC 1952.
 
 namespace {
-static const uint32_t* InitCrc32Table() {
+// Tables for the slicing-by-8 algorithm, table[0] is the usual byte table,
+// table[k][i] is the crc of byte i followed by k zero bytes.
+typedef uint32_t Crc32Tables[8][256];
+
+static const Crc32Tables* InitCrc32Table() {
     // CRC32 polynomial, in reversed form.
     static const uint32_t kCrc32Polynomial = 0xEDB88320;
     // See RFC 1952, or http://en.wikipedia.org/wiki/Cyclic_redundancy_check
-    static uint32_t crc32_table[256];
-    for (uint32_t i = 0; i < TOFT_ARRAY_SIZE(crc32_table); ++i) {
+    static Crc32Tables crc32_table;
+    for (uint32_t i = 0; i < TOFT_ARRAY_SIZE(crc32_table[0]); ++i) {
         uint32_t c = i;
         for (size_t j = 0; j < 8; ++j) {
             if (c & 1) {
@@ -25,14 +29,25 @@ static const uint32_t* InitCrc32Table() {
                 c >>= 1;
             }
         }
-        crc32_table[i] = c;
+        crc32_table[0][i] = c;
+    }
+    for (uint32_t i = 0; i < TOFT_ARRAY_SIZE(crc32_table[0]); ++i) {
+        for (size_t k = 1; k < TOFT_ARRAY_SIZE(crc32_table); ++k) {
+            uint32_t c = crc32_table[k - 1][i];
+            crc32_table[k][i] = crc32_table[0][c & 0xFF] ^ (c >> 8);
+        }
     }
-    return crc32_table;
+    return &crc32_table;
+}
+
+static const Crc32Tables& Crc32Table() {
+    // Build the table only once, it costs more than checksum of short data.
+    static const Crc32Tables* table = InitCrc32Table();
+    return *table;
 }
 
-static const uint32_t* Crc32Table() {
-    const uint32_t* table = InitCrc32Table();
-    return table;
+static uint32_t LoadLittleEndian32(const uint8_t* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24);
 }
 
 } // namespace
@@ -52,9 +67,19 @@ void CRC32::Init() {
 void CRC32::Update(StringPiece sp) {
     uint32_t c = result_ ^ 0xFFFFFFFF;
     const uint8_t* u = reinterpret_cast<const uint8_t*>(sp.data());
-    const uint32_t* table = Crc32Table();
-    for (size_t i = 0; i < sp.size(); ++i) {
-        c = table[(c ^ u[i]) & 0xFF] ^ (c >> 8);
+    size_t size = sp.size();
+    const Crc32Tables& table = Crc32Table();
+    // Process 8 bytes at a time.
+    for (; size >= 8; u += 8, size -= 8) {
+        c ^= LoadLittleEndian32(u);
+        uint32_t high = LoadLittleEndian32(u + 4);
+        c = table[7][c & 0xFF] ^ table[6][(c >> 8) & 0xFF] ^
+            table[5][(c >> 16) & 0xFF] ^ table[4][c >> 24] ^
+            table[3][high & 0xFF] ^ table[2][(high >> 8) & 0xFF] ^
+            table[1][(high >> 16) & 0xFF] ^ table[0][high >> 24];
+    }
+    for (size_t i = 0; i < size; ++i) {
+        c = table[0][(c ^ u[i]) & 0xFF] ^ (c >> 8);
     }
     result_ = c ^ 0xFFFFFFFF;
 }
@@ -85,4 +110,59 @@ std::string CRC32::HexDigest(StringPiece sp) {
     return crc32.HexFinal();
 }
 
+// The following is based on crc32_combine of zlib. Appending a zero bit to
+// the data is a linear operator on the crc register over GF(2), represented
+// as a 32x32 bit matrix, so appending len2 zero bytes can be computed by
+// squaring the matrix in O(log(len2)).
+static uint32_t Gf2MatrixTimes(const uint32_t* matrix, uint32_t vector) {
+    uint32_t sum = 0;
+    while (vector) {
+        if (vector & 1)
+            sum ^= *matrix;
+        vector >>= 1;
+        ++matrix;
+    }
+    return sum;
+}
+
+static void Gf2MatrixSquare(uint32_t* square, const uint32_t* matrix) {
+    for (int n = 0; n < 32; ++n)
+        square[n] = Gf2MatrixTimes(matrix, matrix[n]);
+}
+
+uint32_t CRC32::Combine(uint32_t crc1, uint32_t crc2, size_t len2) {
+    if (len2 == 0)
+        return crc1;
+
+    uint32_t even[32];  // Even power of two zeros operator
+    uint32_t odd[32];   // Odd power of two zeros operator
+
+    // Operator for one zero bit in odd.
+    odd[0] = 0xEDB88320;
+    uint32_t row = 1;
+    for (int n = 1; n < 32; ++n) {
+        odd[n] = row;
+        row <<= 1;
+    }
+    Gf2MatrixSquare(even, odd);  // Two zero bits
+    Gf2MatrixSquare(odd, even);  // Four zero bits
+
+    // Apply len2 zeros to crc1, the first square puts the operator for one
+    // zero byte, eight zero bits, in even.
+    do {
+        Gf2MatrixSquare(even, odd);
+        if (len2 & 1)
+            crc1 = Gf2MatrixTimes(even, crc1);
+        len2 >>= 1;
+        if (len2 == 0)
+            break;
+        Gf2MatrixSquare(odd, even);
+        if (len2 & 1)
+            crc1 = Gf2MatrixTimes(odd, crc1);
+        len2 >>= 1;
+    } while (len2 != 0);
+
+    return crc1 ^ crc2;
+}
+
 }  // namespace toft
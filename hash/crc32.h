@@ -33,6 +33,11 @@ public:
     static uint32_t Digest(StringPiece sp);
     static std::string HexDigest(StringPiece sp);
 
+    // Return crc32 of the concatenation of A and B, from crc1 of A, crc2 of
+    // B and length of B. So crc32 of large data can be computed in pieces
+    // in parallel.
+    static uint32_t Combine(uint32_t crc1, uint32_t crc2, size_t len2);
+
 private:
     uint32_t result_;
 };
@@ -25,4 +25,13 @@ TEST(Crc32Test, TestMultipleUpdates) {
     EXPECT_EQ(0x171A3F5FU, crc32.Final());
 }
 
+TEST(Crc32Test, TestCombine) {
+    std::string input = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+    for (size_t i = 0; i <= input.size(); ++i) {
+        StringPiece a(input.data(), i);
+        StringPiece b(input.data() + i, input.size() - i);
+        EXPECT_EQ(0x171A3F5FU, CRC32::Combine(CRC32::Digest(a), CRC32::Digest(b), b.size()));
+    }
+}
+
 } // namespace toft
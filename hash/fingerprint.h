@@ -31,6 +31,7 @@ uint32_t Fingerprint32WithSeed(const char *str, size_t length, uint32_t seed);
 
 //  High level wrapper using MurmurHash64A
 uint64_t Fingerprint64(const std::string& str);
+uint64_t Fingerprint64(const char* str, size_t length);
 
 //  Helper functions for Fingerprint, it's shorter than IntegerToString,
 //  So it's better to use it as key of sstable (For example , int64 can be used
@@ -18,6 +18,10 @@ uint64_t Fingerprint64(const std::string& str) {
     return MurmurHash64A(str, kFingerPrintSeed);
 }
 
+uint64_t Fingerprint64(const char* str, size_t length) {
+    return MurmurHash64A(str, length, kFingerPrintSeed);
+}
+
 std::string Fingerprint64ToString(uint64_t fp) {
     // NOLINT(runtime/sizeof)
     return modp::b16_encode(reinterpret_cast<char*>(&fp), sizeof(uint64_t));
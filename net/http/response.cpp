@@ -127,7 +127,7 @@ bool HttpResponse::ParseStatusCode(StringPiece status)
 }
 
 void HttpResponse::AppendStartLineToString(std::string* result) const {
-    StringAppend(result, "HTTP/", Version().Major(), ".", Version().Major(),
+    StringAppend(result, "HTTP/", Version().Major(), ".", Version().Minor(),
                  " ", m_status, " ", StatusCodeToReasonPhraseSafe(m_status));
 }
 
@@ -4,104 +4,212 @@
 // Author: CHEN Feng <chen3feng@gmail.com>
 
 #include "toft/net/http/server/connection.h"
-#include "thirdparty/glog/logging.h"
-#include "toft/base/string/format.h"
+#include <errno.h>
+#include <strings.h>
+#include <sys/socket.h>
 #include "toft/base/string/number.h"
-#include "toft/net/http/request.h"
-#include "toft/net/http/response.h"
+
+#include "thirdparty/glog/logging.h"
 
 namespace toft {
 
-HttpConnection::HttpConnection(EventDispatcher* dispatcher, int fd)
+static const size_t kReceiveBufferSize = 65536;
+
+// Stop reading requests if too many of them are waiting for responses.
+static const size_t kMaxPendingTransactions = 64;
+
+HttpConnection::HttpConnection(EventDispatcher* dispatcher, int fd,
+                               const RequestHandler& request_handler,
+                               const ClosedCallback& closed_callback)
     : m_watcher(dispatcher, std::bind(&HttpConnection::OnIoEvents, this,
                                       std::placeholders::_1),
                 fd, EventMask_Read),
-      m_sent_size(0) {
+      m_request_handler(request_handler),
+      m_closed_callback(closed_callback),
+      m_sent_size(0),
+      m_closing(false),
+      m_eof(false) {
     m_socket.Attach(fd);
+    m_socket.SetTcpNoDelay();
     m_watcher.Start();
 }
 
+HttpConnection::~HttpConnection() {
+    m_watcher.Stop();
+}
+
 void HttpConnection::Send(const StringPiece& data) {
-    m_send_queue.push_back(data.as_string());
+    data.append_to_string(&m_send_buffer);
+    UpdateEvents();
 }
 
 void HttpConnection::Close() {
+    if (!m_socket.IsValid())
+        return;
+    m_watcher.Stop();
+    m_socket.Close();
+    // Must be the last one, this object may be deleted in it.
+    if (m_closed_callback)
+        m_closed_callback(this);
+}
+
+void HttpConnection::ResponseReady(const TransactionPtr& transaction) {
+    std::deque<PendingTransaction>::iterator i;
+    for (i = m_pending_transactions.begin(); i != m_pending_transactions.end(); ++i) {
+        if (i->transaction == transaction) {
+            i->ready = true;
+            Flush();
+            return;
+        }
+    }
+    // Dropped after a response closing the connection.
 }
 
 void HttpConnection::OnIoEvents(int events) {
-    LOG(INFO) << "HttpConnection::OnIoEvents";
     if (events & EventMask_Error) {
-        LOG(INFO) << "Error";
-        m_watcher.Stop();
+        Close();
         return;
     }
-    if (events & EventMask_Read) {
-        LOG(INFO) << "Read";
-        if (!OnReadable())
-            return;
-    }
-    if (events & EventMask_Write) {
-        LOG(INFO) << "Write";
-        if (!OnWriteable())
-            return;
+    if ((events & EventMask_Read) && !OnReadable()) {
+        Close();
+        return;
     }
-
-    int new_events = EventMask_Read;
-    if (!m_send_queue.empty())
-        new_events |= EventMask_Write;
-    m_watcher.Set(new_events);
+    Flush();
 }
 
 bool HttpConnection::OnReadable() {
-    size_t kBufferSize = 65536;
-    size_t received_size = m_receive_buffer.size();
-    m_receive_buffer.resize(received_size + kBufferSize);
-    char* buf = &m_receive_buffer[received_size];
-    size_t new_received_size;
-    if (!m_socket.Receive(buf, kBufferSize, &new_received_size)) {
-        OnClosed();
-        return false;
-    }
-    m_receive_buffer.resize(received_size + new_received_size);
-    LOG(INFO) << m_receive_buffer;
-    HttpRequest request;
-    if (request.ParseHeaders(m_receive_buffer)) {
-        LOG(INFO) << "Request URI: " << request.Uri();
-        HttpResponse response;
-        response.SetStatus(HttpResponse::Status_OK);
-        static int i = 0;
-        std::string body = StringPrint("Hello %d", ++i);
-        response.SetBody(body);
-        response.SetHeader("Content-Length", NumberToString(body.size()));
-        Send(response.ToString());
-        m_receive_buffer.clear();
+    char buffer[kReceiveBufferSize];
+    ssize_t n = recv(m_socket.Handle(), buffer, sizeof(buffer), 0);
+    if (n < 0)
+        return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+    if (n == 0) {
+        // Closed by peer, finish responses of received requests.
+        m_eof = true;
+        return true;
     }
-
+    m_receive_buffer.append(buffer, n);
     return true;
 }
 
 bool HttpConnection::OnWriteable() {
-    while (!m_send_queue.empty()) {
-        const std::string& data = m_send_queue.front();
-        size_t data_size = data.size() - m_sent_size;
+    while (m_sent_size < m_send_buffer.size()) {
         size_t sent_size;
-        if (m_socket.Send(data.data() + m_sent_size, data_size, &sent_size)) {
-            if (sent_size == data_size) {
-                m_send_queue.pop_front();
-                m_sent_size = 0;
-            } else {
-                m_sent_size += sent_size;
-                break;
-            }
-        } else {
-            break;
+        if (!m_socket.Send(m_send_buffer.data() + m_sent_size,
+                           m_send_buffer.size() - m_sent_size, &sent_size)) {
+            int error = Socket::GetLastError();
+            return error == EAGAIN || error == EWOULDBLOCK;
         }
+        m_sent_size += sent_size;
     }
+    m_send_buffer.clear();
+    m_sent_size = 0;
     return true;
 }
 
-void HttpConnection::OnClosed() {
-    m_watcher.Stop();
+void HttpConnection::Flush() {
+    HandleRequests();
+    AppendReadyResponses();
+    // Responses are sent as soon as possible, without waiting for the next
+    // writeable event.
+    if (!OnWriteable()) {
+        Close();
+        return;
+    }
+    if ((m_closing || m_eof) && m_pending_transactions.empty() &&
+        m_sent_size == m_send_buffer.size()) {
+        Close();
+        return;
+    }
+    UpdateEvents();
+}
+
+void HttpConnection::HandleRequests() {
+    // Handle all pipelined requests in the buffer.
+    size_t consumed_size = 0;
+    while (!m_closing && m_pending_transactions.size() < kMaxPendingTransactions &&
+           consumed_size < m_receive_buffer.size()) {
+        // The parser keeps its state between reads, so a partly parsed
+        // request must be parsed into the same transaction.
+        if (!m_current_transaction)
+            m_current_transaction.reset(new Transaction);
+        size_t request_size;
+        StringPiece data = StringPiece(m_receive_buffer).substr(consumed_size);
+        HttpRequestParser::ParseResult result =
+            m_parser.Parse(data, &m_current_transaction->request, &request_size);
+        if (result == HttpRequestParser::PARSE_INCOMPLETE)
+            break;
+        TransactionPtr transaction;
+        transaction.swap(m_current_transaction);
+        if (result == HttpRequestParser::PARSE_ERROR) {
+            ReplyError(m_parser.ErrorStatus());
+            break;
+        }
+        consumed_size += request_size;
+        if (!transaction->request.IsKeepAlive())
+            m_closing = true;
+        transaction->response.SetVersion(HttpVersion(1, 1));
+        PendingTransaction pending = { transaction, false };
+        m_pending_transactions.push_back(pending);
+        if (m_request_handler(this, transaction))
+            m_pending_transactions.back().ready = true;
+    }
+    m_receive_buffer.erase(0, consumed_size);
+}
+
+void HttpConnection::ReplyError(HttpResponse::StatusCode status) {
+    // Sent after responses of previous requests.
+    TransactionPtr transaction(new Transaction);
+    HttpResponse& response = transaction->response;
+    response.SetVersion(HttpVersion(1, 1));
+    response.FillWithHtmlPage(status);
+    response.SetHeader("Connection", "close");
+    PendingTransaction pending = { transaction, true };
+    m_pending_transactions.push_back(pending);
+    m_closing = true;
+}
+
+void HttpConnection::AppendReadyResponses() {
+    while (!m_pending_transactions.empty() && m_pending_transactions.front().ready) {
+        TransactionPtr transaction = m_pending_transactions.front().transaction;
+        m_pending_transactions.pop_front();
+        AppendResponse(transaction.get());
+    }
+}
+
+void HttpConnection::AppendResponse(Transaction* transaction) {
+    const HttpRequest& request = transaction->request;
+    HttpResponse& response = transaction->response;
+    if (response.Status() == HttpResponse::Status_None)
+        response.SetStatus(HttpResponse::Status_OK);
+
+    const std::string* connection;
+    if (response.GetHeader("Connection", &connection) &&
+        strcasecmp(connection->c_str(), "close") == 0) {
+        // Responses of later requests are dropped.
+        m_pending_transactions.clear();
+        m_closing = true;
+    } else if (!request.IsKeepAlive()) {
+        response.SetHeader("Connection", "close");
+    } else if (request.Version() < HttpVersion(1, 1)) {
+        response.SetHeader("Connection", "keep-alive");
+    }
+    if (!response.HasHeader("Content-Length"))
+        response.SetHeader("Content-Length", NumberToString(response.Body().size()));
+
+    // Response of HEAD has the same headers as GET, but no body.
+    if (request.Method() == HttpRequest::METHOD_HEAD)
+        response.AppendHeadersToString(&m_send_buffer);
+    else
+        response.AppendToString(&m_send_buffer);
+}
+
+void HttpConnection::UpdateEvents() {
+    int events = EventMask_None;
+    if (!m_closing && !m_eof && m_pending_transactions.size() < kMaxPendingTransactions)
+        events |= EventMask_Read;
+    if (m_sent_size < m_send_buffer.size())
+        events |= EventMask_Write;
+    m_watcher.Set(events);
 }
 
 } // namespace toft
@@ -7,36 +7,86 @@
 #define TOFT_NET_HTTP_SERVER_CONNECTION_H
 #pragma once
 
-#include <list>
+#include <deque>
 #include <string>
-#include <vector>
+#include "toft/base/functional.h"
+#include "toft/base/shared_ptr.h"
 #include "toft/base/string/string_piece.h"
+#include "toft/net/http/request.h"
+#include "toft/net/http/response.h"
+#include "toft/net/http/server/request_parser.h"
 #include "toft/system/event_dispatcher/event_dispatcher.h"
 #include "toft/system/net/socket.h"
 
 namespace toft {
 
+// A http connection served in an event dispatcher.
+//
+// Requests are parsed from the received data, pipelined requests are handled
+// one by one and their responses are sent in the same order. The connection
+// is kept alive unless the client requires to close it.
 class HttpConnection {
     TOFT_DECLARE_UNCOPYABLE(HttpConnection);
 
 public:
-    HttpConnection(EventDispatcher* dispatcher, int fd);
+    // A request and its response.
+    struct Transaction {
+        HttpRequest request;
+        HttpResponse response;
+    };
+    typedef std::shared_ptr<Transaction> TransactionPtr;
+
+    // Return true if the response is filled. Otherwise it's filled later,
+    // maybe in other threads, and ResponseReady must be called in the
+    // dispatcher thread after that.
+    typedef std::function<bool (HttpConnection*, const TransactionPtr&)> RequestHandler;
+    typedef std::function<void (HttpConnection*)> ClosedCallback;
+
+    // closed_callback is called after the connection is closed, the
+    // connection can be deleted in it.
+    HttpConnection(EventDispatcher* dispatcher, int fd,
+                   const RequestHandler& request_handler,
+                   const ClosedCallback& closed_callback);
+    ~HttpConnection();
+
     void Send(const StringPiece& data);
     void Close();
 
+    // Send the response of a transaction handled asynchronously, and
+    // responses after it which are ready. The connection may be closed and
+    // deleted in it.
+    void ResponseReady(const TransactionPtr& transaction);
+
 private:
+    struct PendingTransaction {
+        TransactionPtr transaction;
+        bool ready;
+    };
+
     void OnIoEvents(int events);
-    void OnError();
     bool OnReadable();
     bool OnWriteable();
-    void OnClosed();
+    void HandleRequests();
+    void ReplyError(HttpResponse::StatusCode status);
+    void AppendReadyResponses();
+    void AppendResponse(Transaction* transaction);
+    void Flush();
+    void UpdateEvents();
 
 private:
     StreamSocket m_socket;
     IoEventWatcher m_watcher;
+    RequestHandler m_request_handler;
+    ClosedCallback m_closed_callback;
+    HttpRequestParser m_parser;
     std::string m_receive_buffer;
-    std::list<std::string> m_send_queue;
+    // The request being parsed, whose data may be received in many reads.
+    TransactionPtr m_current_transaction;
+    std::deque<PendingTransaction> m_pending_transactions;  // In request order
+    std::string m_send_buffer;
     size_t m_sent_size;
+    bool m_closing;  // No more requests, close after all responses are sent
+    bool m_eof;      // Closed by peer
 };
 
 } // namespace toft
@@ -4,10 +4,19 @@
 // Author: CHEN Feng <chen3feng@gmail.com>
 
 #include "toft/net/http/server/server.h"
+#include "toft/net/http/server/handler.h"
 
 #include "thirdparty/gflags/gflags.h"
 #include "thirdparty/glog/logging.h"
 
+class HelloHandler : public toft::HttpHandler {
+public:
+    virtual void HandleGet(const toft::HttpRequest* req, toft::HttpResponse* resp) {
+        resp->SetHeader("Content-Type", "text/plain");
+        resp->SetBody("Hello " + req->Uri());
+    }
+};
+
 int main(int argc, char** argv) {
     FLAGS_alsologtostderr = true;
     google::ParseCommandLineFlags(&argc, &argv, true);
@@ -15,6 +24,8 @@ int main(int argc, char** argv) {
 
     using namespace toft;
     HttpServer server;
+    HelloHandler handler;
+    server.RegisterHttpHandler("/", &handler);
     server.Bind(SocketAddressInet4("127.0.0.1", 8080));
     LOG(INFO) << "Listen on http://127.0.0.1:8080/";
     server.Start();
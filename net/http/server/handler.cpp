@@ -8,6 +8,9 @@
 
 namespace toft {
 
+HttpHandler::HttpHandler() {
+}
+
 void HttpHandler::HandleRequest(const HttpRequest* req, HttpResponse* resp) {
     switch (req->Method()) {
     case HttpRequest::METHOD_HEAD:
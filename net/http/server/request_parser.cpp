@@ -0,0 +1,197 @@
+// Copyright (c) 2026, The Toft Authors.
+// All rights reserved.
+//
+// States and transitions of HttpRequestParser.
+
+#include "toft/net/http/server/request_parser.h"
+#include <stdlib.h>
+#include <strings.h>
+#include <string>
+
+namespace toft {
+
+// Size of the headers if data[pos] is the '\n' before the empty line,
+// 0 if not.
+static size_t HeadersEndAt(const StringPiece& data, size_t pos) {
+    if (pos + 1 < data.size() && data[pos + 1] == '\n')
+        return pos + 2;
+    if (pos + 2 < data.size() && data[pos + 1] == '\r' && data[pos + 2] == '\n')
+        return pos + 3;
+    return 0;
+}
+
+static bool IsChunked(const std::string& transfer_encoding) {
+    // Chunked must be the last one if there are more encodings.
+    static const char kChunked[] = "chunked";
+    size_t size = sizeof(kChunked) - 1;
+    return transfer_encoding.size() >= size &&
+        strcasecmp(transfer_encoding.c_str() + transfer_encoding.size() - size,
+                   kChunked) == 0;
+}
+
+HttpRequestParser::HttpRequestParser(size_t max_header_size, size_t max_body_size)
+    : m_max_header_size(max_header_size),
+      m_max_body_size(max_body_size) {
+    Reset();
+}
+
+void HttpRequestParser::Reset() {
+    m_state = STATE_HEADERS;
+    m_offset = 0;
+    m_body_remain_size = 0;
+    m_error_status = HttpResponse::Status_None;
+}
+
+HttpRequestParser::ParseResult HttpRequestParser::Parse(
+    const StringPiece& data, HttpRequest* request, size_t* size) {
+    while (m_error_status == HttpResponse::Status_None) {
+        bool finished = false;
+        switch (m_state) {
+        case STATE_HEADERS:
+            finished = ParseHeaders(data, request);
+            break;
+        case STATE_BODY:
+            finished = ParseBody(data, request);
+            break;
+        case STATE_CHUNK_SIZE:
+            finished = ParseChunkSize(data, request);
+            break;
+        case STATE_CHUNK_DATA:
+            finished = ParseChunkData(data, request);
+            break;
+        case STATE_CHUNK_TRAILER:
+            finished = ParseChunkTrailer(data);
+            break;
+        case STATE_COMPLETE:
+            *size = m_offset;
+            Reset();
+            return PARSE_COMPLETE;
+        }
+        if (!finished && m_error_status == HttpResponse::Status_None)
+            return PARSE_INCOMPLETE;
+    }
+    return PARSE_ERROR;
+}
+
+bool HttpRequestParser::Fail(HttpResponse::StatusCode status) {
+    m_error_status = status;
+    return false;
+}
+
+size_t HttpRequestParser::FindLine(const StringPiece& data) const {
+    size_t pos = data.find('\n', m_offset);
+    if (pos == StringPiece::npos)
+        return 0;
+    return pos + 1 - m_offset;
+}
+
+bool HttpRequestParser::ParseHeaders(const StringPiece& data, HttpRequest* request) {
+    // Continue searching the empty line from the last incomplete line.
+    size_t headers_size = 0;
+    size_t pos = m_offset;
+    while ((pos = data.find('\n', pos)) != StringPiece::npos) {
+        headers_size = HeadersEndAt(data, pos);
+        if (headers_size > 0)
+            break;
+        if (pos + 3 > data.size())
+            break;  // Can't tell whether it's followed by the empty line yet
+        m_offset = ++pos;
+    }
+    if (headers_size == 0) {
+        if (data.size() > m_max_header_size)
+            return Fail(HttpResponse::Status_RequestEntityTooLarge);
+        return false;
+    }
+    if (headers_size > m_max_header_size)
+        return Fail(HttpResponse::Status_RequestEntityTooLarge);
+
+    request->Reset();
+    HttpMessage::ErrorCode error = HttpMessage::SUCCESS;
+    if (request->ParseHeaders(data.substr(0, headers_size), &error) == 0 ||
+        error != HttpMessage::SUCCESS) {
+        return Fail(error == HttpMessage::ERROR_VERSION_UNSUPPORTED ?
+                    HttpResponse::Status_HTTPVersionNotSupported :
+                    HttpResponse::Status_BadRequest);
+    }
+    m_offset = headers_size;
+
+    const std::string* transfer_encoding;
+    if (request->GetHeader("Transfer-Encoding", &transfer_encoding) &&
+        strcasecmp(transfer_encoding->c_str(), "identity") != 0) {
+        if (!IsChunked(*transfer_encoding))
+            return Fail(HttpResponse::Status_NotImplemented);
+        m_state = STATE_CHUNK_SIZE;
+    } else if (request->HasHeader("Content-Length")) {
+        int length = request->GetContentLength();
+        if (length < 0)
+            return Fail(HttpResponse::Status_BadRequest);
+        if (static_cast<size_t>(length) > m_max_body_size)
+            return Fail(HttpResponse::Status_RequestEntityTooLarge);
+        m_body_remain_size = length;
+        m_state = STATE_BODY;
+    } else {
+        m_state = STATE_COMPLETE;
+    }
+    return true;
+}
+
+bool HttpRequestParser::ParseBody(const StringPiece& data, HttpRequest* request) {
+    if (data.size() - m_offset < m_body_remain_size)
+        return false;
+    request->SetBody(data.substr(m_offset, m_body_remain_size));
+    m_offset += m_body_remain_size;
+    m_state = STATE_COMPLETE;
+    return true;
+}
+
+bool HttpRequestParser::ParseChunkSize(const StringPiece& data, const HttpRequest* request) {
+    size_t line_size = FindLine(data);
+    if (line_size == 0) {
+        // Chunk size line is short, unless with very long extensions.
+        if (data.size() - m_offset > m_max_header_size)
+            return Fail(HttpResponse::Status_BadRequest);
+        return false;
+    }
+    std::string line = data.substr(m_offset, line_size).as_string();
+    char* end;
+    unsigned long chunk_size = strtoul(line.c_str(), &end, 16);  // NOLINT(runtime/int)
+    if (end == line.c_str() || (*end != ';' && *end != '\r' && *end != '\n' && *end != ' '))
+        return Fail(HttpResponse::Status_BadRequest);
+    // Too large bodies are stopped before receiving them.
+    if (chunk_size > m_max_body_size - request->Body().size())
+        return Fail(HttpResponse::Status_RequestEntityTooLarge);
+    m_offset += line_size;
+    m_body_remain_size = chunk_size;
+    m_state = chunk_size == 0 ? STATE_CHUNK_TRAILER : STATE_CHUNK_DATA;
+    return true;
+}
+
+bool HttpRequestParser::ParseChunkData(const StringPiece& data, HttpRequest* request) {
+    // Chunk data is followed by "\r\n".
+    size_t chunk_end = m_offset + m_body_remain_size;
+    if (data.size() < chunk_end + 2)
+        return false;
+    if (data[chunk_end] != '\r' || data[chunk_end + 1] != '\n')
+        return Fail(HttpResponse::Status_BadRequest);
+    request->MutableBody()->append(data.data() + m_offset, m_body_remain_size);
+    m_offset = chunk_end + 2;
+    m_state = STATE_CHUNK_SIZE;
+    return true;
+}
+
+bool HttpRequestParser::ParseChunkTrailer(const StringPiece& data) {
+    // Trailer fields are ignored until the empty line.
+    size_t line_size = FindLine(data);
+    if (line_size == 0) {
+        if (data.size() - m_offset > m_max_header_size)
+            return Fail(HttpResponse::Status_RequestEntityTooLarge);
+        return false;
+    }
+    StringPiece line = data.substr(m_offset, line_size);
+    m_offset += line_size;
+    if (line == "\r\n" || line == "\n")
+        m_state = STATE_COMPLETE;
+    return true;
+}
+
+} // namespace toft
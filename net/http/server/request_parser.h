@@ -0,0 +1,105 @@
+// Copyright (c) 2026, The Toft Authors.
+// All rights reserved.
+//
+// Incremental parser of http requests.
+
+#ifndef TOFT_NET_HTTP_SERVER_REQUEST_PARSER_H
+#define TOFT_NET_HTTP_SERVER_REQUEST_PARSER_H
+#pragma once
+
+#include <stddef.h>
+#include "toft/base/string/string_piece.h"
+#include "toft/base/uncopyable.h"
+#include "toft/net/http/request.h"
+#include "toft/net/http/response.h"
+
+namespace toft {
+
+// Parse http requests from a stream incrementally.
+//
+// Data of the stream is received piece by piece, call Parse with all
+// received data of the current request each time, data parsed in previous
+// calls are not scanned again. Both Content-Length and chunked bodies are
+// supported, requests without them have no body.
+//
+// Example:
+//   HttpRequestParser parser;
+//   HttpRequest request;
+//   size_t size;
+//   switch (parser.Parse(buffer, &request, &size)) {
+//   case HttpRequestParser::PARSE_COMPLETE:
+//       // Handle request, remove the first size bytes from buffer
+//       break;
+//   case HttpRequestParser::PARSE_INCOMPLETE:
+//       // Receive more data into buffer
+//       break;
+//   case HttpRequestParser::PARSE_ERROR:
+//       // Reply parser.ErrorStatus() and close the connection
+//       break;
+//   }
+class HttpRequestParser {
+    TOFT_DECLARE_UNCOPYABLE(HttpRequestParser);
+
+public:
+    enum ParseResult {
+        PARSE_INCOMPLETE,
+        PARSE_COMPLETE,
+        PARSE_ERROR,
+    };
+
+    static const size_t kDefaultMaxHeaderSize = 64 * 1024;
+    static const size_t kDefaultMaxBodySize = 64 * 1024 * 1024;
+
+    explicit HttpRequestParser(size_t max_header_size = kDefaultMaxHeaderSize,
+                               size_t max_body_size = kDefaultMaxBodySize);
+
+    // data must start with the current request, and contain data passed to
+    // the previous calls for the same request, request must also be the
+    // same object, it keeps what is parsed in previous calls. If it returns PARSE_COMPLETE,
+    // the request is stored into request, its size is stored into size, and
+    // the parser is reset for the next request.
+    ParseResult Parse(const StringPiece& data, HttpRequest* request, size_t* size);
+
+    // Status to reply after PARSE_ERROR.
+    HttpResponse::StatusCode ErrorStatus() const {
+        return m_error_status;
+    }
+
+    // Prepare for a new request.
+    void Reset();
+
+private:
+    enum State {
+        STATE_HEADERS,
+        STATE_BODY,
+        STATE_CHUNK_SIZE,
+        STATE_CHUNK_DATA,
+        STATE_CHUNK_TRAILER,
+        STATE_COMPLETE,
+    };
+
+    // Each step returns true if it's finished and m_state is moved to the
+    // next one, false if more data is needed or failed.
+    bool ParseHeaders(const StringPiece& data, HttpRequest* request);
+    bool ParseBody(const StringPiece& data, HttpRequest* request);
+    bool ParseChunkSize(const StringPiece& data, const HttpRequest* request);
+    bool ParseChunkData(const StringPiece& data, HttpRequest* request);
+    bool ParseChunkTrailer(const StringPiece& data);
+    bool Fail(HttpResponse::StatusCode status);
+
+    // Find the end of a line from m_offset, return the size of the line
+    // including "\n", or 0 if the line is not complete.
+    size_t FindLine(const StringPiece& data) const;
+
+private:
+    const size_t m_max_header_size;
+    const size_t m_max_body_size;
+    State m_state;
+    size_t m_offset;            // Size of the parsed part
+    size_t m_body_remain_size;  // Of the whole body or the current chunk
+    HttpResponse::StatusCode m_error_status;
+};
+
+} // namespace toft
+
+#endif // TOFT_NET_HTTP_SERVER_REQUEST_PARSER_H
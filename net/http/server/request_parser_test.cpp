@@ -0,0 +1,145 @@
+// Copyright (c) 2026, The Toft Authors.
+// All rights reserved.
+//
+// Tests of HttpRequestParser.
+
+#include "toft/net/http/server/request_parser.h"
+#include <string>
+#include "thirdparty/gtest/gtest.h"
+
+namespace toft {
+
+static const char kGetRequest[] =
+    "GET /index.html?a=1 HTTP/1.1\r\n"
+    "Host: localhost\r\n"
+    "\r\n";
+
+static const char kPostRequest[] =
+    "POST /post HTTP/1.1\r\n"
+    "Content-Length: 5\r\n"
+    "\r\n"
+    "hello";
+
+static const char kChunkedRequest[] =
+    "POST /chunked HTTP/1.1\r\n"
+    "Transfer-Encoding: chunked\r\n"
+    "\r\n"
+    "5;name=value\r\n"
+    "hello\r\n"
+    "B\r\n"
+    ", world!!!!\r\n"
+    "0\r\n"
+    "Trailer: 1\r\n"
+    "\r\n";
+
+TEST(HttpRequestParser, Get) {
+    HttpRequestParser parser;
+    HttpRequest request;
+    size_t size = 0;
+    ASSERT_EQ(HttpRequestParser::PARSE_COMPLETE,
+              parser.Parse(kGetRequest, &request, &size));
+    EXPECT_EQ(sizeof(kGetRequest) - 1, size);
+    EXPECT_EQ(HttpRequest::METHOD_GET, request.Method());
+    EXPECT_EQ("/index.html?a=1", request.Uri());
+    EXPECT_TRUE(request.Body().empty());
+}
+
+TEST(HttpRequestParser, ContentLength) {
+    HttpRequestParser parser;
+    HttpRequest request;
+    size_t size = 0;
+    ASSERT_EQ(HttpRequestParser::PARSE_COMPLETE,
+              parser.Parse(kPostRequest, &request, &size));
+    EXPECT_EQ(sizeof(kPostRequest) - 1, size);
+    EXPECT_EQ(HttpRequest::METHOD_POST, request.Method());
+    EXPECT_EQ("hello", request.Body());
+}
+
+TEST(HttpRequestParser, Chunked) {
+    HttpRequestParser parser;
+    HttpRequest request;
+    size_t size = 0;
+    ASSERT_EQ(HttpRequestParser::PARSE_COMPLETE,
+              parser.Parse(kChunkedRequest, &request, &size));
+    EXPECT_EQ(sizeof(kChunkedRequest) - 1, size);
+    EXPECT_EQ("hello, world!!!!", request.Body());
+}
+
+// Feed requests byte by byte, as if received in many pieces.
+static void ParseIncrementally(const std::string& text, const std::string& body) {
+    HttpRequestParser parser;
+    HttpRequest request;
+    size_t size = 0;
+    for (size_t i = 1; i < text.size(); ++i) {
+        ASSERT_EQ(HttpRequestParser::PARSE_INCOMPLETE,
+                  parser.Parse(text.substr(0, i), &request, &size)) << i;
+    }
+    ASSERT_EQ(HttpRequestParser::PARSE_COMPLETE,
+              parser.Parse(text, &request, &size));
+    EXPECT_EQ(text.size(), size);
+    EXPECT_EQ(body, request.Body());
+}
+
+TEST(HttpRequestParser, Incremental) {
+    ParseIncrementally(kGetRequest, "");
+    ParseIncrementally(kPostRequest, "hello");
+    ParseIncrementally(kChunkedRequest, "hello, world!!!!");
+}
+
+TEST(HttpRequestParser, Pipelined) {
+    std::string data = std::string(kPostRequest) + kChunkedRequest + kGetRequest;
+    HttpRequestParser parser;
+    HttpRequest request;
+    size_t size = 0;
+
+    ASSERT_EQ(HttpRequestParser::PARSE_COMPLETE, parser.Parse(data, &request, &size));
+    EXPECT_EQ("/post", request.Uri());
+    data.erase(0, size);
+    ASSERT_EQ(HttpRequestParser::PARSE_COMPLETE, parser.Parse(data, &request, &size));
+    EXPECT_EQ("/chunked", request.Uri());
+    EXPECT_EQ("hello, world!!!!", request.Body());
+    data.erase(0, size);
+    ASSERT_EQ(HttpRequestParser::PARSE_COMPLETE, parser.Parse(data, &request, &size));
+    EXPECT_EQ("/index.html?a=1", request.Uri());
+    EXPECT_TRUE(request.Body().empty());
+    EXPECT_EQ(data.size(), size);
+}
+
+static HttpResponse::StatusCode ParseError(const std::string& text,
+                                           size_t max_header_size = 1024,
+                                           size_t max_body_size = 1024) {
+    HttpRequestParser parser(max_header_size, max_body_size);
+    HttpRequest request;
+    size_t size = 0;
+    if (parser.Parse(text, &request, &size) != HttpRequestParser::PARSE_ERROR)
+        return HttpResponse::Status_None;
+    return parser.ErrorStatus();
+}
+
+TEST(HttpRequestParser, Errors) {
+    EXPECT_EQ(HttpResponse::Status_BadRequest, ParseError("GET\r\n\r\n"));
+    EXPECT_EQ(HttpResponse::Status_BadRequest,
+              ParseError("POST / HTTP/1.1\r\nContent-Length: x\r\n\r\n"));
+    EXPECT_EQ(HttpResponse::Status_BadRequest,
+              ParseError("POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\nxyz\r\n"));
+    EXPECT_EQ(HttpResponse::Status_BadRequest,
+              ParseError("POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n"
+                         "1\r\nab\r\n"));
+    EXPECT_EQ(HttpResponse::Status_NotImplemented,
+              ParseError("POST / HTTP/1.1\r\nTransfer-Encoding: gzip\r\n\r\n"));
+}
+
+TEST(HttpRequestParser, Limits) {
+    EXPECT_EQ(HttpResponse::Status_RequestEntityTooLarge,
+              ParseError("GET / HTTP/1.1\r\nA: " + std::string(2000, 'a')));
+    EXPECT_EQ(HttpResponse::Status_RequestEntityTooLarge,
+              ParseError("POST / HTTP/1.1\r\nContent-Length: 1025\r\n\r\n"));
+    EXPECT_EQ(HttpResponse::Status_RequestEntityTooLarge,
+              ParseError("POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n"
+                         "200\r\n" + std::string(512, 'a') + "\r\n"
+                         "201\r\n"));
+    EXPECT_EQ(HttpResponse::Status_None,
+              ParseError("POST / HTTP/1.1\r\nContent-Length: 1024\r\n\r\n"));
+}
+
+} // namespace toft
@@ -4,39 +4,270 @@
 // Author: CHEN Feng <chen3feng@gmail.com>
 
 #include "toft/net/http/server/server.h"
+#include <errno.h>
 #include <set>
+#include <vector>
+#include "toft/base/shared_ptr.h"
 #include "toft/net/http/server/connection.h"
+#include "toft/net/http/server/handler.h"
 #include "toft/system/event_dispatcher/event_dispatcher.h"
 #include "toft/system/net/socket.h"
+#include "toft/system/threading/mutex.h"
+#include "toft/system/threading/thread.h"
+#include "toft/system/threading/thread_pool.h"
 
 #include "thirdparty/glog/logging.h"
 
 namespace toft {
 
-struct HttpServer::Impl {
-    Impl()
-        : m_listen_socket(AF_INET, SOCK_STREAM, 0),
+namespace {
+
+typedef std::map<std::string, HttpHandler*> HttpHandlerMap;
+
+// Find the handler registered with the path, or the longest registered
+// path ending with '/' which is a prefix of it.
+HttpHandler* FindHandler(const HttpHandlerMap& handler_map, const std::string& uri) {
+    std::string path = uri.substr(0, uri.find_first_of("?#"));
+    HttpHandlerMap::const_iterator it = handler_map.find(path);
+    if (it != handler_map.end())
+        return it->second;
+    for (size_t pos = path.rfind('/'); pos != std::string::npos;
+         pos = pos > 0 ? path.rfind('/', pos - 1) : std::string::npos) {
+        it = handler_map.find(path.substr(0, pos + 1));
+        if (it != handler_map.end())
+            return it->second;
+    }
+    return NULL;
+}
+
+void CallHandler(HttpHandler* handler, HttpConnection::Transaction* transaction) {
+    if (handler == NULL) {
+        transaction->response.FillWithHtmlPage(HttpResponse::Status_NotFound);
+        return;
+    }
+    handler->HandleRequest(&transaction->request, &transaction->response);
+}
+
+// Closures posted from any thread to run in a dispatcher thread. It's shared
+// with handler tasks, which may finish after the dispatcher is gone.
+class PostedClosures {
+public:
+    explicit PostedClosures(AsyncEventWatcher* watcher) : m_watcher(watcher) {}
+
+    void Post(const std::function<void ()>& closure) {
+        MutexLocker locker(&m_mutex);
+        if (m_watcher == NULL)
+            return;
+        m_closures.push_back(closure);
+        m_watcher->Send();
+    }
+
+    void Swap(std::vector<std::function<void ()> >* closures) {
+        MutexLocker locker(&m_mutex);
+        m_closures.swap(*closures);
+    }
+
+    // Discard all closures posted later.
+    void Close() {
+        MutexLocker locker(&m_mutex);
+        m_watcher = NULL;
+        m_closures.clear();
+    }
+
+private:
+    Mutex m_mutex;
+    AsyncEventWatcher* m_watcher;
+    std::vector<std::function<void ()> > m_closures;
+};
+
+// An event dispatcher and connections accepted by it.
+class HttpReactor {
+    TOFT_DECLARE_UNCOPYABLE(HttpReactor);
+
+public:
+    HttpReactor(const HttpHandlerMap* handler_map, ThreadPool* handler_thread_pool)
+        : m_handler_map(handler_map),
+          m_handler_thread_pool(handler_thread_pool),
+          m_listen_socket(NULL),
           m_listen_watcher(&m_event_dispatcher,
-                           std::bind(&Impl::OnAccept, this,
-                                     std::placeholders::_1)) {
-        m_listen_socket.SetBlocking(false);
+                           std::bind(&HttpReactor::OnAccept, this)),
+          m_close_watcher(&m_event_dispatcher,
+                          std::bind(&HttpReactor::OnClose, this)),
+          m_posted_watcher(&m_event_dispatcher,
+                           std::bind(&HttpReactor::OnPosted, this)),
+          m_posted_closures(new PostedClosures(&m_posted_watcher)) {
+        m_close_watcher.Start();
+        m_posted_watcher.Start();
+    }
+
+    ~HttpReactor() {
+        m_posted_closures->Close();
+        CloseConnections();
+    }
+
+    void Start(ListenerSocket* listen_socket) {
+        m_listen_socket = listen_socket;
+        m_listen_watcher.Set(listen_socket->Handle(), EventMask_Read);
+        m_listen_watcher.Start();
+    }
+
+    void Run() {
+        m_event_dispatcher.Run();
+    }
+
+    void Close() {
+        // Can be called in any thread, the dispatcher thread does the work.
+        m_close_watcher.Send();
+    }
+
+private:
+    void OnAccept() {
+        // Accept all pending connections in one event.
+        for (;;) {
+            StreamSocket socket;
+            if (!m_listen_socket->Accept(&socket)) {
+                int error = Socket::GetLastError();
+                if (error != EAGAIN && error != EWOULDBLOCK)
+                    PLOG(WARNING) << "Accept failed";
+                break;
+            }
+            socket.SetBlocking(false);
+            using namespace std::placeholders;
+            m_connections.insert(new HttpConnection(
+                    &m_event_dispatcher, socket.Detach(),
+                    std::bind(&HttpReactor::HandleRequest, this, _1, _2),
+                    std::bind(&HttpReactor::OnConnectionClosed, this, _1)));
+        }
+    }
+
+    void OnConnectionClosed(HttpConnection* connection) {
+        m_connections.erase(connection);
+        delete connection;
+    }
+
+    void OnClose() {
+        m_listen_watcher.Stop();
+        CloseConnections();
+        m_event_dispatcher.Break();
+    }
+
+    void OnPosted() {
+        std::vector<std::function<void ()> > closures;
+        m_posted_closures->Swap(&closures);
+        for (size_t i = 0; i < closures.size(); ++i)
+            closures[i]();
+    }
+
+    void CloseConnections() {
+        std::set<HttpConnection*>::iterator i;
+        for (i = m_connections.begin(); i != m_connections.end(); ++i)
+            delete *i;
+        m_connections.clear();
+    }
+
+    bool HandleRequest(HttpConnection* connection,
+                       const HttpConnection::TransactionPtr& transaction) {
+        // The handler map is not changed after started, so it's safe to be
+        // read in any thread.
+        HttpHandler* handler = FindHandler(*m_handler_map, transaction->request.Uri());
+        if (m_handler_thread_pool == NULL || handler == NULL) {
+            CallHandler(handler, transaction.get());
+            return true;
+        }
+        m_handler_thread_pool->AddTask(std::bind(
+                &HttpReactor::HandleRequestInPool, handler, transaction,
+                m_posted_closures,
+                std::function<void ()>(std::bind(&HttpReactor::OnResponseReady, this,
+                                                 connection, transaction))));
+        return false;
+    }
+
+    static void HandleRequestInPool(HttpHandler* handler,
+                                    const HttpConnection::TransactionPtr& transaction,
+                                    const std::shared_ptr<PostedClosures>& posted_closures,
+                                    const std::function<void ()>& done) {
+        CallHandler(handler, transaction.get());
+        posted_closures->Post(done);
+    }
+
+    void OnResponseReady(HttpConnection* connection,
+                         const HttpConnection::TransactionPtr& transaction) {
+        // The connection may be closed, and its address may be reused by a
+        // new one, which just ignores the unknown transaction.
+        if (m_connections.count(connection) > 0)
+            connection->ResponseReady(transaction);
+    }
+
+private:
+    const HttpHandlerMap* m_handler_map;
+    ThreadPool* m_handler_thread_pool;
+    EventDispatcher m_event_dispatcher;
+    ListenerSocket* m_listen_socket;
+    IoEventWatcher m_listen_watcher;
+    AsyncEventWatcher m_close_watcher;
+    AsyncEventWatcher m_posted_watcher;
+    std::shared_ptr<PostedClosures> m_posted_closures;
+    std::set<HttpConnection*> m_connections;
+};
+
+ListenerSocket* NewListenerSocket() {
+    ListenerSocket* socket = new ListenerSocket(AF_INET, SOCK_STREAM, 0);
+    socket->SetBlocking(false);
+    socket->SetReuseAddress();
+    return socket;
+}
+
+} // namespace
+
+struct HttpServer::Impl {
+    Impl(int num_threads, ThreadPool* handler_thread_pool) {
+        if (num_threads < 1)
+            num_threads = 1;
+        for (int i = 0; i < num_threads; ++i)
+            m_reactors.push_back(new HttpReactor(&m_handler_map, handler_thread_pool));
+
+        // Share one listener socket if SO_REUSEPORT is not supported.
+        m_listen_sockets.push_back(NewListenerSocket());
+        if (num_threads > 1 && m_listen_sockets[0]->SetReusePort()) {
+            for (int i = 1; i < num_threads; ++i) {
+                m_listen_sockets.push_back(NewListenerSocket());
+                m_listen_sockets.back()->SetReusePort();
+            }
+        }
+    }
+
+    ~Impl() {
+        // Reactors must be destroyed before sockets they are watching.
+        for (size_t i = 0; i < m_reactors.size(); ++i)
+            delete m_reactors[i];
+        for (size_t i = 0; i < m_listen_sockets.size(); ++i)
+            delete m_listen_sockets[i];
     }
 
 public:
     bool Bind(const SocketAddress& address, SocketAddress* real_address) {
-        if (!m_listen_socket.Bind(address))
+        if (!m_listen_sockets[0]->Bind(address))
+            return false;
+        // Bind to the real address in case of the port is 0.
+        SocketAddressStorage bound_address;
+        if (!m_listen_sockets[0]->GetLocalAddress(&bound_address))
             return false;
+        for (size_t i = 1; i < m_listen_sockets.size(); ++i) {
+            if (!m_listen_sockets[i]->Bind(bound_address))
+                return false;
+        }
         if (real_address)
-            return m_listen_socket.GetLocalAddress(real_address);
+            return real_address->CopyFrom(bound_address);
         return true;
     }
 
     bool Start() {
-        if (!m_listen_socket.Listen()) {
-            return false;
+        for (size_t i = 0; i < m_listen_sockets.size(); ++i) {
+            if (!m_listen_sockets[i]->Listen())
+                return false;
         }
-        m_listen_watcher.Set(m_listen_socket.Handle(), EventMask_Write);
-        m_listen_watcher.Start();
+        for (size_t i = 0; i < m_reactors.size(); ++i)
+            m_reactors[i]->Start(m_listen_sockets[i % m_listen_sockets.size()]);
         return true;
     }
 
@@ -45,30 +276,29 @@ public:
     }
 
     void Run() {
-        m_event_dispatcher.Run();
+        std::vector<Thread*> threads;
+        for (size_t i = 1; i < m_reactors.size(); ++i)
+            threads.push_back(new Thread(std::bind(&HttpReactor::Run, m_reactors[i])));
+        m_reactors[0]->Run();
+        for (size_t i = 0; i < threads.size(); ++i) {
+            threads[i]->Join();
+            delete threads[i];
+        }
     }
 
-private:
-    void OnAccept(int events) {
-        StreamSocket socket;
-        SocketAddressStorage address;
-        if (m_listen_socket.Accept(&socket, &address)) {
-            LOG(INFO) << "Connect from " << address.ToString() << " acceptted.";
-            socket.SetBlocking(false);
-            m_connections.insert(new HttpConnection(&m_event_dispatcher,
-                                                    socket.Detach()));
-        }
+    void Close() {
+        for (size_t i = 0; i < m_reactors.size(); ++i)
+            m_reactors[i]->Close();
     }
 
 private:
-    std::map<std::string, HttpHandler*> m_handler_map;
-    EventDispatcher m_event_dispatcher;
-    ListenerSocket m_listen_socket;
-    IoEventWatcher m_listen_watcher;
-    std::set<HttpConnection*> m_connections;
+    HttpHandlerMap m_handler_map;
+    std::vector<HttpReactor*> m_reactors;
+    std::vector<ListenerSocket*> m_listen_sockets;
 };
 
-HttpServer::HttpServer() : m_impl(new Impl()) {
+HttpServer::HttpServer(int num_threads, ThreadPool* handler_thread_pool)
+    : m_impl(new Impl(num_threads, handler_thread_pool)) {
 }
 
 HttpServer::~HttpServer() {
@@ -87,6 +317,10 @@ bool HttpServer::Start() {
     return m_impl->Start();
 }
 
+void HttpServer::Close() {
+    m_impl->Close();
+}
+
 void HttpServer::Run() {
     return m_impl->Run();
 }
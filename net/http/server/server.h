@@ -16,17 +16,34 @@
 namespace toft {
 
 class HttpHandler;
+class ThreadPool;
 
+// Http server running num_threads event dispatchers, each in its own thread
+// with its own connections. If the os supports SO_REUSEPORT, each dispatcher
+// listens on its own socket and the kernel distributes connections among
+// them, otherwise they accept from the same socket.
+//
+// Handlers are called in the dispatcher threads by default, they must be fast
+// and never block. If handler_thread_pool is not NULL, handlers are called in
+// it and the dispatchers keep serving other connections, a kWorkStealing
+// pool is preferred so that fast handlers don't queue after slow ones.
+// Handlers may be called concurrently if num_threads > 1 or
+// handler_thread_pool is set.
 class HttpServer {
     TOFT_DECLARE_UNCOPYABLE(HttpServer);
 
 public:
-    HttpServer();
+    explicit HttpServer(int num_threads = 1, ThreadPool* handler_thread_pool = NULL);
     virtual ~HttpServer();
     bool RegisterHttpHandler(const std::string& path, HttpHandler* handler);
     bool Bind(const SocketAddress& address, SocketAddress* real_address = NULL);
     bool Start();
+
+    // Stop all dispatchers and make Run return, can be called in any thread.
     void Close();
+
+    // Run dispatchers until Close is called, the calling thread runs one of
+    // them.
     void Run();
 
 private:
@@ -0,0 +1,183 @@
+// Copyright (c) 2026, The Toft Authors.
+// All rights reserved.
+//
+// Load test of HttpServer by keep-alive clients, each benchmark thread is a
+// client, reports requests per second and the 99th percentile latency.
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+#include "toft/base/functional.h"
+#include "toft/net/http/server/handler.h"
+#include "toft/net/http/server/server.h"
+#include "toft/system/net/socket.h"
+#include "toft/system/threading/mutex.h"
+#include "toft/system/threading/thread.h"
+#include "toft/system/threading/thread_pool.h"
+#include "toft/system/time/clock.h"
+
+#include "thirdparty/benchmark/benchmark.h"
+
+namespace toft {
+namespace {
+
+class HelloHandler : public HttpHandler {
+public:
+    virtual void HandleGet(const HttpRequest*, HttpResponse* resp) {
+        resp->SetHeader("Content-Type", "text/plain");
+        resp->SetBody("Hello, world!");
+    }
+};
+
+// Servers run in background during the whole process.
+class BenchmarkServer {
+public:
+    BenchmarkServer(int num_threads, ThreadPool* handler_thread_pool)
+        : m_server(num_threads, handler_thread_pool) {
+        m_server.RegisterHttpHandler("/hello", &m_handler);
+        m_server.Bind(SocketAddressInet4("127.0.0.1", 0), &m_address);
+        m_server.Start();
+        m_thread.Start(std::bind(&HttpServer::Run, &m_server));
+    }
+    const SocketAddress& address() const {
+        return m_address;
+    }
+
+private:
+    HelloHandler m_handler;
+    HttpServer m_server;
+    SocketAddressInet4 m_address;
+    Thread m_thread;
+};
+
+const SocketAddress& ServerAddress(int num_threads, bool use_thread_pool) {
+    static Mutex mutex;
+    // Never deleted, server threads are still running at exit.
+    static std::map<std::pair<int, bool>, BenchmarkServer*> servers;
+    static ThreadPool* thread_pool = new ThreadPool(-1, ThreadPool::kWorkStealing);
+    MutexLocker locker(&mutex);
+    BenchmarkServer*& server = servers[std::make_pair(num_threads, use_thread_pool)];
+    if (server == NULL)
+        server = new BenchmarkServer(num_threads, use_thread_pool ? thread_pool : NULL);
+    return server->address();
+}
+
+// Receive a response and return its size, or 0 if failed.
+size_t ReceiveResponse(StreamSocket* socket, std::string* buffer) {
+    for (;;) {
+        size_t headers_size = buffer->find("\r\n\r\n");
+        if (headers_size != std::string::npos) {
+            HttpResponse response;
+            headers_size += 4;
+            if (response.ParseHeaders(StringPiece(*buffer).substr(0, headers_size)) == 0)
+                return 0;
+            size_t size = headers_size + response.GetContentLength();
+            if (buffer->size() >= size)
+                return size;
+        }
+        char data[4096];
+        size_t received_size;
+        if (!socket->Receive(data, sizeof(data), &received_size))
+            return 0;
+        buffer->append(data, received_size);
+    }
+}
+
+// Latencies of all benchmark threads of a run.
+class LatencyCollector {
+public:
+    LatencyCollector() : m_finished_threads(0) {}
+
+    // Add latencies of a finished thread. Return the 99th percentile latency
+    // of all threads if it's the last finished one, otherwise -1.
+    int64_t AddThread(const std::vector<int64_t>& latencies, int num_threads) {
+        MutexLocker locker(&m_mutex);
+        m_latencies.insert(m_latencies.end(), latencies.begin(), latencies.end());
+        if (++m_finished_threads < num_threads)
+            return -1;
+        int64_t p99 = -1;
+        if (!m_latencies.empty()) {
+            size_t index = m_latencies.size() * 99 / 100;
+            std::nth_element(m_latencies.begin(), m_latencies.begin() + index,
+                             m_latencies.end());
+            p99 = m_latencies[index];
+        }
+        // Ready for the next run.
+        m_latencies.clear();
+        m_finished_threads = 0;
+        return p99;
+    }
+
+private:
+    Mutex m_mutex;
+    std::vector<int64_t> m_latencies;
+    int m_finished_threads;
+};
+
+}  // namespace
+}  // namespace toft
+
+// range(0): number of pipelined requests sent together.
+// range(1): number of server dispatcher threads.
+// range(2): whether to call handlers in a thread pool.
+static void HttpServerRequests(benchmark::State& state) {
+    using namespace toft;
+    const int pipeline_depth = state.range(0);
+    const SocketAddress& address = ServerAddress(state.range(1), state.range(2) != 0);
+    std::string requests;
+    for (int i = 0; i < pipeline_depth; ++i)
+        requests += "GET /hello HTTP/1.1\r\nHost: localhost\r\n\r\n";
+
+    // Every thread must reach the end to add its latencies, so don't return
+    // on errors. The loop is skipped if SkipWithError is called before it.
+    StreamSocket socket;
+    bool ok = socket.Create() && socket.Connect(address);
+    if (ok)
+        socket.SetTcpNoDelay();
+    else
+        state.SkipWithError("failed to connect");
+    std::string buffer;
+    std::vector<int64_t> latencies;
+    for (auto _ : state) {
+        int64_t start_time = MonotonicClock.MicroSeconds();
+        if (!socket.SendAll(requests.data(), requests.size())) {
+            state.SkipWithError("failed to send");
+            break;
+        }
+        for (int i = 0; i < pipeline_depth; ++i) {
+            size_t size = ReceiveResponse(&socket, &buffer);
+            if (size == 0) {
+                state.SkipWithError("failed to receive");
+                ok = false;
+                break;
+            }
+            buffer.erase(0, size);
+            latencies.push_back(MonotonicClock.MicroSeconds() - start_time);
+        }
+        if (!ok)
+            break;
+    }
+    state.SetItemsProcessed(latencies.size());
+
+    // Counters are summed over threads, only the last finished thread reports
+    // the percentile of all threads.
+    static LatencyCollector collector;
+    int64_t p99 = collector.AddThread(latencies, state.threads());
+    if (p99 >= 0)
+        state.counters["p99_us"] = p99;
+}
+
+static void HttpServerArguments(benchmark::internal::Benchmark* benchmark) {
+    for (int pipeline_depth = 1; pipeline_depth <= 16; pipeline_depth *= 16) {
+        for (int num_threads = 1; num_threads <= 4; num_threads *= 4) {
+            benchmark->Args({pipeline_depth, num_threads, 0});
+            benchmark->Args({pipeline_depth, num_threads, 1});
+        }
+    }
+}
+BENCHMARK(HttpServerRequests)
+    ->Apply(HttpServerArguments)
+    ->ThreadRange(1, 16)
+    ->UseRealTime();
@@ -4,6 +4,15 @@
 // Author: CHEN Feng <chen3feng@gmail.com>
 
 #include "toft/net/http/server/server.h"
+#include <string>
+#include <utility>
+#include "toft/base/functional.h"
+#include "toft/base/string/number.h"
+#include "toft/net/http/server/handler.h"
+#include "toft/system/net/socket.h"
+#include "toft/system/threading/this_thread.h"
+#include "toft/system/threading/thread.h"
+#include "toft/system/threading/thread_pool.h"
 #include "thirdparty/gtest/gtest.h"
 
 namespace toft {
@@ -12,4 +21,261 @@ TEST(HttpServer, Ctor) {
     HttpServer server;
 }
 
+class EchoHandler : public HttpHandler {
+public:
+    virtual void HandleGet(const HttpRequest* req, HttpResponse* resp) {
+        // "/sleep/N" sleeps N ms before response.
+        int sleep_ms;
+        if (StringToNumber(req->Uri().substr(req->Uri().rfind('/') + 1), &sleep_ms))
+            ThisThread::Sleep(sleep_ms);
+        resp->SetBody(req->Uri());
+    }
+    virtual void HandleHead(const HttpRequest* req, HttpResponse* resp) {
+        HandleGet(req, resp);
+    }
+    virtual void HandlePost(const HttpRequest* req, HttpResponse* resp) {
+        resp->SetBody(req->Body());
+    }
+    virtual void HandlePut(const HttpRequest* req, HttpResponse* resp) {
+        resp->SetBody(std::string(HttpRequest::GetMethodName(req->Method())) + " " +
+                      req->Uri() + " " + req->Body());
+    }
+};
+
+// A blocking http client which can send pipelined requests.
+class TestClient {
+public:
+    bool Connect(const SocketAddress& address) {
+        return m_socket.Create() && m_socket.Connect(address);
+    }
+
+    bool Send(const std::string& data) {
+        return m_socket.SendAll(data.data(), data.size());
+    }
+
+    // Return false if the connection is closed before a whole response.
+    bool Receive(HttpResponse* response, bool has_body = true) {
+        size_t headers_size;
+        while ((headers_size = m_buffer.find("\r\n\r\n")) == std::string::npos) {
+            if (!ReceiveMore())
+                return false;
+        }
+        headers_size += 4;
+        response->Reset();
+        if (response->ParseHeaders(StringPiece(m_buffer).substr(0, headers_size)) == 0)
+            return false;
+        size_t body_size = has_body ? response->GetContentLength() : 0;
+        while (m_buffer.size() < headers_size + body_size) {
+            if (!ReceiveMore())
+                return false;
+        }
+        response->SetBody(StringPiece(m_buffer).substr(headers_size, body_size));
+        m_buffer.erase(0, headers_size + body_size);
+        return true;
+    }
+
+    bool IsReadable(timeval* timeout) {
+        return !m_buffer.empty() || m_socket.WaitReadable(timeout);
+    }
+
+    // Return true if the connection is closed by server.
+    bool IsClosed() {
+        return m_buffer.empty() && !ReceiveMore();
+    }
+
+private:
+    bool ReceiveMore() {
+        char buffer[4096];
+        size_t received_size;
+        if (!m_socket.Receive(buffer, sizeof(buffer), &received_size))
+            return false;
+        m_buffer.append(buffer, received_size);
+        return true;
+    }
+
+private:
+    StreamSocket m_socket;
+    std::string m_buffer;
+};
+
+// Param: number of dispatcher threads, whether to handle in thread pool.
+class HttpServerTest : public testing::TestWithParam<std::pair<int, bool> > {
+protected:
+    HttpServerTest()
+        : m_thread_pool(4, ThreadPool::kWorkStealing),
+          m_server(GetParam().first, GetParam().second ? &m_thread_pool : NULL) {
+    }
+
+    virtual void SetUp() {
+        ASSERT_TRUE(m_server.RegisterHttpHandler("/echo", &m_handler));
+        ASSERT_TRUE(m_server.RegisterHttpHandler("/dir/", &m_handler));
+        ASSERT_TRUE(m_server.RegisterHttpHandler("/sleep/", &m_handler));
+        ASSERT_TRUE(m_server.Bind(SocketAddressInet4("127.0.0.1", 0), &m_address));
+        ASSERT_TRUE(m_server.Start());
+        m_thread.Start(std::bind(&HttpServer::Run, &m_server));
+    }
+
+    virtual void TearDown() {
+        m_server.Close();
+        m_thread.Join();
+    }
+
+protected:
+    EchoHandler m_handler;
+    ThreadPool m_thread_pool;
+    HttpServer m_server;
+    SocketAddressInet4 m_address;
+    Thread m_thread;
+};
+
+TEST_P(HttpServerTest, KeepAlive) {
+    TestClient client;
+    ASSERT_TRUE(client.Connect(m_address));
+    HttpResponse response;
+    for (int i = 0; i < 3; ++i) {
+        ASSERT_TRUE(client.Send("GET /echo?a=1 HTTP/1.1\r\n\r\n"));
+        ASSERT_TRUE(client.Receive(&response));
+        EXPECT_EQ(HttpResponse::Status_OK, response.Status());
+        EXPECT_EQ("/echo?a=1", response.Body());
+        EXPECT_TRUE(response.IsKeepAlive());
+    }
+}
+
+TEST_P(HttpServerTest, Pipelined) {
+    TestClient client;
+    ASSERT_TRUE(client.Connect(m_address));
+    ASSERT_TRUE(client.Send(
+            "GET /dir/a HTTP/1.1\r\n\r\n"
+            "POST /echo HTTP/1.1\r\nContent-Length: 5\r\n\r\nhello"
+            "POST /echo HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n"
+            "5\r\nworld\r\n0\r\n\r\n"
+            "HEAD /dir/b HTTP/1.1\r\n\r\n"
+            "GET /dir/c HTTP/1.1\r\nConnection: close\r\n\r\n"));
+    HttpResponse response;
+    ASSERT_TRUE(client.Receive(&response));
+    EXPECT_EQ("/dir/a", response.Body());
+    ASSERT_TRUE(client.Receive(&response));
+    EXPECT_EQ("hello", response.Body());
+    ASSERT_TRUE(client.Receive(&response));
+    EXPECT_EQ("world", response.Body());
+    ASSERT_TRUE(client.Receive(&response, false));
+    EXPECT_EQ("6", response.GetHeader("Content-Length"));
+    ASSERT_TRUE(client.Receive(&response));
+    EXPECT_EQ("/dir/c", response.Body());
+    EXPECT_FALSE(response.IsKeepAlive());
+    EXPECT_TRUE(client.IsClosed());
+}
+
+// Parts of a request are received by different reads.
+TEST_P(HttpServerTest, SplitRequest) {
+    TestClient client;
+    ASSERT_TRUE(client.Connect(m_address));
+    ASSERT_TRUE(client.Send("PUT /echo HTTP/1.1\r\nContent-Length: 5\r\n\r\n"));
+    ThisThread::Sleep(20);
+    ASSERT_TRUE(client.Send("hello"));
+    HttpResponse response;
+    ASSERT_TRUE(client.Receive(&response));
+    EXPECT_EQ("PUT /echo hello", response.Body());
+
+    ASSERT_TRUE(client.Send("PUT /dir/a HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n"
+                            "5\r\nwor"));
+    ThisThread::Sleep(20);
+    ASSERT_TRUE(client.Send("ld\r\n3\r\nabc\r\n"));
+    ThisThread::Sleep(20);
+    ASSERT_TRUE(client.Send("0\r\n\r\n"));
+    ASSERT_TRUE(client.Receive(&response));
+    EXPECT_EQ("PUT /dir/a worldabc", response.Body());
+}
+
+TEST_P(HttpServerTest, Http10) {
+    TestClient client;
+    ASSERT_TRUE(client.Connect(m_address));
+    ASSERT_TRUE(client.Send("GET /echo HTTP/1.0\r\n\r\n"));
+    HttpResponse response;
+    ASSERT_TRUE(client.Receive(&response));
+    EXPECT_EQ("close", response.GetHeader("Connection"));
+    EXPECT_TRUE(client.IsClosed());
+}
+
+TEST_P(HttpServerTest, NotFound) {
+    TestClient client;
+    ASSERT_TRUE(client.Connect(m_address));
+    ASSERT_TRUE(client.Send("GET /echo/a HTTP/1.1\r\n\r\n"
+                            "GET /dir HTTP/1.1\r\n\r\n"));
+    HttpResponse response;
+    ASSERT_TRUE(client.Receive(&response));
+    EXPECT_EQ(HttpResponse::Status_NotFound, response.Status());
+    ASSERT_TRUE(client.Receive(&response));
+    EXPECT_EQ(HttpResponse::Status_NotFound, response.Status());
+}
+
+TEST_P(HttpServerTest, BadRequest) {
+    TestClient client;
+    ASSERT_TRUE(client.Connect(m_address));
+    ASSERT_TRUE(client.Send("POST /echo HTTP/1.1\r\nContent-Length: x\r\n\r\n"));
+    HttpResponse response;
+    ASSERT_TRUE(client.Receive(&response));
+    EXPECT_EQ(HttpResponse::Status_BadRequest, response.Status());
+    EXPECT_TRUE(client.IsClosed());
+}
+
+TEST_P(HttpServerTest, ManyClients) {
+    const int kClientCount = 100;
+    TestClient clients[kClientCount];
+    for (int i = 0; i < kClientCount; ++i) {
+        ASSERT_TRUE(clients[i].Connect(m_address));
+        ASSERT_TRUE(clients[i].Send("GET /echo HTTP/1.1\r\n\r\n"));
+    }
+    for (int i = 0; i < kClientCount; ++i) {
+        HttpResponse response;
+        ASSERT_TRUE(clients[i].Receive(&response));
+        EXPECT_EQ("/echo", response.Body());
+    }
+}
+
+// Responses are in the request order, even if later ones are ready earlier.
+TEST_P(HttpServerTest, PipelinedOrder) {
+    TestClient client;
+    ASSERT_TRUE(client.Connect(m_address));
+    ASSERT_TRUE(client.Send("GET /sleep/50 HTTP/1.1\r\n\r\n"
+                            "GET /sleep/0 HTTP/1.1\r\n\r\n"
+                            "GET /sleep/20 HTTP/1.1\r\n\r\n"));
+    HttpResponse response;
+    ASSERT_TRUE(client.Receive(&response));
+    EXPECT_EQ("/sleep/50", response.Body());
+    ASSERT_TRUE(client.Receive(&response));
+    EXPECT_EQ("/sleep/0", response.Body());
+    ASSERT_TRUE(client.Receive(&response));
+    EXPECT_EQ("/sleep/20", response.Body());
+}
+
+// Slow handlers don't block other connections if they are run in thread pool.
+TEST_P(HttpServerTest, SlowHandler) {
+    if (!GetParam().second)
+        return;
+    TestClient slow_client;
+    ASSERT_TRUE(slow_client.Connect(m_address));
+    ASSERT_TRUE(slow_client.Send("GET /sleep/1000 HTTP/1.1\r\n\r\n"));
+    ThisThread::Sleep(10);
+
+    TestClient client;
+    ASSERT_TRUE(client.Connect(m_address));
+    HttpResponse response;
+    for (int i = 0; i < 10; ++i) {
+        ASSERT_TRUE(client.Send("GET /echo HTTP/1.1\r\n\r\n"));
+        ASSERT_TRUE(client.Receive(&response));
+        EXPECT_EQ("/echo", response.Body());
+    }
+    timeval timeout = { 0, 0 };
+    EXPECT_FALSE(slow_client.IsReadable(&timeout));
+    ASSERT_TRUE(slow_client.Receive(&response));
+    EXPECT_EQ("/sleep/1000", response.Body());
+}
+
+INSTANTIATE_TEST_CASE_P(HttpServerTest, HttpServerTest,
+                        testing::Values(std::make_pair(1, false),
+                                        std::make_pair(4, false),
+                                        std::make_pair(1, true),
+                                        std::make_pair(4, true)));
+
 } // namespace toft
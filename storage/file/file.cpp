@@ -6,11 +6,60 @@
 #include "toft/storage/file/file.h"
 
 #include <errno.h>
+#include <stdio.h>
 
 #include "toft/base/scoped_ptr.h"
+#include "toft/system/atomic/atomic.h"
+#include "toft/system/threading/event.h"
+#include "toft/system/threading/thread_pool.h"
 
 namespace toft {
 
+namespace {
+
+// Reads mostly wait for devices, so there are more threads than cpus.
+const int kIoThreadCount = 16;
+
+ThreadPool* GetIoThreadPool()
+{
+    // Never deleted, tasks may still be running at exit.
+    static ThreadPool* pool = new ThreadPool(kIoThreadCount);
+    return pool;
+}
+
+void ReadRequest(File* file, FileReadRequest* request)
+{
+    request->result = file->ReadAt(request->offset, request->buffer,
+                                   request->size);
+    request->error = request->result < 0 ? errno : 0;
+}
+
+void ReadRequests(File* file, FileReadRequest* requests, size_t count,
+                  const std::function<void ()>& done)
+{
+    for (size_t i = 0; i < count; ++i)
+        ReadRequest(file, &requests[i]);
+    done();
+}
+
+struct ReadBatch {
+    ReadBatch(size_t count, const std::function<void ()>& done)
+        : remaining(count), done(done) {}
+    Atomic<size_t> remaining;
+    std::function<void ()> done;
+};
+
+void ReadBatchRequest(File* file, FileReadRequest* request, ReadBatch* batch)
+{
+    ReadRequest(file, request);
+    if (--batch->remaining == 0) {
+        batch->done();
+        delete batch;
+    }
+}
+
+} // namespace
+
 /////////////////////////////////////////////////////////////////////////////
 // FileSystem
 
@@ -51,6 +100,54 @@ bool FileSystem::ReadLines(const std::string& file_path,
 File::File() {}
 File::~File() {}
 
+int64_t File::ReadAt(int64_t offset, void* buffer, int64_t size)
+{
+    if (!Seek(offset, SEEK_SET))
+        return -1;
+    int64_t total = 0;
+    while (total < size) {
+        int64_t nread = Read(static_cast<char*>(buffer) + total, size - total);
+        if (nread < 0)
+            return -1;
+        if (nread == 0)
+            break;
+        total += nread;
+    }
+    return total;
+}
+
+void File::AsyncReadAt(FileReadRequest* requests, size_t count,
+                       const std::function<void ()>& done)
+{
+    if (count == 0) {
+        done();
+        return;
+    }
+    if (!IsReadAtThreadSafe()) {
+        GetIoThreadPool()->AddTask(
+            std::bind(ReadRequests, this, requests, count, done));
+        return;
+    }
+    ReadBatch* batch = new ReadBatch(count, done);
+    std::vector<std::function<void ()> > tasks;
+    tasks.reserve(count);
+    for (size_t i = 0; i < count; ++i)
+        tasks.push_back(std::bind(ReadBatchRequest, this, &requests[i], batch));
+    GetIoThreadPool()->AddTasks(tasks);
+}
+
+bool File::ReadAtBatch(FileReadRequest* requests, size_t count)
+{
+    AutoResetEvent event;
+    AsyncReadAt(requests, count, std::bind(&AutoResetEvent::Set, &event));
+    event.Wait();
+    for (size_t i = 0; i < count; ++i) {
+        if (requests[i].result < 0)
+            return false;
+    }
+    return true;
+}
+
 FileSystem* File::GetFileSystemByPath(const std::string& file_path)
 {
     // "/mfs/abc" -> "mfs"
@@ -12,6 +12,7 @@
 #include <string>
 #include <vector>
 #include "toft/base/class_registry.h"
+#include "toft/base/functional.h"
 #include "toft/base/uncopyable.h"
 
 namespace toft {
@@ -51,6 +52,22 @@ public:
     virtual bool GetNext(FileEntry* entry) = 0;
 };
 
+// A read request of File::AsyncReadAt.
+struct FileReadRequest {
+    FileReadRequest() : offset(0), buffer(NULL), size(0), result(0), error(0) {}
+    FileReadRequest(int64_t offset, void* buffer, int64_t size)
+        : offset(offset), buffer(buffer), size(size), result(0), error(0) {}
+
+    int64_t offset;
+    void* buffer;
+    int64_t size;
+
+    // Set when completed, the same as the return value of ReadAt.
+    int64_t result;
+    // errno if result is -1.
+    int error;
+};
+
 // A abstruct object.
 //
 // All errors are reported by errno.
@@ -93,6 +110,36 @@ public:
     // Read at most max_size if no eol found.
     virtual bool ReadLine(std::string* line, size_t max_size = 65536) = 0;
 
+    // Read at most size bytes from offset into buffer, less bytes are read
+    // only if end of file is reached.
+    // Return the number of bytes read.
+    // Return -1 if error occurs.
+    //
+    // The default implementation is Seek and Read, so it moves the file
+    // pointer and is not thread safe. See IsReadAtThreadSafe.
+    virtual int64_t ReadAt(int64_t offset, void* buffer, int64_t size);
+
+    // Return true if ReadAt doesn't depend on or change the file pointer,
+    // and can be called concurrently without lock.
+    virtual bool IsReadAtThreadSafe() const {
+        return false;
+    }
+
+    // Start reading count requests asynchronously, in any order. done is
+    // called once after all of them are completed, usually in another
+    // thread, so it should return quickly. requests and their buffers must
+    // be valid until then.
+    //
+    // The default implementation calls ReadAt in a shared io thread pool,
+    // each request in its own task if IsReadAtThreadSafe, otherwise all
+    // requests in one task, and the file must not be used until done.
+    virtual void AsyncReadAt(FileReadRequest* requests, size_t count,
+                             const std::function<void ()>& done);
+
+    // Read count requests by AsyncReadAt and wait for all of them.
+    // Return false if any of them fails.
+    bool ReadAtBatch(FileReadRequest* requests, size_t count);
+
 public:
     // The returned File* object is created by new and can be deleted.
     // So it can be stored into a scoped_ptr.
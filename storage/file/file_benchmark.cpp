@@ -0,0 +1,90 @@
+// Copyright (c) 2026, The Toft Authors.
+// All rights reserved.
+//
+// Scattered 4K reads from a 64M local file, by ReadAt one by one, and by
+// ReadAtBatch with io_uring or the io thread pool. The file is mostly in
+// page cache, so it's the overhead but not the device queue depth measured.
+
+#include <stdlib.h>
+#include <string>
+#include <vector>
+#include "toft/base/scoped_ptr.h"
+#include "toft/storage/file/file.h"
+
+#include "thirdparty/benchmark/benchmark.h"
+
+namespace toft {
+namespace {
+
+const char kFilePath[] = "./file_benchmark.dat";
+const int64_t kFileSize = 64 * 1024 * 1024;
+const int kReadSize = 4096;
+
+enum Method {
+    kReadAt,
+    kBatch,
+    kThreadPoolBatch,
+};
+
+// Use the default AsyncReadAt of File.
+class ThreadPoolFile : public File {
+public:
+    explicit ThreadPoolFile(File* file) : m_file(file) {}
+    virtual int64_t Read(void*, int64_t) { return -1; }
+    virtual int64_t Write(const void*, int64_t) { return -1; }
+    virtual bool Flush() { return false; }
+    virtual bool Close() { return m_file->Close(); }
+    virtual bool Seek(int64_t, int) { return false; }
+    virtual int64_t Tell() { return -1; }
+    virtual bool ReadLine(std::string*, size_t) { return false; }
+    virtual int64_t ReadAt(int64_t offset, void* buffer, int64_t size) {
+        return m_file->ReadAt(offset, buffer, size);
+    }
+    virtual bool IsReadAtThreadSafe() const { return true; }
+private:
+    scoped_ptr<File> m_file;
+};
+
+void CreateFile() {
+    if (File::Exists(kFilePath))
+        return;
+    scoped_ptr<File> file(File::Open(kFilePath, "w"));
+    std::string block(1024 * 1024, 'x');
+    for (int64_t size = 0; size < kFileSize; size += block.size())
+        file->Write(block.data(), block.size());
+    file->Close();
+}
+
+}  // namespace
+}  // namespace toft
+
+// range(0): method.
+// range(1): number of reads in a batch.
+static void FileScatteredRead(benchmark::State& state) {
+    using namespace toft;
+    CreateFile();
+    scoped_ptr<File> file(File::Open(kFilePath, "r"));
+    if (state.range(0) == kThreadPoolBatch)
+        file.reset(new ThreadPoolFile(file.release()));
+    const int batch_size = state.range(1);
+    std::vector<char> buffer(batch_size * kReadSize);
+    std::vector<FileReadRequest> requests(batch_size);
+    unsigned seed = 0;
+    for (auto _ : state) {
+        for (int i = 0; i < batch_size; ++i) {
+            int64_t offset = rand_r(&seed) % (kFileSize / kReadSize) * kReadSize;
+            requests[i] = FileReadRequest(offset, &buffer[i * kReadSize], kReadSize);
+        }
+        if (state.range(0) == kReadAt) {
+            for (int i = 0; i < batch_size; ++i)
+                file->ReadAt(requests[i].offset, requests[i].buffer, requests[i].size);
+        } else {
+            file->ReadAtBatch(&requests[0], requests.size());
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * batch_size);
+    state.SetBytesProcessed(state.iterations() * batch_size * kReadSize);
+}
+BENCHMARK(FileScatteredRead)
+    ->ArgsProduct({{toft::kReadAt, toft::kBatch, toft::kThreadPoolBatch}, {16, 256}})
+    ->UseRealTime();
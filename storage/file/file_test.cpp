@@ -2,9 +2,17 @@
 // All rights reserved.
 // Author: CHEN Feng <chen3feng@gmail.com>
 
+#include <errno.h>
+#include <string.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "toft/base/functional.h"
 #include "toft/base/scoped_ptr.h"
 #include "toft/storage/file/file.h"
 #include "toft/storage/file/local_file.h"
+#include "toft/system/threading/event.h"
 
 #include "thirdparty/gtest/gtest.h"
 
@@ -85,6 +93,138 @@ TEST_F(FileTest, Seek) {
     EXPECT_EQ(0, memcmp(buffer, "world", 5));
 }
 
+TEST_F(FileTest, ReadAt) {
+    scoped_ptr<File> fp(File::Open(kFileName, "r"));
+    EXPECT_TRUE(fp->IsReadAtThreadSafe());
+    char buffer[5];
+    EXPECT_EQ(5, fp->ReadAt(17, buffer, sizeof(buffer)));
+    EXPECT_EQ(0, memcmp(buffer, "world", 5));
+    // File pointer is not changed.
+    EXPECT_EQ(0, fp->Tell());
+    EXPECT_EQ(5, fp->Read(buffer, sizeof(buffer)));
+    EXPECT_EQ(0, memcmp(buffer, "hello", 5));
+    // Read to the end of file.
+    EXPECT_EQ(2, fp->ReadAt(35, buffer, sizeof(buffer)));
+    EXPECT_EQ(0, fp->ReadAt(100, buffer, sizeof(buffer)));
+}
+
+// Forward to a File, but ReadAt can't be called concurrently.
+class UnsafeReadAtFile : public File {
+public:
+    explicit UnsafeReadAtFile(File* file) : m_file(file) {}
+    virtual int64_t Read(void* buffer, int64_t size) {
+        return m_file->Read(buffer, size);
+    }
+    virtual int64_t Write(const void* buffer, int64_t size) {
+        return m_file->Write(buffer, size);
+    }
+    virtual bool Flush() { return m_file->Flush(); }
+    virtual bool Close() { return m_file->Close(); }
+    virtual bool Seek(int64_t offset, int whence) {
+        return m_file->Seek(offset, whence);
+    }
+    virtual int64_t Tell() { return m_file->Tell(); }
+    virtual bool ReadLine(std::string* line, size_t max_size) {
+        return m_file->ReadLine(line, max_size);
+    }
+private:
+    scoped_ptr<File> m_file;
+};
+
+// Read 1000 requests of 1000 bytes from a file, more than io_uring can hold,
+// in reverse order, and some beyond end of file.
+static void ExpectReadAtBatch(File* fp, const std::string& content) {
+    const int kCount = 1000;
+    std::vector<std::string> buffers(kCount, std::string(1000, '\0'));
+    std::vector<FileReadRequest> requests;
+    for (int i = 0; i < kCount; ++i) {
+        requests.push_back(FileReadRequest((kCount - 1 - i) * 997, &buffers[i][0],
+                                           buffers[i].size()));
+    }
+    ASSERT_TRUE(fp->ReadAtBatch(&requests[0], requests.size()));
+    for (int i = 0; i < kCount; ++i) {
+        int64_t offset = requests[i].offset;
+        std::string expected = content.substr(std::min<size_t>(offset, content.size()), 1000);
+        ASSERT_EQ(static_cast<int64_t>(expected.size()), requests[i].result) << i;
+        ASSERT_EQ(expected, buffers[i].substr(0, expected.size())) << i;
+    }
+}
+
+class AsyncReadAtTest : public testing::Test {
+protected:
+    void SetUp() {
+        for (int i = 0; m_content.size() < 900000; ++i) {
+            m_content += "line " + std::string(i % 100, 'x') + "\n";
+        }
+        scoped_ptr<File> fp(File::Open("async_read.dat", "w"));
+        ASSERT_EQ(static_cast<int64_t>(m_content.size()),
+                  fp->Write(m_content.data(), m_content.size()));
+    }
+    void TearDown() {
+        File::Delete("async_read.dat");
+    }
+    std::string m_content;
+};
+
+TEST_F(AsyncReadAtTest, LocalFile) {
+    scoped_ptr<File> fp(File::Open("async_read.dat", "r"));
+    ExpectReadAtBatch(fp.get(), m_content);
+}
+
+TEST_F(AsyncReadAtTest, ThreadPool) {
+    // LocalFile uses the default implementation if io_uring is unavailable.
+    class ThreadPoolFile : public UnsafeReadAtFile {
+    public:
+        explicit ThreadPoolFile(File* file) : UnsafeReadAtFile(file), m_file(file) {}
+        virtual int64_t ReadAt(int64_t offset, void* buffer, int64_t size) {
+            return m_file->ReadAt(offset, buffer, size);
+        }
+        virtual bool IsReadAtThreadSafe() const { return true; }
+    private:
+        File* m_file;
+    };
+    ThreadPoolFile file(File::Open("async_read.dat", "r"));
+    ExpectReadAtBatch(&file, m_content);
+}
+
+TEST_F(AsyncReadAtTest, UnsafeReadAt) {
+    UnsafeReadAtFile file(File::Open("async_read.dat", "r"));
+    EXPECT_FALSE(file.IsReadAtThreadSafe());
+    ExpectReadAtBatch(&file, m_content);
+}
+
+TEST_F(AsyncReadAtTest, Empty) {
+    scoped_ptr<File> fp(File::Open("async_read.dat", "r"));
+    EXPECT_TRUE(fp->ReadAtBatch(NULL, 0));
+}
+
+TEST_F(AsyncReadAtTest, Error) {
+    scoped_ptr<File> fp(File::Open("testdata/dir", "r"));
+    ASSERT_TRUE(fp);
+    char buffer[10];
+    FileReadRequest request(0, buffer, sizeof(buffer));
+    EXPECT_FALSE(fp->ReadAtBatch(&request, 1));
+    EXPECT_EQ(-1, request.result);
+    EXPECT_EQ(EISDIR, request.error);
+}
+
+static void ReadAgain(File* fp, FileReadRequest* request, AutoResetEvent* event) {
+    request->offset += 1000;
+    fp->AsyncReadAt(request, 1, std::bind(&AutoResetEvent::Set, event));
+}
+
+// Done callbacks may start more reads.
+TEST_F(AsyncReadAtTest, ReadInDone) {
+    scoped_ptr<File> fp(File::Open("async_read.dat", "r"));
+    char buffer[10];
+    FileReadRequest request(0, buffer, sizeof(buffer));
+    AutoResetEvent event;
+    fp->AsyncReadAt(&request, 1, std::bind(ReadAgain, fp.get(), &request, &event));
+    event.Wait();
+    EXPECT_EQ(10, request.result);
+    EXPECT_EQ(m_content.substr(1000, 10), std::string(buffer, 10));
+}
+
 TEST_F(FileTest, Tell) {
     scoped_ptr<File> fp(File::Open(kFileName, "r"));
     ASSERT_EQ(0, fp->Tell());
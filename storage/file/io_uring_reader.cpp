@@ -0,0 +1,337 @@
+// Copyright (c) 2026, The Toft Authors.
+// All rights reserved.
+//
+// Ring setup, submission and completion of IoUringReader.
+
+#include "toft/storage/file/io_uring_reader.h"
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <algorithm>
+#include <vector>
+
+#include "toft/storage/file/file.h"
+#include "toft/system/threading/this_thread.h"
+
+#if defined __linux__ && defined __NR_io_uring_setup
+#include <linux/io_uring.h>
+#define TOFT_HAS_IO_URING 1
+#endif
+
+namespace toft {
+
+#ifdef TOFT_HAS_IO_URING
+
+namespace {
+
+const unsigned kRingEntries = 256;
+
+} // namespace
+
+struct IoUringReader::Batch {
+    size_t remaining; // Under m_mutex
+    std::function<void ()> done;
+    std::vector<Operation> operations;
+};
+
+struct IoUringReader::Operation {
+    Batch* batch;
+    int fd;
+    FileReadRequest* request;
+    int64_t bytes_read;
+    struct iovec iov;
+};
+
+IoUringReader* IoUringReader::GetInstance()
+{
+    struct Creator {
+        static IoUringReader* Create() {
+            IoUringReader* reader = new IoUringReader();
+            if (!reader->Initialize(kRingEntries)) {
+                delete reader;
+                return NULL;
+            }
+            return reader;
+        }
+    };
+    // Never deleted, the completion thread runs until exit.
+    static IoUringReader* instance = Creator::Create();
+    return instance;
+}
+
+IoUringReader::IoUringReader()
+    : m_ring_fd(-1),
+      m_sq_ring(NULL), m_sq_ring_size(0),
+      m_cq_ring(NULL), m_cq_ring_size(0),
+      m_sqes(NULL), m_sqes_size(0),
+      m_sq_tail(NULL), m_sq_mask(0), m_sq_array(NULL), m_sq_entries(0),
+      m_cq_head(NULL), m_cq_tail(NULL), m_cq_mask(0), m_cqes(NULL),
+      m_inflight(0), m_broken(false), m_error(0)
+{
+}
+
+IoUringReader::~IoUringReader()
+{
+    if (m_sqes != NULL)
+        munmap(m_sqes, m_sqes_size);
+    if (m_cq_ring != NULL && m_cq_ring != m_sq_ring)
+        munmap(m_cq_ring, m_cq_ring_size);
+    if (m_sq_ring != NULL)
+        munmap(m_sq_ring, m_sq_ring_size);
+    if (m_ring_fd >= 0)
+        close(m_ring_fd);
+}
+
+bool IoUringReader::Initialize(unsigned entries)
+{
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    m_ring_fd = syscall(__NR_io_uring_setup, entries, &params);
+    if (m_ring_fd < 0)
+        return false;
+
+    m_sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    m_cq_ring_size = params.cq_off.cqes +
+                     params.cq_entries * sizeof(struct io_uring_cqe);
+    bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_mmap)
+        m_sq_ring_size = m_cq_ring_size = std::max(m_sq_ring_size, m_cq_ring_size);
+    void* sq_ring = mmap(NULL, m_sq_ring_size, PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_POPULATE, m_ring_fd, IORING_OFF_SQ_RING);
+    if (sq_ring == MAP_FAILED)
+        return false;
+    m_sq_ring = sq_ring;
+    if (single_mmap) {
+        m_cq_ring = m_sq_ring;
+    } else {
+        void* cq_ring = mmap(NULL, m_cq_ring_size, PROT_READ | PROT_WRITE,
+                             MAP_SHARED | MAP_POPULATE, m_ring_fd, IORING_OFF_CQ_RING);
+        if (cq_ring == MAP_FAILED)
+            return false;
+        m_cq_ring = cq_ring;
+    }
+    m_sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    void* sqes = mmap(NULL, m_sqes_size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, m_ring_fd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED)
+        return false;
+    m_sqes = sqes;
+
+    char* sq = static_cast<char*>(m_sq_ring);
+    m_sq_tail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    m_sq_mask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    m_sq_array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    m_sq_entries = params.sq_entries;
+    char* cq = static_cast<char*>(m_cq_ring);
+    m_cq_head = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    m_cq_tail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    m_cq_mask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    m_cqes = cq + params.cq_off.cqes;
+
+    m_thread.Start(std::bind(&IoUringReader::ReapCompletions, this));
+    return true;
+}
+
+bool IoUringReader::Read(int fd, FileReadRequest* requests, size_t count,
+                         const std::function<void ()>& done)
+{
+    if (count == 0) {
+        done();
+        return true;
+    }
+    Batch* batch = new Batch();
+    batch->remaining = count;
+    batch->done = done;
+    batch->operations.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        Operation* operation = &batch->operations[i];
+        operation->batch = batch;
+        operation->fd = fd;
+        operation->request = &requests[i];
+        operation->bytes_read = 0;
+    }
+
+    std::vector<Batch*> done_batches;
+    {
+        MutexLocker locker(&m_mutex);
+        if (m_broken) {
+            delete batch;
+            return false;
+        }
+        for (size_t i = 0; i < count; ++i)
+            m_pending.push_back(&batch->operations[i]);
+        SubmitPending(&done_batches);
+    }
+    // Not empty only if it's broken just now.
+    RunDone(&done_batches);
+    return true;
+}
+
+void IoUringReader::PrepareRead(Operation* operation)
+{
+    FileReadRequest* request = operation->request;
+    operation->iov.iov_base = static_cast<char*>(request->buffer) + operation->bytes_read;
+    operation->iov.iov_len = request->size - operation->bytes_read;
+
+    // Only submitters with m_mutex write the tail.
+    unsigned tail = *m_sq_tail;
+    unsigned index = tail & m_sq_mask;
+    struct io_uring_sqe* sqe = static_cast<struct io_uring_sqe*>(m_sqes) + index;
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = IORING_OP_READV;
+    sqe->fd = operation->fd;
+    sqe->addr = reinterpret_cast<uint64_t>(&operation->iov);
+    sqe->len = 1;
+    sqe->off = request->offset + operation->bytes_read;
+    sqe->user_data = reinterpret_cast<uint64_t>(operation);
+    m_sq_array[index] = index;
+    __atomic_store_n(m_sq_tail, tail + 1, __ATOMIC_RELEASE);
+}
+
+void IoUringReader::SubmitPending(std::vector<Batch*>* done_batches)
+{
+    // At most as many operations as submission entries are in flight, and
+    // the completion queue is twice as large, so it never overflows.
+    unsigned count = 0;
+    while (!m_pending.empty() && m_inflight < m_sq_entries) {
+        PrepareRead(m_pending.front());
+        m_pending.pop_front();
+        ++m_inflight;
+        ++count;
+    }
+    while (count > 0) {
+        int ret = syscall(__NR_io_uring_enter, m_ring_fd, count, 0, 0, NULL, 0);
+        if (ret < 0) {
+            if (errno == EINTR || errno == EAGAIN || errno == EBUSY)
+                continue;
+            Break(errno, count, done_batches);
+            return;
+        }
+        count -= ret;
+    }
+}
+
+void IoUringReader::Break(int error, unsigned num_unsubmitted,
+                          std::vector<Batch*>* done_batches)
+{
+    if (!m_broken) {
+        m_broken = true;
+        m_error = error;
+    }
+    // Take back the entries not consumed by the kernel, they are the last
+    // ones before the tail. Without SQPOLL, the kernel only reads them in
+    // io_uring_enter, which is called under m_mutex.
+    unsigned tail = *m_sq_tail;
+    for (unsigned i = 0; i < num_unsubmitted; ++i) {
+        --tail;
+        const struct io_uring_sqe* sqe =
+            static_cast<const struct io_uring_sqe*>(m_sqes) + (tail & m_sq_mask);
+        --m_inflight;
+        Fail(reinterpret_cast<Operation*>(sqe->user_data), m_error, done_batches);
+    }
+    __atomic_store_n(m_sq_tail, tail, __ATOMIC_RELEASE);
+    while (!m_pending.empty()) {
+        Fail(m_pending.front(), m_error, done_batches);
+        m_pending.pop_front();
+    }
+}
+
+void IoUringReader::Fail(Operation* operation, int error, std::vector<Batch*>* done_batches)
+{
+    operation->request->result = -1;
+    operation->request->error = error;
+    if (--operation->batch->remaining == 0)
+        done_batches->push_back(operation->batch);
+}
+
+void IoUringReader::RunDone(std::vector<Batch*>* done_batches)
+{
+    for (size_t i = 0; i < done_batches->size(); ++i) {
+        (*done_batches)[i]->done();
+        delete (*done_batches)[i];
+    }
+    done_batches->clear();
+}
+
+bool IoUringReader::Complete(Operation* operation, int result)
+{
+    FileReadRequest* request = operation->request;
+    if (result == -EINTR || result == -EAGAIN) {
+        m_pending.push_front(operation);
+        return false;
+    }
+    if (result < 0) {
+        request->result = -1;
+        request->error = -result;
+        return true;
+    }
+    operation->bytes_read += result;
+    // Like pread, less bytes may be read without end of file.
+    if (result > 0 && operation->bytes_read < request->size) {
+        m_pending.push_front(operation);
+        return false;
+    }
+    request->result = operation->bytes_read;
+    request->error = 0;
+    return true;
+}
+
+void IoUringReader::ReapCompletions()
+{
+    std::vector<Batch*> done_batches;
+    for (;;) {
+        int ret = syscall(__NR_io_uring_enter, m_ring_fd, 0, 1,
+                          IORING_ENTER_GETEVENTS, NULL, 0);
+        int error = ret < 0 ? errno : 0;
+        bool failed = ret < 0 && error != EINTR && error != EAGAIN && error != EBUSY;
+        {
+            MutexLocker locker(&m_mutex);
+            unsigned head = *m_cq_head;
+            unsigned tail = __atomic_load_n(m_cq_tail, __ATOMIC_ACQUIRE);
+            for (; head != tail; ++head) {
+                const struct io_uring_cqe* cqe =
+                    static_cast<const struct io_uring_cqe*>(m_cqes) + (head & m_cq_mask);
+                Operation* operation = reinterpret_cast<Operation*>(cqe->user_data);
+                --m_inflight;
+                if (Complete(operation, cqe->res) && --operation->batch->remaining == 0)
+                    done_batches.push_back(operation->batch);
+            }
+            __atomic_store_n(m_cq_head, head, __ATOMIC_RELEASE);
+            if (failed)
+                Break(error, 0, &done_batches);
+            else
+                SubmitPending(&done_batches);
+            if (m_broken && m_inflight == 0)
+                break;
+        }
+        // Out of lock, done may read more.
+        RunDone(&done_batches);
+        // Submitted operations are still completed by the kernel, poll them.
+        if (failed)
+            ThisThread::Sleep(1);
+    }
+    RunDone(&done_batches);
+}
+
+#else // TOFT_HAS_IO_URING
+
+IoUringReader* IoUringReader::GetInstance()
+{
+    return NULL;
+}
+
+bool IoUringReader::Read(int, FileReadRequest*, size_t, const std::function<void ()>&)
+{
+    abort(); // Never called, there is no instance.
+    return false;
+}
+
+#endif // TOFT_HAS_IO_URING
+
+} // namespace toft
@@ -0,0 +1,93 @@
+// Copyright (c) 2026, The Toft Authors.
+// All rights reserved.
+//
+// Asynchronous reading of local files by io_uring.
+
+#ifndef TOFT_STORAGE_FILE_IO_URING_READER_H
+#define TOFT_STORAGE_FILE_IO_URING_READER_H
+#pragma once
+
+#include <stddef.h>
+#include <deque>
+#include <vector>
+#include "toft/base/functional.h"
+#include "toft/base/uncopyable.h"
+#include "toft/system/threading/mutex.h"
+#include "toft/system/threading/thread.h"
+
+namespace toft {
+
+struct FileReadRequest;
+
+// Read local files by a process wide io_uring of linux, completions are
+// reaped by a background thread. Used by LocalFile::AsyncReadAt.
+//
+// Requests more than the ring can hold are queued and submitted when
+// previous ones are completed, so Read never blocks, and can also be called
+// in done callbacks.
+//
+// If io_uring_enter fails unexpectedly, the reader is broken: requests not
+// submitted yet are failed with the error, and later Read returns false.
+class IoUringReader {
+    TOFT_DECLARE_UNCOPYABLE(IoUringReader);
+
+public:
+    // Return NULL if io_uring is not supported by the system or the kernel,
+    // or is not allowed, such as in some containers.
+    static IoUringReader* GetInstance();
+
+    // Same as File::AsyncReadAt, for fd. Return false without reading if
+    // the reader is broken, the caller should read in other ways.
+    bool Read(int fd, FileReadRequest* requests, size_t count,
+              const std::function<void ()>& done);
+
+private:
+    struct Batch;
+    struct Operation;
+
+    IoUringReader();
+    ~IoUringReader();
+    bool Initialize(unsigned entries);
+    void PrepareRead(Operation* operation);
+    // Batches whose operations are all completed are added to done_batches,
+    // their done should be called out of m_mutex.
+    void SubmitPending(std::vector<Batch*>* done_batches);
+    // Return true if the operation is completed, false if it is pending
+    // again for retry or reading the rest.
+    bool Complete(Operation* operation, int result);
+    // Mark the reader broken, fail the operations not submitted yet.
+    void Break(int error, unsigned num_unsubmitted, std::vector<Batch*>* done_batches);
+    void Fail(Operation* operation, int error, std::vector<Batch*>* done_batches);
+    static void RunDone(std::vector<Batch*>* done_batches);
+    void ReapCompletions();
+
+private:
+    int m_ring_fd;
+    void* m_sq_ring;
+    size_t m_sq_ring_size;
+    void* m_cq_ring;
+    size_t m_cq_ring_size;
+    void* m_sqes;
+    size_t m_sqes_size;
+
+    unsigned* m_sq_tail;
+    unsigned m_sq_mask;
+    unsigned* m_sq_array;
+    unsigned m_sq_entries;
+    unsigned* m_cq_head;
+    unsigned* m_cq_tail;
+    unsigned m_cq_mask;
+    void* m_cqes;
+
+    Mutex m_mutex; // Protects submission and fields below.
+    unsigned m_inflight;
+    std::deque<Operation*> m_pending;
+    bool m_broken;
+    int m_error; // The error broke the reader.
+
+    Thread m_thread;
+};
+
+} // namespace toft
+
+#endif // TOFT_STORAGE_FILE_IO_URING_READER_H
@@ -10,12 +10,14 @@
 #include "toft/storage/file/local_file.h"
 
 #include <dirent.h>
+#include <errno.h>
 #include <string.h>
 #include <unistd.h>
 #include <sys/stat.h>
 
 #include "toft/base/string/algorithm.h"
 #include "toft/base/unique_ptr.h"
+#include "toft/storage/file/io_uring_reader.h"
 #include "toft/storage/path/path.h"
 #include "toft/text/wildcard.h"
 
@@ -200,6 +202,35 @@ int64_t LocalFile::Tell()
     return ftello(m_fp);
 }
 
+int64_t LocalFile::ReadAt(int64_t offset, void* buffer, int64_t size)
+{
+    int fd = fileno(m_fp);
+    int64_t total = 0;
+    while (total < size) {
+        ssize_t nread = pread(fd, static_cast<char*>(buffer) + total,
+                              size - total, offset + total);
+        if (nread < 0) {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+        if (nread == 0)
+            break;
+        total += nread;
+    }
+    return total;
+}
+
+void LocalFile::AsyncReadAt(FileReadRequest* requests, size_t count,
+                            const std::function<void ()>& done)
+{
+    IoUringReader* reader = IoUringReader::GetInstance();
+    if (reader != NULL && reader->Read(fileno(m_fp), requests, count, done))
+        return;
+    // Not supported or broken, read in the io thread pool.
+    File::AsyncReadAt(requests, count, done);
+}
+
 bool LocalFile::ReadLine(std::string* line, size_t max_size)
 {
     line->resize(max_size + 1);
@@ -42,6 +42,16 @@ public:
     virtual bool Seek(int64_t offset, int whence);
     virtual int64_t Tell();
     virtual bool ReadLine(std::string* line, size_t max_size);
+
+    // By pread, data buffered by Write is not visible until Flush.
+    virtual int64_t ReadAt(int64_t offset, void* buffer, int64_t size);
+    virtual bool IsReadAtThreadSafe() const {
+        return true;
+    }
+
+    // By io_uring if supported, otherwise by pread in the io thread pool.
+    virtual void AsyncReadAt(FileReadRequest* requests, size_t count,
+                             const std::function<void ()>& done);
 private:
     FILE* m_fp;
 };
@@ -0,0 +1,90 @@
+// Copyright (c) 2026, The Toft Authors.
+// All rights reserved.
+//
+// mmap, madvise and munmap of MemoryMappedFile.
+
+#ifndef _FILE_OFFSET_BITS
+#define _FILE_OFFSET_BITS 64
+#endif
+
+#include "toft/storage/file/memory_mapped_file.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace toft {
+
+// Non NULL address for mapped empty file.
+static const char kEmptyData[1] = "";
+
+MemoryMappedFile::MemoryMappedFile() : m_data(NULL), m_size(0), m_empty(false)
+{
+}
+
+MemoryMappedFile::~MemoryMappedFile()
+{
+    Close();
+}
+
+bool MemoryMappedFile::Open(const std::string& file_path)
+{
+    Close();
+    int fd = open(file_path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat buf;
+    if (fstat(fd, &buf) < 0 || !S_ISREG(buf.st_mode)) {
+        close(fd);
+        return false;
+    }
+    if (buf.st_size == 0) {
+        close(fd);
+        m_data = kEmptyData;
+        m_empty = true;
+        return true;
+    }
+    void* data = mmap(NULL, buf.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    // The mapping is still valid after the fd is closed.
+    close(fd);
+    if (data == MAP_FAILED)
+        return false;
+    m_data = static_cast<const char*>(data);
+    m_size = buf.st_size;
+    return true;
+}
+
+void MemoryMappedFile::Close()
+{
+    if (m_data != NULL && !m_empty)
+        munmap(const_cast<char*>(m_data), m_size);
+    m_data = NULL;
+    m_size = 0;
+    m_empty = false;
+}
+
+bool MemoryMappedFile::GetRange(size_t offset, size_t length, StringPiece* range) const
+{
+    if (offset > m_size || length > m_size - offset)
+        return false;
+    range->set(m_data + offset, length);
+    return true;
+}
+
+bool MemoryMappedFile::Advise(size_t offset, size_t length, Advice advice) const
+{
+    if (offset > m_size || length > m_size - offset)
+        return false;
+    if (length == 0)
+        return true;
+    int advices[] = {
+        MADV_NORMAL, MADV_SEQUENTIAL, MADV_RANDOM, MADV_WILLNEED, MADV_DONTNEED
+    };
+    size_t page_size = sysconf(_SC_PAGESIZE);
+    size_t begin = offset / page_size * page_size;
+    return madvise(const_cast<char*>(m_data) + begin, offset + length - begin,
+                   advices[advice]) == 0;
+}
+
+} // namespace toft
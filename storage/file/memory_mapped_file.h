@@ -0,0 +1,71 @@
+// Copyright (c) 2026, The Toft Authors.
+// All rights reserved.
+//
+// Read only memory mapping of local files.
+
+#ifndef TOFT_STORAGE_FILE_MEMORY_MAPPED_FILE_H
+#define TOFT_STORAGE_FILE_MEMORY_MAPPED_FILE_H
+#pragma once
+
+#include <stddef.h>
+#include <string>
+
+#include "toft/base/string/string_piece.h"
+#include "toft/base/uncopyable.h"
+
+namespace toft {
+
+// Map a whole local file into memory for reading.
+//
+// The mapped memory can be read by multiple threads concurrently without
+// any lock or system call, pages are loaded by the kernel on demand.
+class MemoryMappedFile {
+    TOFT_DECLARE_UNCOPYABLE(MemoryMappedFile);
+
+public:
+    // How the mapped memory will be accessed, see madvise(2).
+    enum Advice {
+        kAdviceNormal,
+        kAdviceSequential,  // Read ahead aggressively, free pages after read
+        kAdviceRandom,      // Don't read ahead
+        kAdviceWillNeed,    // Load the range in background
+        kAdviceDontNeed,    // Free pages of the range
+    };
+
+    MemoryMappedFile();
+    ~MemoryMappedFile();
+
+    // Map the file read only, return false if failed. Only files on local
+    // file system can be mapped.
+    bool Open(const std::string& file_path);
+
+    // Unmap the file, can be called multiple times.
+    void Close();
+
+    bool IsOpen() const {
+        return m_data != NULL;
+    }
+
+    const char* data() const {
+        return m_data;
+    }
+    size_t size() const {
+        return m_size;
+    }
+
+    // Get a range of the mapped memory, return false if it's out of range.
+    bool GetRange(size_t offset, size_t length, StringPiece* range) const;
+
+    // Advise the kernel about a range, which is extended to page boundaries.
+    // It's only a hint, return false if the range is invalid or failed.
+    bool Advise(size_t offset, size_t length, Advice advice) const;
+
+private:
+    const char* m_data;
+    size_t m_size;
+    bool m_empty;  // Empty file can't be mapped
+};
+
+} // namespace toft
+
+#endif // TOFT_STORAGE_FILE_MEMORY_MAPPED_FILE_H
@@ -0,0 +1,66 @@
+// Copyright (c) 2026, The Toft Authors.
+// All rights reserved.
+//
+// Tests of MemoryMappedFile.
+
+#include "toft/storage/file/memory_mapped_file.h"
+
+#include <stdio.h>
+
+#include "thirdparty/gtest/gtest.h"
+
+namespace toft {
+
+TEST(MemoryMappedFile, Open) {
+    MemoryMappedFile file;
+    EXPECT_FALSE(file.IsOpen());
+    ASSERT_TRUE(file.Open("testdata/testfile.txt"));
+    EXPECT_TRUE(file.IsOpen());
+    EXPECT_EQ("helloworld1\nhelloworld2\nhelloworld3\n\n",
+              std::string(file.data(), file.size()));
+    file.Close();
+    EXPECT_FALSE(file.IsOpen());
+    file.Close();
+}
+
+TEST(MemoryMappedFile, OpenError) {
+    MemoryMappedFile file;
+    EXPECT_FALSE(file.Open("non-exist.dat"));
+    EXPECT_FALSE(file.Open("testdata/dir"));
+    EXPECT_FALSE(file.IsOpen());
+}
+
+TEST(MemoryMappedFile, Empty) {
+    fclose(fopen("empty.dat", "w"));
+    MemoryMappedFile file;
+    ASSERT_TRUE(file.Open("empty.dat"));
+    EXPECT_TRUE(file.IsOpen());
+    EXPECT_EQ(0U, file.size());
+    StringPiece range;
+    EXPECT_TRUE(file.GetRange(0, 0, &range));
+    EXPECT_FALSE(file.GetRange(0, 1, &range));
+    remove("empty.dat");
+}
+
+TEST(MemoryMappedFile, GetRange) {
+    MemoryMappedFile file;
+    ASSERT_TRUE(file.Open("testdata/testfile.txt"));
+    StringPiece range;
+    ASSERT_TRUE(file.GetRange(5, 5, &range));
+    EXPECT_EQ("world", range);
+    ASSERT_TRUE(file.GetRange(file.size(), 0, &range));
+    EXPECT_TRUE(range.empty());
+    EXPECT_FALSE(file.GetRange(file.size() - 1, 2, &range));
+    EXPECT_FALSE(file.GetRange(file.size() + 1, 0, &range));
+}
+
+TEST(MemoryMappedFile, Advise) {
+    MemoryMappedFile file;
+    ASSERT_TRUE(file.Open("testdata/testfile.txt"));
+    EXPECT_TRUE(file.Advise(0, file.size(), MemoryMappedFile::kAdviceSequential));
+    EXPECT_TRUE(file.Advise(5, 5, MemoryMappedFile::kAdviceWillNeed));
+    EXPECT_TRUE(file.Advise(0, 0, MemoryMappedFile::kAdviceRandom));
+    EXPECT_FALSE(file.Advise(file.size() - 1, 2, MemoryMappedFile::kAdviceNormal));
+}
+
+} // namespace toft
@@ -0,0 +1,92 @@
+// Copyright (C) 2026, The Toft Authors.
+//
+// Description: splitting RecordIO files and scanning the splits on ThreadPool.
+
+#include "toft/storage/recordio/parallel_scan.h"
+
+#include <algorithm>
+
+#include "toft/base/scoped_ptr.h"
+#include "toft/storage/file/file.h"
+#include "toft/storage/recordio/recordio.h"
+#include "toft/system/atomic/atomic.h"
+#include "toft/system/threading/parallel_for.h"
+
+#include "thirdparty/glog/logging.h"
+
+namespace toft {
+
+namespace {
+
+bool ScanSplit(const std::string& file_path, const RecordFileSplit& split,
+               size_t split_index,
+               const std::function<void (size_t, const StringPiece&)>& callback) {
+    scoped_ptr<File> file(File::Open(file_path, "r"));
+    if (file == NULL) {
+        LOG(ERROR) << "Open " << file_path << " error.";
+        return false;
+    }
+    RecordReader reader(file.get());
+    if (!reader.ResetRange(split.start, split.end)) {
+        return false;
+    }
+    int ret;
+    while ((ret = reader.Next()) == 1) {
+        StringPiece record;
+        reader.ReadRecord(&record);
+        callback(split_index, record);
+    }
+    return ret == 0;
+}
+
+void ScanSplits(const std::string* file_path,
+                const std::vector<RecordFileSplit>* splits,
+                const std::function<void (size_t, const StringPiece&)>* callback,
+                Atomic<bool>* failed,
+                size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+        if (!ScanSplit(*file_path, (*splits)[i], i, *callback)) {
+            *failed = true;
+        }
+    }
+}
+
+} // namespace
+
+bool SplitRecordFile(const std::string& file_path, int64_t split_size,
+                     std::vector<RecordFileSplit>* splits) {
+    CHECK_GT(split_size, 0);
+    splits->clear();
+    scoped_ptr<File> file(File::Open(file_path, "r"));
+    if (file == NULL) {
+        LOG(ERROR) << "Open " << file_path << " error.";
+        return false;
+    }
+    RecordReader reader(file.get());
+    if (!reader.Reset()) {
+        return false;
+    }
+    int64_t file_size = reader.file_size();
+    if (!reader.is_framed()) {
+        split_size = std::max<int64_t>(file_size, 1);
+    }
+    for (int64_t start = 0; start < file_size || start == 0; start += split_size) {
+        RecordFileSplit split;
+        split.start = start;
+        split.end = std::min(start + split_size, file_size);
+        splits->push_back(split);
+    }
+    return true;
+}
+
+bool ParallelScanRecords(ThreadPool* pool, const std::string& file_path,
+                         const std::vector<RecordFileSplit>& splits,
+                         const std::function<void (size_t, const StringPiece&)>& callback) {
+    using namespace std::placeholders;
+    Atomic<bool> failed(false);
+    ParallelFor(pool, 0, splits.size(), 1,
+                std::bind(ScanSplits, &file_path, &splits, &callback, &failed, _1, _2));
+    return !failed;
+}
+
+} // namespace toft
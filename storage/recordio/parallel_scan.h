@@ -0,0 +1,53 @@
+// Copyright (C) 2026, The Toft Authors.
+//
+// Description: scan splits of a RecordIO file in parallel.
+
+#ifndef TOFT_STORAGE_RECORDIO_PARALLEL_SCAN_H
+#define TOFT_STORAGE_RECORDIO_PARALLEL_SCAN_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "toft/base/functional.h"
+#include "toft/base/string/string_piece.h"
+
+namespace toft {
+
+class ThreadPool;
+
+// A byte range of a file, records starting in it belong to the split.
+struct RecordFileSplit {
+    int64_t start;
+    int64_t end;
+};
+
+// Divide a RecordIO file into splits of about split_size bytes. Legacy
+// files can't be split, there is only one split for them.
+bool SplitRecordFile(const std::string& file_path, int64_t split_size,
+                     std::vector<RecordFileSplit>* splits);
+
+// Call callback(split_index, record) for each record of the file.
+//
+// Splits are read by threads of pool and the calling thread in parallel,
+// each by its own File and RecordReader. Records of a split are passed in
+// the file order in one thread, so the callback can collect results of a
+// split without lock, but it must be thread safe among splits.
+//
+// Return false if the file can't be opened or any split fails to read.
+//
+// Example:
+//   std::vector<RecordFileSplit> splits;
+//   SplitRecordFile(path, 64 * 1024 * 1024, &splits);
+//   std::vector<int64_t> counts(splits.size());
+//   ParallelScanRecords(&pool, path, splits,
+//                       std::bind(CountRecord, &counts, _1, _2));
+bool ParallelScanRecords(ThreadPool* pool, const std::string& file_path,
+                         const std::vector<RecordFileSplit>& splits,
+                         const std::function<void (size_t, const StringPiece&)>& callback);
+
+} // namespace toft
+
+#endif // TOFT_STORAGE_RECORDIO_PARALLEL_SCAN_H
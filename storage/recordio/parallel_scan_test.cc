@@ -0,0 +1,116 @@
+// Copyright (C) 2026, The Toft Authors.
+//
+// Description: tests of SplitRecordFile and ParallelScanRecords.
+
+#include "toft/storage/recordio/parallel_scan.h"
+
+#include <string>
+#include <vector>
+
+#include "thirdparty/gtest/gtest.h"
+#include "toft/base/scoped_ptr.h"
+#include "toft/base/string/number.h"
+#include "toft/storage/file/file.h"
+#include "toft/storage/recordio/recordio.h"
+#include "toft/system/threading/thread_pool.h"
+
+namespace toft {
+
+const char kFilePath[] = "./test_parallel_scan.dat";
+const int kRecordCount = 10000;
+
+void WriteRecords(RecordWriter* writer) {
+    for (int i = 0; i < kRecordCount; ++i) {
+        ASSERT_TRUE(writer->WriteRecord(NumberToString(i)));
+    }
+    ASSERT_TRUE(writer->Finish());
+}
+
+void CollectRecord(std::vector<std::vector<int> >* results,
+                   size_t split_index, const StringPiece& record) {
+    int i;
+    ASSERT_TRUE(StringToNumber(record.as_string(), &i));
+    (*results)[split_index].push_back(i);
+}
+
+void IgnoreRecord(size_t, const StringPiece&) {
+}
+
+// Records of splits are in the file order, each record is scanned once.
+void ExpectScanned(ThreadPool* pool, int64_t split_size, size_t min_split_count) {
+    std::vector<RecordFileSplit> splits;
+    ASSERT_TRUE(SplitRecordFile(kFilePath, split_size, &splits));
+    EXPECT_GE(splits.size(), min_split_count);
+    std::vector<std::vector<int> > results(splits.size());
+    using namespace std::placeholders;
+    ASSERT_TRUE(ParallelScanRecords(pool, kFilePath, splits,
+                                    std::bind(CollectRecord, &results, _1, _2)));
+    int next = 0;
+    for (size_t i = 0; i < results.size(); ++i) {
+        for (size_t j = 0; j < results[i].size(); ++j) {
+            ASSERT_EQ(next, results[i][j]);
+            ++next;
+        }
+    }
+    EXPECT_EQ(kRecordCount, next);
+}
+
+class ParallelScanTest : public ::testing::Test {
+protected:
+    ParallelScanTest() : m_pool(4) {}
+    virtual void TearDown() {
+        File::Delete(kFilePath);
+    }
+
+protected:
+    ThreadPool m_pool;
+};
+
+TEST_F(ParallelScanTest, Framed) {
+    {
+        scoped_ptr<File> file(File::Open(kFilePath, "w"));
+        RecordWriterOptions options;
+        options.block_size = 1024;
+        RecordWriter writer(file.get(), options);
+        WriteRecords(&writer);
+    }
+    ExpectScanned(&m_pool, 1000, 50);
+    ExpectScanned(&m_pool, 4096, 10);
+    ExpectScanned(NULL, 4096, 10);
+}
+
+TEST_F(ParallelScanTest, Compressed) {
+    {
+        scoped_ptr<File> file(File::Open(kFilePath, "w"));
+        RecordWriterOptions options;
+        options.block_size = 1024;
+        options.compression = "snappy";
+        options.chunk_size = 1000;
+        RecordWriter writer(file.get(), options);
+        WriteRecords(&writer);
+    }
+    ExpectScanned(&m_pool, 1000, 5);
+}
+
+// Legacy files are scanned in one split.
+TEST_F(ParallelScanTest, Legacy) {
+    {
+        scoped_ptr<File> file(File::Open(kFilePath, "w"));
+        RecordWriter writer(file.get());
+        WriteRecords(&writer);
+    }
+    std::vector<RecordFileSplit> splits;
+    ASSERT_TRUE(SplitRecordFile(kFilePath, 1000, &splits));
+    EXPECT_EQ(1u, splits.size());
+    ExpectScanned(&m_pool, 1000, 1);
+}
+
+TEST_F(ParallelScanTest, NotExist) {
+    std::vector<RecordFileSplit> splits;
+    EXPECT_FALSE(SplitRecordFile("./not_exist.dat", 1000, &splits));
+    RecordFileSplit split = { 0, 1000 };
+    splits.push_back(split);
+    EXPECT_FALSE(ParallelScanRecords(&m_pool, "./not_exist.dat", splits, IgnoreRecord));
+}
+
+} // namespace toft
@@ -0,0 +1,111 @@
+// Copyright (C) 2026, The Toft Authors.
+//
+// Description: Layout of the block framed RecordIO format.
+//
+// The file begins with a header:
+//   magic (8 bytes) | header size (fixed32) | block size (fixed32) | compression
+// compression is the name of a registered BlockCompression, or empty if
+// records are not compressed; its size is header size - kHeaderSize.
+//
+// The whole file, including the header, is divided into blocks of block
+// size. Each record is stored as one or more fragments, and a fragment never
+// crosses the block boundary:
+//   crc32 of type and data (fixed32) | data size (fixed16) | type (1 byte) | data
+// If the rest of a block is too small for a fragment header, it's filled
+// with zeros.
+//
+// A corrupted fragment only loses records in its block, the reader resumes
+// from the next block. Block boundaries are also where readers of a byte
+// range split start: a record belongs to the split where its first fragment
+// starts. All integers are little endian.
+//
+// In compressed files, records are grouped into chunks, each is compressed
+// and stored as a record in blocks:
+//   size (varint32) | data | size (varint32) | data ...
+// So corruption loses the whole chunk.
+//
+// Fragments with the kMetadataFragment bit in type are not records, they are
+// skipped when reading records. A writer which starts with an empty file
+// writes a sparse index of records as a metadata record when finished:
+//   (record number delta (varint64), offset delta (varint64)) ...
+// each pair is the number of the first record in a framed record, and the
+// offset of its first fragment. A footer fragment follows it at the end of
+// the file, in the same block:
+//   index offset (fixed64) | record count (fixed64) | kIndexMagic
+// Metadata fragments are also used to fill the block if the footer doesn't
+// fit into it.
+
+#ifndef TOFT_STORAGE_RECORDIO_RECORD_FORMAT_H
+#define TOFT_STORAGE_RECORDIO_RECORD_FORMAT_H
+
+#include <stdint.h>
+#include <string.h>
+
+#include "toft/base/byte_order.h"
+
+namespace toft {
+namespace recordio {
+
+// The first 4 bytes are a record size of more than 1G in the legacy format,
+// so legacy files are hardly mistaken for framed ones.
+const char kMagic[] = "\x89RIO\r\n\x1a\n";
+const size_t kMagicSize = sizeof(kMagic) - 1;
+// Size of the header without compression name.
+const size_t kHeaderSize = kMagicSize + 4 + 4;
+
+const uint32_t kDefaultBlockSize = 32 * 1024;
+const size_t kFragmentHeaderSize = 4 + 2 + 1;
+// Data size of a fragment is fixed16.
+const uint32_t kMaxBlockSize = 0xFFFF + kFragmentHeaderSize;
+
+enum FragmentType {
+    // 0 is reserved for zero filled space.
+    FRAGMENT_FULL = 1,
+    FRAGMENT_FIRST = 2,
+    FRAGMENT_MIDDLE = 3,
+    FRAGMENT_LAST = 4,
+};
+
+const int kMetadataFragment = 0x80;
+
+const char kIndexMagic[] = "RIOINDEX";
+const size_t kFooterDataSize = 8 + 8 + sizeof(kIndexMagic) - 1;
+const size_t kFooterSize = kFragmentHeaderSize + kFooterDataSize;
+
+inline void EncodeFixed16(char* buffer, uint16_t value) {
+    value = ByteOrder::ToLittleEndian<uint16_t>(value);
+    memcpy(buffer, &value, sizeof(value));
+}
+
+inline void EncodeFixed32(char* buffer, uint32_t value) {
+    value = ByteOrder::ToLittleEndian<uint32_t>(value);
+    memcpy(buffer, &value, sizeof(value));
+}
+
+inline void EncodeFixed64(char* buffer, uint64_t value) {
+    value = ByteOrder::ToLittleEndian<uint64_t>(value);
+    memcpy(buffer, &value, sizeof(value));
+}
+
+inline uint16_t DecodeFixed16(const char* buffer) {
+    uint16_t value;
+    memcpy(&value, buffer, sizeof(value));
+    return ByteOrder::FromLittleEndian<uint16_t>(value);
+}
+
+inline uint32_t DecodeFixed32(const char* buffer) {
+    uint32_t value;
+    memcpy(&value, buffer, sizeof(value));
+    return ByteOrder::FromLittleEndian<uint32_t>(value);
+}
+
+inline uint64_t DecodeFixed64(const char* buffer) {
+    uint64_t value;
+    memcpy(&value, buffer, sizeof(value));
+    return ByteOrder::FromLittleEndian<uint64_t>(value);
+}
+
+} // namespace recordio
+} // namespace toft
+
+#endif // TOFT_STORAGE_RECORDIO_RECORD_FORMAT_H
@@ -5,16 +5,78 @@
 
 #include "toft/storage/recordio/recordio.h"
 
+#include <string.h>
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+#include "toft/compress/block/block_compression.h"
+#include "toft/encoding/varint.h"
+#include "toft/hash/crc32.h"
+#include "toft/storage/file/memory_mapped_file.h"
+
 #include "thirdparty/glog/logging.h"
 
 namespace toft {
 
+namespace {
+
+const int64_t kMaxOffset = std::numeric_limits<int64_t>::max();
+
+RecordWriterOptions LegacyOptions() {
+    RecordWriterOptions options;
+    options.framed = false;
+    options.buffer_size = 0;
+    return options;
+}
+
+} // namespace
+
 RecordWriter::RecordWriter(File *file)
-    : m_file(file) {
+    : m_file(file),
+      m_options(LegacyOptions()),
+      m_started(false),
+      m_finished(false),
+      m_offset(0),
+      m_record_count(0),
+      m_chunk_first_record(0),
+      m_indexed(false),
+      m_next_indexed_record(0),
+      m_last_indexed_record(0),
+      m_last_indexed_offset(0) {
     CHECK(m_file != NULL);
 }
 
-RecordWriter::~RecordWriter() {}
+RecordWriter::RecordWriter(File *file, const RecordWriterOptions& options)
+    : m_file(file),
+      m_options(options),
+      m_started(false),
+      m_finished(false),
+      m_offset(0),
+      m_record_count(0),
+      m_chunk_first_record(0),
+      m_indexed(false),
+      m_next_indexed_record(0),
+      m_last_indexed_record(0),
+      m_last_indexed_offset(0) {
+    CHECK(m_file != NULL);
+    if (m_options.framed) {
+        CHECK_GE(m_options.block_size,
+                 recordio::kHeaderSize + m_options.compression.size() +
+                 recordio::kFragmentHeaderSize + 1);
+        CHECK_LE(m_options.block_size, recordio::kMaxBlockSize);
+    }
+    if (!m_options.compression.empty()) {
+        CHECK(m_options.framed) << "Only the framed format can be compressed";
+        m_compression.reset(TOFT_CREATE_BLOCK_COMPRESSION(m_options.compression));
+        CHECK(m_compression != NULL) << "Unknown compression: " << m_options.compression;
+    }
+}
+
+RecordWriter::~RecordWriter() {
+    CompressChunk();
+    WriteBuffer();
+}
 
 bool RecordWriter::WriteMessage(const ::google::protobuf::Message& message) {
     std::string output;
@@ -33,12 +95,45 @@ bool RecordWriter::WriteMessage(const ::google::protobuf::Message& message) {
 }
 
 bool RecordWriter::WriteRecord(const char *data, uint32_t size) {
-    if (!Write(reinterpret_cast<char*>(&size), sizeof(size))) {
+    if (m_finished) {
+        LOG(ERROR) << "RecordWriter is finished.";
         return false;
     }
-    if (!Write(data, size)) {
+    if (!m_options.framed && m_options.buffer_size == 0) {
+        if (!Write(reinterpret_cast<char*>(&size), sizeof(size))) {
+            return false;
+        }
+        if (!Write(data, size)) {
+            return false;
+        }
+        return true;
+    }
+
+    if (!m_started && !Start()) {
         return false;
     }
+    if (m_compression != NULL) {
+        if (m_chunk.empty()) {
+            m_chunk_first_record = m_record_count;
+        }
+        Varint::PutLengthPrefixedStringPiece(&m_chunk, StringPiece(data, size));
+        ++m_record_count;
+        if (m_chunk.size() < m_options.chunk_size) {
+            return true;
+        }
+        if (!CompressChunk()) {
+            return false;
+        }
+    } else if (m_options.framed) {
+        AddIndexEntry(m_record_count, AppendFramedRecord(data, size, 0));
+        ++m_record_count;
+    } else {
+        m_buffer.append(reinterpret_cast<char*>(&size), sizeof(size));
+        m_buffer.append(data, size);
+    }
+    if (m_buffer.size() >= m_options.buffer_size) {
+        return WriteBuffer();
+    }
     return true;
 }
 
@@ -50,11 +145,178 @@ bool RecordWriter::WriteRecord(const StringPiece& data) {
     return WriteRecord(data.data(), data.size());
 }
 
+bool RecordWriter::Flush() {
+    if (!CompressChunk() || !WriteBuffer()) {
+        return false;
+    }
+    return m_file->Flush();
+}
+
+bool RecordWriter::Finish() {
+    if (m_finished) {
+        return true;
+    }
+    if (m_options.framed && !m_started && !Start()) {
+        return false;
+    }
+    if (!CompressChunk()) {
+        return false;
+    }
+    if (m_indexed) {
+        AppendIndex();
+    }
+    m_finished = true;
+    return Flush();
+}
+
+bool RecordWriter::Start() {
+    if (m_options.framed) {
+        // Find the end of records already in the file, they must be written
+        // with the same block size.
+        if (!m_file->Seek(0, SEEK_END)) {
+            LOG(ERROR) << "RecordWriter seek error.";
+            return false;
+        }
+        int64_t offset = m_file->Tell();
+        if (offset < 0) {
+            LOG(ERROR) << "RecordWriter tell error.";
+            return false;
+        }
+        if (offset == 0) {
+            uint32_t header_size = recordio::kHeaderSize + m_options.compression.size();
+            char header[recordio::kHeaderSize];
+            memcpy(header, recordio::kMagic, recordio::kMagicSize);
+            recordio::EncodeFixed32(header + recordio::kMagicSize, header_size);
+            recordio::EncodeFixed32(header + recordio::kMagicSize + 4, m_options.block_size);
+            m_buffer.append(header, sizeof(header));
+            m_buffer.append(m_options.compression);
+            offset = header_size;
+            m_indexed = m_options.index_interval > 0;
+        }
+        m_offset = offset;
+    }
+    m_buffer.reserve(m_options.buffer_size + m_options.block_size);
+    m_started = true;
+    return true;
+}
+
+bool RecordWriter::CompressChunk() {
+    if (m_chunk.empty()) {
+        return true;
+    }
+    m_compressed_chunk.clear();
+    bool ok = m_compression->Compress(m_chunk, &m_compressed_chunk);
+    m_chunk.clear();
+    if (!ok) {
+        LOG(ERROR) << "Compress chunk error.";
+        return false;
+    }
+    int64_t offset = AppendFramedRecord(m_compressed_chunk.data(),
+                                        m_compressed_chunk.size(), 0);
+    AddIndexEntry(m_chunk_first_record, offset);
+    if (m_buffer.size() >= m_options.buffer_size) {
+        return WriteBuffer();
+    }
+    return true;
+}
+
+int64_t RecordWriter::AppendFramedRecord(const char *data, uint32_t size, int flags) {
+    const uint32_t block_size = m_options.block_size;
+    uint32_t space = block_size - m_offset % block_size;
+    if (space < recordio::kFragmentHeaderSize) {
+        // Too small for a fragment, fill it with zeros.
+        m_buffer.append(space, '\0');
+        m_offset += space;
+        space = block_size;
+    }
+    int64_t offset = m_offset;
+    bool begin = true;
+    for (;;) {
+        uint32_t fragment_size = std::min<uint32_t>(
+            size, space - recordio::kFragmentHeaderSize);
+        bool end = fragment_size == size;
+        int type;
+        if (begin) {
+            type = end ? recordio::FRAGMENT_FULL : recordio::FRAGMENT_FIRST;
+        } else {
+            type = end ? recordio::FRAGMENT_LAST : recordio::FRAGMENT_MIDDLE;
+        }
+        AppendFragment(type | flags, data, fragment_size);
+        if (end) {
+            break;
+        }
+        data += fragment_size;
+        size -= fragment_size;
+        begin = false;
+        space = block_size;
+    }
+    return offset;
+}
+
+void RecordWriter::AppendFragment(int type, const char *data, uint32_t size) {
+    char header[recordio::kFragmentHeaderSize];
+    header[6] = static_cast<char>(type);
+    CRC32 crc;
+    crc.Update(StringPiece(header + 6, 1));
+    crc.Update(StringPiece(data, size));
+    recordio::EncodeFixed32(header, crc.Final());
+    recordio::EncodeFixed16(header + 4, size);
+    m_buffer.append(header, sizeof(header));
+    m_buffer.append(data, size);
+    m_offset += recordio::kFragmentHeaderSize + size;
+}
+
+void RecordWriter::AddIndexEntry(int64_t record_number, int64_t offset) {
+    if (!m_indexed || record_number < m_next_indexed_record) {
+        return;
+    }
+    Varint::Put64(&m_index, record_number - m_last_indexed_record);
+    Varint::Put64(&m_index, offset - m_last_indexed_offset);
+    m_last_indexed_record = record_number;
+    m_last_indexed_offset = offset;
+    m_next_indexed_record = record_number + m_options.index_interval;
+}
+
+void RecordWriter::AppendIndex() {
+    int64_t index_offset = AppendFramedRecord(m_index.data(), m_index.size(),
+                                              recordio::kMetadataFragment);
+    const uint32_t block_size = m_options.block_size;
+    uint32_t space = block_size - m_offset % block_size;
+    if (space < recordio::kFooterSize) {
+        // The footer must be in one block, so that it can be found from
+        // the end of the file.
+        if (space >= recordio::kFragmentHeaderSize) {
+            std::string padding(space - recordio::kFragmentHeaderSize, '\0');
+            AppendFragment(recordio::FRAGMENT_FULL | recordio::kMetadataFragment,
+                           padding.data(), padding.size());
+        } else {
+            m_buffer.append(space, '\0');
+            m_offset += space;
+        }
+    }
+    char footer[recordio::kFooterDataSize];
+    recordio::EncodeFixed64(footer, index_offset);
+    recordio::EncodeFixed64(footer + 8, m_record_count);
+    memcpy(footer + 16, recordio::kIndexMagic, sizeof(recordio::kIndexMagic) - 1);
+    AppendFragment(recordio::FRAGMENT_FULL | recordio::kMetadataFragment,
+                   footer, sizeof(footer));
+    m_index.clear();
+}
+
+bool RecordWriter::WriteBuffer() {
+    if (m_buffer.empty()) {
+        return true;
+    }
+    bool ok = Write(m_buffer.data(), m_buffer.size());
+    m_buffer.clear();
+    return ok;
+}
+
 bool RecordWriter::Write(const char *data, uint32_t size) {
     uint32_t write_size = 0;
     while (write_size < size) {
         int32_t ret = m_file->Write(data + write_size, size - write_size);
-        if (ret == -1) {
+        if (ret <= 0) {
             LOG(ERROR) << "RecordWriter error.";
             return false;
         }
@@ -64,75 +326,468 @@ bool RecordWriter::Write(const char *data, uint32_t size) {
 }
 
 RecordReader::RecordReader(File *file)
-    : m_file(file),
-      m_buffer_size(1 * 1024 * 1024) {
+    : RecordReader(file, NULL) {
     CHECK(m_file != NULL);
     m_buffer.reset(new char[m_buffer_size]);
     Reset();
 }
 
+RecordReader::RecordReader(const MemoryMappedFile* mapped_file)
+    : RecordReader(NULL, mapped_file) {
+    CHECK(m_mapped_file != NULL && m_mapped_file->IsOpen());
+    Reset();
+}
+
+RecordReader::RecordReader(File *file, const MemoryMappedFile* mapped_file)
+    : m_file(file),
+      m_mapped_file(mapped_file),
+      m_file_position(-1),
+      m_valid(false),
+      m_framed(false),
+      m_data(NULL),
+      m_data_size(0),
+      m_skipped_bytes(0),
+      m_file_size(0),
+      m_offset(0),
+      m_range_start(0),
+      m_range_end(0),
+      m_buffer_size(1 * 1024 * 1024),
+      m_resyncing(false),
+      m_index_loaded(false),
+      m_header_size(0),
+      m_block_size(0),
+      m_block(NULL),
+      m_block_data_size(0),
+      m_block_offset(0),
+      m_chunk_offset(0) {
+}
+
 RecordReader::~RecordReader() {}
 
 bool RecordReader::Reset() {
-    if (!m_file->Seek(0, SEEK_END)) {
+    m_valid = Open();
+    return m_valid;
+}
+
+bool RecordReader::Open() {
+    m_framed = false;
+    m_data = NULL;
+    m_data_size = 0;
+    m_skipped_bytes = 0;
+    m_offset = 0;
+    m_range_start = 0;
+    m_range_end = kMaxOffset;
+    m_resyncing = false;
+    m_index_loaded = false;
+    m_index.clear();
+    m_block_data_size = 0;
+    m_block_offset = 0;
+    m_record.clear();
+    m_compression.reset();
+    m_chunk.clear();
+    m_chunk_offset = 0;
+
+    if (m_mapped_file != NULL) {
+        m_file_size = m_mapped_file->size();
+        m_mapped_file->Advise(0, m_file_size, MemoryMappedFile::kAdviceSequential);
+    } else {
+        if (!m_file->Seek(0, SEEK_END)) {
+            LOG(ERROR) << "RecordReader Reset error.";
+            return false;
+        }
+        m_file_size = m_file->Tell();
+        m_file_position = m_file_size;
+    }
+    if (m_file_size < static_cast<int64_t>(recordio::kHeaderSize)) {
+        return true;
+    }
+
+    char header_buffer[recordio::kHeaderSize];
+    const char* header;
+    if (!ReadAt(0, sizeof(header_buffer), header_buffer, &header)) {
         LOG(ERROR) << "RecordReader Reset error.";
         return false;
     }
-    m_file_size = m_file->Tell();
-    if (!m_file->Seek(0, SEEK_SET)) {
+    if (memcmp(header, recordio::kMagic, recordio::kMagicSize) != 0) {
+        // Legacy format without header.
+        return true;
+    }
+
+    uint32_t header_size = recordio::DecodeFixed32(header + recordio::kMagicSize);
+    uint32_t block_size = recordio::DecodeFixed32(header + recordio::kMagicSize + 4);
+    if (block_size > recordio::kMaxBlockSize || header_size < recordio::kHeaderSize ||
+        header_size > block_size) {
+        LOG(ERROR) << "Bad RecordIO header, header size: " << header_size
+                   << ", block size: " << block_size;
+        return false;
+    }
+    m_framed = true;
+    if (block_size != m_block_size) {
+        m_block_size = block_size;
+        if (m_mapped_file == NULL) {
+            m_block_buffer.reset(new char[m_block_size]);
+        }
+    }
+    // Read the first block again, as if the header is a fragment.
+    if (ReadBlock() < 0) {
         LOG(ERROR) << "RecordReader Reset error.";
         return false;
     }
+    if (header_size > m_block_data_size) {
+        LOG(ERROR) << "Truncated RecordIO header";
+        return false;
+    }
+    m_header_size = header_size;
+    m_block_offset = header_size;
+
+    if (header_size > recordio::kHeaderSize) {
+        std::string compression(m_block + recordio::kHeaderSize,
+                                header_size - recordio::kHeaderSize);
+        m_compression.reset(TOFT_CREATE_BLOCK_COMPRESSION(compression));
+        if (m_compression == NULL) {
+            LOG(ERROR) << "Unknown RecordIO compression: " << compression;
+            return false;
+        }
+    }
     return true;
 }
 
+bool RecordReader::ResetRange(int64_t start, int64_t end) {
+    if (!Reset()) {
+        return false;
+    }
+    m_range_start = start;
+    m_range_end = end;
+    if (!m_framed) {
+        if (start > 0) {
+            LOG(ERROR) << "Legacy RecordIO file can only be read from the beginning.";
+            m_valid = false;
+            return false;
+        }
+        return true;
+    }
+    m_valid = PositionAt(start);
+    return m_valid;
+}
+
+bool RecordReader::SeekToRecord(int64_t index) {
+    if (!Reset()) {
+        return false;
+    }
+    int64_t record_number = 0;
+    if (m_framed) {
+        LoadIndex();
+        // The last entry before the record.
+        std::vector<std::pair<int64_t, int64_t> >::iterator it =
+            std::upper_bound(m_index.begin(), m_index.end(),
+                             std::make_pair(index, kMaxOffset));
+        if (it != m_index.begin()) {
+            --it;
+            record_number = it->first;
+            m_range_start = it->second;
+        }
+        if (!PositionAt(m_range_start)) {
+            m_valid = false;
+            return false;
+        }
+    }
+    for (; record_number < index; ++record_number) {
+        if (Next() != 1) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool RecordReader::PositionAt(int64_t offset) {
+    // Read from the beginning of the block, fragments before offset are
+    // dropped as records out of range.
+    int64_t block_start = offset - offset % m_block_size;
+    m_offset = block_start;
+    m_block_data_size = 0;
+    m_block_offset = 0;
+    if (ReadBlock() < 0) {
+        return false;
+    }
+    if (block_start == 0) {
+        m_block_offset = m_header_size;
+    }
+    m_record.clear();
+    m_chunk.clear();
+    m_chunk_offset = 0;
+    m_resyncing = true;
+    return true;
+}
+
+void RecordReader::LoadIndex() {
+    if (m_index_loaded) {
+        return;
+    }
+    m_index_loaded = true;
+
+    // Find the footer at the end of the file.
+    int64_t footer_offset = m_file_size - recordio::kFooterSize;
+    if (footer_offset < m_header_size ||
+        footer_offset % m_block_size + recordio::kFooterSize > m_block_size) {
+        return;
+    }
+    char footer_buffer[recordio::kFooterSize];
+    const char* footer;
+    if (!ReadAt(footer_offset, sizeof(footer_buffer), footer_buffer, &footer)) {
+        LOG(ERROR) << "Read RecordIO footer error.";
+        return;
+    }
+    const char* data = footer + recordio::kFragmentHeaderSize;
+    CRC32 crc;
+    crc.Update(StringPiece(footer + 6, recordio::kFooterSize - 6));
+    if (crc.Final() != recordio::DecodeFixed32(footer) ||
+        recordio::DecodeFixed16(footer + 4) != recordio::kFooterDataSize ||
+        footer[6] != static_cast<char>(recordio::FRAGMENT_FULL | recordio::kMetadataFragment) ||
+        memcmp(data + 16, recordio::kIndexMagic, sizeof(recordio::kIndexMagic) - 1) != 0) {
+        // Not finished, or appended after finished.
+        return;
+    }
+    int64_t index_offset = recordio::DecodeFixed64(data);
+    if (index_offset < m_header_size || index_offset > footer_offset) {
+        LOG(ERROR) << "Bad RecordIO index offset: " << index_offset;
+        return;
+    }
+
+    m_range_start = index_offset;
+    bool metadata = false;
+    if (!PositionAt(index_offset) || ReadFramedRecord(&metadata) != 1 || !metadata) {
+        LOG(ERROR) << "Read RecordIO index error.";
+        m_range_start = 0;
+        return;
+    }
+    m_range_start = 0;
+
+    const char* p = m_data;
+    const char* limit = m_data + m_data_size;
+    int64_t record_number = 0;
+    int64_t offset = 0;
+    while (p < limit) {
+        uint64_t record_number_delta;
+        uint64_t offset_delta;
+        p = Varint::Decode64(p, limit, &record_number_delta);
+        if (p != NULL) {
+            p = Varint::Decode64(p, limit, &offset_delta);
+        }
+        if (p == NULL) {
+            LOG(ERROR) << "Bad RecordIO index.";
+            m_index.clear();
+            return;
+        }
+        record_number += record_number_delta;
+        offset += offset_delta;
+        m_index.push_back(std::make_pair(record_number, offset));
+    }
+}
+
 int RecordReader::Next() {
-    // read size
-    int64_t ret = m_file->Tell();
-    if (ret == -1) {
-        LOG(ERROR) << "Tell error.";
+    if (!m_valid) {
         return -1;
     }
+    if (m_compression != NULL) {
+        return NextChunkRecord();
+    }
+    if (m_framed) {
+        return NextFramedRecord();
+    }
+    return NextLegacyRecord();
+}
 
-    if (ret == m_file_size) {
+int RecordReader::NextLegacyRecord() {
+    // read size
+    if (m_offset == m_file_size || m_offset >= m_range_end) {
         return 0;
-    } else if (m_file_size - ret >= static_cast<int64_t>(sizeof(m_data_size))) { // NO_LINT
-        if (!Read(reinterpret_cast<char*>(&m_data_size), sizeof(m_data_size))) {
-            LOG(ERROR) << "Read size error.";
-            return -1;
-        }
     }
+    if (m_file_size - m_offset < static_cast<int64_t>(sizeof(m_data_size))) {
+        LOG(ERROR) << "Truncated record size at " << m_offset;
+        return -1;
+    }
+    char size_buffer[sizeof(m_data_size)];
+    const char* size;
+    if (!ReadAt(m_offset, sizeof(size_buffer), size_buffer, &size)) {
+        LOG(ERROR) << "Read size error.";
+        return -1;
+    }
+    memcpy(&m_data_size, size, sizeof(m_data_size));
+    m_offset += sizeof(m_data_size);
 
     // read data
-    ret = m_file->Tell();
-    if (ret == -1) {
-        LOG(ERROR) << "Tell error.";
+    if (m_file_size - m_offset < m_data_size) {
+        LOG(ERROR) << "Truncated record data at " << m_offset;
         return -1;
     }
-
-    if (ret >= m_file_size && m_data_size != 0) {
-        LOG(ERROR) << "read error.";
+    if (m_mapped_file == NULL && m_data_size > m_buffer_size) {
+        while (m_data_size > m_buffer_size) {
+            m_buffer_size *= 2;
+        }
+        m_buffer.reset(new char[m_buffer_size]);
+    }
+    if (!ReadAt(m_offset, m_data_size, m_buffer.get(), &m_data)) {
+        LOG(ERROR) << "Read data error.";
         return -1;
-    } else if (m_file_size - ret >= m_data_size) { // NO_LINT
-        if (m_data_size > m_buffer_size) {
-            while (m_data_size > m_buffer_size) {
-                m_buffer_size *= 2;
+    }
+    m_offset += m_data_size;
+    return 1;
+}
+
+int RecordReader::NextFramedRecord() {
+    for (;;) {
+        bool metadata = false;
+        int ret = ReadFramedRecord(&metadata);
+        if (ret <= 0 || !metadata) {
+            return ret;
+        }
+    }
+}
+
+int RecordReader::ReadFramedRecord(bool* metadata) {
+    bool in_record = false;
+    bool record_metadata = false;
+    int64_t record_offset = 0;
+    for (;;) {
+        uint32_t left = m_block_data_size - m_block_offset;
+        if (left < recordio::kFragmentHeaderSize) {
+            // Zero filled end of block.
+            int ret = ReadBlock();
+            if (ret <= 0) {
+                if (in_record) {
+                    SkipBytes(m_record.size(), "truncated record");
+                }
+                return ret;
+            }
+            continue;
+        }
+
+        int64_t offset = m_offset - m_block_data_size + m_block_offset;
+        const char* header = m_block + m_block_offset;
+        uint32_t size = recordio::DecodeFixed16(header + 4);
+        int type = static_cast<uint8_t>(header[6]) & ~recordio::kMetadataFragment;
+        bool is_metadata = (header[6] & recordio::kMetadataFragment) != 0;
+        const char* reason = NULL;
+        if (recordio::kFragmentHeaderSize + size > left) {
+            // Corrupted size, or the last fragment is truncated.
+            reason = "bad fragment size";
+        } else if (type < recordio::FRAGMENT_FULL || type > recordio::FRAGMENT_LAST) {
+            reason = "bad fragment type";
+        } else {
+            CRC32 crc;
+            crc.Update(StringPiece(header + 6, 1 + size));
+            if (crc.Final() != recordio::DecodeFixed32(header)) {
+                reason = "checksum mismatch";
+            }
+        }
+        if (reason != NULL) {
+            // Nothing in the rest of the block can be trusted.
+            SkipBytes(left + (in_record ? m_record.size() : 0), reason);
+            in_record = false;
+            m_block_offset = m_block_data_size;
+            continue;
+        }
+        const char* data = header + recordio::kFragmentHeaderSize;
+        m_block_offset += recordio::kFragmentHeaderSize + size;
+
+        if (type == recordio::FRAGMENT_FULL || type == recordio::FRAGMENT_FIRST) {
+            if (in_record) {
+                SkipBytes(m_record.size(), "partial record");
+            }
+            m_resyncing = false;
+            if (offset >= m_range_end) {
+                // Belongs to the next range.
+                m_block_offset = m_block_data_size;
+                m_offset = m_file_size;
+                return 0;
+            }
+            record_offset = offset;
+            record_metadata = is_metadata;
+            if (type == recordio::FRAGMENT_FIRST) {
+                m_record.assign(data, size);
+                in_record = true;
+                continue;
             }
-            m_buffer.reset(new char[m_buffer_size]);
+            m_data = data;
+            m_data_size = size;
+        } else {
+            if (!in_record || is_metadata != record_metadata) {
+                // The beginning of the record is lost, or in the previous
+                // range.
+                if (!m_resyncing) {
+                    SkipBytes(recordio::kFragmentHeaderSize + size +
+                              (in_record ? m_record.size() : 0), "partial record");
+                }
+                in_record = false;
+                continue;
+            }
+            m_record.append(data, size);
+            if (type == recordio::FRAGMENT_MIDDLE) {
+                continue;
+            }
+            in_record = false;
+            m_data = m_record.data();
+            m_data_size = m_record.size();
+        }
+        if (record_offset >= m_range_start) {
+            *metadata = record_metadata;
+            return 1;
         }
+    }
+}
 
-        if (!Read(m_buffer.get(), m_data_size)) {
-            LOG(ERROR) << "Read data error.";
-            return -1;
+int RecordReader::NextChunkRecord() {
+    while (m_chunk_offset >= m_chunk.size()) {
+        int ret = NextFramedRecord();
+        if (ret <= 0) {
+            return ret;
+        }
+        m_chunk.clear();
+        m_chunk_offset = 0;
+        if (!m_compression->Uncompress(m_data, m_data_size, &m_chunk)) {
+            SkipBytes(m_data_size, "uncompress chunk error");
+            m_chunk.clear();
         }
     }
 
+    const char* begin = m_chunk.data() + m_chunk_offset;
+    const char* end = m_chunk.data() + m_chunk.size();
+    StringPiece record;
+    const char* next = Varint::GetLengthPrefixedStringPiece(begin, end, &record);
+    if (next == NULL) {
+        SkipBytes(end - begin, "bad chunk");
+        m_chunk_offset = m_chunk.size();
+        return NextChunkRecord();
+    }
+    m_chunk_offset = next - m_chunk.data();
+    m_data = record.data();
+    m_data_size = record.size();
+    return 1;
+}
+
+int RecordReader::ReadBlock() {
+    int64_t size = std::min<int64_t>(m_block_size, m_file_size - m_offset);
+    if (size <= 0) {
+        return 0;
+    }
+    if (!ReadAt(m_offset, size, m_block_buffer.get(), &m_block)) {
+        LOG(ERROR) << "Read block error.";
+        return -1;
+    }
+    m_offset += size;
+    m_block_data_size = size;
+    m_block_offset = 0;
     return 1;
 }
 
+void RecordReader::SkipBytes(int64_t size, const char* reason) {
+    LOG(WARNING) << "RecordReader skips " << size << " bytes before "
+                 << m_offset << ": " << reason;
+    m_skipped_bytes += size;
+}
+
 bool RecordReader::ReadMessage(::google::protobuf::Message *message) {
-    std::string str(m_buffer.get(), m_data_size);
-    if (!message->ParseFromArray(m_buffer.get(), m_data_size)) {
+    if (!message->ParseFromArray(m_data, m_data_size)) {
         LOG(WARNING) << "Missing required fields.";
         return false;
     }
@@ -141,8 +796,7 @@ bool RecordReader::ReadMessage(::google::protobuf::Message *message) {
 
 bool RecordReader::ReadNextMessage(::google::protobuf::Message *message) {
     while (Next() == 1) {
-        std::string str(m_buffer.get(), m_data_size);
-        if (message->ParseFromArray(m_buffer.get(), m_data_size)) {
+        if (message->ParseFromArray(m_data, m_data_size)) {
             return true;
         }
     }
@@ -150,13 +804,13 @@ bool RecordReader::ReadNextMessage(::google::protobuf::Message *message) {
 }
 
 bool RecordReader::ReadRecord(const char **data, uint32_t *size) {
-    *data = m_buffer.get();
+    *data = m_data;
     *size = m_data_size;
     return true;
 }
 
 bool RecordReader::ReadRecord(std::string *data) {
-    data->assign(m_buffer.get(), m_data_size);
+    data->assign(m_data, m_data_size);
     return true;
 }
 
@@ -170,18 +824,39 @@ bool RecordReader::ReadRecord(StringPiece* data) {
     return true;
 }
 
-bool RecordReader::Read(char *data, uint32_t size) {
-    // Read
+bool RecordReader::ReadAt(int64_t offset, uint32_t size, char* buffer,
+                          const char** data) {
+    if (m_mapped_file != NULL) {
+        // No copy.
+        StringPiece range;
+        if (!m_mapped_file->GetRange(offset, size, &range)) {
+            LOG(ERROR) << "Read out of range.";
+            return false;
+        }
+        *data = range.data();
+        return true;
+    }
+
+    if (offset != m_file_position) {
+        if (!m_file->Seek(offset, SEEK_SET)) {
+            LOG(ERROR) << "Seek error.";
+            m_file_position = -1;
+            return false;
+        }
+        m_file_position = offset;
+    }
     uint32_t read_size = 0;
     while (read_size < size) {
-        int64_t ret = m_file->Read(data + read_size, size - read_size);
-        if (ret == -1) {
+        int64_t ret = m_file->Read(buffer + read_size, size - read_size);
+        if (ret <= 0) {
             LOG(ERROR) << "Read error.";
+            m_file_position = -1;
             return false;
         }
         read_size += ret;
     }
-
+    m_file_position += size;
+    *data = buffer;
     return true;
 }
 
@@ -7,17 +7,60 @@
 #define TOFT_STORAGE_RECORDIO_RECORDIO_H
 
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "thirdparty/protobuf/message.h"
 #include "toft/base/scoped_array.h"
+#include "toft/base/scoped_ptr.h"
 #include "toft/base/string/string_piece.h"
 #include "toft/storage/file/file.h"
+#include "toft/storage/recordio/record_format.h"
 
 namespace toft {
 
+class BlockCompression;
+class MemoryMappedFile;
+
+struct RecordWriterOptions {
+    RecordWriterOptions()
+        : framed(true),
+          block_size(recordio::kDefaultBlockSize),
+          buffer_size(256 * 1024),
+          chunk_size(64 * 1024),
+          index_interval(1024) {}
+
+    // Write the block framed format described in record_format.h. Otherwise
+    // write the legacy format, which is just a size before each record.
+    bool framed;
+    // Block size of the framed format, no more than recordio::kMaxBlockSize.
+    uint32_t block_size;
+    // Records are written into the file when so many bytes are buffered, or
+    // Flush is called. 0 means no buffer.
+    size_t buffer_size;
+    // Name of the block compression, such as "snappy", for the framed format.
+    // Empty means not to compress.
+    std::string compression;
+    // Records are compressed together when so many bytes are collected.
+    size_t chunk_size;
+    // Number of records between entries of the sparse index written by
+    // Finish, 0 means no index.
+    uint32_t index_interval;
+};
+
+// Write records into a file.
+//
+// The file can be empty or has records written by RecordWriter with the
+// same options. A writer constructed without options writes the legacy
+// format without buffer, the same as old versions.
+//
+// Buffered records are written in Flush or destructor, so be sure to flush
+// the writer before closing the file. Finish also writes the index, so that
+// RecordReader::SeekToRecord needn't read from the beginning.
 class RecordWriter {
 public:
     explicit RecordWriter(File *file);
+    RecordWriter(File *file, const RecordWriterOptions& options);
     ~RecordWriter();
 
     bool WriteMessage(const ::google::protobuf::Message& message);
@@ -25,20 +68,79 @@ public:
     bool WriteRecord(const std::string& data);
     bool WriteRecord(const StringPiece& data);
 
+    // Write buffered records into the file, and flush the file.
+    bool Flush();
+
+    // Flush and write the index if the file was empty when started.
+    // No records can be written after it.
+    bool Finish();
+
 private:
+    bool Start();
+    bool CompressChunk();
+    // Return offset of the first fragment.
+    int64_t AppendFramedRecord(const char *data, uint32_t size, int flags);
+    void AppendFragment(int type, const char *data, uint32_t size);
+    void AddIndexEntry(int64_t record_number, int64_t offset);
+    void AppendIndex();
+    bool WriteBuffer();
     bool Write(const char *data, uint32_t size);
 
 private:
     File* m_file;
+    RecordWriterOptions m_options;
+    std::string m_buffer;
+    bool m_started;
+    bool m_finished;
+    int64_t m_offset;         // File offset of the end of m_buffer
+    int64_t m_record_count;
+    scoped_ptr<BlockCompression> m_compression;
+    std::string m_chunk;      // Records to be compressed
+    int64_t m_chunk_first_record;
+    std::string m_compressed_chunk;
+
+    bool m_indexed;
+    std::string m_index;
+    int64_t m_next_indexed_record;
+    int64_t m_last_indexed_record;
+    int64_t m_last_indexed_offset;
 };
 
+// Read records written by RecordWriter, both the framed and the legacy
+// format are supported.
+//
+// Records are valid until the next call of Next or Reset. Records in a
+// compressed chunk are pieces of the uncompressed chunk, without copy.
+//
+// A framed file can be divided into byte ranges, which are read by
+// different readers in parallel, see ResetRange.
+//
+// For framed files, corrupted blocks are skipped and reading continues from
+// the next block, see skipped_bytes().
+//
+// A reader of a MemoryMappedFile returns records in the mapped memory
+// whenever possible, without copy and system calls. The mapped file must
+// be open while the reader is used.
 class RecordReader {
 public:
     explicit RecordReader(File *file);
+    explicit RecordReader(const MemoryMappedFile* mapped_file);
     ~RecordReader();
 
     bool Reset();
 
+    // Reset to read records starting in [start, end) of the file, which are
+    // usually splits of the file. Records across split boundaries are read
+    // by the split where they start, so each record is read exactly once.
+    // Legacy files can only be read from start 0.
+    bool ResetRange(int64_t start, int64_t end);
+
+    // Reset to read from the index-th record (0 based) to the end. It reads
+    // from the nearest entry of the index written by RecordWriter::Finish,
+    // or from the beginning if there is no index.
+    // Return false if there are no so many records.
+    bool SeekToRecord(int64_t index);
+
     // for ok, return 1;
     // for no more data, return 0;
     // for error, return -1;
@@ -50,15 +152,66 @@ public:
     bool ReadRecord(std::string *data);
     bool ReadRecord(StringPiece* data);
 
+    bool is_framed() const {
+        return m_framed;
+    }
+    int64_t file_size() const {
+        return m_file_size;
+    }
+    // Bytes dropped because of corruption or truncation.
+    int64_t skipped_bytes() const {
+        return m_skipped_bytes;
+    }
+
 private:
-    bool Read(char *data, uint32_t size);
+    RecordReader(File *file, const MemoryMappedFile* mapped_file);
+    bool Open();
+    bool PositionAt(int64_t offset);
+    void LoadIndex();
+    int NextLegacyRecord();
+    int NextFramedRecord();
+    int ReadFramedRecord(bool* metadata);
+    int NextChunkRecord();
+    int ReadBlock();
+    void SkipBytes(int64_t size, const char* reason);
+    // Read into buffer, or just get the range for mapped file.
+    bool ReadAt(int64_t offset, uint32_t size, char* buffer, const char** data);
 
 private:
     File* m_file;
+    const MemoryMappedFile* m_mapped_file;
+    int64_t m_file_position;  // Position of m_file, -1 if unknown
+    bool m_valid;   // Reset succeeded
+    bool m_framed;
+    const char* m_data;
+    uint32_t m_data_size;
+    int64_t m_skipped_bytes;
+    int64_t m_file_size;
+    int64_t m_offset;
+    int64_t m_range_start;
+    int64_t m_range_end;
+
+    // For the legacy format.
     scoped_array<char> m_buffer;
-    uint32_t m_file_size;
     uint32_t m_buffer_size;
-    uint32_t m_data_size;
+
+    // For the framed format.
+    bool m_resyncing;            // Fragments of records out of range are expected
+    bool m_index_loaded;
+    // Pairs of record number and offset of the framed record.
+    std::vector<std::pair<int64_t, int64_t> > m_index;
+    uint32_t m_header_size;
+    uint32_t m_block_size;
+    scoped_array<char> m_block_buffer;
+    const char* m_block;
+    uint32_t m_block_data_size;  // Less than m_block_size for the last block
+    uint32_t m_block_offset;     // Offset of the next fragment in the block
+    std::string m_record;        // Record assembled from fragments
+
+    // For compressed framed files.
+    scoped_ptr<BlockCompression> m_compression;
+    std::string m_chunk;         // The uncompressed chunk
+    size_t m_chunk_offset;       // Offset of the next record in the chunk
 };
 
 } // namespace toft
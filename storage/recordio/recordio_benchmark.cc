@@ -0,0 +1,108 @@
+// Copyright (C) 2026, The Toft Authors.
+//
+// Description: Records per second of writing and reading small log like
+// records, in the legacy format without buffer, the buffered framed format,
+// and the framed format compressed by snappy, by File and MemoryMappedFile.
+
+#include <string>
+#include <vector>
+
+#include "toft/base/scoped_ptr.h"
+#include "toft/base/string/format.h"
+#include "toft/storage/file/file.h"
+#include "toft/storage/file/memory_mapped_file.h"
+#include "toft/storage/recordio/recordio.h"
+
+#include "thirdparty/benchmark/benchmark.h"
+
+namespace {
+
+const char kFilePath[] = "./recordio_benchmark.dat";
+const int kRecordCount = 100000;
+
+enum Format {
+    kLegacy,
+    kFramed,
+    kSnappy,
+};
+
+// About 100 bytes.
+const std::vector<std::string>& Records() {
+    static std::vector<std::string> records;
+    if (records.empty()) {
+        for (int i = 0; i < kRecordCount; ++i) {
+            records.push_back(toft::StringPrint(
+                    "time=%d level=INFO server=web%02d uri=/item/%d.html status=200 latency_us=%d",
+                    1380000000 + i / 10, i % 37, i * 7919 % 1000003, i * 31 % 5000));
+        }
+    }
+    return records;
+}
+
+// Return bytes of the file.
+int64_t WriteRecords(int format) {
+    toft::scoped_ptr<toft::File> file(toft::File::Open(kFilePath, "w"));
+    toft::scoped_ptr<toft::RecordWriter> writer;
+    if (format == kLegacy) {
+        writer.reset(new toft::RecordWriter(file.get()));
+    } else {
+        toft::RecordWriterOptions options;
+        if (format == kSnappy)
+            options.compression = "snappy";
+        writer.reset(new toft::RecordWriter(file.get(), options));
+    }
+    const std::vector<std::string>& records = Records();
+    for (size_t i = 0; i < records.size(); ++i)
+        writer->WriteRecord(records[i]);
+    writer->Flush();
+    writer.reset();
+    int64_t size = file->Tell();
+    file->Close();
+    return size;
+}
+
+}  // namespace
+
+// range(0): format of the file.
+static void RecordWriterWrite(benchmark::State& state) {
+    Records();
+    int64_t file_size = 0;
+    for (auto _ : state)
+        file_size = WriteRecords(state.range(0));
+    state.SetItemsProcessed(state.iterations() * kRecordCount);
+    state.counters["file_bytes"] = file_size;
+    toft::File::Delete(kFilePath);
+}
+BENCHMARK(RecordWriterWrite)->Arg(kLegacy)->Arg(kFramed)->Arg(kSnappy)->UseRealTime();
+
+// range(0): format of the file.
+// range(1): whether to read from a MemoryMappedFile.
+static void RecordReaderRead(benchmark::State& state) {
+    WriteRecords(state.range(0));
+    toft::scoped_ptr<toft::File> file(toft::File::Open(kFilePath, "r"));
+    toft::MemoryMappedFile mapped_file;
+    toft::scoped_ptr<toft::RecordReader> reader;
+    if (state.range(1)) {
+        mapped_file.Open(kFilePath);
+        reader.reset(new toft::RecordReader(&mapped_file));
+    } else {
+        reader.reset(new toft::RecordReader(file.get()));
+    }
+    int64_t count = 0;
+    for (auto _ : state) {
+        reader->Reset();
+        while (reader->Next() == 1) {
+            toft::StringPiece record;
+            reader->ReadRecord(&record);
+            benchmark::DoNotOptimize(record.data());
+            ++count;
+        }
+    }
+    state.SetItemsProcessed(count);
+    reader.reset();
+    file->Close();
+    toft::File::Delete(kFilePath);
+}
+BENCHMARK(RecordReaderRead)
+    ->ArgsProduct({{kLegacy, kFramed, kSnappy}, {0, 1}})
+    ->UseRealTime();
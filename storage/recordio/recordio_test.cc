@@ -9,8 +9,10 @@
 
 #include "thirdparty/gtest/gtest.h"
 #include "toft/base/scoped_ptr.h"
+#include "toft/base/string/number.h"
 #include "toft/base/string/string_piece.h"
 #include "toft/storage/file/file.h"
+#include "toft/storage/file/memory_mapped_file.h"
 
 #include "toft/storage/recordio/document.pb.h"
 
@@ -130,4 +132,430 @@ TEST_F(RecordIOTest, StringPiece) {
     ASSERT_TRUE(file->Close());
 }
 
+// Framed records written with small blocks, so records cross blocks.
+class FramedRecordIOTest : public ::testing::Test {
+protected:
+    FramedRecordIOTest() : m_file_path("./test_framed.dat") {
+        m_options.block_size = 256;
+        m_options.buffer_size = 1000;
+    }
+    virtual void SetUp() {
+        File::Delete(m_file_path);
+    }
+    virtual void TearDown() {
+        File::Delete(m_file_path);
+    }
+
+    void WriteRecords(const char* mode, int begin, int end, bool finish = false) {
+        scoped_ptr<File> file(File::Open(m_file_path, mode));
+        ASSERT_TRUE(file != NULL);
+        RecordWriter writer(file.get(), m_options);
+        for (int i = begin; i < end; ++i) {
+            ASSERT_TRUE(writer.WriteRecord(MakeRecord(i)));
+        }
+        if (finish) {
+            ASSERT_TRUE(writer.Finish());
+        } else {
+            ASSERT_TRUE(writer.Flush());
+        }
+        ASSERT_TRUE(file->Close());
+    }
+
+    // Read records of ranges of range_size bytes, check each record is read
+    // once.
+    void ReadRanges(int64_t range_size, int record_count) {
+        scoped_ptr<File> file(File::Open(m_file_path, "r"));
+        RecordReader reader(file.get());
+        int next = 0;
+        for (int64_t start = 0; start < reader.file_size(); start += range_size) {
+            ASSERT_TRUE(reader.ResetRange(start, start + range_size));
+            while (reader.Next() == 1) {
+                std::string record;
+                ASSERT_TRUE(reader.ReadRecord(&record));
+                ASSERT_EQ(MakeRecord(next), record);
+                ++next;
+            }
+            EXPECT_EQ(0, reader.skipped_bytes());
+        }
+        EXPECT_EQ(record_count, next);
+    }
+
+    void ExpectSeekToRecord(int index) {
+        scoped_ptr<File> file(File::Open(m_file_path, "r"));
+        RecordReader reader(file.get());
+        ASSERT_TRUE(reader.SeekToRecord(index)) << index;
+        ASSERT_EQ(1, reader.Next()) << index;
+        std::string record;
+        ASSERT_TRUE(reader.ReadRecord(&record));
+        EXPECT_EQ(MakeRecord(index), record);
+    }
+
+    // Record i has i bytes and ends with the number i.
+    static std::string MakeRecord(int i) {
+        std::string record = NumberToString(i);
+        if (record.size() < static_cast<size_t>(i)) {
+            record.insert(0, i - record.size(), 'x');
+        }
+        return record.substr(record.size() - i);
+    }
+
+    void ReplaceFileContent(const std::string& content) {
+        scoped_ptr<File> file(File::Open(m_file_path, "w"));
+        ASSERT_TRUE(file != NULL);
+        ASSERT_EQ(static_cast<int64_t>(content.size()),
+                  file->Write(content.data(), content.size()));
+        ASSERT_TRUE(file->Close());
+    }
+
+protected:
+    std::string m_file_path;
+    RecordWriterOptions m_options;
+};
+
+TEST_F(FramedRecordIOTest, WriteAndRead) {
+    WriteRecords("w", 0, 1000);
+
+    scoped_ptr<File> file(File::Open(m_file_path, "r"));
+    RecordReader reader(file.get());
+    EXPECT_TRUE(reader.is_framed());
+    for (int i = 0; i < 1000; ++i) {
+        ASSERT_EQ(1, reader.Next()) << i;
+        StringPiece record;
+        ASSERT_TRUE(reader.ReadRecord(&record));
+        ASSERT_EQ(MakeRecord(i), record);
+    }
+    EXPECT_EQ(0, reader.Next());
+    EXPECT_EQ(0, reader.skipped_bytes());
+
+    // Read again.
+    ASSERT_TRUE(reader.Reset());
+    ASSERT_EQ(1, reader.Next());
+    std::string record;
+    ASSERT_TRUE(reader.ReadRecord(&record));
+    EXPECT_EQ(MakeRecord(0), record);
+}
+
+TEST_F(FramedRecordIOTest, Message) {
+    recordio_test::Document document;
+    document.set_docid(10);
+    document.add_name()->set_url("http://A");
+    {
+        scoped_ptr<File> file(File::Open(m_file_path, "w"));
+        RecordWriter writer(file.get(), m_options);
+        ASSERT_TRUE(writer.WriteMessage(document));
+        ASSERT_TRUE(writer.Flush());
+    }
+
+    scoped_ptr<File> file(File::Open(m_file_path, "r"));
+    RecordReader reader(file.get());
+    recordio_test::Document message;
+    ASSERT_TRUE(reader.ReadNextMessage(&message));
+    EXPECT_EQ(document.SerializeAsString(), message.SerializeAsString());
+    EXPECT_FALSE(reader.ReadNextMessage(&message));
+}
+
+TEST_F(FramedRecordIOTest, Append) {
+    WriteRecords("w", 0, 50);
+    WriteRecords("a", 50, 100);
+
+    scoped_ptr<File> file(File::Open(m_file_path, "r"));
+    RecordReader reader(file.get());
+    for (int i = 0; i < 100; ++i) {
+        ASSERT_EQ(1, reader.Next()) << i;
+        std::string record;
+        ASSERT_TRUE(reader.ReadRecord(&record));
+        ASSERT_EQ(MakeRecord(i), record);
+    }
+    EXPECT_EQ(0, reader.Next());
+}
+
+// Records in corrupted blocks are lost, and reading goes on from the next block.
+TEST_F(FramedRecordIOTest, Corruption) {
+    WriteRecords("w", 0, 100);
+    std::string content;
+    ASSERT_TRUE(File::ReadAll(m_file_path, &content));
+    ASSERT_GT(content.size(), 10u * m_options.block_size);
+    content[m_options.block_size * 3 + 100] ^= 0x55;
+    ReplaceFileContent(content);
+
+    scoped_ptr<File> file(File::Open(m_file_path, "r"));
+    RecordReader reader(file.get());
+    int last = -1;
+    int count = 0;
+    while (reader.Next() == 1) {
+        std::string record;
+        ASSERT_TRUE(reader.ReadRecord(&record));
+        int i = static_cast<int>(record.size());
+        ASSERT_EQ(MakeRecord(i), record);
+        ASSERT_GT(i, last);
+        last = i;
+        ++count;
+    }
+    EXPECT_EQ(99, last);
+    EXPECT_LT(count, 100);
+    EXPECT_GT(count, 90);
+    EXPECT_GT(reader.skipped_bytes(), 0);
+}
+
+// The record being written when crashed is ignored.
+TEST_F(FramedRecordIOTest, Truncated) {
+    WriteRecords("w", 0, 100);
+    std::string content;
+    ASSERT_TRUE(File::ReadAll(m_file_path, &content));
+    ReplaceFileContent(content.substr(0, content.size() - 10));
+
+    scoped_ptr<File> file(File::Open(m_file_path, "r"));
+    RecordReader reader(file.get());
+    for (int i = 0; i < 99; ++i) {
+        ASSERT_EQ(1, reader.Next()) << i;
+    }
+    EXPECT_EQ(0, reader.Next());
+    EXPECT_GT(reader.skipped_bytes(), 0);
+}
+
+TEST_F(FramedRecordIOTest, Compressed) {
+    WriteRecords("w", 0, 1000);
+    std::string uncompressed;
+    ASSERT_TRUE(File::ReadAll(m_file_path, &uncompressed));
+
+    m_options.compression = "snappy";
+    m_options.chunk_size = 1000;
+    WriteRecords("w", 0, 1000);
+    WriteRecords("a", 1000, 1100);
+    std::string compressed;
+    ASSERT_TRUE(File::ReadAll(m_file_path, &compressed));
+    EXPECT_LT(compressed.size() * 3, uncompressed.size());
+
+    scoped_ptr<File> file(File::Open(m_file_path, "r"));
+    RecordReader reader(file.get());
+    EXPECT_TRUE(reader.is_framed());
+    for (int i = 0; i < 1100; ++i) {
+        ASSERT_EQ(1, reader.Next()) << i;
+        StringPiece record;
+        ASSERT_TRUE(reader.ReadRecord(&record));
+        ASSERT_EQ(MakeRecord(i), record);
+    }
+    EXPECT_EQ(0, reader.Next());
+    EXPECT_EQ(0, reader.skipped_bytes());
+}
+
+// Records in the corrupted chunk are lost.
+TEST_F(FramedRecordIOTest, CompressedCorruption) {
+    m_options.compression = "snappy";
+    m_options.chunk_size = 1000;
+    WriteRecords("w", 0, 1000);
+    std::string content;
+    ASSERT_TRUE(File::ReadAll(m_file_path, &content));
+    content[content.size() / 2] ^= 0x55;
+    ReplaceFileContent(content);
+
+    scoped_ptr<File> file(File::Open(m_file_path, "r"));
+    RecordReader reader(file.get());
+    int last = -1;
+    int count = 0;
+    while (reader.Next() == 1) {
+        std::string record;
+        ASSERT_TRUE(reader.ReadRecord(&record));
+        int i = static_cast<int>(record.size());
+        ASSERT_EQ(MakeRecord(i), record);
+        ASSERT_GT(i, last);
+        last = i;
+        ++count;
+    }
+    EXPECT_EQ(999, last);
+    EXPECT_LT(count, 1000);
+    EXPECT_GT(count, 900);
+    EXPECT_GT(reader.skipped_bytes(), 0);
+}
+
+TEST_F(FramedRecordIOTest, UnknownCompression) {
+    m_options.compression = "snappy";
+    WriteRecords("w", 0, 10);
+    std::string content;
+    ASSERT_TRUE(File::ReadAll(m_file_path, &content));
+    size_t pos = content.find("snappy");
+    ASSERT_NE(std::string::npos, pos);
+    content.replace(pos, 6, "zappy!");
+    ReplaceFileContent(content);
+
+    scoped_ptr<File> file(File::Open(m_file_path, "r"));
+    RecordReader reader(file.get());
+    EXPECT_FALSE(reader.Reset());
+    EXPECT_EQ(-1, reader.Next());
+}
+
+TEST_F(FramedRecordIOTest, Ranges) {
+    WriteRecords("w", 0, 1000, true);
+    ReadRanges(37, 1000);
+    ReadRanges(100, 1000);
+    ReadRanges(m_options.block_size, 1000);
+    ReadRanges(1000, 1000);
+    ReadRanges(1 << 30, 1000);
+}
+
+TEST_F(FramedRecordIOTest, CompressedRanges) {
+    m_options.compression = "snappy";
+    m_options.chunk_size = 1000;
+    WriteRecords("w", 0, 1000, true);
+    ReadRanges(7, 1000);
+    ReadRanges(m_options.block_size, 1000);
+    ReadRanges(3000, 1000);
+}
+
+TEST_F(FramedRecordIOTest, SeekToRecord) {
+    m_options.index_interval = 10;
+    WriteRecords("w", 0, 1000, true);
+    ExpectSeekToRecord(0);
+    ExpectSeekToRecord(1);
+    ExpectSeekToRecord(10);
+    ExpectSeekToRecord(555);
+    ExpectSeekToRecord(999);
+
+    scoped_ptr<File> file(File::Open(m_file_path, "r"));
+    RecordReader reader(file.get());
+    EXPECT_TRUE(reader.SeekToRecord(1000));
+    EXPECT_EQ(0, reader.Next());
+    EXPECT_FALSE(reader.SeekToRecord(1001));
+
+    // The index is invisible to normal reading.
+    ASSERT_TRUE(reader.Reset());
+    int count = 0;
+    while (reader.Next() == 1) {
+        ++count;
+    }
+    EXPECT_EQ(1000, count);
+    EXPECT_EQ(0, reader.skipped_bytes());
+}
+
+TEST_F(FramedRecordIOTest, CompressedSeekToRecord) {
+    m_options.compression = "snappy";
+    m_options.chunk_size = 1000;
+    WriteRecords("w", 0, 1000, true);
+    ExpectSeekToRecord(0);
+    ExpectSeekToRecord(321);
+    ExpectSeekToRecord(999);
+}
+
+// Without index, records are skipped from the beginning.
+TEST_F(FramedRecordIOTest, SeekToRecordWithoutIndex) {
+    WriteRecords("w", 0, 500, true);
+    WriteRecords("a", 500, 1000, true);
+    ExpectSeekToRecord(0);
+    ExpectSeekToRecord(777);
+    ReadRanges(100, 1000);
+}
+
+// Records read from the mapped file point into the mapping.
+TEST_F(FramedRecordIOTest, MemoryMapped) {
+    m_options.index_interval = 10;
+    WriteRecords("w", 0, 1000, true);
+    MemoryMappedFile mapped_file;
+    ASSERT_TRUE(mapped_file.Open(m_file_path));
+    RecordReader reader(&mapped_file);
+    EXPECT_TRUE(reader.is_framed());
+    EXPECT_EQ(static_cast<int64_t>(mapped_file.size()), reader.file_size());
+    const char* mapped_end = mapped_file.data() + mapped_file.size();
+    int mapped_count = 0;
+    for (int i = 0; i < 1000; ++i) {
+        ASSERT_EQ(1, reader.Next()) << i;
+        StringPiece record;
+        ASSERT_TRUE(reader.ReadRecord(&record));
+        ASSERT_EQ(MakeRecord(i), record);
+        // Only records of more than one fragment are copied.
+        if (record.data() >= mapped_file.data() && record.data() < mapped_end) {
+            ++mapped_count;
+        }
+    }
+    EXPECT_EQ(0, reader.Next());
+    EXPECT_GT(mapped_count, 100);
+    EXPECT_EQ(0, reader.skipped_bytes());
+
+    ASSERT_TRUE(reader.SeekToRecord(555));
+    ASSERT_EQ(1, reader.Next());
+    std::string record;
+    ASSERT_TRUE(reader.ReadRecord(&record));
+    EXPECT_EQ(MakeRecord(555), record);
+
+    ASSERT_TRUE(reader.ResetRange(m_options.block_size, 2 * m_options.block_size));
+    int count = 0;
+    while (reader.Next() == 1) {
+        ++count;
+    }
+    EXPECT_GT(count, 0);
+}
+
+TEST_F(FramedRecordIOTest, MemoryMappedCompressed) {
+    m_options.compression = "snappy";
+    m_options.chunk_size = 1000;
+    WriteRecords("w", 0, 1000, true);
+    MemoryMappedFile mapped_file;
+    ASSERT_TRUE(mapped_file.Open(m_file_path));
+    RecordReader reader(&mapped_file);
+    for (int i = 0; i < 1000; ++i) {
+        ASSERT_EQ(1, reader.Next()) << i;
+        StringPiece record;
+        ASSERT_TRUE(reader.ReadRecord(&record));
+        ASSERT_EQ(MakeRecord(i), record);
+    }
+    EXPECT_EQ(0, reader.Next());
+}
+
+TEST_F(FramedRecordIOTest, MemoryMappedCorruption) {
+    WriteRecords("w", 0, 100);
+    std::string content;
+    ASSERT_TRUE(File::ReadAll(m_file_path, &content));
+    content[m_options.block_size * 3 + 100] ^= 0x55;
+    ReplaceFileContent(content.substr(0, content.size() - 10));
+
+    MemoryMappedFile mapped_file;
+    ASSERT_TRUE(mapped_file.Open(m_file_path));
+    RecordReader reader(&mapped_file);
+    int count = 0;
+    while (reader.Next() == 1) {
+        ++count;
+    }
+    EXPECT_LT(count, 99);
+    EXPECT_GT(count, 90);
+    EXPECT_GT(reader.skipped_bytes(), 0);
+}
+
+TEST_F(FramedRecordIOTest, MemoryMappedLegacy) {
+    {
+        scoped_ptr<File> file(File::Open(m_file_path, "w"));
+        RecordWriter writer(file.get());
+        ASSERT_TRUE(writer.WriteRecord(StringPiece("hello")));
+        ASSERT_TRUE(writer.WriteRecord(StringPiece("world")));
+    }
+    MemoryMappedFile mapped_file;
+    ASSERT_TRUE(mapped_file.Open(m_file_path));
+    RecordReader reader(&mapped_file);
+    EXPECT_FALSE(reader.is_framed());
+    StringPiece record;
+    ASSERT_EQ(1, reader.Next());
+    ASSERT_TRUE(reader.ReadRecord(&record));
+    EXPECT_EQ("hello", record);
+    ASSERT_EQ(1, reader.Next());
+    ASSERT_TRUE(reader.ReadRecord(&record));
+    EXPECT_EQ("world", record);
+    EXPECT_EQ(0, reader.Next());
+}
+
+TEST_F(FramedRecordIOTest, LegacyTruncated) {
+    {
+        scoped_ptr<File> file(File::Open(m_file_path, "w"));
+        RecordWriter writer(file.get());
+        ASSERT_TRUE(writer.WriteRecord(StringPiece("hello")));
+        ASSERT_TRUE(writer.WriteRecord(StringPiece("world")));
+    }
+    std::string content;
+    ASSERT_TRUE(File::ReadAll(m_file_path, &content));
+    ReplaceFileContent(content.substr(0, content.size() - 1));
+
+    scoped_ptr<File> file(File::Open(m_file_path, "r"));
+    RecordReader reader(file.get());
+    EXPECT_FALSE(reader.is_framed());
+    ASSERT_EQ(1, reader.Next());
+    EXPECT_EQ(-1, reader.Next());
+}
+
 } // namespace toft
@@ -5,10 +5,21 @@
 
 #include "toft/storage/recordio/reverse_recordio.h"
 
+#include <string.h>
+#include <algorithm>
+
+#include "toft/storage/file/memory_mapped_file.h"
+
 #include "thirdparty/glog/logging.h"
 
 namespace toft {
 
+namespace {
+
+const int64_t kReadAheadSize = 1024 * 1024;
+
+} // namespace
+
 ReverseRecordWriter::ReverseRecordWriter(File *file)
     : m_file(file) {
     CHECK(m_file != NULL);
@@ -66,15 +77,39 @@ bool ReverseRecordWriter::Write(const char *data, uint32_t size) {
 
 ReverseRecordReader::ReverseRecordReader(File *file)
     : m_file(file),
-      m_buffer_size(1 * 1024 * 1024) {
+      m_mapped_file(NULL),
+      m_buffer_size(1 * 1024 * 1024),
+      m_data(NULL),
+      m_data_size(0),
+      m_position(0),
+      m_read_ahead_offset(0) {
     CHECK(m_file != NULL);
     m_buffer.reset(new char[m_buffer_size]);
     Reset();
 }
 
+ReverseRecordReader::ReverseRecordReader(const MemoryMappedFile* mapped_file)
+    : m_file(NULL),
+      m_mapped_file(mapped_file),
+      m_buffer_size(0),
+      m_data(NULL),
+      m_data_size(0),
+      m_position(0),
+      m_read_ahead_offset(0) {
+    CHECK(m_mapped_file != NULL && m_mapped_file->IsOpen());
+    Reset();
+}
+
 ReverseRecordReader::~ReverseRecordReader() {}
 
 bool ReverseRecordReader::Reset() {
+    if (m_mapped_file != NULL) {
+        m_position = m_mapped_file->size();
+        m_read_ahead_offset = m_position;
+        m_mapped_file->Advise(0, m_position, MemoryMappedFile::kAdviceRandom);
+        ReadAhead();
+        return true;
+    }
     if (!m_file->Seek(0, SEEK_END)) {
         LOG(ERROR) << "ReverseRecordReader Reset error.";
         return false;
@@ -83,6 +118,10 @@ bool ReverseRecordReader::Reset() {
 }
 
 int ReverseRecordReader::Next() {
+    if (m_mapped_file != NULL) {
+        return NextMapped();
+    }
+
     // read size
     int64_t ret = m_file->Tell();
     if (ret == -1) {
@@ -121,13 +160,45 @@ int ReverseRecordReader::Next() {
             LOG(ERROR) << "Read data error.";
             return -1;
         }
+        m_data = m_buffer.get();
     }
 
     return 1;
 }
 
+int ReverseRecordReader::NextMapped() {
+    if (m_position == 0) {
+        return 0;
+    }
+    if (m_position < static_cast<int64_t>(sizeof(m_data_size))) {
+        LOG(ERROR) << "Truncated record size at " << m_position;
+        return -1;
+    }
+    m_position -= sizeof(m_data_size);
+    memcpy(&m_data_size, m_mapped_file->data() + m_position, sizeof(m_data_size));
+    if (m_position < m_data_size) {
+        LOG(ERROR) << "Truncated record data at " << m_position;
+        return -1;
+    }
+    m_position -= m_data_size;
+    m_data = m_mapped_file->data() + m_position;
+    ReadAhead();
+    return 1;
+}
+
+void ReverseRecordReader::ReadAhead() {
+    // Keep at least one window before the position being loaded.
+    if (m_position - kReadAheadSize >= m_read_ahead_offset) {
+        return;
+    }
+    int64_t offset = std::max<int64_t>(m_position - 2 * kReadAheadSize, 0);
+    m_mapped_file->Advise(offset, m_read_ahead_offset - offset,
+                          MemoryMappedFile::kAdviceWillNeed);
+    m_read_ahead_offset = offset;
+}
+
 bool ReverseRecordReader::ReadMessage(::google::protobuf::Message *message) {
-    if (!message->ParseFromArray(m_buffer.get(), m_data_size)) {
+    if (!message->ParseFromArray(m_data, m_data_size)) {
         LOG(WARNING) << "Missing required fields.";
         return false;
     }
@@ -136,8 +207,7 @@ bool ReverseRecordReader::ReadMessage(::google::protobuf::Message *message) {
 
 bool ReverseRecordReader::ReadNextMessage(::google::protobuf::Message *message) {
     while (Next() == 1) {
-        std::string str(m_buffer.get(), m_data_size);
-        if (message->ParseFromArray(m_buffer.get(), m_data_size)) {
+        if (message->ParseFromArray(m_data, m_data_size)) {
             return true;
         }
     }
@@ -145,13 +215,13 @@ bool ReverseRecordReader::ReadNextMessage(::google::protobuf::Message *message)
 }
 
 bool ReverseRecordReader::ReadRecord(const char **data, uint32_t *size) {
-    *data = m_buffer.get();
+    *data = m_data;
     *size = m_data_size;
     return true;
 }
 
 bool ReverseRecordReader::ReadRecord(std::string *data) {
-    data->assign(m_buffer.get(), m_data_size);
+    data->assign(m_data, m_data_size);
     return true;
 }
 
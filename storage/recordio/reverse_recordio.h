@@ -15,6 +15,8 @@
 
 namespace toft {
 
+class MemoryMappedFile;
+
 class ReverseRecordWriter {
 public:
     explicit ReverseRecordWriter(File *file);
@@ -32,9 +34,16 @@ private:
     File* m_file;
 };
 
+// Read records from the end to the beginning of the file.
+//
+// A reader of a MemoryMappedFile returns records in the mapped memory,
+// without copy and system calls. Pages before the current position are
+// loaded in advance, because the kernel only reads ahead forward. The
+// mapped file must be open while the reader is used.
 class ReverseRecordReader {
 public:
     explicit ReverseRecordReader(File *file);
+    explicit ReverseRecordReader(const MemoryMappedFile* mapped_file);
     ~ReverseRecordReader();
 
     bool Reset();
@@ -51,13 +60,19 @@ public:
     bool ReadRecord(StringPiece* data);
 
 private:
+    int NextMapped();
+    void ReadAhead();
     bool Read(char *data, uint32_t size);
 
 private:
     File* m_file;
+    const MemoryMappedFile* m_mapped_file;
     scoped_array<char> m_buffer;
     uint32_t m_buffer_size;
+    const char* m_data;
     uint32_t m_data_size;
+    int64_t m_position;          // End of unread records in mapped file
+    int64_t m_read_ahead_offset; // Pages after it are advised to be loaded
 };
 
 } // namespace toft
@@ -11,6 +11,7 @@
 #include "toft/base/scoped_ptr.h"
 #include "toft/base/string/string_piece.h"
 #include "toft/storage/file/file.h"
+#include "toft/storage/file/memory_mapped_file.h"
 
 #include "toft/storage/recordio/document.pb.h"
 
@@ -181,4 +182,33 @@ TEST_F(ReverseRecordIOTest, StringPiece) {
     ASSERT_TRUE(file->Close());
 }
 
+TEST_F(ReverseRecordIOTest, MemoryMapped) {
+    // write records, larger than the read ahead window
+    scoped_ptr<File> file(File::Open("./test_memory_mapped.dat", "w"));
+    m_writer.reset(new ReverseRecordWriter(file.get()));
+    std::string record(1000, 'x');
+    for (int i = 0; i < 5000; ++i) {
+        record[0] = static_cast<char>(i);
+        ASSERT_TRUE(m_writer->WriteRecord(record));
+    }
+    ASSERT_TRUE(file->Close());
+
+    // read records
+    MemoryMappedFile mapped_file;
+    ASSERT_TRUE(mapped_file.Open("./test_memory_mapped.dat"));
+    m_reader.reset(new ReverseRecordReader(&mapped_file));
+    for (int i = 4999; i >= 0; --i) {
+        ASSERT_EQ(1, m_reader->Next()) << i;
+        StringPiece sp;
+        ASSERT_TRUE(m_reader->ReadRecord(&sp));
+        ASSERT_EQ(1000u, sp.size());
+        ASSERT_EQ(static_cast<char>(i), sp[0]);
+        EXPECT_GE(sp.data(), mapped_file.data());
+    }
+    ASSERT_EQ(0, m_reader->Next());
+
+    ASSERT_TRUE(m_reader->Reset());
+    ASSERT_EQ(1, m_reader->Next());
+}
+
 } // namespace toft
@@ -0,0 +1,106 @@
+// Copyright (c) 2026, The Toft Authors.
+// All rights reserved.
+//
+// Cache of decoded data blocks shared by sstable readers.
+
+#ifndef TOFT_STORAGE_SSTABLE_BLOCK_CACHE_H
+#define TOFT_STORAGE_SSTABLE_BLOCK_CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "toft/base/functional.h"
+#include "toft/base/scoped_ptr.h"
+#include "toft/base/shared_ptr.h"
+#include "toft/base/uncopyable.h"
+#include "toft/container/sharded_lru_cache.h"
+#include "toft/system/atomic/atomic.h"
+
+namespace toft {
+namespace hfile {
+class DataBlock;
+} // namespace hfile
+
+// Identify a data block of an opened sstable file.
+struct BlockCacheKey {
+    BlockCacheKey() : file_id(0), offset(0) {}
+    BlockCacheKey(uint64_t id, int64_t off) : file_id(id), offset(off) {}
+    uint64_t file_id;
+    int64_t offset;
+
+    bool operator==(const BlockCacheKey& rhs) const {
+        return file_id == rhs.file_id && offset == rhs.offset;
+    }
+    bool operator<(const BlockCacheKey& rhs) const {
+        return file_id < rhs.file_id || (file_id == rhs.file_id && offset < rhs.offset);
+    }
+};
+
+struct BlockCacheKeyHash {
+    size_t operator()(const BlockCacheKey& key) const {
+        return static_cast<size_t>(key.file_id * 0xC6A4A7935BD1E995ULL ^ key.offset);
+    }
+};
+
+// A thread safe cache of uncompressed data blocks, which can be shared by
+// many sstable readers, limited by total uncompressed bytes of blocks.
+//
+// Each opened file gets an unique id by NewFileId(), so blocks of different
+// files and different opening of the same file never conflict.
+//
+// Example:
+//   SSTableReadOption option;
+//   option.set_block_cache(BlockCache::Default());
+//   SSTableReader* reader = SSTableReader::Open(path, option);
+class BlockCache {
+    TOFT_DECLARE_UNCOPYABLE(BlockCache);
+
+public:
+    static const int kDefaultShardBits = 4;
+
+    explicit BlockCache(size_t capacity, int shard_bits = kDefaultShardBits);
+    ~BlockCache();
+
+    // The process wide shared cache, sized by --sstable_block_cache_bytes.
+    static BlockCache* Default();
+
+    uint64_t NewFileId() {
+        return ++m_last_file_id;
+    }
+
+    // Return NULL if not found.
+    std::shared_ptr<hfile::DataBlock> Lookup(uint64_t file_id, int64_t offset);
+
+    // Insert the block with its charge, usually the uncompressed size.
+    void Insert(uint64_t file_id, int64_t offset,
+                const std::shared_ptr<hfile::DataBlock>& block,
+                size_t charge);
+
+    void Erase(uint64_t file_id, int64_t offset);
+
+    size_t Capacity() const {
+        return m_cache.Capacity();
+    }
+
+    // Total charge of cached blocks.
+    size_t Charge() const {
+        return m_cache.Charge();
+    }
+
+    void GetStats(CacheStats* stats) const {
+        m_cache.GetStats(stats);
+    }
+
+    // hits / (hits + misses), 0 if no lookup at all.
+    double HitRate() const;
+
+private:
+    typedef ShardedLruCache<BlockCacheKey, std::shared_ptr<hfile::DataBlock>,
+                            Mutex, BlockCacheKeyHash> Cache;
+    Atomic<uint64_t> m_last_file_id;
+    Cache m_cache;
+};
+
+}  // namespace toft
+
+#endif  // TOFT_STORAGE_SSTABLE_BLOCK_CACHE_H
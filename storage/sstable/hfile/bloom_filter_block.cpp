@@ -0,0 +1,118 @@
+// Copyright (c) 2026, The Toft Authors.
+// All rights reserved.
+//
+// Encoding and decoding of BloomFilterBlock.
+
+#include "toft/storage/sstable/hfile/bloom_filter_block.h"
+
+#include <math.h>
+
+#include <algorithm>
+
+#include "toft/base/string/algorithm.h"
+#include "toft/container/bloom_filter.h"
+#include "toft/storage/sstable/hfile/coding.h"
+
+#include "thirdparty/glog/logging.h"
+
+namespace toft {
+namespace hfile {
+
+const char BloomFilterBlock::kMetaBlockName[] = "BLOOM_FILTER";
+
+static const std::string kBloomBlockMagic = "BLMBLK\41\43";
+
+BloomFilterBlock::BloomFilterBlock(int bits_per_key)
+                : bits_per_key_(bits_per_key),
+                  buffer_(kBloomBlockMagic) {
+    CHECK_GT(bits_per_key_, 0);
+}
+
+BloomFilterBlock::~BloomFilterBlock() {
+    Clear();
+}
+
+void BloomFilterBlock::Clear() {
+    for (size_t i = 0; i < filters_.size(); ++i)
+        delete filters_[i];
+    filters_.clear();
+}
+
+void BloomFilterBlock::AddKey(const StringPiece &key) {
+    keys_.append(key.data(), key.size());
+    key_lengths_.push_back(key.size());
+}
+
+void BloomFilterBlock::FinishDataBlock() {
+    // Each filter is: number of hashes, bitmap size, bitmap.
+    if (key_lengths_.empty()) {
+        PutFixed32(&buffer_, 0);
+        PutFixed32(&buffer_, 0);
+        filters_.push_back(NULL);
+        return;
+    }
+    // k = ln2 * m / n is optimal.
+    size_t num_hashes = static_cast<size_t>(bits_per_key_ * log(2.0) + 0.5);
+    num_hashes = std::max<size_t>(1, std::min<size_t>(num_hashes, 30));
+    size_t bitmap_size = (key_lengths_.size() * bits_per_key_ + 7) / 8;
+    // Too small filter has high false positive rate.
+    bitmap_size = std::max<size_t>(bitmap_size, 8);
+
+    BloomFilter *filter = new BloomFilter(bitmap_size, num_hashes);
+    const char *key = keys_.data();
+    for (size_t i = 0; i < key_lengths_.size(); ++i) {
+        filter->Insert(key, key_lengths_[i]);
+        key += key_lengths_[i];
+    }
+    PutFixed32(&buffer_, num_hashes);
+    PutFixed32(&buffer_, bitmap_size);
+    buffer_.append(reinterpret_cast<const char*>(filter->GetBitmap()), bitmap_size);
+    filters_.push_back(filter);
+
+    keys_.clear();
+    key_lengths_.clear();
+}
+
+bool BloomFilterBlock::DecodeFromString(const std::string &str) {
+    if (!StringStartsWith(str, kBloomBlockMagic)) {
+        LOG(ERROR)<< "invalid bloom filter block header";
+        return false;
+    }
+    Clear();
+    buffer_ = str;
+    const char *begin = buffer_.data() + kBloomBlockMagic.size();
+    const char *end = buffer_.data() + buffer_.size();
+    while (begin < end) {
+        if (end - begin < static_cast<int>(2 * sizeof(uint32_t))) {
+            LOG(ERROR)<< "incomplete bloom filter block";
+            return false;
+        }
+        uint32_t num_hashes = ReadInt32(&begin);
+        uint32_t bitmap_size = ReadInt32(&begin);
+        if (static_cast<uint32_t>(end - begin) < bitmap_size) {
+            LOG(ERROR)<< "incomplete bloom filter block";
+            return false;
+        }
+        BloomFilter *filter = NULL;
+        if (bitmap_size > 0) {
+            // Refer to the bitmap in buffer_ without copying.
+            filter = new BloomFilter(const_cast<char*>(begin), bitmap_size,
+                                     num_hashes, false);
+        }
+        filters_.push_back(filter);
+        begin += bitmap_size;
+    }
+    return true;
+}
+
+bool BloomFilterBlock::MayContain(int block_id, const StringPiece &key) const {
+    if (block_id < 0 || block_id >= static_cast<int>(filters_.size()))
+        return true;
+    const BloomFilter *filter = filters_[block_id];
+    if (filter == NULL)
+        return false;
+    return filter->MayContain(key.data(), key.size());
+}
+
+}  // namespace hfile
+}  // namespace toft
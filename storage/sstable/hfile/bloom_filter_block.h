@@ -0,0 +1,71 @@
+// Copyright (c) 2026, The Toft Authors.
+// All rights reserved.
+//
+// Meta block of bloom filters, one for each data block.
+
+#ifndef TOFT_STORAGE_SSTABLE_HFILE_BLOOM_FILTER_BLOCK_H
+#define TOFT_STORAGE_SSTABLE_HFILE_BLOOM_FILTER_BLOCK_H
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "toft/base/string/string_piece.h"
+#include "toft/storage/sstable/hfile/block.h"
+
+namespace toft {
+class BloomFilter;
+
+namespace hfile {
+
+// Bloom filters of data blocks, one filter for each data block, so the
+// filters can be built while the blocks are written, without knowing the
+// total number of keys.
+//
+// It's stored as a meta block named kMetaBlockName.
+class BloomFilterBlock : public Block {
+    TOFT_DECLARE_UNCOPYABLE(BloomFilterBlock);
+
+public:
+    static const char kMetaBlockName[];
+
+    // bits_per_key is only used for writing, 10 bits gives about 1% false
+    // positive rate.
+    explicit BloomFilterBlock(int bits_per_key = 10);
+    ~BloomFilterBlock();
+
+    virtual const std::string EncodeToString() const {
+        return buffer_;
+    }
+    virtual bool DecodeFromString(const std::string &str);
+
+    // Add a key of the current data block.
+    void AddKey(const StringPiece &key);
+    // Build the filter of keys added since the last call, call it once for
+    // each data block, even if the block is empty.
+    void FinishDataBlock();
+
+    int GetFilterCount() const {
+        return filters_.size();
+    }
+    // Return false if the key is definitely not in the data block.
+    bool MayContain(int block_id, const StringPiece &key) const;
+
+private:
+    void Clear();
+
+    int bits_per_key_;
+    // Keys of the current data block.
+    std::string keys_;
+    std::vector<uint32_t> key_lengths_;
+
+    std::string buffer_;
+    // Decoded filters, NULL for empty data blocks, bitmaps are in buffer_.
+    std::vector<BloomFilter*> filters_;
+};
+
+}  // namespace hfile
+}  // namespace toft
+
+#endif  // TOFT_STORAGE_SSTABLE_HFILE_BLOOM_FILTER_BLOCK_H
@@ -0,0 +1,63 @@
+// Copyright (c) 2026, The Toft Authors.
+// All rights reserved.
+//
+// Tests of BloomFilterBlock.
+
+#include "toft/storage/sstable/hfile/bloom_filter_block.h"
+
+#include <string>
+
+#include "toft/base/string/number.h"
+
+#include "thirdparty/gtest/gtest.h"
+
+namespace toft {
+namespace hfile {
+
+TEST(BloomFilterBlock, EncodeDecode) {
+    const int kBlockNum = 10;
+    const int kKeyNum = 1000;
+    BloomFilterBlock block;
+    for (int i = 0; i < kBlockNum; ++i) {
+        for (int j = 0; j < kKeyNum; ++j)
+            block.AddKey("key_" + NumberToString(i * kKeyNum + j));
+        block.FinishDataBlock();
+    }
+    // An empty data block.
+    block.FinishDataBlock();
+    EXPECT_EQ(kBlockNum + 1, block.GetFilterCount());
+
+    BloomFilterBlock decoded;
+    ASSERT_TRUE(decoded.DecodeFromString(block.EncodeToString()));
+    ASSERT_EQ(kBlockNum + 1, decoded.GetFilterCount());
+    int false_positives = 0;
+    for (int i = 0; i < kBlockNum; ++i) {
+        for (int j = 0; j < kKeyNum; ++j) {
+            // No false negative.
+            EXPECT_TRUE(decoded.MayContain(i, "key_" + NumberToString(i * kKeyNum + j)));
+            if (decoded.MayContain(i, "missing_" + NumberToString(j)))
+                ++false_positives;
+        }
+    }
+    // About 1% with 10 bits per key.
+    EXPECT_LT(false_positives, kBlockNum * kKeyNum * 3 / 100);
+    EXPECT_FALSE(decoded.MayContain(kBlockNum, "key_0"));
+    // Out of range block is not filtered.
+    EXPECT_TRUE(decoded.MayContain(kBlockNum + 1, "key_0"));
+}
+
+TEST(BloomFilterBlock, BadCases) {
+    BloomFilterBlock block;
+    block.AddKey("key");
+    block.FinishDataBlock();
+    std::string encoded = block.EncodeToString();
+
+    BloomFilterBlock decoded;
+    EXPECT_FALSE(decoded.DecodeFromString("invalid magic"));
+    EXPECT_FALSE(decoded.DecodeFromString(encoded.substr(0, encoded.size() - 1)));
+    EXPECT_TRUE(decoded.DecodeFromString(encoded));
+    EXPECT_TRUE(decoded.MayContain(0, "key"));
+}
+
+}  // namespace hfile
+}  // namespace toft
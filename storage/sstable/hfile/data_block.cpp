@@ -5,9 +5,13 @@
 
 #include "toft/storage/sstable/hfile/data_block.h"
 
+
+#include <algorithm>
+
 #include "toft/base/string/algorithm.h"
 #include "toft/base/string/format.h"
 #include "toft/compress/block/block_compression.h"
+#include "toft/encoding/varint.h"
 #include "toft/storage/sstable/hfile/coding.h"
 
 #include "thirdparty/glog/logging.h"
@@ -16,95 +20,346 @@
 
 namespace {
 static const std::string kDataBlockMagic = "DATABLK\42";
+static const std::string kPrefixDataBlockMagic = "DATABLK\43";
+static const int kDefaultRestartInterval = 16;
 }
 
 namespace toft {
 namespace hfile {
 
+const size_t DataBlock::kItemHeaderSize;
+
 DataBlock::~DataBlock() {
+    ClearRestoredKeys();
+    delete compression_;
+}
+
+DataBlock::DataBlock(CompressType codec, Format format)
+                : compression_(CreateCompression(codec)),
+                  format_(format),
+                  compressed_size_(0),
+                  restart_interval_(kDefaultRestartInterval),
+                  restart_counter_(0) {
+    CHECK(format_ == kPlainFormat || format_ == kPrefixFormat)
+        << "unknown data block format: " << format_;
 }
 
-DataBlock::DataBlock(CompressType codec)
-                : compression_(NULL),
-                  compressed_size_(0) {
+BlockCompression* DataBlock::CreateCompression(CompressType codec) {
     switch (codec) {
     case CompressType_kSnappy:
-        compression_ = TOFT_CREATE_BLOCK_COMPRESSION("snappy");
-        break;
+        return TOFT_CREATE_BLOCK_COMPRESSION("snappy");
     case CompressType_kLzo:
-        compression_ = TOFT_CREATE_BLOCK_COMPRESSION("snappy");
-        break;
+        return TOFT_CREATE_BLOCK_COMPRESSION("snappy");
     case CompressType_kUnCompress:
-        break;
+        return NULL;
     default:
         LOG(FATAL)<< "not supported yet!";
     }
+    return NULL;
 }
 
-const std::string DataBlock::EncodeToString() const {
-    if (compression_ != NULL) {
+const std::string DataBlock::EncodeBuffer(BlockCompression* compression,
+                                          const std::string &buffer) {
+    if (compression != NULL) {
         std::string compressed;
-        if (!compression_->Compress(buffer_.c_str(), buffer_.size(), &compressed)) {
+        if (!compression->Compress(buffer.c_str(), buffer.size(), &compressed)) {
             LOG(ERROR)<< "compress failed!";
             return "";
         }
-        // save the compressed info
-        compressed_size_ = compressed.size();
         return compressed;
     }
-    compressed_size_ = buffer_.size();
-    return buffer_;
+    return buffer;
+}
+
+const std::string DataBlock::EncodeToString() const {
+    std::string encoded;
+    if (format_ == kPrefixFormat) {
+        std::string buffer = buffer_;
+        AppendRestarts(&buffer);
+        encoded = EncodeBuffer(compression_, buffer);
+    } else {
+        encoded = EncodeBuffer(compression_, buffer_);
+    }
+    // save the compressed info
+    compressed_size_ = encoded.size();
+    return encoded;
 }
 
 bool DataBlock::DecodeFromString(const std::string &str) {
+    return DecodeFromMemory(str);
+}
+
+bool DataBlock::DecodeFromBuffer(std::string *buffer) {
+    if (compression_ != NULL)
+        return DecodeFromMemory(*buffer);
+    data_.swap(*buffer);
+    return DecodeInternal();
+}
+
+bool DataBlock::DecodeFromMemory(const StringPiece &data) {
     if (compression_ != NULL) {
-        std::string uncompressed;
-        if (!compression_->Uncompress(str.c_str(), str.size(), &uncompressed)) {
+        if (!compression_->Uncompress(data, &data_)) {
             LOG(ERROR)<< "uncompress failed!";
             return false;
         }
-        return DecodeInternal(uncompressed);
+    } else {
+        data_.assign(data.data(), data.size());
     }
-    return DecodeInternal(str);
+    return DecodeInternal();
 }
 
-bool DataBlock::DecodeInternal(const std::string &str) {
-    if (!StringStartsWith(str, kDataBlockMagic)) {
+bool DataBlock::DecodeInternal() {
+    items_.clear();
+    restart_items_.clear();
+    ClearRestoredKeys();
+    bool result = format_ == kPlainFormat ? DecodePlainItems() : DecodePrefixItems();
+    if (!result) {
+        items_.clear();
+        restart_items_.clear();
+    }
+    restored_keys_.resize(restart_items_.size(), NULL);
+    return result;
+}
+
+void DataBlock::ClearRestoredKeys() {
+    for (size_t i = 0; i < restored_keys_.size(); ++i)
+        delete restored_keys_[i];
+    restored_keys_.clear();
+}
+
+bool DataBlock::DecodePlainItems() {
+    if (!StringStartsWith(data_, kDataBlockMagic)) {
         LOG(INFO)<< "invalid data block header.";
         return false;
     }
-    data_items_.clear();
-    const char *begin = str.c_str() + kDataBlockMagic.size();
-    const char *end = str.c_str() + str.length();
-    while (begin < end) {
-        int key_length = ReadInt32(&begin);
-        int value_length = ReadInt32(&begin);
-        std::string key = std::string(begin, key_length);
-        begin += key_length;
-        std::string value = std::string(begin, value_length);
-        begin += value_length;
-        data_items_.push_back(make_pair(key, value));
-    }
-    if (begin > end) {
-        LOG(ERROR) << "not a complete data block, "
-        << StringPrint("begin: %p, end: %p", begin, end);
+    size_t offset = kDataBlockMagic.size();
+    while (offset < data_.size()) {
+        const char *item = data_.data() + offset;
+        size_t remain_size = data_.size() - offset;
+        if (remain_size < kItemHeaderSize ||
+            remain_size - kItemHeaderSize <
+            static_cast<uint64_t>(DecodeFixed32(item)) + DecodeFixed32(item + sizeof(uint32_t))) {
+            LOG(ERROR) << "not a complete data block, "
+                       << StringPrint("offset: %zu, size: %zu", offset, data_.size());
+            return false;
+        }
+        ItemInfo info;
+        info.key_offset = offset + kItemHeaderSize;
+        info.key_length = DecodeFixed32(item);
+        info.value_offset = info.key_offset + info.key_length;
+        info.value_length = DecodeFixed32(item + sizeof(uint32_t));
+        info.shared_length = 0;
+        info.restart_index = 0;
+        items_.push_back(info);
+        offset = info.value_offset + info.value_length;
+    }
+    return true;
+}
+
+bool DataBlock::DecodePrefixItems() {
+    if (!StringStartsWith(data_, kPrefixDataBlockMagic) ||
+        data_.size() < kPrefixDataBlockMagic.size() + sizeof(uint32_t)) {
+        LOG(INFO)<< "invalid data block header.";
+        return false;
+    }
+    // Restart points are at the end.
+    const char *end = data_.data() + data_.size() - sizeof(uint32_t);
+    uint32_t restart_count = DecodeFixed32(end);
+    if ((end - data_.data() - kPrefixDataBlockMagic.size()) / sizeof(uint32_t) < restart_count) {
+        LOG(ERROR) << "invalid restart count: " << restart_count;
+        return false;
+    }
+    end -= restart_count * sizeof(uint32_t);
+    const char *restarts = end;
+
+    const char *p = data_.data() + kPrefixDataBlockMagic.size();
+    size_t restart_index = 0;
+    size_t last_key_length = 0;
+    size_t restored_size = 0;  // Of keys in the current restart interval
+    while (p < end) {
+        uint32_t offset = p - data_.data();
+        bool is_restart = restart_index < restart_count &&
+                          DecodeFixed32(restarts + restart_index * sizeof(uint32_t)) == offset;
+        uint32_t shared;
+        uint32_t unshared;
+        uint32_t value_length;
+        if ((p = Varint::Decode32(p, end, &shared)) == NULL ||
+            (p = Varint::Decode32(p, end, &unshared)) == NULL ||
+            (p = Varint::Decode32(p, end, &value_length)) == NULL ||
+            static_cast<uint64_t>(end - p) < static_cast<uint64_t>(unshared) + value_length ||
+            shared > last_key_length || (is_restart && shared != 0) ||
+            (shared != 0 && restart_items_.empty())) {
+            LOG(ERROR) << "not a complete data block, "
+                       << StringPrint("offset: %u, size: %zu", offset, data_.size());
+            return false;
+        }
+        if (is_restart) {
+            restart_items_.push_back(items_.size());
+            ++restart_index;
+            restored_size = 0;
+        }
+        ItemInfo info;
+        info.key_length = shared + unshared;
+        info.shared_length = shared;
+        info.restart_index = restart_items_.empty() ? 0 : restart_items_.size() - 1;
+        // Keys sharing nothing are used in place, others are restored later.
+        if (shared == 0) {
+            info.key_offset = p - data_.data();
+        } else {
+            info.key_offset = restored_size;
+            restored_size += info.key_length;
+        }
+        p += unshared;
+        info.value_offset = p - data_.data();
+        info.value_length = value_length;
+        p += value_length;
+        items_.push_back(info);
+        last_key_length = info.key_length;
+    }
+    if (restart_index != restart_count) {
+        LOG(ERROR) << "invalid restart points of data block";
         return false;
     }
     return true;
 }
 
-void DataBlock::AddItem(const std::string &key, const std::string &value) {
+const std::string *DataBlock::RestoreKeys(uint32_t restart_index) const {
+    std::string **slot = &restored_keys_[restart_index];
+    std::string *keys = __atomic_load_n(slot, __ATOMIC_ACQUIRE);
+    if (keys != NULL)
+        return keys;
+
+    size_t begin = restart_items_[restart_index];
+    size_t end = restart_index + 1 < restart_items_.size() ?
+                 restart_items_[restart_index + 1] : items_.size();
+    size_t size = 0;
+    for (size_t i = begin; i < end; ++i) {
+        if (items_[i].shared_length > 0)
+            size += items_[i].key_length;
+    }
+    // Reserved, so the previous key doesn't move while appending.
+    keys = new std::string;
+    keys->reserve(size);
+    StringPiece last_key;
+    for (size_t i = begin; i < end; ++i) {
+        const ItemInfo &item = items_[i];
+        if (item.shared_length == 0) {
+            last_key.set(data_.data() + item.key_offset, item.key_length);
+            continue;
+        }
+        uint32_t unshared = item.key_length - item.shared_length;
+        keys->append(last_key.data(), item.shared_length);
+        keys->append(data_.data() + item.value_offset - unshared, unshared);
+        last_key.set(keys->data() + item.key_offset, item.key_length);
+    }
+
+    // Readers in other threads may restore the same interval at the same
+    // time, only the first one is kept.
+    std::string *expected = NULL;
+    if (!__atomic_compare_exchange_n(slot, &expected, keys, false,
+                                     __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        delete keys;
+        return expected;
+    }
+    return keys;
+}
+
+void DataBlock::AppendRestarts(std::string *buffer) const {
+    if (format_ != kPrefixFormat || buffer->empty())
+        return;
+    for (size_t i = 0; i < restarts_.size(); ++i)
+        PutFixed32(buffer, restarts_[i]);
+    PutFixed32(buffer, restarts_.size());
+}
+
+void DataBlock::ResetWriteState() {
+    compressed_size_ = 0;
+    restart_counter_ = 0;
+    last_key_.clear();
+    restarts_.clear();
+}
+
+void DataBlock::ClearItems() {
+    buffer_.clear();
+    ResetWriteState();
+}
+
+void DataBlock::SwapBuffer(std::string *buffer) {
+    AppendRestarts(&buffer_);
+    buffer->clear();
+    buffer->swap(buffer_);
+    ResetWriteState();
+}
+
+void DataBlock::AddItem(const StringPiece &key, const StringPiece &value) {
     // ignore totally empty item
     if (key.empty() && value.empty())
         return;
 
+    if (format_ == kPlainFormat) {
+        if (buffer_.empty())
+            buffer_ = kDataBlockMagic;
+        PutFixed32(&buffer_, key.size());
+        PutFixed32(&buffer_, value.size());
+        buffer_.append(key.data(), key.size());
+        buffer_.append(value.data(), value.size());
+        return;
+    }
+
     if (buffer_.empty())
-        buffer_ = kDataBlockMagic;
+        buffer_ = kPrefixDataBlockMagic;
+    size_t shared = 0;
+    if (restart_counter_ < restart_interval_) {
+        size_t max_shared = std::min(last_key_.size(), key.size());
+        while (shared < max_shared && last_key_[shared] == key[shared])
+            ++shared;
+    } else {
+        restart_counter_ = 0;
+    }
+    if (restart_counter_ == 0)
+        restarts_.push_back(buffer_.size());
+    Varint::Put32(&buffer_, shared);
+    Varint::Put32(&buffer_, key.size() - shared);
+    Varint::Put32(&buffer_, value.size());
+    buffer_.append(key.data() + shared, key.size() - shared);
+    buffer_.append(value.data(), value.size());
+    last_key_.assign(key.data(), key.size());
+    ++restart_counter_;
+}
 
-    PutFixed32(&buffer_, key.size());
-    PutFixed32(&buffer_, value.size());
-    buffer_ += key;
-    buffer_ += value;
+int DataBlock::LowerBound(const StringPiece &key) const {
+    int begin = 0;
+    int end = items_.size();
+    if (!restart_items_.empty()) {
+        // Find the last restart point whose key is less than key, then the
+        // result is in its interval or at the next restart point.
+        int left = 0;
+        int right = restart_items_.size();
+        while (left < right) {
+            int mid = (left + right) / 2;
+            if (GetKey(restart_items_[mid]).compare(key) < 0) {
+                left = mid + 1;
+            } else {
+                right = mid;
+            }
+        }
+        if (left > 0)
+            begin = restart_items_[left - 1];
+        if (left < static_cast<int>(restart_items_.size()))
+            end = restart_items_[left];
+        while (begin < end && GetKey(begin).compare(key) < 0)
+            ++begin;
+        return begin;
+    }
+    while (begin < end) {
+        int mid = (begin + end) / 2;
+        if (GetKey(mid).compare(key) < 0) {
+            begin = mid + 1;
+        } else {
+            end = mid;
+        }
+    }
+    return begin;
 }
 
 }  // namespace hfile
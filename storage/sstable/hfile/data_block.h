@@ -6,11 +6,14 @@
 #ifndef TOFT_STORAGE_SSTABLE_HFILE_DATA_BLOCK_H
 #define TOFT_STORAGE_SSTABLE_HFILE_DATA_BLOCK_H
 
+#include <stdint.h>
+
 #include <string>
-#include <utility>
 #include <vector>
 
+#include "toft/base/string/string_piece.h"
 #include "toft/storage/sstable/hfile/block.h"
+#include "toft/storage/sstable/hfile/coding.h"
 #include "toft/storage/sstable/types.h"
 
 #include "thirdparty/glog/logging.h"
@@ -24,19 +27,51 @@ class DataBlock : public Block {
     TOFT_DECLARE_UNCOPYABLE(DataBlock);
 
 public:
-    explicit DataBlock(CompressType codec);
+    // Encoding of items, it's recorded in FileInfo.
+    enum Format {
+        // Each item is: key length, value length, key, value.
+        kPlainFormat = 1,
+        // Each item is: shared key length, unshared key length, value length
+        // in varint, unshared key, value. Followed by offsets of restart
+        // points and the number of restart points, keys of restart points
+        // share nothing with the previous key.
+        kPrefixFormat = 2,
+    };
+
+    explicit DataBlock(CompressType codec, Format format = kPlainFormat);
     ~DataBlock();
 
+    Format format() const {
+        return format_;
+    }
+    // Only for writing kPrefixFormat, a restart point every interval keys.
+    void set_restart_interval(int interval) {
+        restart_interval_ = interval > 0 ? interval : 1;
+    }
+
+    // Create the block compression of codec, return NULL if uncompressed.
+    static BlockCompression* CreateCompression(CompressType codec);
+
+    // Encode the raw buffer of items into the format written to file,
+    // compression can be NULL. Return an empty string if failed.
+    static const std::string EncodeBuffer(BlockCompression* compression,
+                                          const std::string &buffer);
+
     virtual const std::string EncodeToString() const;
     virtual bool DecodeFromString(const std::string &str);
+    // Same as DecodeFromString, but take over the buffer to avoid copying
+    // it if the block is not compressed.
+    bool DecodeFromBuffer(std::string *buffer);
+    // Same as DecodeFromString, but from memory such as a mapped file.
+    bool DecodeFromMemory(const StringPiece &data);
 
     // It is the caller's responsibility to keep the item ordered
     // and decide when to finish adding items
-    void AddItem(const std::string &key, const std::string &value);
-    void ClearItems() {
-        buffer_.clear();
-        compressed_size_ = 0;
-    }
+    void AddItem(const StringPiece &key, const StringPiece &value);
+    void ClearItems();
+    // Take over the raw buffer of added items and clear them, the buffer
+    // can be encoded later by EncodeBuffer, maybe in another thread.
+    void SwapBuffer(std::string *buffer);
 
     int64_t GetUncompressedBufferSize() const {
         return buffer_.size();
@@ -45,29 +80,83 @@ public:
         return compressed_size_;
     }
 
-    // Getters
+    // Getters, the returned keys and values refer to the decoded buffer, so
+    // they are valid until the block is decoded again or destroyed.
     int GetDataItemSize() const {
-        return data_items_.size();
+        return items_.size();
     }
-    const std::string GetKey(size_t index) const {
-        CHECK(index < data_items_.size());
-        return data_items_[index].first;
+    StringPiece GetKey(size_t index) const {
+        CHECK(index < items_.size());
+        const ItemInfo &item = items_[index];
+        // Keys sharing a prefix with the previous key are restored on demand.
+        const char *base = item.shared_length == 0 ?
+                           data_.data() : RestoreKeys(item.restart_index)->data();
+        return StringPiece(base + item.key_offset, item.key_length);
     }
-    const std::string GetValue(size_t index) const {
-        CHECK(index < data_items_.size());
-        return data_items_[index].second;
+    StringPiece GetValue(size_t index) const {
+        CHECK(index < items_.size());
+        const ItemInfo &item = items_[index];
+        return StringPiece(data_.data() + item.value_offset, item.value_length);
     }
 
+    // Return the index of the first item whose key is not less than key, or
+    // GetDataItemSize() if there is no such item. Keys must be sorted.
+    // It's a binary search over restart points in kPrefixFormat, so only
+    // keys of one restart interval are restored, and over all items in
+    // kPlainFormat.
+    int LowerBound(const StringPiece &key) const;
+
 private:
-    bool DecodeInternal(const std::string &str);
+    // Each item is: key length, value length, key, value.
+    static const size_t kItemHeaderSize = 2 * sizeof(uint32_t);
+
+    struct ItemInfo {
+        // In data_, or in the restored keys of its restart interval if
+        // shared_length > 0.
+        uint32_t key_offset;
+        uint32_t key_length;
+        uint32_t value_offset;
+        uint32_t value_length;
+        // Only for kPrefixFormat.
+        uint32_t shared_length;
+        uint32_t restart_index;
+    };
+
+    // Parse data_ into items_.
+    bool DecodeInternal();
+    bool DecodePlainItems();
+    bool DecodePrefixItems();
+    // Return keys of items in the restart interval which share a prefix
+    // with the previous key, restored one after another.
+    const std::string *RestoreKeys(uint32_t restart_index) const;
+    void ClearRestoredKeys();
+
+    // Append the restart points to buffer in kPrefixFormat.
+    void AppendRestarts(std::string *buffer) const;
+    void ResetWriteState();
 
     BlockCompression* compression_;
+    Format format_;
+
+    // The decoded buffer, and the position of each item in it.
+    std::string data_;
+    std::vector<ItemInfo> items_;
+    // Index of items at restart points in kPrefixFormat, and the restored
+    // keys of each restart interval. Restored keys are built when they are
+    // accessed first and published atomically, so a decoded block can still
+    // be read concurrently.
+    std::vector<uint32_t> restart_items_;
+    mutable std::vector<std::string*> restored_keys_;
 
-    // Save parsed data from string
-    std::vector<std::pair<std::string, std::string> > data_items_;
     // To save the inputed data info
     std::string buffer_;
     mutable int64_t compressed_size_;
+
+    // For writing kPrefixFormat.
+    int restart_interval_;
+    int restart_counter_;
+    std::string last_key_;
+    std::vector<uint32_t> restarts_;
 };
 
 }  // namespace hfile
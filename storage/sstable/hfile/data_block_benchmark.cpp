@@ -0,0 +1,96 @@
+// Copyright (c) 2026, The Toft Authors.
+// All rights reserved.
+//
+// Size, decoding and seeking time of data blocks in plain and prefix format.
+// Keys are like urls, with long common prefixes.
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "toft/base/string/format.h"
+#include "toft/storage/sstable/hfile/data_block.h"
+
+#include "thirdparty/benchmark/benchmark.h"
+
+namespace {
+
+using toft::hfile::DataBlock;
+
+// About 64k bytes of items in plain format.
+const int kItemCount = 1000;
+
+const std::vector<std::string>& SortedKeys() {
+    static std::vector<std::string> keys;
+    if (keys.empty()) {
+        for (int i = 0; i < kItemCount; ++i) {
+            keys.push_back(toft::StringPrint("http://www.example.com/%d/page/%08d.html",
+                                             i % 7, i * 7919 % 1000003));
+        }
+        std::sort(keys.begin(), keys.end());
+    }
+    return keys;
+}
+
+std::string BuildBlock(DataBlock::Format format, int restart_interval) {
+    DataBlock block(toft::CompressType_kUnCompress, format);
+    block.set_restart_interval(restart_interval);
+    const std::vector<std::string>& keys = SortedKeys();
+    for (size_t i = 0; i < keys.size(); ++i)
+        block.AddItem(keys[i], "value");
+    std::string buffer;
+    block.SwapBuffer(&buffer);
+    return buffer;
+}
+
+DataBlock::Format GetFormat(const benchmark::State& state) {
+    return state.range(0) == 0 ? DataBlock::kPlainFormat : DataBlock::kPrefixFormat;
+}
+
+}  // namespace
+
+// range(0): restart interval, 0 means plain format.
+static void DataBlockDecode(benchmark::State& state) {
+    const std::string buffer = BuildBlock(GetFormat(state), state.range(0));
+    DataBlock block(toft::CompressType_kUnCompress, GetFormat(state));
+    for (auto _ : state) {
+        block.DecodeFromString(buffer);
+        benchmark::DoNotOptimize(block.GetDataItemSize());
+    }
+    state.counters["block_bytes"] = buffer.size();
+    state.SetItemsProcessed(state.iterations() * kItemCount);
+}
+BENCHMARK(DataBlockDecode)->Arg(0)->Arg(1)->Arg(4)->Arg(16)->Arg(64);
+
+static void DataBlockLowerBound(benchmark::State& state) {
+    std::string buffer = BuildBlock(GetFormat(state), state.range(0));
+    DataBlock block(toft::CompressType_kUnCompress, GetFormat(state));
+    block.DecodeFromBuffer(&buffer);
+    const std::vector<std::string>& keys = SortedKeys();
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(block.LowerBound(keys[i]));
+        i = (i + 7919) % keys.size();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(DataBlockLowerBound)->Arg(0)->Arg(1)->Arg(4)->Arg(16)->Arg(64);
+
+// Seek by walking from the first item, as OnDiskIterator did before
+// LowerBound.
+static void DataBlockLinearSeek(benchmark::State& state) {
+    std::string buffer = BuildBlock(DataBlock::kPlainFormat, 0);
+    DataBlock block(toft::CompressType_kUnCompress);
+    block.DecodeFromBuffer(&buffer);
+    const std::vector<std::string>& keys = SortedKeys();
+    size_t i = 0;
+    for (auto _ : state) {
+        int index = 0;
+        while (index < block.GetDataItemSize() && block.GetKey(index) < keys[i])
+            ++index;
+        benchmark::DoNotOptimize(index);
+        i = (i + 7919) % keys.size();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(DataBlockLinearSeek);
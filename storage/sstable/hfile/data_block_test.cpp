@@ -0,0 +1,151 @@
+// Copyright (c) 2026, The Toft Authors.
+// All rights reserved.
+//
+// Tests of DataBlock.
+
+#include "toft/storage/sstable/hfile/data_block.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "toft/base/string/number.h"
+
+#include "thirdparty/gtest/gtest.h"
+
+namespace toft {
+namespace hfile {
+
+static void TestEncodeDecode(CompressType codec,
+                             DataBlock::Format format = DataBlock::kPlainFormat) {
+    DataBlock block(codec, format);
+    for (int i = 0; i < 100; ++i)
+        block.AddItem("key" + NumberToString(i), std::string(i, 'v'));
+    std::string buffer = block.EncodeToString();
+
+    DataBlock decoded(codec, format);
+    ASSERT_TRUE(decoded.DecodeFromBuffer(&buffer));
+    ASSERT_EQ(100, decoded.GetDataItemSize());
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_EQ("key" + NumberToString(i), decoded.GetKey(i).as_string());
+        EXPECT_EQ(std::string(i, 'v'), decoded.GetValue(i).as_string());
+    }
+}
+
+TEST(DataBlock, EncodeDecode) {
+    TestEncodeDecode(CompressType_kUnCompress);
+}
+
+TEST(DataBlock, EncodeDecodeSnappy) {
+    TestEncodeDecode(CompressType_kSnappy);
+}
+
+TEST(DataBlock, EncodeDecodePrefix) {
+    TestEncodeDecode(CompressType_kUnCompress, DataBlock::kPrefixFormat);
+    TestEncodeDecode(CompressType_kSnappy, DataBlock::kPrefixFormat);
+}
+
+static std::string SortedKey(int i) {
+    // Keys with long common prefixes.
+    return "common/prefix/of/keys/" + NumberToString(i / 10) + "/" + NumberToString(i * 2);
+}
+
+static void TestLowerBound(DataBlock::Format format, int restart_interval) {
+    std::vector<std::string> keys;
+    for (int i = 0; i < 500; ++i)
+        keys.push_back(SortedKey(i));
+    std::sort(keys.begin(), keys.end());
+
+    DataBlock block(CompressType_kUnCompress, format);
+    block.set_restart_interval(restart_interval);
+    for (size_t i = 0; i < keys.size(); ++i)
+        block.AddItem(keys[i], NumberToString(i));
+    std::string buffer;
+    block.SwapBuffer(&buffer);
+    EXPECT_EQ(0, block.GetUncompressedBufferSize());
+
+    DataBlock decoded(CompressType_kUnCompress, format);
+    ASSERT_TRUE(decoded.DecodeFromBuffer(&buffer));
+    ASSERT_EQ(static_cast<int>(keys.size()), decoded.GetDataItemSize());
+    for (size_t i = 0; i < keys.size(); ++i) {
+        EXPECT_EQ(keys[i], decoded.GetKey(i).as_string());
+        EXPECT_EQ(NumberToString(i), decoded.GetValue(i).as_string());
+        EXPECT_EQ(static_cast<int>(i), decoded.LowerBound(keys[i]));
+        // A key between keys[i - 1] and keys[i].
+        std::string less = keys[i].substr(0, keys[i].size() - 1);
+        EXPECT_EQ(std::lower_bound(keys.begin(), keys.end(), less) - keys.begin(),
+                  decoded.LowerBound(less));
+    }
+    EXPECT_EQ(0, decoded.LowerBound(""));
+    EXPECT_EQ(decoded.GetDataItemSize(), decoded.LowerBound("z"));
+}
+
+TEST(DataBlock, LowerBound) {
+    TestLowerBound(DataBlock::kPlainFormat, 16);
+    TestLowerBound(DataBlock::kPrefixFormat, 1);
+    TestLowerBound(DataBlock::kPrefixFormat, 16);
+    TestLowerBound(DataBlock::kPrefixFormat, 1000);
+}
+
+TEST(DataBlock, PrefixFormatIsSmaller) {
+    DataBlock plain(CompressType_kUnCompress);
+    DataBlock prefix(CompressType_kUnCompress, DataBlock::kPrefixFormat);
+    for (int i = 0; i < 1000; ++i) {
+        plain.AddItem(SortedKey(i), "v");
+        prefix.AddItem(SortedKey(i), "v");
+    }
+    EXPECT_LT(prefix.EncodeToString().size() * 2, plain.EncodeToString().size());
+}
+
+TEST(DataBlock, PrefixFormatIncomplete) {
+    DataBlock block(CompressType_kUnCompress, DataBlock::kPrefixFormat);
+    block.set_restart_interval(2);
+    block.AddItem("key1", "value1");
+    block.AddItem("key2", "value2");
+    block.AddItem("key3", "value3");
+    std::string buffer = block.EncodeToString();
+
+    DataBlock decoded(CompressType_kUnCompress, DataBlock::kPrefixFormat);
+    for (size_t size = 0; size < buffer.size(); ++size) {
+        EXPECT_FALSE(decoded.DecodeFromString(buffer.substr(0, size))) << size;
+        EXPECT_EQ(0, decoded.GetDataItemSize());
+    }
+    // Plain block can't be decoded as prefix format.
+    DataBlock plain(CompressType_kUnCompress);
+    plain.AddItem("key", "value");
+    EXPECT_FALSE(decoded.DecodeFromString(plain.EncodeToString()));
+    EXPECT_TRUE(decoded.DecodeFromString(buffer));
+    EXPECT_EQ(3, decoded.GetDataItemSize());
+}
+
+TEST(DataBlock, ZeroCopy) {
+    DataBlock block(CompressType_kUnCompress);
+    block.AddItem("key", "value");
+    std::string buffer = block.EncodeToString();
+    const char* data = buffer.data();
+
+    DataBlock decoded(CompressType_kUnCompress);
+    ASSERT_TRUE(decoded.DecodeFromBuffer(&buffer));
+    ASSERT_EQ(1, decoded.GetDataItemSize());
+    // Keys and values refer to the buffer taken over, after the 8 bytes
+    // magic and 8 bytes item header.
+    EXPECT_EQ(data + 16, decoded.GetKey(0).data());
+    EXPECT_EQ(data + 19, decoded.GetValue(0).data());
+}
+
+TEST(DataBlock, Incomplete) {
+    DataBlock block(CompressType_kUnCompress);
+    block.AddItem("key", "value");
+    std::string buffer = block.EncodeToString();
+
+    DataBlock decoded(CompressType_kUnCompress);
+    EXPECT_FALSE(decoded.DecodeFromString(buffer.substr(0, buffer.size() - 1)));
+    EXPECT_EQ(0, decoded.GetDataItemSize());
+    EXPECT_FALSE(decoded.DecodeFromString(buffer.substr(0, buffer.size() - 9)));
+    EXPECT_FALSE(decoded.DecodeFromString("invalid"));
+    EXPECT_TRUE(decoded.DecodeFromString(buffer));
+    EXPECT_EQ(1, decoded.GetDataItemSize());
+}
+
+}  // namespace hfile
+}  // namespace toft
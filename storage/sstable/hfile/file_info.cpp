@@ -20,13 +20,19 @@ const std::string FileInfo::COMPARATOR = FileInfo::RESERVED_PREFIX
     + "COMPARATOR";
 const std::string FileInfo::LASTKEY = FileInfo::RESERVED_PREFIX
     + "LASTKEY";
+const std::string FileInfo::DATA_BLOCK_FORMAT = FileInfo::RESERVED_PREFIX
+    + "DATA_BLOCK_FORMAT";
+
+// DataBlock::kPlainFormat, the format of files before it's recorded.
+static const int32_t kPlainDataBlockFormat = 1;
 
 FileInfo::FileInfo()
     : item_num_(4),
       last_key_(""),
       avg_key_len_(0),
       avg_value_len_(0),
-      comparator_("org.apache.hadoop.hbase.util.Bytes$ByteArrayComparator") {
+      comparator_("org.apache.hadoop.hbase.util.Bytes$ByteArrayComparator"),
+      data_block_format_(kPlainDataBlockFormat) {
 }
 
 FileInfo::~FileInfo() {
@@ -34,7 +40,8 @@ FileInfo::~FileInfo() {
 
 const std::string FileInfo::EncodeToString() const {
     std::string result;
-    PutFixed32(&result, item_num_);
+    bool has_format = data_block_format_ != kPlainDataBlockFormat;
+    PutFixed32(&result, item_num_ + (has_format ? 1 : 0));
     Varint::Put32(&result, AVG_KEY_LEN.length());
     result += AVG_KEY_LEN;
     result += "\1";  // for cmpatible with HFile
@@ -55,6 +62,13 @@ const std::string FileInfo::EncodeToString() const {
     result += "\1";
     Varint::Put32(&result, last_key_.length());
     result += last_key_;
+    if (has_format) {
+        Varint::Put32(&result, DATA_BLOCK_FORMAT.length());
+        result += DATA_BLOCK_FORMAT;
+        result += "\1";
+        Varint::Put32(&result, sizeof(int32_t));
+        PutFixed32(&result, data_block_format_);
+    }
     return result + buffer_;
 }
 
@@ -81,6 +95,10 @@ bool FileInfo::DecodeFromString(const std::string &str) {
             last_key_ = std::string(begin, value_length);
             begin += value_length;
             continue;
+        } else if (key == DATA_BLOCK_FORMAT) {
+            data_block_format_ = ReadInt32(&begin);
+            --item_num_;  // Not counted in memory, see EncodeToString.
+            continue;
         }
         std::string value = std::string(begin, value_length);
         begin += value_length;
@@ -46,6 +46,10 @@ public:
     std::string comparator() const {
         return comparator_;
     }
+    // See DataBlock::Format.
+    int32_t data_block_format() const {
+        return data_block_format_;
+    }
     void set_item_num(int32_t item_num) {
         item_num_ = item_num;
     }
@@ -61,6 +65,9 @@ public:
     void set_comparator(std::string comparator) {
         comparator_ = comparator;
     }
+    void set_data_block_format(int32_t format) {
+        data_block_format_ = format;
+    }
 
 private:
     static const std::string RESERVED_PREFIX;
@@ -68,6 +75,7 @@ private:
     static const std::string AVG_KEY_LEN;
     static const std::string AVG_VALUE_LEN;
     static const std::string COMPARATOR;
+    static const std::string DATA_BLOCK_FORMAT;
 
     // Item num in this list
     int32_t item_num_;
@@ -79,6 +87,8 @@ private:
     int32_t avg_value_len_;
     // Comparator class name of data keys
     std::string comparator_;
+    // Only written if it's not the plain format, files without it are plain.
+    int32_t data_block_format_;
     // Save input meta data
     std::string buffer_;
 };
@@ -42,6 +42,9 @@ public:
     int64_t meta_index_offset() const {
         return meta_index_offset_;
     }
+    int32_t meta_index_count() const {
+        return meta_index_count_;
+    }
     CompressType compress_type() const {
         return compress_type_;
     }
@@ -61,6 +64,12 @@ public:
     void set_data_index_count(int32_t count) {
         data_index_count_ = count;
     }
+    void set_meta_index_offset(int64_t offset) {
+        meta_index_offset_ = offset;
+    }
+    void set_meta_index_count(int32_t count) {
+        meta_index_count_ = count;
+    }
     void set_total_uncompressed_bytes(int total_bytes) {
         total_uncompressed_bytes_ = total_bytes;
     }
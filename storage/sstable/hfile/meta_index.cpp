@@ -0,0 +1,115 @@
+// Copyright (c) 2026, The Toft Authors.
+// All rights reserved.
+//
+// Encoding and decoding of MetaIndex.
+
+#include "toft/storage/sstable/hfile/meta_index.h"
+
+#include <utility>
+
+#include "toft/base/string/algorithm.h"
+#include "toft/encoding/varint.h"
+#include "toft/storage/sstable/hfile/coding.h"
+
+#include "thirdparty/glog/logging.h"
+
+namespace toft {
+namespace hfile {
+
+static const std::string kMetaIndexMagic = "MIDXBK\41\43";
+
+MetaIndex::MetaIndex(int64_t offset) : offset_(offset) {
+}
+
+MetaIndex::~MetaIndex() {
+}
+
+const std::string MetaIndex::EncodeToString() const {
+    // The index size doesn't depend on offsets of blocks.
+    size_t index_size = kMetaIndexMagic.size() + sizeof(int32_t);
+    for (size_t i = 0; i < blocks_.size(); ++i) {
+        std::string name_length;
+        Varint::Put32(&name_length, blocks_[i].name.size());
+        index_size += sizeof(int64_t) + sizeof(int32_t) + name_length.size() +
+                      blocks_[i].name.size();
+    }
+
+    std::string result(kMetaIndexMagic);
+    PutFixed32(&result, blocks_.size());
+    int64_t block_offset = offset_ + index_size;
+    for (size_t i = 0; i < blocks_.size(); ++i) {
+        PutFixed64(&result, block_offset);
+        PutFixed32(&result, blocks_[i].data.size());
+        Varint::Put32(&result, blocks_[i].name.size());
+        result += blocks_[i].name;
+        block_offset += blocks_[i].data.size();
+    }
+    DCHECK_EQ(index_size, result.size());
+    for (size_t i = 0; i < blocks_.size(); ++i)
+        result += blocks_[i].data;
+    return result;
+}
+
+bool MetaIndex::DecodeFromString(const std::string &str) {
+    if (str.size() < kMetaIndexMagic.size() + sizeof(int32_t) ||
+        !StringStartsWith(str, kMetaIndexMagic)) {
+        LOG(ERROR)<< "invalid meta index header";
+        return false;
+    }
+    blocks_.clear();
+    const char *begin = str.c_str() + kMetaIndexMagic.size();
+    const char *end = str.c_str() + str.size();
+    int count = ReadInt32(&begin);
+    std::vector<std::pair<int64_t, uint32_t> > ranges;
+    for (int i = 0; i < count; ++i) {
+        if (end - begin < static_cast<int>(sizeof(int64_t) + sizeof(int32_t))) {
+            LOG(ERROR)<< "incomplete meta index";
+            return false;
+        }
+        int64_t block_offset = ReadInt64(&begin);
+        uint32_t block_size = ReadInt32(&begin);
+        int name_length = ReadVint(&begin, end);
+        if (name_length < 0 || end - begin < name_length) {
+            LOG(ERROR)<< "incomplete meta index";
+            return false;
+        }
+        MetaBlock block;
+        block.name.assign(begin, name_length);
+        begin += name_length;
+        blocks_.push_back(block);
+        ranges.push_back(std::make_pair(block_offset - offset_, block_size));
+    }
+
+    // Meta blocks follow the index.
+    int64_t index_size = begin - str.c_str();
+    for (size_t i = 0; i < blocks_.size(); ++i) {
+        if (ranges[i].first < index_size ||
+            ranges[i].first + ranges[i].second > static_cast<int64_t>(str.size())) {
+            LOG(ERROR)<< "meta block out of range: " << blocks_[i].name;
+            blocks_.clear();
+            return false;
+        }
+        blocks_[i].data.assign(str, ranges[i].first, ranges[i].second);
+    }
+    return true;
+}
+
+void MetaIndex::AddMetaBlock(const std::string &name, const std::string &data) {
+    MetaBlock block;
+    block.name = name;
+    block.data = data;
+    blocks_.push_back(block);
+}
+
+bool MetaIndex::FindMetaBlock(const std::string &name, std::string *data) const {
+    for (size_t i = 0; i < blocks_.size(); ++i) {
+        if (blocks_[i].name == name) {
+            *data = blocks_[i].data;
+            return true;
+        }
+    }
+    return false;
+}
+
+}  // namespace hfile
+}  // namespace toft
@@ -0,0 +1,63 @@
+// Copyright (c) 2026, The Toft Authors.
+// All rights reserved.
+//
+// Index of named meta blocks of HFile.
+
+#ifndef TOFT_STORAGE_SSTABLE_HFILE_META_INDEX_H
+#define TOFT_STORAGE_SSTABLE_HFILE_META_INDEX_H
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "toft/storage/sstable/hfile/block.h"
+
+namespace toft {
+namespace hfile {
+
+// Index of named meta blocks, such as bloom filters.
+//
+// The index is followed by the meta blocks, and they are placed between the
+// data index and the file trailer, so readers who don't know meta blocks
+// still work, because they read the data index until the meta index offset
+// in trailer.
+class MetaIndex : public Block {
+    TOFT_DECLARE_UNCOPYABLE(MetaIndex);
+
+public:
+    // offset is where the meta index is in the file.
+    explicit MetaIndex(int64_t offset);
+    ~MetaIndex();
+
+    // Encode the index and all the meta blocks.
+    virtual const std::string EncodeToString() const;
+    // Decode from the content between the meta index offset and the trailer.
+    virtual bool DecodeFromString(const std::string &str);
+
+    void AddMetaBlock(const std::string &name, const std::string &data);
+
+    // Return false if no such meta block.
+    bool FindMetaBlock(const std::string &name, std::string *data) const;
+
+    int64_t offset() const {
+        return offset_;
+    }
+    int GetBlockCount() const {
+        return blocks_.size();
+    }
+
+private:
+    struct MetaBlock {
+        std::string name;
+        std::string data;
+    };
+
+    int64_t offset_;
+    std::vector<MetaBlock> blocks_;
+};
+
+}  // namespace hfile
+}  // namespace toft
+
+#endif  // TOFT_STORAGE_SSTABLE_HFILE_META_INDEX_H
@@ -0,0 +1,58 @@
+// Copyright (c) 2026, The Toft Authors.
+// All rights reserved.
+//
+// Tests of MetaIndex.
+
+#include "toft/storage/sstable/hfile/meta_index.h"
+
+#include <string>
+
+#include "thirdparty/gtest/gtest.h"
+
+namespace toft {
+namespace hfile {
+
+TEST(MetaIndex, EncodeDecode) {
+    const int64_t kOffset = 1000;
+    MetaIndex index(kOffset);
+    index.AddMetaBlock("first", "data of first");
+    index.AddMetaBlock("empty", "");
+    index.AddMetaBlock("second", std::string(100, 'x'));
+    std::string encoded = index.EncodeToString();
+
+    MetaIndex decoded(kOffset);
+    ASSERT_TRUE(decoded.DecodeFromString(encoded));
+    EXPECT_EQ(3, decoded.GetBlockCount());
+    std::string data;
+    EXPECT_TRUE(decoded.FindMetaBlock("first", &data));
+    EXPECT_EQ("data of first", data);
+    EXPECT_TRUE(decoded.FindMetaBlock("empty", &data));
+    EXPECT_EQ("", data);
+    EXPECT_TRUE(decoded.FindMetaBlock("second", &data));
+    EXPECT_EQ(std::string(100, 'x'), data);
+    EXPECT_FALSE(decoded.FindMetaBlock("third", &data));
+}
+
+TEST(MetaIndex, Empty) {
+    MetaIndex index(0);
+    MetaIndex decoded(0);
+    ASSERT_TRUE(decoded.DecodeFromString(index.EncodeToString()));
+    EXPECT_EQ(0, decoded.GetBlockCount());
+}
+
+TEST(MetaIndex, BadCases) {
+    MetaIndex index(10);
+    index.AddMetaBlock("name", "data");
+    std::string encoded = index.EncodeToString();
+
+    MetaIndex decoded(10);
+    EXPECT_FALSE(decoded.DecodeFromString(""));
+    EXPECT_FALSE(decoded.DecodeFromString("invalid magic"));
+    EXPECT_FALSE(decoded.DecodeFromString(encoded.substr(0, encoded.size() - 1)));
+    // Offsets of blocks don't match.
+    MetaIndex wrong_offset(20);
+    EXPECT_FALSE(wrong_offset.DecodeFromString(encoded));
+}
+
+}  // namespace hfile
+}  // namespace toft
@@ -32,19 +32,29 @@ public:
     // ignore bad file that miss meta data such as set id, shard id, etc.
     bool Open(const std::vector<std::string> &paths, ReadMode type, bool ignore_bad_files);
 
+    // Open with options, e.g., all sstables can share one block cache.
+    // If open_thread_pool is set in option, files are opened concurrently,
+    // but sstables are still merged in the order of paths.
+    bool Open(const std::vector<std::string> &paths,
+              const SSTableReadOption &option,
+              bool ignore_bad_files);
+
     bool Open(const std::vector<std::string> &paths);
 
     void GetPaths(std::vector<std::string> *paths) const;
 
     // Load one extra sstable.
     bool LoadSSTableReader(const std::string &path, ReadMode type);
+    bool LoadSSTableReader(const std::string &path, const SSTableReadOption &option);
 
 public:
     virtual int EntryCount() const;
+    virtual int64_t MemoryUsage() const;
 
     // New a iterator to the key or the first one after the key if it's not found.
     // Caller owns the iterator.
     virtual Iterator *Seek(const std::string &key);
+    virtual Iterator *SeekForScan(const std::string &key);
 
     // TODO(yeshunping): the single result of GetMetaData for merged sstable does not
     // make sense, we need another one.
@@ -54,7 +64,20 @@ public:
 
     bool Lookup(const std::string &key, std::string *value);
 
+    // Keys are grouped by shard, and each sstable looks up its keys in one
+    // call.
+    virtual int MultiLookup(const std::vector<std::string> &keys,
+                            std::vector<std::string> *values,
+                            std::vector<bool> *found);
+
 private:
+    bool OpenConcurrently(const std::vector<std::string> &paths,
+                          const SSTableReadOption &option,
+                          bool ignore_bad_files);
+    // Take the ownership of the opened sstable, and fill it into the proper
+    // sstable set.
+    bool AddSSTableReader(SSTableReader *sstable);
+
     friend class MergedIterator;
     friend class MergedReverseIterator;
     class Impl;
@@ -0,0 +1,54 @@
+// Copyright (c) 2026, The Toft Authors.
+// All rights reserved.
+//
+// BlockCache operations and the process wide default cache.
+
+#include "toft/storage/sstable/block_cache.h"
+
+#include "toft/storage/sstable/hfile/data_block.h"
+
+#include "thirdparty/gflags/gflags.h"
+
+DEFINE_int64(sstable_block_cache_bytes, 256 * 1024 * 1024,
+             "capacity in uncompressed bytes of the process wide shared sstable "
+             "block cache, see BlockCache::Default()");
+
+namespace toft {
+
+BlockCache::BlockCache(size_t capacity, int shard_bits)
+    : m_last_file_id(0), m_cache(capacity, shard_bits) {
+}
+
+BlockCache::~BlockCache() {
+}
+
+BlockCache* BlockCache::Default() {
+    // Never destroyed, readers may be destructed at exit.
+    static BlockCache* cache = new BlockCache(FLAGS_sstable_block_cache_bytes);
+    return cache;
+}
+
+std::shared_ptr<hfile::DataBlock> BlockCache::Lookup(uint64_t file_id, int64_t offset) {
+    std::shared_ptr<hfile::DataBlock> block;
+    m_cache.Get(BlockCacheKey(file_id, offset), &block);
+    return block;
+}
+
+void BlockCache::Insert(uint64_t file_id, int64_t offset,
+                        const std::shared_ptr<hfile::DataBlock>& block,
+                        size_t charge) {
+    m_cache.Put(BlockCacheKey(file_id, offset), block, charge);
+}
+
+void BlockCache::Erase(uint64_t file_id, int64_t offset) {
+    m_cache.Remove(BlockCacheKey(file_id, offset));
+}
+
+double BlockCache::HitRate() const {
+    CacheStats stats;
+    m_cache.GetStats(&stats);
+    uint64_t total = stats.hits + stats.misses;
+    return total == 0 ? 0.0 : static_cast<double>(stats.hits) / total;
+}
+
+}  // namespace toft
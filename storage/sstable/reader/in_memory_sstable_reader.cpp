@@ -2,11 +2,28 @@
 // Author: Ye Shunping <yeshunping@gmail.com>
 
 #include "toft/storage/sstable/reader/in_memory_sstable_reader.h"
-#include "toft/storage/sstable/reader/on_disk_sstable_reader.h"
+
+#include <algorithm>
+
+#include "toft/storage/sstable/hfile/data_block.h"
 #include "toft/storage/sstable/reader/sstable_reader_impl.h"
 
+#include "thirdparty/glog/logging.h"
+
 namespace toft {
 
+class InMemorySSTableReader::EntryKeyLess {
+public:
+    explicit EntryKeyLess(const char *arena) : arena_(arena) {}
+
+    bool operator()(const Entry &entry, const StringPiece &key) const {
+        return StringPiece(arena_ + entry.offset, entry.key_size).compare(key) < 0;
+    }
+
+private:
+    const char *arena_;
+};
+
 InMemorySSTableReader::InMemorySSTableReader() {
 }
 
@@ -18,111 +35,74 @@ SSTableReader::Iterator *InMemorySSTableReader::Seek(const std::string &key) {
 }
 
 void InMemorySSTableReader::Init() {
-    cached_block_.reset(new hfile::DataBlock(impl_->file_trailer_->compress_type()));
-    std::vector<std::string> values;
-    std::string ori_key = "";
+    toft::scoped_ptr<hfile::DataBlock> block(impl_->NewDataBlock());
+    entries_.reserve(impl_->EntryCount());
     for (int block_id = 0; block_id < impl_->file_trailer_->data_index_count(); block_id++) {
-        impl_->LoadDataBlock(block_id, cached_block_.get());
-        for (int data_idx = 0; data_idx < cached_block_->GetDataItemSize(); data_idx++) {
-            if (block_id == 0 && data_idx == 0) {
-                ori_key = cached_block_->GetKey(0);
-            }
-            std::string key = cached_block_->GetKey(data_idx);
-            std::string value = cached_block_->GetValue(data_idx);
-            if (key != ori_key) {
-                data_.push_back(make_pair(ori_key, values));
-                ori_key = key;
-                values.clear();
-            }
-            values.push_back(value);
+        if (!impl_->LoadDataBlock(block_id, block.get())) {
+            LOG(ERROR) << "failed to load block " << block_id << " of " << impl_->path_;
+            break;
+        }
+        for (int data_idx = 0; data_idx < block->GetDataItemSize(); data_idx++) {
+            StringPiece key = block->GetKey(data_idx);
+            StringPiece value = block->GetValue(data_idx);
+            Entry entry;
+            entry.offset = arena_.size();
+            entry.key_size = key.size();
+            entry.value_size = value.size();
+            entries_.push_back(entry);
+            arena_.append(key.data(), key.size());
+            arena_.append(value.data(), value.size());
         }
     }
-    data_.push_back(make_pair(ori_key, values));
-//  index_.resize(data_.size() * 2);
-    for (DataVector::iterator it = data_.begin(); it != data_.end(); it++) {
-        index_.insert(make_pair(it->first, it));
-    }
+    arena_.shrink_to_fit();
+    entries_.shrink_to_fit();
+}
+
+size_t InMemorySSTableReader::LowerBound(const StringPiece &key) const {
+    return std::lower_bound(entries_.begin(), entries_.end(), key,
+                            EntryKeyLess(arena_.data())) - entries_.begin();
+}
+
+bool InMemorySSTableReader::Lookup(const std::string &key, std::string *value) {
+    size_t index = LowerBound(key);
+    if (index == entries_.size() || GetKey(index) != key)
+        return false;
+    StringPiece found = GetValue(index);
+    value->assign(found.data(), found.size());
+    return true;
+}
+
+int64_t InMemorySSTableReader::MemoryUsage() const {
+    return arena_.capacity() + entries_.capacity() * sizeof(Entry);
 }
 
-InMemoryIterator::InMemoryIterator(InMemorySSTableReader *sstable, const std::string &key)
-                : sstable_(sstable) {
+InMemoryIterator::InMemoryIterator(const InMemorySSTableReader *sstable,
+                                   const std::string &key)
+                : sstable_(sstable), index_(0) {
     SeekKey(key);
-    if (valid_) {
-        LoadItem();
-    }
 }
 
 InMemoryIterator::~InMemoryIterator() {
 }
 
 void InMemoryIterator::Next() {
-    NextItem();
     if (valid_) {
+        ++index_;
         LoadItem();
     }
 }
 
-bool InMemoryIterator::NextItem() {
-    valid_ = false;
-    if (pos_ < size_ - 1) {
-        pos_++;
-    } else {
-        cur_it_++;
-        if (cur_it_ != sstable_->data_.end()) {
-            pos_ = 0;
-            size_ = cur_it_->second.size();
-        } else {
-            return false;
-        }
-    }
-    valid_ = true;
-    return true;
-}
-
 void InMemoryIterator::LoadItem() {
-    key_ = cur_it_->first;
-    value_ = cur_it_->second.at(pos_);
+    valid_ = index_ < sstable_->entries_.size();
+    if (valid_) {
+        key_ = sstable_->GetKey(index_);
+        value_ = sstable_->GetValue(index_);
+    }
 }
 
 void InMemoryIterator::SeekKey(const std::string &key) {
-    bool found = false;
-    std::map<std::string, DataVector::iterator>::iterator it = sstable_->index_.find(key);
-    if (it != sstable_->index_.end()) {
-        cur_it_ = it->second;
-        found = true;
-    }
-    // FIXME(yesp) : is it right?
-    if (!found && (key < sstable_->data_.begin()->first)) {
-        cur_it_ = sstable_->data_.begin();
-        found = true;
-    }
-    if (!found && (key > sstable_->data_.back().first)) {
-        valid_ = false;
-        return;
-    }
-    if (!found) {
-        DataVector::size_type n = sstable_->data_.size();
-        unsigned int begin = 0;
-        unsigned int end = n - 1;
-        unsigned int mid = 0;
-        while (begin <= end) {
-            mid = (begin + end) / 2;
-            LOG(INFO)<< "begin:" << begin << ";mid:" << mid << ";end:" << end;
-            const std::pair<std::string, std::vector<std::string> >& midPair = sstable_->data_[mid];
-            if (midPair.first == key) {
-                break;
-            } else if (midPair.first < key) {
-                begin = mid + 1;
-            } else if (midPair.first > key) {
-                end = mid - 1;
-            }
-        }
-        cur_it_ = sstable_->data_.begin() + mid;
-    }
-    pos_ = 0;
-    size_ = cur_it_->second.size();
-    valid_ = true;
-    return;
+    index_ = sstable_->LowerBound(key);
+    LoadItem();
 }
 
 }  // namespace toft
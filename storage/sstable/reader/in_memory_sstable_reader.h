@@ -6,21 +6,20 @@
 #ifndef TOFT_STORAGE_SSTABLE_READER_IN_MEMORY_SSTABLE_READER_H
 #define TOFT_STORAGE_SSTABLE_READER_IN_MEMORY_SSTABLE_READER_H
 
-#include <map>
+#include <stdint.h>
+
 #include <string>
-#include <utility>
 #include <vector>
 
-#include "toft/base/scoped_ptr.h"
+#include "toft/base/string/string_piece.h"
 #include "toft/storage/sstable/sstable_reader.h"
 
 namespace toft {
-namespace hfile {
-class DataBlock;
-} // namespace hfile
-
-typedef std::vector<std::pair<std::string, std::vector<std::string> > > DataVector;
 
+// All items are loaded into one flat arena in the order of file, and are
+// indexed by a sorted array of small fixed size entries, so an item costs
+// its key and value plus 16 bytes, and seeking is a binary search over the
+// entries.
 class InMemorySSTableReader : public SSTableReader {
     TOFT_DECLARE_UNCOPYABLE(InMemorySSTableReader);
 public:
@@ -31,33 +30,52 @@ public:
 
     virtual Iterator *Seek(const std::string &key);
 
+    // Search in memory directly, without creating iterator.
+    virtual bool Lookup(const std::string &key, std::string *value);
+
+    virtual int64_t MemoryUsage() const;
+
 private:
     friend class InMemoryIterator;
 
-    toft::scoped_ptr<hfile::DataBlock> cached_block_;
-    //  Replace with hash_map
-    std::map<std::string, DataVector::iterator> index_;
-    DataVector data_;
+    struct Entry {
+        uint64_t offset;  // Offset of key in arena_, followed by value
+        uint32_t key_size;
+        uint32_t value_size;
+    };
+    class EntryKeyLess;
+
+    StringPiece GetKey(size_t index) const {
+        const Entry &entry = entries_[index];
+        return StringPiece(arena_.data() + entry.offset, entry.key_size);
+    }
+    StringPiece GetValue(size_t index) const {
+        const Entry &entry = entries_[index];
+        return StringPiece(arena_.data() + entry.offset + entry.key_size, entry.value_size);
+    }
+
+    // Index of the first item whose key is not less than key.
+    size_t LowerBound(const StringPiece &key) const;
+
+    std::string arena_;
+    std::vector<Entry> entries_;
 };
 
 class InMemoryIterator : public SSTableReader::Iterator {
     TOFT_DECLARE_UNCOPYABLE(InMemoryIterator);
 
 public:
-    InMemoryIterator(InMemorySSTableReader *sstable, const std::string &key);
+    InMemoryIterator(const InMemorySSTableReader *sstable, const std::string &key);
     ~InMemoryIterator();
 
     void SeekKey(const std::string &key);
     virtual void Next();
 
 private:
-    bool NextItem();
     void LoadItem();
 
-    InMemorySSTableReader *sstable_;
-    DataVector::iterator cur_it_;
-    int pos_;
-    int size_;
+    const InMemorySSTableReader *sstable_;
+    size_t index_;
 };
 
 }  // namespace toft
@@ -5,8 +5,9 @@
 
 #include "toft/storage/sstable/merged_sstable_reader.h"
 
+#include <algorithm>
 #include <map>
-#include <set>
+#include <vector>
 
 #include "toft/base/scoped_ptr.h"
 #include "toft/base/stl_util.h"
@@ -16,6 +17,10 @@
 #include "toft/storage/sstable/reader/on_disk_sstable_reader.h"
 #include "toft/storage/sstable/sstable.h"
 #include "toft/storage/sstable/sstable_reader.h"
+#include "toft/system/atomic/atomic.h"
+#include "toft/system/threading/mutex.h"
+#include "toft/system/threading/parallel_for.h"
+#include "toft/system/threading/thread_pool.h"
 
 #include "thirdparty/glog/logging.h"
 
@@ -26,6 +31,86 @@ DEFINE_bool(ignore_sstable_setid, false, "If true, ignore sstable's setid");
 
 namespace toft {
 
+namespace {
+
+// Open a sstable, return NULL if failed or it's empty.
+SSTableReader *OpenSSTable(const std::string &path, const SSTableReadOption &option) {
+    SSTableReader *sstable = SSTableReader::Open(path, option);
+    if (sstable == NULL) {
+        LOG(ERROR)<< "Failed to open sstable:" << path;
+        return NULL;
+    }
+    if (sstable->EntryCount() == 0) {
+        LOG(WARNING)<< "sstable " << path << " is empty.";
+        delete sstable;
+        return NULL;
+    }
+    return sstable;
+}
+
+// Open sstables by a few workers, each worker takes the next path until no
+// path left, so at most number of workers files are being opened.
+class ConcurrentOpener {
+    TOFT_DECLARE_UNCOPYABLE(ConcurrentOpener);
+
+public:
+    ConcurrentOpener(const std::vector<std::string> &paths,
+                     const SSTableReadOption &option,
+                     bool ignore_bad_files,
+                     std::vector<SSTableReader*> *tables)
+        : paths_(paths), option_(option), ignore_bad_files_(ignore_bad_files),
+          tables_(tables), next_path_(0), opened_(0) {
+        tables_->assign(paths_.size(), NULL);
+    }
+
+    // Return false if any file failed to open and bad files are not ignored.
+    bool Run(ThreadPool *pool, size_t num_workers) {
+        ParallelFor(pool, 0, num_workers, 1,
+                    std::bind(&ConcurrentOpener::RunWorkers, this,
+                              std::placeholders::_1, std::placeholders::_2),
+                    &cancellation_);
+        return !cancellation_.IsCancelled();
+    }
+
+private:
+    void RunWorkers(size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+            RunWorker();
+    }
+
+    void RunWorker() {
+        for (;;) {
+            // Files not started are skipped once any file failed.
+            if (cancellation_.IsCancelled())
+                return;
+            size_t index = next_path_++;
+            if (index >= paths_.size())
+                return;
+            LOG(INFO)<< "path:" << paths_[index];
+            SSTableReader *sstable = OpenSSTable(paths_[index], option_);
+            (*tables_)[index] = sstable;
+            if (sstable == NULL && !ignore_bad_files_)
+                cancellation_.Cancel();
+
+            MutexLocker locker(&mutex_);
+            ++opened_;
+            if (option_.open_progress_callback())
+                option_.open_progress_callback()(opened_, paths_.size());
+        }
+    }
+
+    const std::vector<std::string> &paths_;
+    const SSTableReadOption &option_;
+    const bool ignore_bad_files_;
+    std::vector<SSTableReader*> *tables_;
+    Atomic<size_t> next_path_;
+    CancellationToken cancellation_;
+    Mutex mutex_;
+    int opened_;  // Under mutex_
+};
+
+}  // namespace
+
 // One sstable set means a set of sstables that have the same set id.
 class SSTableReaderSet {
     TOFT_DECLARE_UNCOPYABLE(SSTableReaderSet);
@@ -70,6 +155,30 @@ public:
         return false;
     }
 
+    // Look up keys[i] for each i in indexes, the same as Lookup them one
+    // by one, but keys of the same table are looked up in one call.
+    void MultiLookup(const std::vector<std::string> &keys,
+                     const std::vector<size_t> &indexes,
+                     std::vector<std::string> *values,
+                     std::vector<bool> *found) {
+        if (!sharding_man_.get()) {
+            for (std::map<int, SSTableReader*>::const_iterator it = tables_.begin();
+                            it != tables_.end(); ++it) {
+                MultiLookupTable(it->second, keys, indexes, values, found);
+            }
+            return;
+        }
+        std::map<int, std::vector<size_t> > shard_indexes;
+        for (size_t i = 0; i < indexes.size(); ++i)
+            shard_indexes[sharding_man_->Shard(keys[indexes[i]])].push_back(indexes[i]);
+        for (std::map<int, std::vector<size_t> >::const_iterator it = shard_indexes.begin();
+                        it != shard_indexes.end(); ++it) {
+            std::map<int, SSTableReader*>::iterator table = tables_.find(it->first);
+            if (table != tables_.end())
+                MultiLookupTable(table->second, keys, it->second, values, found);
+        }
+    }
+
     bool AddSSTableReader(SSTableReader *sstable,
                     const std::string &set_id,
                     const std::string &sharding_policy,
@@ -102,6 +211,29 @@ public:
     }
 
 private:
+    // Found values take the place of existing ones if they are empty or
+    // larger, like Lookup without sharding policy.
+    static void MultiLookupTable(SSTableReader *table,
+                                 const std::vector<std::string> &keys,
+                                 const std::vector<size_t> &indexes,
+                                 std::vector<std::string> *values,
+                                 std::vector<bool> *found) {
+        std::vector<std::string> table_keys(indexes.size());
+        for (size_t i = 0; i < indexes.size(); ++i)
+            table_keys[i] = keys[indexes[i]];
+        std::vector<std::string> table_values;
+        std::vector<bool> table_found;
+        if (table->MultiLookup(table_keys, &table_values, &table_found) == 0)
+            return;
+        for (size_t i = 0; i < indexes.size(); ++i) {
+            std::string &value = (*values)[indexes[i]];
+            if (table_found[i] && (value.empty() || value > table_values[i])) {
+                value.swap(table_values[i]);
+                (*found)[indexes[i]] = true;
+            }
+        }
+    }
+
     const std::string set_id_;
     const std::string sharding_policy_;
     int num_shard_;
@@ -128,34 +260,38 @@ public:
     std::vector<SSTableReader*> tables_;
 };
 
-struct IteratorComp {
+// For min heap of child iterators by std heap algorithms, compares the
+// borrowed key and value pieces without copying.
+struct IteratorGreater {
     inline bool operator()(const SSTableReader::Iterator *iter1,
                            const SSTableReader::Iterator *iter2) const {
-        if (iter1->key() < iter2->key())
-            return true;
-        if (iter1->key() == iter2->key())
-            return iter1->value() < iter2->value();
-        return false;
+        int result = iter1->key_piece().compare(iter2->key_piece());
+        if (result != 0)
+            return result > 0;
+        return iter1->value_piece().compare(iter2->value_piece()) > 0;
     }
 };
 
+// Merge child iterators by a binary heap. The current item refers to the
+// top child iterator, which is moved forward in the next call of Next, so
+// items are not copied.
 class MergedIterator : public SSTableReader::Iterator {
     TOFT_DECLARE_UNCOPYABLE(MergedIterator);
 
 public:
-    MergedIterator(MergedSSTableReader::Impl *sstable, const std::string &key)
-                    : sstable_(sstable) {
+    // If scan is true, child iterators are created by SeekForScan.
+    MergedIterator(MergedSSTableReader::Impl *sstable, const std::string &key, bool scan)
+                    : sstable_(sstable), scan_(scan) {
         SeekKey(key);
-        if (valid_) {
-            LoadItem();
-        }
     }
     ~MergedIterator() {
-        DeleteElements(&iter_queue_);
+        DeleteElements(&heap_);
     }
 
     virtual void Next() {
-        valid_ = !iter_queue_.empty();
+        if (!heap_.empty())
+            NextTop();
+        valid_ = !heap_.empty();
         if (valid_) {
             LoadItem();
         }
@@ -164,37 +300,70 @@ public:
 
 private:
     void LoadItem();
+    // Move the top child iterator to its next item and restore the heap.
+    void NextTop();
+    void SiftDown(size_t index);
 
     MergedSSTableReader::Impl *sstable_;
-    std::multiset<SSTableReader::Iterator*, IteratorComp> iter_queue_;
+    bool scan_;
+    std::vector<SSTableReader::Iterator*> heap_;
 };
 
 void MergedIterator::SeekKey(const std::string &key) {
     valid_ = false;
+    DeleteElements(&heap_);
     std::vector<SSTableReader*>::iterator iter = sstable_->tables_.begin();
     for (; iter != sstable_->tables_.end(); ++iter) {
-        SSTableReader::Iterator *it = (*iter)->Seek(key);
+        SSTableReader::Iterator *it = scan_ ? (*iter)->SeekForScan(key) : (*iter)->Seek(key);
         if (it->Valid()) {
-            iter_queue_.insert(it);
+            heap_.push_back(it);
             valid_ = true;
         } else {
             delete it;
         }
     }
+    std::make_heap(heap_.begin(), heap_.end(), IteratorGreater());
+    if (valid_)
+        LoadItem();
 }
 
 void MergedIterator::LoadItem() {
-    std::multiset<SSTableReader::Iterator*>::iterator iter = iter_queue_.begin();
-    SSTableReader::Iterator *it = *iter;
-    key_ = it->key();
-    value_ = it->value();
+    // Valid until the top iterator is moved in Next.
+    key_ = heap_[0]->key_piece();
+    value_ = heap_[0]->value_piece();
+}
+
+void MergedIterator::NextTop() {
+    SSTableReader::Iterator *it = heap_[0];
     it->Next();
-    iter_queue_.erase(iter);
-    if (it->Valid()) {
-        iter_queue_.insert(it);
-    } else {
+    if (!it->Valid()) {
         delete it;
+        heap_[0] = heap_.back();
+        heap_.pop_back();
+        if (heap_.empty())
+            return;
     }
+    SiftDown(0);
+}
+
+void MergedIterator::SiftDown(size_t index) {
+    // Usually the top iterator is still the smallest after moving forward,
+    // which costs only two comparisons.
+    IteratorGreater greater;
+    SSTableReader::Iterator *it = heap_[index];
+    size_t size = heap_.size();
+    for (;;) {
+        size_t child = 2 * index + 1;
+        if (child >= size)
+            break;
+        if (child + 1 < size && greater(heap_[child], heap_[child + 1]))
+            ++child;
+        if (!greater(it, heap_[child]))
+            break;
+        heap_[index] = heap_[child];
+        index = child;
+    }
+    heap_[index] = it;
 }
 
 MergedSSTableReader::MergedSSTableReader()
@@ -207,13 +376,55 @@ MergedSSTableReader::~MergedSSTableReader() {
 bool MergedSSTableReader::Open(const std::vector<std::string> &paths,
                                ReadMode type,
                                bool ignore_bad_files) {
+    SSTableReadOption option;
+    option.set_read_mode(type);
+    return Open(paths, option, ignore_bad_files);
+}
+
+bool MergedSSTableReader::Open(const std::vector<std::string> &paths,
+                               const SSTableReadOption &option,
+                               bool ignore_bad_files) {
     impl_->Reset();
+    if (option.open_thread_pool() != NULL)
+        return OpenConcurrently(paths, option, ignore_bad_files);
     for (size_t i = 0; i < paths.size(); ++i) {
         LOG(INFO)<< "path:" << paths[i];
-        if (!LoadSSTableReader(paths[i], type) && !ignore_bad_files) {
+        if (!LoadSSTableReader(paths[i], option) && !ignore_bad_files) {
             return false;
         }
+        if (option.open_progress_callback())
+            option.open_progress_callback()(i + 1, paths.size());
+    }
+    VLOG(2) << "loaded " << impl_->tables_.size() << " sstables.";
+    return !impl_->tables_.empty();
+}
+
+bool MergedSSTableReader::OpenConcurrently(const std::vector<std::string> &paths,
+                                           const SSTableReadOption &option,
+                                           bool ignore_bad_files) {
+    ThreadPool *pool = option.open_thread_pool();
+    size_t num_workers = option.max_concurrent_opens() > 0 ?
+                         option.max_concurrent_opens() : pool->num_threads() + 1;
+    num_workers = std::min(num_workers, paths.size());
+
+    std::vector<SSTableReader*> tables;
+    ConcurrentOpener opener(paths, option, ignore_bad_files, &tables);
+    bool ok = opener.Run(pool, num_workers);
+
+    // Fill sstables into sets in the order of paths, the same as opening
+    // them one by one.
+    for (size_t i = 0; i < tables.size(); ++i) {
+        if (!ok) {
+            delete tables[i];
+            continue;
+        }
+        if (tables[i] == NULL)
+            continue;
+        if (!AddSSTableReader(tables[i]) && !ignore_bad_files)
+            ok = false;
     }
+    if (!ok)
+        return false;
     VLOG(2) << "loaded " << impl_->tables_.size() << " sstables.";
     return !impl_->tables_.empty();
 }
@@ -231,17 +442,20 @@ void MergedSSTableReader::GetPaths(std::vector<std::string> *paths) const {
 }
 
 bool MergedSSTableReader::LoadSSTableReader(const std::string &path, ReadMode type) {
-    SSTableReader *sstable = SSTableReader::Open(path, type);
-    if (sstable == NULL) {
-        LOG(ERROR)<< "Failed to open sstable:" << path;
-        return false;
-    }
-    if (sstable->EntryCount() == 0) {
-        LOG(WARNING)<< "sstable " << path << " is empty.";
-        delete sstable;
+    SSTableReadOption option;
+    option.set_read_mode(type);
+    return LoadSSTableReader(path, option);
+}
+
+bool MergedSSTableReader::LoadSSTableReader(const std::string &path,
+                                            const SSTableReadOption &option) {
+    SSTableReader *sstable = OpenSSTable(path, option);
+    if (sstable == NULL)
         return false;
-    }
+    return AddSSTableReader(sstable);
+}
 
+bool MergedSSTableReader::AddSSTableReader(SSTableReader *sstable) {
     // now fill it into proper sstable set.
     std::string set_id = sstable->GetMetaData(kSSTableSetID);
     if (set_id.empty()) {
@@ -299,8 +513,19 @@ int MergedSSTableReader::EntryCount() const {
     return count;
 }
 
+int64_t MergedSSTableReader::MemoryUsage() const {
+    int64_t usage = 0;
+    for (size_t i = 0; i < impl_->tables_.size(); ++i)
+        usage += impl_->tables_[i]->MemoryUsage();
+    return usage;
+}
+
 SSTableReader::Iterator* MergedSSTableReader::Seek(const std::string &key) {
-    return new MergedIterator(impl_.get(), key);
+    return new MergedIterator(impl_.get(), key, false);
+}
+
+SSTableReader::Iterator* MergedSSTableReader::SeekForScan(const std::string &key) {
+    return new MergedIterator(impl_.get(), key, true);
 }
 
 const std::string MergedSSTableReader::GetMetaData(const std::string &key) const {
@@ -321,6 +546,28 @@ void MergedSSTableReader::IterateMetaData(
     }
 }
 
+int MergedSSTableReader::MultiLookup(const std::vector<std::string> &keys,
+                                     std::vector<std::string> *values,
+                                     std::vector<bool> *found) {
+    values->assign(keys.size(), std::string());
+    found->assign(keys.size(), false);
+    std::vector<size_t> pending(keys.size());
+    for (size_t i = 0; i < keys.size(); ++i)
+        pending[i] = i;
+    // Like Lookup, a key found in one set is not looked up in later sets.
+    for (std::map<std::string, SSTableReaderSet*>::iterator it = impl_->sets_.begin();
+                    it != impl_->sets_.end() && !pending.empty(); ++it) {
+        it->second->MultiLookup(keys, pending, values, found);
+        size_t num_pending = 0;
+        for (size_t i = 0; i < pending.size(); ++i) {
+            if (!(*found)[pending[i]])
+                pending[num_pending++] = pending[i];
+        }
+        pending.resize(num_pending);
+    }
+    return keys.size() - pending.size();
+}
+
 bool MergedSSTableReader::Lookup(const std::string &key, std::string *value) {
     VLOG(1) << "Lookup " << key << ", set num: " << impl_->sets_.size();
     for (std::map<std::string, SSTableReaderSet*>::iterator it = impl_->sets_.begin();
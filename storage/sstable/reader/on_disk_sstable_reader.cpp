@@ -7,41 +7,182 @@
 
 #include <algorithm>
 
+#include "toft/base/functional.h"
+#include "toft/system/threading/parallel_for.h"
+
 #include "thirdparty/gflags/gflags.h"
 
 DEFINE_int32(on_disk_sstable_block_cache, 128,
              "max # of item in the block cache for one on disk sstable");
+DEFINE_int64(on_disk_sstable_block_cache_bytes, 0,
+             "if positive, limit the block cache of one on disk sstable by "
+             "uncompressed bytes of blocks instead of block number");
 
 namespace toft {
 
-OnDiskSSTableReader::OnDiskSSTableReader()
-                : block_cache_(new LruCache<int, std::shared_ptr<hfile::DataBlock> >(
-                               FLAGS_on_disk_sstable_block_cache)) {
+namespace {
+
+class KeyIndexLess {
+public:
+    explicit KeyIndexLess(const std::vector<std::string> &keys) : keys_(keys) {}
+
+    bool operator()(size_t a, size_t b) const {
+        return keys_[a] < keys_[b];
+    }
+
+private:
+    const std::vector<std::string> &keys_;
+};
+
+}  // namespace
+
+OnDiskSSTableReader::OnDiskSSTableReader(BlockCache* block_cache, ThreadPool* io_thread_pool,
+                                         int scan_readahead_blocks)
+                : block_cache_(block_cache),
+                  io_thread_pool_(io_thread_pool),
+                  scan_readahead_blocks_(scan_readahead_blocks),
+                  file_id_(0),
+                  charge_by_bytes_(true) {
+    if (block_cache_ == NULL) {
+        // Private cache is not shared, so there is no need to shard it.
+        charge_by_bytes_ = FLAGS_on_disk_sstable_block_cache_bytes > 0;
+        size_t capacity = charge_by_bytes_ ? FLAGS_on_disk_sstable_block_cache_bytes
+                                           : FLAGS_on_disk_sstable_block_cache;
+        private_block_cache_.reset(new BlockCache(capacity, 0));
+        block_cache_ = private_block_cache_.get();
+    }
+    file_id_ = block_cache_->NewFileId();
 }
 
 OnDiskSSTableReader::~OnDiskSSTableReader() {
+    // Blocks of this file will never be hit again, release them early.
+    if (!private_block_cache_.get()) {
+        for (int i = 0; i < GetBlockSize(); ++i)
+            block_cache_->Erase(file_id_, impl_->data_index_->GetOffset(i));
+    }
 }
 
 std::shared_ptr<hfile::DataBlock> OnDiskSSTableReader::LoadDataBlock(int block_id) {
-    std::shared_ptr<hfile::DataBlock> block;
-    if (!block_cache_->Get(block_id, &block)) {
+    int64_t offset = impl_->data_index_->GetOffset(block_id);
+    std::shared_ptr<hfile::DataBlock> block = block_cache_->Lookup(file_id_, offset);
+    if (!block) {
         // not in cache,
-        hfile::DataBlock *new_block = new hfile::DataBlock(impl_->file_trailer_->compress_type());
+        hfile::DataBlock *new_block = impl_->NewDataBlock();
         if (!impl_->LoadDataBlock(block_id, new_block)) {
             delete new_block;
             LOG(ERROR)<< "fail to load data block!";
             return std::shared_ptr<hfile::DataBlock>();
         }
         block.reset(new_block);
-        block_cache_->Put(block_id, block);
+        size_t charge = charge_by_bytes_ ? impl_->data_index_->GetDataSize(block_id) : 1;
+        block_cache_->Insert(file_id_, offset, block, charge);
     }
     return block;
 }
 
+std::shared_ptr<hfile::DataBlock> OnDiskSSTableReader::LoadUncachedDataBlock(int block_id) {
+    std::shared_ptr<hfile::DataBlock> block(impl_->NewDataBlock());
+    if (!impl_->LoadDataBlock(block_id, block.get())) {
+        LOG(ERROR)<< "fail to load data block!";
+        block.reset();
+    }
+    return block;
+}
+
+void OnDiskSSTableReader::LoadDataBlockRange(
+    const std::vector<int> *block_ids,
+    std::vector<std::shared_ptr<hfile::DataBlock> > *blocks,
+    size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i)
+        (*blocks)[i] = LoadDataBlock((*block_ids)[i]);
+}
+
+void OnDiskSSTableReader::LoadDataBlocks(
+    const std::vector<int> &block_ids,
+    std::vector<std::shared_ptr<hfile::DataBlock> > *blocks) {
+    blocks->assign(block_ids.size(), std::shared_ptr<hfile::DataBlock>());
+    // Both block cache and loading blocks are thread safe.
+    ParallelFor(block_ids.size() > 1 ? io_thread_pool_ : NULL, 0, block_ids.size(), 1,
+                std::bind(&OnDiskSSTableReader::LoadDataBlockRange, this, &block_ids, blocks,
+                          std::placeholders::_1, std::placeholders::_2));
+}
+
+int OnDiskSSTableReader::MultiLookup(const std::vector<std::string> &keys,
+                                     std::vector<std::string> *values,
+                                     std::vector<bool> *found) {
+    values->assign(keys.size(), std::string());
+    found->assign(keys.size(), false);
+    const hfile::DataIndex *index = impl_->data_index_.get();
+    int block_count = index->GetBlockSize();
+    if (block_count == 0)
+        return 0;
+
+    // Keys which may be in the table in order, with their minimal blocks.
+    std::vector<size_t> order;
+    order.reserve(keys.size());
+    for (size_t i = 0; i < keys.size(); ++i) {
+        if (impl_->KeyMayMatch(keys[i]))
+            order.push_back(i);
+    }
+    std::sort(order.begin(), order.end(), KeyIndexLess(keys));
+
+    // Items with the same key may cross blocks, and the first one may be at
+    // the beginning of the next block, so the next block is needed too if
+    // its first key is equal to the key. Block ids are in order as keys.
+    std::vector<int> key_blocks(order.size());
+    std::vector<int> block_ids;
+    for (size_t i = 0; i < order.size(); ++i) {
+        const std::string &key = keys[order[i]];
+        int block_id = index->FindMinimalBlock(key);
+        key_blocks[i] = block_id;
+        if (block_ids.empty() || block_ids.back() < block_id)
+            block_ids.push_back(block_id);
+        if (block_id + 1 < block_count && index->GetKey(block_id + 1) == key &&
+            block_ids.back() < block_id + 1) {
+            block_ids.push_back(block_id + 1);
+        }
+    }
+    std::vector<std::shared_ptr<hfile::DataBlock> > blocks;
+    LoadDataBlocks(block_ids, &blocks);
+
+    int count = 0;
+    size_t block_pos = 0;
+    for (size_t i = 0; i < order.size(); ++i) {
+        const std::string &key = keys[order[i]];
+        while (block_ids[block_pos] < key_blocks[i])
+            ++block_pos;
+        const hfile::DataBlock *block = blocks[block_pos].get();
+        if (block == NULL)
+            continue;
+        int item = block->LowerBound(key);
+        if (item == block->GetDataItemSize()) {
+            // All keys in the block are less than key, try the next block.
+            if (block_pos + 1 == block_ids.size() ||
+                block_ids[block_pos + 1] != key_blocks[i] + 1)
+                continue;
+            block = blocks[block_pos + 1].get();
+            if (block == NULL)
+                continue;
+            item = 0;
+        }
+        if (block->GetKey(item) != key)
+            continue;
+        StringPiece value = block->GetValue(item);
+        (*values)[order[i]].assign(value.data(), value.size());
+        (*found)[order[i]] = true;
+        ++count;
+    }
+    return count;
+}
+
 SSTableReader::Iterator *OnDiskSSTableReader::Seek(const std::string &key) {
     return new OnDiskIterator(this, key);
 }
 
+SSTableReader::Iterator *OnDiskSSTableReader::SeekForScan(const std::string &key) {
+    return new OnDiskScanIterator(this, key, io_thread_pool_, scan_readahead_blocks_);
+}
+
 OnDiskIterator::OnDiskIterator(OnDiskSSTableReader *sstable, const std::string &key)
                 : sstable_(sstable),
                   block_idx_(-1),
@@ -78,17 +219,17 @@ void OnDiskIterator::SeekKey(const std::string &key) {
         return;
     }
 
-    data_idx_ = 0;
-    key_ = cached_block_->GetKey(data_idx_);
-    if (key_ < key) {  // check if the first item is what we need
-        while (NextItem()) {
-            key_ = cached_block_->GetKey(data_idx_);
-            if (key_ >= key) break;
-        }
-        if (!valid_) return;
+    // The first key of the next block is not less than key, so if all keys
+    // in this block are less than key, it's the first item of next block.
+    data_idx_ = cached_block_->LowerBound(key);
+    if (data_idx_ == cached_block_->GetDataItemSize()) {
+        --data_idx_;
+        if (!NextItem())
+            return;
     } else {
         valid_ = true;
     }
+    key_ = cached_block_->GetKey(data_idx_);
     value_ = cached_block_->GetValue(data_idx_);
 }
 
@@ -117,4 +258,83 @@ void OnDiskIterator::LoadItem() {
     value_ = cached_block_->GetValue(data_idx_);
 }
 
+OnDiskScanIterator::OnDiskScanIterator(OnDiskSSTableReader *sstable, const std::string &key,
+                                       ThreadPool *pool, int readahead_blocks)
+                : sstable_(sstable),
+                  pool_(pool),
+                  readahead_blocks_(pool != NULL && readahead_blocks > 0 ? readahead_blocks : 0),
+                  block_idx_(-1),
+                  data_idx_(-1) {
+    SeekKey(key);
+}
+
+OnDiskScanIterator::~OnDiskScanIterator() {
+    // Running tasks are still using the sstable.
+    ClearPending();
+}
+
+void OnDiskScanIterator::ClearPending() {
+    for (size_t i = 0; i < pending_.size(); ++i)
+        pending_[i].second.Wait();
+    pending_.clear();
+}
+
+void OnDiskScanIterator::ReadAhead() {
+    int next_block = pending_.empty() ? block_idx_ + 1 : pending_.back().first + 1;
+    while (pending_.size() < readahead_blocks_ && next_block < sstable_->GetBlockSize()) {
+        BlockFuture block = AsyncRun(pool_, std::function<std::shared_ptr<hfile::DataBlock> ()>(
+            std::bind(&OnDiskSSTableReader::LoadUncachedDataBlock, sstable_, next_block)));
+        pending_.push_back(std::make_pair(next_block, block));
+        ++next_block;
+    }
+}
+
+bool OnDiskScanIterator::LoadBlock(int block_id) {
+    if (!pending_.empty() && pending_.front().first == block_id) {
+        block_ = pending_.front().second.Get();
+        pending_.pop_front();
+    } else {
+        // Not read ahead, such as seeking to another place.
+        ClearPending();
+        block_ = sstable_->LoadUncachedDataBlock(block_id);
+    }
+    block_idx_ = block_id;
+    if (!block_)
+        return false;
+    ReadAhead();
+    return true;
+}
+
+void OnDiskScanIterator::SeekKey(const std::string &key) {
+    valid_ = false;
+    if (sstable_->GetBlockSize() == 0)
+        return;
+    int block_id = sstable_->FindMinimalBlock(key);
+    if ((block_idx_ != block_id || !block_) && !LoadBlock(block_id))
+        return;
+    data_idx_ = block_->LowerBound(key);
+    if (data_idx_ == block_->GetDataItemSize()) {
+        // All keys in this block are less than key, it's the first item of
+        // the next block.
+        data_idx_ = block_->GetDataItemSize() - 1;
+        Next();
+        return;
+    }
+    valid_ = true;
+    LoadItem();
+}
+
+void OnDiskScanIterator::Next() {
+    valid_ = false;
+    if (data_idx_ + 1 < block_->GetDataItemSize()) {
+        ++data_idx_;
+    } else {
+        if (block_idx_ + 1 >= sstable_->GetBlockSize() || !LoadBlock(block_idx_ + 1))
+            return;
+        data_idx_ = 0;
+    }
+    valid_ = true;
+    LoadItem();
+}
+
 }  // namespace toft
@@ -6,28 +6,48 @@
 #ifndef TOFT_STORAGE_SSTABLE_READER_ON_DISK_SSTABLE_READER_H
 #define TOFT_STORAGE_SSTABLE_READER_ON_DISK_SSTABLE_READER_H
 
+#include <deque>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "toft/base/scoped_ptr.h"
 #include "toft/base/shared_ptr.h"
-#include "toft/container/lru_cache.h"
+#include "toft/storage/sstable/block_cache.h"
 #include "toft/storage/sstable/reader/sstable_reader_impl.h"
 #include "toft/storage/sstable/sstable.h"
+#include "toft/system/threading/future.h"
 
 namespace toft {
 
+class ThreadPool;
+
 // OnDiskSSTableReader is not good at key lookup but iteration.
 class OnDiskSSTableReader : public SSTableReader {
     TOFT_DECLARE_UNCOPYABLE(OnDiskSSTableReader);
 
 public:
-    OnDiskSSTableReader();
+    // Use a private block cache if block_cache is NULL. If io_thread_pool
+    // is not NULL, blocks needed by one call are loaded in it concurrently,
+    // and scan iterators read scan_readahead_blocks blocks ahead in it.
+    explicit OnDiskSSTableReader(BlockCache* block_cache = NULL,
+                                 ThreadPool* io_thread_pool = NULL,
+                                 int scan_readahead_blocks = 0);
     ~OnDiskSSTableReader();
 
     virtual Iterator *Seek(const std::string &key);
+    virtual Iterator *SeekForScan(const std::string &key);
+
+    // Sort keys and group them by data block, so each block is loaded once.
+    virtual int MultiLookup(const std::vector<std::string> &keys,
+                            std::vector<std::string> *values,
+                            std::vector<bool> *found);
 
     std::shared_ptr<hfile::DataBlock> LoadDataBlock(int block_id);
 
+    // Load the block without looking up or inserting into the block cache.
+    std::shared_ptr<hfile::DataBlock> LoadUncachedDataBlock(int block_id);
+
     int GetBlockSize() const {
         return impl_->data_index_->GetBlockSize();
     }
@@ -37,8 +57,27 @@ public:
         return impl_->data_index_->FindMinimalBlock(key);
     }
 
+    // Return hit, miss and eviction counters of the block cache, which
+    // include other readers if the cache is shared.
+    void GetBlockCacheStats(CacheStats* stats) const {
+        block_cache_->GetStats(stats);
+    }
+
 private:
-    toft::scoped_ptr<LruCache<int, std::shared_ptr<hfile::DataBlock> > > block_cache_;
+    // Load blocks by ids, blocks[i] is NULL if failed to load block_ids[i].
+    void LoadDataBlocks(const std::vector<int> &block_ids,
+                        std::vector<std::shared_ptr<hfile::DataBlock> > *blocks);
+    void LoadDataBlockRange(const std::vector<int> *block_ids,
+                            std::vector<std::shared_ptr<hfile::DataBlock> > *blocks,
+                            size_t begin, size_t end);
+
+    toft::scoped_ptr<BlockCache> private_block_cache_;
+    BlockCache* block_cache_;
+    ThreadPool* io_thread_pool_;
+    int scan_readahead_blocks_;
+    uint64_t file_id_;
+    // Charge blocks by uncompressed size, otherwise by 1.
+    bool charge_by_bytes_;
 };
 
 class OnDiskIterator : public SSTableReader::Iterator {
@@ -67,6 +106,46 @@ private:
 TOFT_DECLARE_UNCOPYABLE(OnDiskIterator);
 };
 
+// Iterate blocks in order without the block cache, the next blocks are read
+// and decompressed in the io thread pool while the current one is used.
+class OnDiskScanIterator : public SSTableReader::Iterator {
+    TOFT_DECLARE_UNCOPYABLE(OnDiskScanIterator);
+
+public:
+    OnDiskScanIterator(OnDiskSSTableReader *sstable, const std::string &key,
+                       ThreadPool *pool, int readahead_blocks);
+    ~OnDiskScanIterator();
+
+    virtual void Next();
+    virtual void SeekKey(const std::string &key);
+
+private:
+    typedef Future<std::shared_ptr<hfile::DataBlock> > BlockFuture;
+
+    // Make block_ the block of block_id, return false if failed.
+    bool LoadBlock(int block_id);
+
+    // Start reading blocks after the pending ones.
+    void ReadAhead();
+
+    // Wait for all blocks being read and drop them.
+    void ClearPending();
+
+    void LoadItem() {
+        key_ = block_->GetKey(data_idx_);
+        value_ = block_->GetValue(data_idx_);
+    }
+
+    OnDiskSSTableReader *sstable_;
+    ThreadPool *pool_;
+    size_t readahead_blocks_;
+    std::shared_ptr<hfile::DataBlock> block_;
+    int block_idx_;
+    int data_idx_;
+    // Blocks being read in order, with their block ids.
+    std::deque<std::pair<int, BlockFuture> > pending_;
+};
+
 }  // namespace toft
 
 #endif  // TOFT_STORAGE_SSTABLE_READER_ON_DISK_SSTABLE_READER_H
@@ -26,19 +26,26 @@ SSTableReader::~SSTableReader() {
 }
 
 SSTableReader *SSTableReader::Open(const std::string &path, ReadMode type) {
+    SSTableReadOption option;
+    option.set_read_mode(type);
+    return Open(path, option);
+}
+
+SSTableReader *SSTableReader::Open(const std::string &path, const SSTableReadOption &option) {
     toft::scoped_ptr<SSTableReader> ptr;
-    switch (type) {
+    switch (option.read_mode()) {
     case ON_DISK:
-        ptr.reset(new OnDiskSSTableReader);
+        ptr.reset(new OnDiskSSTableReader(option.block_cache(), option.io_thread_pool(),
+                                          option.scan_readahead_blocks()));
         break;
     case IN_MEMORY:
         ptr.reset(new InMemorySSTableReader);
         break;
     default:
-        DCHECK(false) << "invalid sstable type: " << type;
+        DCHECK(false) << "invalid sstable type: " << option.read_mode();
     }
     if (ptr.get()) {
-        if (!ptr->impl_->LoadFile(path)) {
+        if (!ptr->impl_->LoadFile(path, option.use_mmap())) {
             return NULL;
         }
         ptr->Init();
@@ -101,14 +108,44 @@ SSTableReader::Iterator *SSTableReader::NewIterator() {
     return Seek("");
 }
 
+SSTableReader::Iterator *SSTableReader::SeekForScan(const std::string &key) {
+    return Seek(key);
+}
+
+SSTableReader::Iterator *SSTableReader::NewScanIterator() {
+    return SeekForScan("");
+}
+
 std::string SSTableReader::GetPath() const {
     return impl_->path_;
 }
 
+int SSTableReader::MultiLookup(const std::vector<std::string> &keys,
+                               std::vector<std::string> *values,
+                               std::vector<bool> *found) {
+    values->assign(keys.size(), std::string());
+    found->assign(keys.size(), false);
+    int count = 0;
+    for (size_t i = 0; i < keys.size(); ++i) {
+        if (Lookup(keys[i], &(*values)[i])) {
+            (*found)[i] = true;
+            ++count;
+        }
+    }
+    return count;
+}
+
+int64_t SSTableReader::MemoryUsage() const {
+    return 0;
+}
+
 bool SSTableReader::Lookup(const std::string &key, std::string *value) {
+    // Most missing keys are filtered out without loading any data block.
+    if (!impl_->KeyMayMatch(key))
+        return false;
     toft::scoped_ptr<Iterator> iter(Seek(key));
-    if (iter->key() == key) {
-        *value = iter->value();
+    if (iter->Valid() && iter->key_piece() == key) {
+        value->assign(iter->value_piece().data(), iter->value_piece().size());
         return true;
     }
     return false;
@@ -136,7 +136,7 @@ SSTableReader::Impl::Impl()
 
 SSTableReader::Impl::~Impl() {}
 
-bool SSTableReader::Impl::LoadFile(const std::string &path) {
+bool SSTableReader::Impl::LoadFile(const std::string &path, bool use_mmap) {
     CHECK(!file_base_.get()) << "the sstable is already opened.";
     path_ = path;
     MutexLocker l(&mutex_);
@@ -145,8 +145,72 @@ bool SSTableReader::Impl::LoadFile(const std::string &path) {
         LOG(ERROR)<< "open sstable failed: " << path;
         return false;
     }
+    if (use_mmap && !mapped_file_.Open(path)) {
+        // Still works by reading the file.
+        LOG(WARNING)<< "fail to mmap sstable: " << path;
+    }
+
+    if (!LoadFileInfo(file_base_.get(), data_index_.get(), file_info_.get(),
+                      file_trailer_.get())) {
+        return false;
+    }
+    return LoadMetaBlocks();
+}
+
+bool SSTableReader::Impl::LoadMetaBlocks() {
+    if (file_trailer_->meta_index_count() <= 0)
+        return true;
+    // Meta index and meta blocks are between the data index and trailer.
+    if (!file_base_->Seek(0, SEEK_END)) {
+        LOG(ERROR)<< "Fail to seek file";
+        return false;
+    }
+    int64_t meta_offset = file_trailer_->meta_index_offset();
+    int64_t meta_length = file_base_->Tell() - hfile::FileTrailer::TrailerSize() - meta_offset;
+    if (meta_length < 0) {
+        LOG(ERROR)<< "get invalid meta index length: " << meta_length;
+        return false;
+    }
+    std::string buffer;
+    buffer.resize(meta_length);
+    if (file_base_->ReadAt(meta_offset, &buffer[0], meta_length) != meta_length) {
+        LOG(ERROR)<< "read meta index failed";
+        return false;
+    }
+    hfile::MetaIndex meta_index(meta_offset);
+    if (!meta_index.DecodeFromString(buffer)) {
+        LOG(ERROR)<< "parse meta index failed, invalid format!";
+        return false;
+    }
 
-    return LoadFileInfo(file_base_.get(), data_index_.get(), file_info_.get(), file_trailer_.get());
+    std::string bloom_data;
+    if (meta_index.FindMetaBlock(hfile::BloomFilterBlock::kMetaBlockName, &bloom_data)) {
+        bloom_filter_.reset(new hfile::BloomFilterBlock);
+        if (!bloom_filter_->DecodeFromString(bloom_data) ||
+            bloom_filter_->GetFilterCount() != data_index_->GetBlockSize()) {
+            // Data is still readable without bloom filter.
+            LOG(WARNING)<< "ignore invalid bloom filter of " << path_;
+            bloom_filter_.reset(NULL);
+        }
+    }
+    return true;
+}
+
+bool SSTableReader::Impl::KeyMayMatch(const std::string &key) const {
+    if (!bloom_filter_.get())
+        return true;
+    int block_count = data_index_->GetBlockSize();
+    if (block_count == 0)
+        return false;
+    // Items with the same key may cross blocks, so check all blocks from the
+    // first candidate until the first key of block is larger than the key.
+    int block_id = data_index_->FindMinimalBlock(key);
+    do {
+        if (bloom_filter_->MayContain(block_id, key))
+            return true;
+        ++block_id;
+    } while (block_id < block_count && data_index_->GetKey(block_id) <= key);
+    return false;
 }
 
 const std::string SSTableReader::Impl::GetMetaData(const std::string &key) const {
@@ -170,6 +234,13 @@ void SSTableReader::Impl::IterMetaData(
     }
 }
 
+hfile::DataBlock *SSTableReader::Impl::NewDataBlock() const {
+    hfile::DataBlock::Format format = hfile::DataBlock::kPlainFormat;
+    if (file_info_->data_block_format() == hfile::DataBlock::kPrefixFormat)
+        format = hfile::DataBlock::kPrefixFormat;
+    return new hfile::DataBlock(file_trailer_->compress_type(), format);
+}
+
 bool SSTableReader::Impl::LoadDataBlock(int block_id, hfile::DataBlock *block) {
     CHECK(block_id >= 0 && block_id < data_index_->GetBlockSize())
                     << "invalid block_id: " << block_id;
@@ -182,21 +253,34 @@ bool SSTableReader::Impl::LoadDataBlock(int block_id, hfile::DataBlock *block) {
         next_offset = file_trailer_->file_info_offset();
     }
     int64_t cur_offset = data_index_->GetOffset(block_id);
-    int length = next_offset - cur_offset;
+    int64_t length = next_offset - cur_offset;
+    if (length < 0) {
+        LOG(ERROR)<< "invalid data block length: " << length;
+        return false;
+    }
 
-    std::string buffer;
-    {
-        MutexLocker l(&mutex_);
-        if (!file_base_->Seek(cur_offset, SEEK_SET)) {
-            return false;
-        }
-        buffer.resize(length);
-        int64_t size = file_base_->Read((void*) buffer.c_str(), length);
-        if (size != length) {
+    if (mapped_file_.IsOpen()) {
+        StringPiece data;
+        if (!mapped_file_.GetRange(cur_offset, length, &data)) {
+            LOG(ERROR)<< "data block out of range, offset: " << cur_offset;
             return false;
         }
+        return block->DecodeFromMemory(data);
+    }
+
+    std::string buffer;
+    buffer.resize(length);
+    int64_t size;
+    if (file_base_->IsReadAtThreadSafe()) {
+        size = file_base_->ReadAt(cur_offset, &buffer[0], length);
+    } else {
+        MutexLocker l(&mutex_);
+        size = file_base_->ReadAt(cur_offset, &buffer[0], length);
+    }
+    if (size != length) {
+        return false;
     }
-    return block->DecodeFromString(buffer);
+    return block->DecodeFromBuffer(&buffer);
 }
 
 }  // namespace toft
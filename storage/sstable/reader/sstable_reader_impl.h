@@ -16,6 +16,7 @@
 
 #include "toft/base/closure.h"
 #include "toft/base/scoped_ptr.h"
+#include "toft/storage/file/memory_mapped_file.h"
 #include "toft/storage/sstable/sstable.h"
 #include "toft/system/threading/mutex.h"
 
@@ -37,9 +38,19 @@ public:
     Impl();
     ~Impl();
 
+    // Create an empty data block to load blocks of this file.
+    hfile::DataBlock *NewDataBlock() const;
+
+    // Thread safe, blocks are loaded without lock if the file is mapped or
+    // supports concurrent positional read.
     bool LoadDataBlock(int block_id, hfile::DataBlock *block);
 
-    bool LoadFile(const std::string &path);
+    // If use_mmap is true, data blocks are read from the mapped file.
+    bool LoadFile(const std::string &path, bool use_mmap = false);
+
+    // Return false if the key is definitely not in the sstable by bloom
+    // filters, always true if the sstable has no bloom filter.
+    bool KeyMayMatch(const std::string &key) const;
 
     const std::string GetMetaData(const std::string &key) const;
 
@@ -54,11 +65,17 @@ public:
     std::string path_;
 
 private:
+    // Load meta blocks after the data index if there are.
+    bool LoadMetaBlocks();
+
     toft::scoped_ptr<hfile::FileInfo> file_info_;
+    toft::scoped_ptr<hfile::BloomFilterBlock> bloom_filter_;
     uint32_t buffer_size_;
 
-    toft::Mutex mutex_;  // protects file_base_
+    // Protects file_base_ only if it doesn't support concurrent ReadAt.
+    toft::Mutex mutex_;
     toft::scoped_ptr<File> file_base_;
+    MemoryMappedFile mapped_file_;
 };
 
 }  // namespace toft
@@ -15,11 +15,11 @@ SSTableReader::Iterator::~Iterator() {
 }
 
 const std::string SSTableReader::Iterator::key() const {
-    return key_;
+    return key_.as_string();
 }
 
 const std::string SSTableReader::Iterator::value() const {
-    return value_;
+    return value_.as_string();
 }
 
 bool SSTableReader::Iterator::Valid() const {
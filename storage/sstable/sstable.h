@@ -6,9 +6,11 @@
 #ifndef TOFT_STORAGE_SSTABLE_SSTABLE_H
 #define TOFT_STORAGE_SSTABLE_SSTABLE_H
 
+#include "toft/storage/sstable/hfile/bloom_filter_block.h"
 #include "toft/storage/sstable/hfile/data_block.h"
 #include "toft/storage/sstable/hfile/data_index.h"
 #include "toft/storage/sstable/hfile/file_info.h"
 #include "toft/storage/sstable/hfile/file_trailer.h"
+#include "toft/storage/sstable/hfile/meta_index.h"
 
 #endif  // TOFT_STORAGE_SSTABLE_SSTABLE_H
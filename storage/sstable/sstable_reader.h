@@ -8,12 +8,15 @@
 #ifndef TOFT_STORAGE_SSTABLE_SSTABLE_READER_H
 #define TOFT_STORAGE_SSTABLE_SSTABLE_READER_H
 
+#include <stdint.h>
 #include <stdio.h>
 #include <string>
 #include <vector>
 
 #include "toft/base/closure.h"
+#include "toft/base/functional.h"
 #include "toft/base/scoped_ptr.h"
+#include "toft/base/string/string_piece.h"
 #include "toft/base/uncopyable.h"
 
 // GLOBAL_NOLINT(readability/casting)
@@ -26,7 +29,10 @@ class FileTrailer;
 class FileInfo;
 } // namespace hfile
 
+class BlockCache;
 class File;
+class ThreadPool;
+class SSTableReadOption;
 
 // The file format is HFile 1.0. But the key and value are only std::string.
 class SSTableReader {
@@ -48,6 +54,7 @@ public:
     // ON_DISK mode is not good at looking key
     // IN_MEMORY mode load data to memory, which is more efficient
     static SSTableReader *Open(const std::string &path, ReadMode type);
+    static SSTableReader *Open(const std::string &path, const SSTableReadOption &option);
     static bool GetMetaData(const std::string &path, const std::string &key, std::string *value);
     static bool GetEntryCount(const std::string &path, int *count);
 
@@ -62,6 +69,15 @@ public:
     virtual int EntryCount() const;
     virtual bool Lookup(const std::string &key, std::string *value);
 
+    // Look up many keys in one call, values and found are resized to the
+    // size of keys, values[i] is the value of keys[i] if found[i] is true,
+    // or empty if not.
+    // ON_DISK tables load each needed block only once for all keys.
+    // Return the number of found keys.
+    virtual int MultiLookup(const std::vector<std::string> &keys,
+                            std::vector<std::string> *values,
+                            std::vector<bool> *found);
+
     // New a iterator to the key, or the first one after the key if it's not found.
     // Caller should delete the iterator
     virtual Iterator* Seek(const std::string &key) = 0;
@@ -69,8 +85,21 @@ public:
     // Caller should delete the iterator
     Iterator* NewIterator();
 
+    // Same as Seek, but for scanning a large range in order. ON_DISK tables
+    // read the next blocks ahead in io_thread_pool, and don't put blocks
+    // into the block cache, so scanning doesn't evict hot blocks.
+    // Caller should delete the iterator
+    virtual Iterator* SeekForScan(const std::string &key);
+    // New a scan iterator pointed to the first key.
+    // Caller should delete the iterator
+    Iterator* NewScanIterator();
+
     std::string GetPath() const;
 
+    // Bytes of memory used by loaded items, such as the whole table in
+    // IN_MEMORY mode. Shared block caches are not counted.
+    virtual int64_t MemoryUsage() const;
+
 protected:
     SSTableReader();
 
@@ -87,6 +116,15 @@ public:
     const std::string key() const;
     const std::string value() const;
 
+    // Same as key() and value() but without copying, the returned pieces
+    // are valid until the iterator is moved or deleted.
+    StringPiece key_piece() const {
+        return key_;
+    }
+    StringPiece value_piece() const {
+        return value_;
+    }
+
     virtual void Next() = 0;
     //  If exist, seek to first position of this key.
     //  If not exist then
@@ -98,10 +136,111 @@ public:
     bool Valid() const;
 
 protected:
-    std::string key_;
-    std::string value_;
+    // Refer to the data owned by the derived iterator.
+    StringPiece key_;
+    StringPiece value_;
     bool valid_;
 };
+
+class SSTableReadOption {
+public:
+    SSTableReadOption()
+        : read_mode_(SSTableReader::ON_DISK),
+          block_cache_(NULL),
+          use_mmap_(false),
+          io_thread_pool_(NULL),
+          scan_readahead_blocks_(4),
+          open_thread_pool_(NULL),
+          max_concurrent_opens_(0) {
+    }
+
+    SSTableReader::ReadMode read_mode() const {
+        return read_mode_;
+    }
+    void set_read_mode(SSTableReader::ReadMode read_mode) {
+        read_mode_ = read_mode;
+    }
+
+    // Block cache for ON_DISK mode, not owned. If it's NULL, each reader
+    // uses a private cache sized by --on_disk_sstable_block_cache[_bytes].
+    // Use BlockCache::Default() to share one cache among all readers.
+    BlockCache* block_cache() const {
+        return block_cache_;
+    }
+    void set_block_cache(BlockCache* block_cache) {
+        block_cache_ = block_cache;
+    }
+
+    // Map the file into memory and load data blocks from it, so loading
+    // blocks needs no system call. Only for local files, fall back to
+    // positional read if failed.
+    bool use_mmap() const {
+        return use_mmap_;
+    }
+    void set_use_mmap(bool use_mmap) {
+        use_mmap_ = use_mmap;
+    }
+
+    // Load data blocks of ON_DISK tables in the pool when more than one
+    // block is needed, such as by MultiLookup, not owned. If it's NULL,
+    // blocks are loaded in the calling thread.
+    ThreadPool* io_thread_pool() const {
+        return io_thread_pool_;
+    }
+    void set_io_thread_pool(ThreadPool* pool) {
+        io_thread_pool_ = pool;
+    }
+
+    // Number of blocks read ahead by iterators of SeekForScan if
+    // io_thread_pool is set, 0 disables reading ahead.
+    int scan_readahead_blocks() const {
+        return scan_readahead_blocks_;
+    }
+    void set_scan_readahead_blocks(int scan_readahead_blocks) {
+        scan_readahead_blocks_ = scan_readahead_blocks;
+    }
+
+    // The following options are only used by MergedSSTableReader::Open.
+
+    // Open sstables concurrently in the pool, not owned. If it's NULL,
+    // sstables are opened one by one in the calling thread.
+    ThreadPool* open_thread_pool() const {
+        return open_thread_pool_;
+    }
+    void set_open_thread_pool(ThreadPool* pool) {
+        open_thread_pool_ = pool;
+    }
+
+    // Max number of sstables being opened at the same time, which bounds
+    // the io parallelism. 0 means one per thread of the pool, plus the
+    // calling thread.
+    int max_concurrent_opens() const {
+        return max_concurrent_opens_;
+    }
+    void set_max_concurrent_opens(int max_concurrent_opens) {
+        max_concurrent_opens_ = max_concurrent_opens;
+    }
+
+    // Called with (opened, total) number of files after each file is opened,
+    // maybe in threads of the pool, but calls are serialized.
+    const std::function<void (int, int)>& open_progress_callback() const {
+        return open_progress_callback_;
+    }
+    void set_open_progress_callback(const std::function<void (int, int)>& callback) {
+        open_progress_callback_ = callback;
+    }
+
+private:
+    SSTableReader::ReadMode read_mode_;
+    BlockCache* block_cache_;
+    bool use_mmap_;
+    ThreadPool* io_thread_pool_;
+    int scan_readahead_blocks_;
+    ThreadPool* open_thread_pool_;
+    int max_concurrent_opens_;
+    std::function<void (int, int)> open_progress_callback_;
+};
+
 }  // namespace toft
 
 #endif  // TOFT_STORAGE_SSTABLE_SSTABLE_READER_H
@@ -0,0 +1,128 @@
+// Copyright (c) 2026, The Toft Authors.
+// All rights reserved.
+//
+// Tests of BlockCache.
+
+#include "toft/storage/sstable/block_cache.h"
+
+#include <string>
+#include <vector>
+
+#include "toft/base/scoped_ptr.h"
+#include "toft/base/string/format.h"
+#include "toft/storage/sstable/merged_sstable_reader.h"
+#include "toft/storage/sstable/sstable.h"
+#include "toft/storage/sstable/sstable_reader.h"
+#include "toft/storage/sstable/sstable_writer.h"
+#include "toft/storage/sstable/test/test_util.h"
+
+#include "thirdparty/gtest/gtest.h"
+
+namespace toft {
+
+static void BuildSSTable(const std::string& path) {
+    SSTableWriteOption option;
+    option.set_path(path);
+    option.set_block_size(1024);
+    option.set_compress_type(CompressType_kSnappy);
+    UnsortedSSTableWriter builder(option);
+    for (int i = 0; i < kTestNum; ++i)
+        ASSERT_TRUE(builder.Add(GenKey(i, kMaxLength), GenValue(i, kMaxLength)));
+    ASSERT_TRUE(builder.Flush());
+}
+
+static int Scan(SSTableReader* sstable) {
+    int count = 0;
+    scoped_ptr<SSTableReader::Iterator> iter(sstable->NewIterator());
+    for (; iter->Valid(); iter->Next()) {
+        EXPECT_EQ(GenKey(count, kMaxLength), iter->key());
+        ++count;
+    }
+    return count;
+}
+
+TEST(BlockCache, Basic) {
+    BlockCache cache(100, 0);
+    uint64_t id1 = cache.NewFileId();
+    uint64_t id2 = cache.NewFileId();
+    EXPECT_NE(id1, id2);
+
+    std::shared_ptr<hfile::DataBlock> block(new hfile::DataBlock(CompressType_kUnCompress));
+    EXPECT_FALSE(cache.Lookup(id1, 0));
+    cache.Insert(id1, 0, block, 60);
+    EXPECT_TRUE(cache.Lookup(id1, 0));
+    EXPECT_FALSE(cache.Lookup(id2, 0));
+    EXPECT_EQ(60U, cache.Charge());
+    EXPECT_DOUBLE_EQ(1.0 / 3, cache.HitRate());
+
+    cache.Insert(id2, 0, block, 60);
+    EXPECT_FALSE(cache.Lookup(id1, 0));
+    EXPECT_TRUE(cache.Lookup(id2, 0));
+    cache.Erase(id2, 0);
+    EXPECT_EQ(0U, cache.Charge());
+}
+
+TEST(BlockCache, SharedByReaders) {
+    const std::string path1 = "/tmp/test_block_cache_1.sstable";
+    const std::string path2 = "/tmp/test_block_cache_2.sstable";
+    BuildSSTable(path1);
+    BuildSSTable(path2);
+
+    const size_t kCapacity = 16 * 1024;
+    BlockCache cache(kCapacity, 2);
+    SSTableReadOption option;
+    option.set_block_cache(&cache);
+    scoped_ptr<SSTableReader> sstable1(SSTableReader::Open(path1, option));
+    scoped_ptr<SSTableReader> sstable2(SSTableReader::Open(path2, option));
+    ASSERT_TRUE(sstable1.get());
+    ASSERT_TRUE(sstable2.get());
+
+    EXPECT_EQ(kTestNum, Scan(sstable1.get()));
+    EXPECT_EQ(kTestNum, Scan(sstable2.get()));
+    EXPECT_LE(cache.Charge(), kCapacity);
+
+    CacheStats stats;
+    cache.GetStats(&stats);
+    EXPECT_GT(stats.misses, 0U);
+    EXPECT_GT(stats.evictions, 0U);
+
+    // Lookup the same key repeatedly, should hit the cache.
+    std::string key = GenKey(kTestNum / 2, kMaxLength);
+    std::string value;
+    for (int i = 0; i < 10; ++i) {
+        ASSERT_TRUE(sstable1->Lookup(key, &value));
+        EXPECT_EQ(GenValue(kTestNum / 2, kMaxLength), value);
+    }
+    CacheStats stats2;
+    cache.GetStats(&stats2);
+    EXPECT_GE(stats2.hits, stats.hits + 9);
+
+    // Blocks of closed reader are released.
+    sstable1.reset();
+    sstable2.reset();
+    EXPECT_EQ(0U, cache.Charge());
+}
+
+TEST(BlockCache, MergedSSTableReader) {
+    std::vector<std::string> paths;
+    for (int i = 0; i < 3; ++i) {
+        paths.push_back(StringPrint("/tmp/test_block_cache_merged_%d.sstable", i));
+        BuildSSTable(paths.back());
+    }
+
+    BlockCache cache(1024 * 1024);
+    SSTableReadOption option;
+    option.set_block_cache(&cache);
+    MergedSSTableReader sstable;
+    ASSERT_TRUE(sstable.Open(paths, option, false));
+    EXPECT_EQ(3 * kTestNum, sstable.EntryCount());
+
+    scoped_ptr<SSTableReader::Iterator> iter(sstable.NewIterator());
+    int count = 0;
+    for (; iter->Valid(); iter->Next())
+        ++count;
+    EXPECT_EQ(3 * kTestNum, count);
+    EXPECT_GT(cache.Charge(), 0U);
+}
+
+}  // namespace toft
@@ -0,0 +1,131 @@
+// Copyright (c) 2026, The Toft Authors.
+// All rights reserved.
+//
+// Tests of ExternalSorter.
+
+#include "toft/storage/sstable/writer/external_sorter.h"
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "toft/base/string/number.h"
+#include "toft/storage/file/file.h"
+
+#include "thirdparty/gtest/gtest.h"
+
+namespace toft {
+
+typedef std::vector<std::pair<std::string, std::string> > Items;
+
+static bool KeyLess(const std::pair<std::string, std::string> &a,
+                    const std::pair<std::string, std::string> &b) {
+    return a.first < b.first;
+}
+
+// Keys with common prefixes, different length and duplications.
+static Items GenItems(int count) {
+    Items items;
+    for (int i = 0; i < count; ++i) {
+        int n = (i * 7919) % (count / 3 + 1);
+        std::string key = std::string(i % 12, 'k') + NumberToString(n);
+        if (i % 5 == 0)
+            key += std::string(i % 3, '\0');
+        items.push_back(std::make_pair(key, NumberToString(i)));
+    }
+    return items;
+}
+
+static void CheckSort(const Items &items, int64_t memory_budget, int min_runs) {
+    ExternalSorter sorter(memory_budget, "/tmp/external_sorter_test");
+    for (size_t i = 0; i < items.size(); ++i)
+        ASSERT_TRUE(sorter.Add(items[i].first, items[i].second));
+    EXPECT_EQ(static_cast<int64_t>(items.size()), sorter.item_count());
+    EXPECT_GE(sorter.run_count(), min_runs);
+    ASSERT_TRUE(sorter.Sort());
+
+    Items expected = items;
+    std::stable_sort(expected.begin(), expected.end(), KeyLess);
+    StringPiece key;
+    StringPiece value;
+    size_t count = 0;
+    while (sorter.GetNext(&key, &value)) {
+        ASSERT_LT(count, expected.size());
+        EXPECT_EQ(expected[count].first, key.as_string()) << count;
+        EXPECT_EQ(expected[count].second, value.as_string()) << count;
+        ++count;
+    }
+    EXPECT_FALSE(sorter.failed());
+    EXPECT_EQ(expected.size(), count);
+}
+
+TEST(ExternalSorter, Empty) {
+    ExternalSorter sorter(0, "/tmp/external_sorter_test");
+    ASSERT_TRUE(sorter.Sort());
+    StringPiece key;
+    StringPiece value;
+    EXPECT_FALSE(sorter.GetNext(&key, &value));
+    EXPECT_FALSE(sorter.failed());
+}
+
+TEST(ExternalSorter, InMemory) {
+    CheckSort(GenItems(10000), 0, 0);
+}
+
+TEST(ExternalSorter, Spill) {
+    CheckSort(GenItems(10000), 16 * 1024, 10);
+}
+
+TEST(ExternalSorter, SpillEachItem) {
+    CheckSort(GenItems(100), 1, 100);
+}
+
+TEST(ExternalSorter, LargeItem) {
+    Items items = GenItems(100);
+    items[50].second = std::string(3 * 1024 * 1024, 'v');
+    CheckSort(items, 1024, 2);
+}
+
+TEST(ExternalSorter, ManySmallRuns) {
+    // Far more runs than can be merged at once.
+    CheckSort(GenItems(20000), 256, 1000);
+}
+
+TEST(ExternalSorter, MergeRuns) {
+    ExternalSorter sorter(256, "/tmp/external_sorter_merge");
+    for (int i = 0; i < 1000; ++i)
+        ASSERT_TRUE(sorter.Add(NumberToString(1000 - i), NumberToString(i)));
+    int run_count = sorter.run_count();
+    ASSERT_GT(run_count, 100);
+    ASSERT_TRUE(sorter.Sort());
+    // Runs are merged into fewer ones, and merged runs are deleted.
+    EXPECT_LT(sorter.run_count(), run_count);
+    EXPECT_FALSE(File::Exists("/tmp/external_sorter_merge.run0"));
+
+    StringPiece key;
+    StringPiece value;
+    std::string last_key;
+    int count = 0;
+    while (sorter.GetNext(&key, &value)) {
+        EXPECT_LE(last_key, key.as_string());
+        last_key = key.as_string();
+        ++count;
+    }
+    EXPECT_FALSE(sorter.failed());
+    EXPECT_EQ(1000, count);
+}
+
+TEST(ExternalSorter, DeleteRunFiles) {
+    {
+        ExternalSorter sorter(1, "/tmp/external_sorter_delete");
+        sorter.Add("b", "1");
+        sorter.Add("a", "2");
+        EXPECT_EQ(2, sorter.run_count());
+        EXPECT_TRUE(File::Exists("/tmp/external_sorter_delete.run0"));
+    }
+    EXPECT_FALSE(File::Exists("/tmp/external_sorter_delete.run0"));
+    EXPECT_FALSE(File::Exists("/tmp/external_sorter_delete.run1"));
+}
+
+}  // namespace toft
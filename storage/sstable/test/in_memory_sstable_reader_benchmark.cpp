@@ -0,0 +1,69 @@
+// Copyright (c) 2026, The Toft Authors.
+// All rights reserved.
+//
+// Lookup and scan a table loaded in IN_MEMORY mode.
+
+#include <stdlib.h>
+
+#include <string>
+
+#include "toft/base/scoped_ptr.h"
+#include "toft/base/string/format.h"
+#include "toft/storage/sstable/sstable_reader.h"
+#include "toft/storage/sstable/sstable_writer.h"
+
+#include "thirdparty/benchmark/benchmark.h"
+
+namespace {
+
+const int kItemNum = 200000;
+const char kPath[] = "/tmp/in_memory_sstable_benchmark.sstable";
+
+std::string BenchmarkKey(int i) {
+    return toft::StringPrint("key_%010d", i);
+}
+
+toft::SSTableReader *OpenTable() {
+    toft::SSTableWriteOption option;
+    option.set_path(kPath);
+    toft::SingleSSTableWriter builder(option);
+    for (int i = 0; i < kItemNum; ++i)
+        builder.AddOrDie(BenchmarkKey(i), toft::StringPrint("value_%024d", i));
+    builder.Flush();
+    return toft::SSTableReader::Open(kPath, toft::SSTableReader::IN_MEMORY);
+}
+
+toft::SSTableReader *Table() {
+    static toft::SSTableReader *sstable = OpenTable();
+    return sstable;
+}
+
+}  // namespace
+
+static void InMemorySSTableLookup(benchmark::State& state) {
+    toft::SSTableReader *sstable = Table();
+    unsigned int seed = 1;
+    std::string value;
+    for (auto _ : state) {
+        // Half of the keys are missing.
+        int i = rand_r(&seed) % (2 * kItemNum);
+        benchmark::DoNotOptimize(sstable->Lookup(BenchmarkKey(i), &value));
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.counters["memory_bytes"] = sstable->MemoryUsage();
+}
+BENCHMARK(InMemorySSTableLookup);
+
+static void InMemorySSTableScan(benchmark::State& state) {
+    toft::SSTableReader *sstable = Table();
+    int64_t items = 0;
+    for (auto _ : state) {
+        toft::scoped_ptr<toft::SSTableReader::Iterator> iter(sstable->NewIterator());
+        for (; iter->Valid(); iter->Next()) {
+            benchmark::DoNotOptimize(iter->value_piece().data());
+            ++items;
+        }
+    }
+    state.SetItemsProcessed(items);
+}
+BENCHMARK(InMemorySSTableScan)->Unit(benchmark::kMillisecond);
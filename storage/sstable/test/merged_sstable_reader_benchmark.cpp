@@ -0,0 +1,84 @@
+// Copyright (c) 2026, The Toft Authors.
+// All rights reserved.
+//
+// Merge many small sstables, whose keys interleave with each other.
+
+#include <string>
+#include <vector>
+
+#include "toft/base/scoped_ptr.h"
+#include "toft/base/string/format.h"
+#include "toft/storage/sstable/merged_sstable_reader.h"
+#include "toft/storage/sstable/sstable_writer.h"
+#include "toft/system/threading/thread_pool.h"
+
+#include "thirdparty/benchmark/benchmark.h"
+
+namespace {
+
+const int kItemsPerTable = 2000;
+
+// Build tables once for all benchmarks, table i has keys i, i + n, ...
+std::vector<std::string> BuildTables(int table_num) {
+    std::vector<std::string> paths;
+    for (int t = 0; t < table_num; ++t) {
+        std::string path = toft::StringPrint("/tmp/merged_sstable_benchmark_%d_%d.sstable",
+                                             table_num, t);
+        toft::SSTableWriteOption option;
+        option.set_path(path);
+        toft::SingleSSTableWriter builder(option);
+        for (int i = 0; i < kItemsPerTable; ++i) {
+            builder.AddOrDie(toft::StringPrint("key_%010d", i * table_num + t),
+                             toft::StringPrint("value_%d", i));
+        }
+        builder.Flush();
+        paths.push_back(path);
+    }
+    return paths;
+}
+
+}  // namespace
+
+// range(0): number of tables.
+static void MergedSSTableScan(benchmark::State& state) {
+    const int table_num = state.range(0);
+    std::vector<std::string> paths = BuildTables(table_num);
+    toft::MergedSSTableReader sstable;
+    if (!sstable.Open(paths, toft::SSTableReader::ON_DISK, false)) {
+        state.SkipWithError("failed to open sstables");
+        return;
+    }
+    int64_t items = 0;
+    for (auto _ : state) {
+        toft::scoped_ptr<toft::SSTableReader::Iterator> iter(sstable.NewIterator());
+        for (; iter->Valid(); iter->Next()) {
+            benchmark::DoNotOptimize(iter->key_piece().data());
+            ++items;
+        }
+    }
+    state.SetItemsProcessed(items);
+}
+BENCHMARK(MergedSSTableScan)->Arg(2)->Arg(16)->Arg(128)->Arg(256)
+    ->Unit(benchmark::kMillisecond);
+
+// range(0): number of tables, range(1): number of threads to open them.
+static void MergedSSTableOpen(benchmark::State& state) {
+    const int table_num = state.range(0);
+    std::vector<std::string> paths = BuildTables(table_num);
+    toft::scoped_ptr<toft::ThreadPool> pool;
+    toft::SSTableReadOption option;
+    if (state.range(1) > 0) {
+        pool.reset(new toft::ThreadPool(state.range(1)));
+        option.set_open_thread_pool(pool.get());
+    }
+    for (auto _ : state) {
+        toft::MergedSSTableReader sstable;
+        if (!sstable.Open(paths, option, false)) {
+            state.SkipWithError("failed to open sstables");
+            return;
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * table_num);
+}
+BENCHMARK(MergedSSTableOpen)->Args({256, 0})->Args({256, 4})->Args({256, 16})->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
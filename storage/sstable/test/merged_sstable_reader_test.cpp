@@ -3,6 +3,10 @@
 //
 // Author: Ye Shunping <yeshunping@gmail.com>
 
+#include <algorithm>
+#include <utility>
+#include <vector>
+
 #include "toft/base/string/format.h"
 #include "toft/storage/sharding/fingerprint_sharding.h"
 #include "toft/storage/sstable/merged_sstable_reader.h"
@@ -11,6 +15,7 @@
 #include "toft/storage/sstable/sstable_writer.h"
 #include "toft/storage/sstable/test/test_util.h"
 #include "toft/storage/sstable/types.h"
+#include "toft/system/threading/thread_pool.h"
 
 #include "thirdparty/glog/logging.h"
 
@@ -132,6 +137,182 @@ TEST(MergedSSTableReader, Lookup) {
         }
     }
     LOG(INFO)<< "done!";
+
+    std::vector<std::string> keys;
+    for (int i = kTestNum - 1; i >= 0; --i)
+        keys.push_back(GenKey(i, kMaxLength));
+    std::vector<std::string> values;
+    std::vector<bool> found;
+    int count = merged_sstable.MultiLookup(keys, &values, &found);
+    int expected_count = 0;
+    for (size_t i = 0; i < keys.size(); ++i) {
+        std::string value;
+        bool exist = merged_sstable.Lookup(keys[i], &value);
+        ASSERT_EQ(exist, found[i]) << keys[i];
+        if (exist) {
+            EXPECT_EQ(value, values[i]);
+            ++expected_count;
+        }
+    }
+    EXPECT_EQ(expected_count, count);
+}
+
+typedef std::vector<std::pair<std::string, std::string> > Items;
+
+// Keys interleave between files, and some keys are in all files.
+static void BuildManyFiles(int file_num, std::vector<std::string> *paths, Items *items) {
+    const int kItemNum = 500;
+    for (int f = 0; f < file_num; ++f) {
+        SSTableWriteOption option;
+        option.set_path(StringPrint("/tmp/test_merged_many_%d.sstable", f));
+        option.set_block_size(512);
+        SingleSSTableWriter builder(option);
+        for (int i = 0; i < kItemNum; ++i) {
+            std::string key = i % 50 == 0 ? StringPrint("%09d", i * file_num)
+                                          : StringPrint("%09d", i * file_num + f);
+            std::string value = StringPrint("value_%d", (f * 7) % file_num);
+            builder.AddOrDie(key, value);
+            items->push_back(std::make_pair(key, value));
+        }
+        ASSERT_TRUE(builder.Flush());
+        paths->push_back(option.path());
+    }
+    std::sort(items->begin(), items->end());
+}
+
+static void CheckItems(SSTableReader::Iterator *iter, const Items &expected, size_t begin) {
+    for (size_t i = begin; i < expected.size(); ++i) {
+        ASSERT_TRUE(iter->Valid()) << i;
+        EXPECT_EQ(expected[i].first, iter->key_piece().as_string()) << i;
+        EXPECT_EQ(expected[i].second, iter->value_piece().as_string()) << i;
+        iter->Next();
+    }
+    EXPECT_FALSE(iter->Valid());
+}
+
+TEST(MergedSSTableReader, MergeManyFiles) {
+    std::vector<std::string> paths;
+    Items expected;
+    BuildManyFiles(20, &paths, &expected);
+
+    MergedSSTableReader sstable;
+    ASSERT_TRUE(sstable.Open(paths, SSTableReader::ON_DISK, false));
+    toft::scoped_ptr<SSTableReader::Iterator> iter(sstable.NewIterator());
+    CheckItems(iter.get(), expected, 0);
+
+    // Seek to the middle.
+    size_t middle = expected.size() / 2;
+    iter.reset(sstable.Seek(expected[middle].first));
+    size_t first = std::lower_bound(expected.begin(), expected.end(),
+                                    std::make_pair(expected[middle].first, std::string())) -
+                   expected.begin();
+    CheckItems(iter.get(), expected, first);
+
+    // SeekKey on an existing iterator.
+    iter.reset(sstable.NewIterator());
+    iter->Next();
+    iter->SeekKey(expected[middle].first);
+    CheckItems(iter.get(), expected, first);
+    iter->SeekKey(expected[0].first);
+    CheckItems(iter.get(), expected, 0);
+}
+
+TEST(MergedSSTableReader, Scan) {
+    std::vector<std::string> paths;
+    Items expected;
+    BuildManyFiles(20, &paths, &expected);
+
+    ThreadPool pool(4);
+    SSTableReadOption option;
+    option.set_io_thread_pool(&pool);
+    MergedSSTableReader sstable;
+    ASSERT_TRUE(sstable.Open(paths, option, false));
+    toft::scoped_ptr<SSTableReader::Iterator> iter(sstable.NewScanIterator());
+    CheckItems(iter.get(), expected, 0);
+}
+
+TEST(MergedSSTableReader, MultiLookup) {
+    std::vector<std::string> paths;
+    Items items;
+    BuildManyFiles(20, &paths, &items);
+    MergedSSTableReader sstable;
+    ASSERT_TRUE(sstable.Open(paths, SSTableReader::ON_DISK, false));
+
+    std::vector<std::string> keys;
+    for (int i = 0; i < 500 * 20; i += 3)
+        keys.push_back(StringPrint("%09d", i));
+    keys.push_back("not_exist");
+    std::vector<std::string> values;
+    std::vector<bool> found;
+    int count = sstable.MultiLookup(keys, &values, &found);
+    ASSERT_EQ(keys.size(), values.size());
+    ASSERT_EQ(keys.size(), found.size());
+    int expected_count = 0;
+    for (size_t i = 0; i < keys.size(); ++i) {
+        std::string value;
+        bool exist = sstable.Lookup(keys[i], &value);
+        ASSERT_EQ(exist, found[i]) << keys[i];
+        if (exist) {
+            EXPECT_EQ(value, values[i]) << keys[i];
+            ++expected_count;
+        }
+    }
+    EXPECT_GT(expected_count, 0);
+    EXPECT_EQ(expected_count, count);
+}
+
+static void RecordProgress(std::vector<int> *progress, int opened, int total) {
+    EXPECT_EQ(20, total);
+    progress->push_back(opened);
+}
+
+TEST(MergedSSTableReader, OpenConcurrently) {
+    std::vector<std::string> paths;
+    Items expected;
+    BuildManyFiles(20, &paths, &expected);
+
+    ThreadPool pool(4);
+    std::vector<int> progress;
+    SSTableReadOption option;
+    option.set_open_thread_pool(&pool);
+    option.set_max_concurrent_opens(3);
+    option.set_open_progress_callback(
+        std::bind(RecordProgress, &progress, std::placeholders::_1, std::placeholders::_2));
+    MergedSSTableReader sstable;
+    ASSERT_TRUE(sstable.Open(paths, option, false));
+    ASSERT_EQ(20U, progress.size());
+    for (size_t i = 0; i < progress.size(); ++i)
+        EXPECT_EQ(static_cast<int>(i + 1), progress[i]);
+
+    // Tables are in the order of paths.
+    std::vector<std::string> opened_paths;
+    sstable.GetPaths(&opened_paths);
+    EXPECT_EQ(paths, opened_paths);
+    toft::scoped_ptr<SSTableReader::Iterator> iter(sstable.NewIterator());
+    CheckItems(iter.get(), expected, 0);
+}
+
+TEST(MergedSSTableReader, OpenConcurrentlyBadFiles) {
+    std::vector<std::string> paths;
+    Items expected;
+    BuildManyFiles(20, &paths, &expected);
+    std::vector<std::string> good_paths = paths;
+    paths.insert(paths.begin() + 5, "/tmp/test_merged_not_exist.sstable");
+    paths.push_back("/tmp/test_merged_not_exist.sstable");
+
+    ThreadPool pool(4);
+    SSTableReadOption option;
+    option.set_open_thread_pool(&pool);
+    {
+        MergedSSTableReader sstable;
+        EXPECT_FALSE(sstable.Open(paths, option, false));
+    }
+    MergedSSTableReader sstable;
+    ASSERT_TRUE(sstable.Open(paths, option, true));
+    std::vector<std::string> opened_paths;
+    sstable.GetPaths(&opened_paths);
+    EXPECT_EQ(good_paths, opened_paths);
+    EXPECT_EQ(static_cast<int>(expected.size()), sstable.EntryCount());
 }
 
 }  // namespace toft
@@ -3,9 +3,14 @@
 //
 // Author: Ye Shunping <yeshunping@gmail.com>
 
+#include "toft/base/functional.h"
 #include "toft/base/string/format.h"
+#include "toft/storage/sstable/block_cache.h"
+#include "toft/storage/sstable/reader/on_disk_sstable_reader.h"
 #include "toft/storage/sstable/sstable_reader.h"
 #include "toft/storage/sstable/sstable_writer.h"
+#include "toft/system/atomic/atomic.h"
+#include "toft/system/threading/thread_pool.h"
 
 #include "thirdparty/glog/logging.h"
 #include "thirdparty/gtest/gtest.h"
@@ -40,4 +45,326 @@ TEST(SSTableReader, MetaData) {
     EXPECT_EQ("2", sstable->GetMetaData(kShardID));
 }
 
+static const int kLookupTestNum = 20000;
+
+static const std::string LookupTestKey(int i) {
+    return StringPrint("key_%08d", i);
+}
+
+static void BuildLookupTestSSTable(const std::string &path, CompressType codec) {
+    SSTableWriteOption option;
+    option.set_path(path);
+    option.set_compress_type(codec);
+    SingleSSTableWriter builder(option);
+    for (int i = 0; i < kLookupTestNum; ++i)
+        builder.AddOrDie(LookupTestKey(i), StringPrint("value_%d", i));
+    ASSERT_TRUE(builder.Flush());
+}
+
+static void LookupRange(SSTableReader *sstable, int begin, int step,
+                        Atomic<int> *error_count) {
+    for (int i = begin; i < kLookupTestNum; i += step) {
+        std::string value;
+        if (!sstable->Lookup(LookupTestKey(i), &value) ||
+            value != StringPrint("value_%d", i)) {
+            ++*error_count;
+        }
+    }
+    std::string value;
+    if (sstable->Lookup("not_exist", &value))
+        ++*error_count;
+}
+
+static void ConcurrentLookup(const std::string &path, bool use_mmap) {
+    SSTableReadOption option;
+    option.set_read_mode(SSTableReader::ON_DISK);
+    option.set_use_mmap(use_mmap);
+    toft::scoped_ptr<SSTableReader> sstable(SSTableReader::Open(path, option));
+    ASSERT_TRUE(sstable.get() != NULL);
+
+    const int kThreadNum = 8;
+    ThreadPool pool(kThreadNum);
+    Atomic<int> error_count(0);
+    for (int i = 0; i < kThreadNum; ++i)
+        pool.AddTask(std::bind(LookupRange, sstable.get(), i, kThreadNum, &error_count));
+    pool.WaitForIdle();
+    EXPECT_EQ(0, error_count.Value());
+
+    int count = 0;
+    toft::scoped_ptr<SSTableReader::Iterator> iter(sstable->NewIterator());
+    for (; iter->Valid(); iter->Next()) {
+        EXPECT_EQ(LookupTestKey(count), iter->key());
+        ++count;
+    }
+    EXPECT_EQ(kLookupTestNum, count);
+}
+
+TEST(SSTableReader, ConcurrentLookup) {
+    std::string path = "/tmp/test_concurrent_lookup.sstable";
+    BuildLookupTestSSTable(path, CompressType_kUnCompress);
+    ConcurrentLookup(path, false);
+    BuildLookupTestSSTable(path, CompressType_kSnappy);
+    ConcurrentLookup(path, false);
+}
+
+TEST(SSTableReader, ConcurrentLookupWithMmap) {
+    std::string path = "/tmp/test_concurrent_lookup_mmap.sstable";
+    BuildLookupTestSSTable(path, CompressType_kUnCompress);
+    ConcurrentLookup(path, true);
+    BuildLookupTestSSTable(path, CompressType_kSnappy);
+    ConcurrentLookup(path, true);
+}
+
+static void BuildBloomFilterTestSSTable(const std::string &path, int bits_per_key) {
+    SSTableWriteOption option;
+    option.set_path(path);
+    option.set_block_size(1024);
+    option.set_bloom_filter_bits_per_key(bits_per_key);
+    SingleSSTableWriter builder(option);
+    for (int i = 0; i < kLookupTestNum; i += 2)
+        builder.AddOrDie(LookupTestKey(i), StringPrint("value_%d", i));
+    // Items with the same key cross several blocks.
+    for (int i = 0; i < 200; ++i)
+        builder.AddOrDie(LookupTestKey(kLookupTestNum / 2), StringPrint("dup_%d", i));
+    ASSERT_TRUE(builder.Flush());
+}
+
+static void CheckBloomFilterLookup(const std::string &path, bool filtered) {
+    BlockCache cache(1024, 0);
+    SSTableReadOption option;
+    option.set_block_cache(&cache);
+    toft::scoped_ptr<SSTableReader> sstable(SSTableReader::Open(path, option));
+    ASSERT_TRUE(sstable.get() != NULL);
+
+    std::string value;
+    for (int i = 0; i < kLookupTestNum; i += 2) {
+        ASSERT_TRUE(sstable->Lookup(LookupTestKey(i), &value)) << i;
+        if (i != kLookupTestNum / 2) {
+            EXPECT_EQ(StringPrint("value_%d", i), value);
+        }
+    }
+    EXPECT_TRUE(sstable->Lookup(LookupTestKey(kLookupTestNum / 2), &value));
+
+    CacheStats before;
+    cache.GetStats(&before);
+    for (int i = 1; i < kLookupTestNum; i += 2)
+        EXPECT_FALSE(sstable->Lookup(LookupTestKey(i), &value)) << i;
+    EXPECT_FALSE(sstable->Lookup("", &value));
+    EXPECT_FALSE(sstable->Lookup("zzz", &value));
+    CacheStats after;
+    cache.GetStats(&after);
+    uint64_t loads = after.hits + after.misses - before.hits - before.misses;
+    if (filtered) {
+        // Only false positives load data blocks.
+        EXPECT_LT(loads, kLookupTestNum / 2 / 20U);
+    } else {
+        EXPECT_GE(loads, kLookupTestNum / 2 + 2U);
+    }
+}
+
+TEST(SSTableReader, BloomFilter) {
+    // Opt in.
+    EXPECT_EQ(0, SSTableWriteOption().bloom_filter_bits_per_key());
+    std::string path = "/tmp/test_bloom_filter.sstable";
+    BuildBloomFilterTestSSTable(path, 10);
+    CheckBloomFilterLookup(path, true);
+    BuildBloomFilterTestSSTable(path, 0);
+    CheckBloomFilterLookup(path, false);
+}
+
+TEST(SSTableReader, InMemorySeek) {
+    SSTableWriteOption option;
+    std::string path = "/tmp/test_in_memory_seek.sstable";
+    option.set_path(path);
+    option.set_block_size(64);
+    SingleSSTableWriter builder(option);
+    // Even keys, and each key has two values.
+    for (int i = 0; i < 100; i += 2) {
+        builder.AddOrDie(StringPrint("key_%03d", i), StringPrint("value_%d_a", i));
+        builder.AddOrDie(StringPrint("key_%03d", i), StringPrint("value_%d_b", i));
+    }
+    ASSERT_TRUE(builder.Flush());
+
+    toft::scoped_ptr<SSTableReader> sstable(SSTableReader::Open(path, SSTableReader::IN_MEMORY));
+    ASSERT_TRUE(sstable.get());
+    EXPECT_EQ(100, sstable->EntryCount());
+    // Keys are 7 bytes, values are 9 or 10 bytes, plus the 16 bytes entry.
+    EXPECT_GE(sstable->MemoryUsage(), 100 * (7 + 9 + 16));
+    EXPECT_LE(sstable->MemoryUsage(), 100 * (7 + 10 + 16));
+
+    toft::scoped_ptr<SSTableReader::Iterator> iter(sstable->Seek("a"));
+    ASSERT_TRUE(iter->Valid());
+    EXPECT_EQ("key_000", iter->key());
+    EXPECT_EQ("value_0_a", iter->value());
+
+    // The first value of an existing key.
+    iter.reset(sstable->Seek("key_010"));
+    ASSERT_TRUE(iter->Valid());
+    EXPECT_EQ("value_10_a", iter->value());
+    iter->Next();
+    ASSERT_TRUE(iter->Valid());
+    EXPECT_EQ("key_010", iter->key());
+    EXPECT_EQ("value_10_b", iter->value());
+
+    // The next key if not found.
+    iter.reset(sstable->Seek("key_011"));
+    ASSERT_TRUE(iter->Valid());
+    EXPECT_EQ("key_012", iter->key());
+    EXPECT_EQ("value_12_a", iter->value());
+
+    iter.reset(sstable->Seek("key_098x"));
+    EXPECT_FALSE(iter->Valid());
+
+    std::string value;
+    EXPECT_TRUE(sstable->Lookup("key_098", &value));
+    EXPECT_EQ("value_98_a", value);
+    EXPECT_FALSE(sstable->Lookup("key_097", &value));
+    EXPECT_FALSE(sstable->Lookup("z", &value));
+
+    int count = 0;
+    for (iter.reset(sstable->NewIterator()); iter->Valid(); iter->Next())
+        ++count;
+    EXPECT_EQ(100, count);
+}
+
+static void CheckMultiLookup(const std::string &path, const SSTableReadOption &option) {
+    toft::scoped_ptr<SSTableReader> sstable(SSTableReader::Open(path, option));
+    ASSERT_TRUE(sstable.get());
+    std::vector<std::string> keys;
+    for (int i = 2 * kLookupTestNum - 1; i >= 0; i -= 7)
+        keys.push_back(LookupTestKey(i));
+    keys.push_back(LookupTestKey(10));
+    keys.push_back(LookupTestKey(10));
+    keys.push_back("");
+    keys.push_back("not_exist");
+    std::vector<std::string> values;
+    std::vector<bool> found;
+    int count = sstable->MultiLookup(keys, &values, &found);
+    int expected_count = 0;
+    for (size_t i = 0; i < keys.size(); ++i) {
+        std::string value;
+        bool exist = sstable->Lookup(keys[i], &value);
+        ASSERT_EQ(exist, found[i]) << keys[i];
+        if (exist) {
+            EXPECT_EQ(value, values[i]) << keys[i];
+            ++expected_count;
+        }
+    }
+    EXPECT_EQ(kLookupTestNum / 7 + 2, expected_count);
+    EXPECT_EQ(expected_count, count);
+}
+
+TEST(SSTableReader, MultiLookup) {
+    std::string path = "/tmp/test_multi_lookup.sstable";
+    BuildLookupTestSSTable(path, CompressType_kSnappy);
+    SSTableReadOption option;
+    CheckMultiLookup(path, option);
+    option.set_read_mode(SSTableReader::IN_MEMORY);
+    CheckMultiLookup(path, option);
+
+    ThreadPool pool(4);
+    BlockCache cache(64 * 1024 * 1024, 0);
+    option.set_read_mode(SSTableReader::ON_DISK);
+    option.set_io_thread_pool(&pool);
+    option.set_block_cache(&cache);
+    CheckMultiLookup(path, option);
+
+    // Each block is loaded once.
+    toft::scoped_ptr<SSTableReader> sstable(SSTableReader::Open(path, option));
+    std::vector<std::string> keys;
+    for (int i = 0; i < kLookupTestNum; ++i)
+        keys.push_back(LookupTestKey(i));
+    std::vector<std::string> values;
+    std::vector<bool> found;
+    CacheStats before;
+    cache.GetStats(&before);
+    EXPECT_EQ(kLookupTestNum, sstable->MultiLookup(keys, &values, &found));
+    CacheStats after;
+    cache.GetStats(&after);
+    OnDiskSSTableReader *on_disk = static_cast<OnDiskSSTableReader*>(sstable.get());
+    EXPECT_EQ(static_cast<uint64_t>(on_disk->GetBlockSize()), after.misses - before.misses);
+    EXPECT_EQ(0U, after.hits - before.hits);
+}
+
+// Items with the same key cross blocks.
+TEST(SSTableReader, MultiLookupDuplicatedKeys) {
+    SSTableWriteOption write_option;
+    std::string path = "/tmp/test_multi_lookup_duplicated.sstable";
+    write_option.set_path(path);
+    write_option.set_block_size(64);
+    SingleSSTableWriter builder(write_option);
+    for (int i = 0; i < 100; ++i) {
+        for (int j = 0; j < i % 10; ++j)
+            builder.AddOrDie(LookupTestKey(i), StringPrint("value_%d_%d", i, j));
+    }
+    ASSERT_TRUE(builder.Flush());
+
+    toft::scoped_ptr<SSTableReader> sstable(SSTableReader::Open(path, SSTableReader::ON_DISK));
+    std::vector<std::string> keys;
+    for (int i = 0; i < 100; ++i)
+        keys.push_back(LookupTestKey(i));
+    // Values of missed keys are cleared.
+    std::vector<std::string> values(100, "old");
+    std::vector<bool> found;
+    EXPECT_EQ(90, sstable->MultiLookup(keys, &values, &found));
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_EQ(i % 10 != 0, found[i]) << i;
+        if (found[i]) {
+            EXPECT_EQ(StringPrint("value_%d_0", i), values[i]);
+        } else {
+            EXPECT_EQ("", values[i]);
+        }
+    }
+}
+
+static void CheckScan(const std::string &path, ThreadPool *pool, int readahead_blocks) {
+    BlockCache cache(64 * 1024 * 1024, 0);
+    SSTableReadOption option;
+    option.set_block_cache(&cache);
+    option.set_io_thread_pool(pool);
+    option.set_scan_readahead_blocks(readahead_blocks);
+    toft::scoped_ptr<SSTableReader> sstable(SSTableReader::Open(path, option));
+    ASSERT_TRUE(sstable.get());
+
+    toft::scoped_ptr<SSTableReader::Iterator> iter(sstable->NewScanIterator());
+    for (int i = 0; i < kLookupTestNum; ++i) {
+        ASSERT_TRUE(iter->Valid()) << i;
+        EXPECT_EQ(LookupTestKey(i), iter->key()) << i;
+        EXPECT_EQ(StringPrint("value_%d", i), iter->value()) << i;
+        iter->Next();
+    }
+    EXPECT_FALSE(iter->Valid());
+
+    // Seek forward and backward.
+    iter.reset(sstable->SeekForScan(LookupTestKey(100)));
+    for (int i = 100; i < 200; ++i) {
+        ASSERT_TRUE(iter->Valid()) << i;
+        EXPECT_EQ(LookupTestKey(i), iter->key()) << i;
+        iter->Next();
+    }
+    iter->SeekKey(LookupTestKey(kLookupTestNum / 2) + "x");
+    ASSERT_TRUE(iter->Valid());
+    EXPECT_EQ(LookupTestKey(kLookupTestNum / 2 + 1), iter->key());
+    iter->SeekKey(LookupTestKey(5));
+    ASSERT_TRUE(iter->Valid());
+    EXPECT_EQ(LookupTestKey(5), iter->key());
+    iter->SeekKey("z");
+    EXPECT_FALSE(iter->Valid());
+
+    // Blocks are not put into the cache.
+    CacheStats stats;
+    cache.GetStats(&stats);
+    EXPECT_EQ(0U, stats.size);
+    EXPECT_EQ(0U, stats.hits + stats.misses);
+}
+
+TEST(SSTableReader, Scan) {
+    std::string path = "/tmp/test_scan.sstable";
+    BuildLookupTestSSTable(path, CompressType_kSnappy);
+    CheckScan(path, NULL, 0);
+    ThreadPool pool(4);
+    CheckScan(path, &pool, 1);
+    CheckScan(path, &pool, 8);
+}
+
 }  // namespace toft
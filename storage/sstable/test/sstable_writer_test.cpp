@@ -13,6 +13,7 @@
 #include "toft/storage/sstable/sstable_writer.h"
 #include "toft/storage/sstable/test/test_util.h"
 #include "toft/storage/sstable/types.h"
+#include "toft/system/threading/thread_pool.h"
 
 #include "thirdparty/glog/logging.h"
 #include "thirdparty/gtest/gtest.h"
@@ -218,6 +219,35 @@ TEST(SingleSSTableWriter, BuildLzoSingleFileInMem) {
     TestSSTableWriter(&builder, path, kTestNum, kMaxLength, SSTableReader::IN_MEMORY);
 }
 
+TEST(SingleSSTableWriter, BuildPrefixKeysFileOnDisk) {
+    SSTableWriteOption option;
+    std::string path = "/tmp/test_single_prefix_disk.sstable";
+    option.set_path(path);
+    option.set_block_size(1024);
+    option.set_key_restart_interval(16);
+    SingleSSTableWriter builder(option);
+    TestSSTableWriterSeek(&builder, path, kTestNum, kMaxLength, SSTableReader::ON_DISK);
+}
+
+TEST(SingleSSTableWriter, BuildPrefixKeysSnappyFileInMem) {
+    SSTableWriteOption option;
+    std::string path = "/tmp/test_single_prefix_mem.sstable";
+    option.set_path(path);
+    option.set_compress_type(CompressType_kSnappy);
+    option.set_key_restart_interval(4);
+    SingleSSTableWriter builder(option);
+    TestSSTableWriter(&builder, path, kTestNum, kMaxLength, SSTableReader::IN_MEMORY);
+}
+
+TEST(UnsortedSSTableWriter, BuildPrefixKeysFileOnDisk) {
+    SSTableWriteOption option;
+    std::string path = "/tmp/test_unsorted_prefix_disk.sstable";
+    option.set_path(path);
+    option.set_key_restart_interval(16);
+    UnsortedSSTableWriter builder(option);
+    TestSSTableWriter(&builder, path, kTestNum, kMaxLength, SSTableReader::ON_DISK);
+}
+
 TEST(UnsortedSSTableWriter, BuildLargeUnsortedFileOnDisk) {
     SSTableWriteOption option;
     std::string path = "/tmp/test_unsorted_large_disk.sstable";
@@ -298,6 +328,97 @@ TEST(CompositedSSTableWriter, BuildSnappySingleFile) {
     TestSSTableWriter(&builder, path, kTestNum, kMaxLength, SSTableReader::ON_DISK);
 }
 
+// Build the same sstable with and without compress thread pool, return
+// true if the two files are identical.
+template <typename Writer>
+bool BuildWithCompressThreadPool(const std::string &path, CompressType codec) {
+    SSTableWriteOption option;
+    option.set_block_size(256);
+    option.set_compress_type(codec);
+
+    option.set_path(path + ".serial");
+    Writer serial_builder(option);
+    ThreadPool pool(4);
+    option.set_path(path + ".pipelined");
+    option.set_compress_thread_pool(&pool);
+    option.set_max_pending_blocks(4);
+    Writer pipelined_builder(option);
+
+    for (int i = 0; i < kTestNum; ++i) {
+        std::string key = GenKey(i, kMaxLength);
+        std::string value = GenValue(i, kMaxLength);
+        serial_builder.AddOrDie(key, value);
+        pipelined_builder.AddOrDie(key, value);
+    }
+    serial_builder.AddMetaData("123", "456");
+    pipelined_builder.AddMetaData("123", "456");
+    EXPECT_TRUE(serial_builder.Flush());
+    EXPECT_TRUE(pipelined_builder.Flush());
+
+    std::string serial_content;
+    std::string pipelined_content;
+    EXPECT_TRUE(File::ReadAll(path + ".serial", &serial_content));
+    EXPECT_TRUE(File::ReadAll(path + ".pipelined", &pipelined_content));
+    EXPECT_FALSE(serial_content.empty());
+    return serial_content == pipelined_content;
+}
+
+TEST(SingleSSTableWriter, CompressThreadPool) {
+    EXPECT_TRUE(BuildWithCompressThreadPool<SingleSSTableWriter>(
+        "/tmp/test_single_pool", CompressType_kUnCompress));
+    EXPECT_TRUE(BuildWithCompressThreadPool<SingleSSTableWriter>(
+        "/tmp/test_single_pool_snappy", CompressType_kSnappy));
+    EXPECT_TRUE(BuildWithCompressThreadPool<SingleSSTableWriter>(
+        "/tmp/test_single_pool_lzo", CompressType_kLzo));
+
+    toft::scoped_ptr<SSTableReader> sstable(
+        SSTableReader::Open("/tmp/test_single_pool_snappy.pipelined", SSTableReader::ON_DISK));
+    ASSERT_TRUE(sstable.get());
+    toft::scoped_ptr<SSTableReader::Iterator> iter(sstable->NewIterator());
+    for (int i = 0; i < kTestNum; ++i) {
+        ASSERT_TRUE(iter->Valid()) << i;
+        EXPECT_EQ(GenKey(i, kMaxLength), iter->key());
+        EXPECT_EQ(GenValue(i, kMaxLength), iter->value());
+        EXPECT_EQ(GenKey(i, kMaxLength), iter->key_piece());
+        EXPECT_EQ(GenValue(i, kMaxLength), iter->value_piece());
+        iter->Next();
+    }
+    EXPECT_FALSE(iter->Valid());
+}
+
+TEST(SingleSSTableWriter, SortMemoryBudget) {
+    SSTableWriteOption option;
+    option.set_compress_type(CompressType_kSnappy);
+    option.set_path("/tmp/test_single_in_memory_sort.sstable");
+    SingleSSTableWriter in_memory_builder(option);
+    option.set_path("/tmp/test_single_external_sort.sstable");
+    option.set_sort_memory_budget(4096);
+    SingleSSTableWriter external_builder(option);
+    // Add in reverse order with duplicated keys.
+    for (int i = kTestNum - 1; i >= 0; --i) {
+        std::string key = GenKey(i / 2, kMaxLength);
+        std::string value = GenValue(i, kMaxLength);
+        in_memory_builder.AddOrDie(key, value);
+        external_builder.AddOrDie(key, value);
+    }
+    EXPECT_TRUE(in_memory_builder.Flush());
+    EXPECT_TRUE(external_builder.Flush());
+
+    std::string in_memory_content;
+    std::string external_content;
+    EXPECT_TRUE(File::ReadAll("/tmp/test_single_in_memory_sort.sstable", &in_memory_content));
+    EXPECT_TRUE(File::ReadAll("/tmp/test_single_external_sort.sstable", &external_content));
+    EXPECT_FALSE(in_memory_content.empty());
+    EXPECT_TRUE(in_memory_content == external_content);
+}
+
+TEST(UnsortedSSTableWriter, CompressThreadPool) {
+    EXPECT_TRUE(BuildWithCompressThreadPool<UnsortedSSTableWriter>(
+        "/tmp/test_unsorted_pool", CompressType_kUnCompress));
+    EXPECT_TRUE(BuildWithCompressThreadPool<UnsortedSSTableWriter>(
+        "/tmp/test_unsorted_pool_snappy", CompressType_kSnappy));
+}
+
 TEST(SSTableWriter, ReadStaticMeta) {
     std::string value;
     for (int i = 0; i < kTestNum; ++i) {
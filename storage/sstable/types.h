@@ -12,6 +12,8 @@
 
 namespace toft {
 
+class ThreadPool;
+
 static const std::string kShardID = "shard_id";
 static const std::string kShardTotalNum = "shard_total_num";
 static const std::string kShardPolicy = "shard_policy";
@@ -30,7 +32,12 @@ class SSTableWriteOption {
 public:
     SSTableWriteOption()
         : compress_type_(CompressType_kUnCompress),
-          block_size_(64 * 1024) {
+          block_size_(64 * 1024),
+          compress_thread_pool_(NULL),
+          max_pending_blocks_(16),
+          sort_memory_budget_(0),
+          bloom_filter_bits_per_key_(0),
+          key_restart_interval_(0) {
     }
 
     void set_path(const std::string &path) {
@@ -61,11 +68,68 @@ public:
         sharding_policy_ = policy;
     }
 
+    // If set, data blocks are compressed in the pool while later blocks are
+    // still being filled, the file content is the same as without it.
+    // The pool is not owned and must outlive the writer.
+    void set_compress_thread_pool(ThreadPool* pool) {
+        compress_thread_pool_ = pool;
+    }
+    ThreadPool* compress_thread_pool() const {
+        return compress_thread_pool_;
+    }
+
+    // Max number of blocks being compressed or waiting to be written, it
+    // bounds the memory used by the compress thread pool.
+    void set_max_pending_blocks(int max_pending_blocks) {
+        max_pending_blocks_ = max_pending_blocks;
+    }
+    int max_pending_blocks() const {
+        return max_pending_blocks_;
+    }
+
+    // Memory budget in bytes to sort items in SingleSSTableWriter, sorted
+    // items are spilled into temp files beyond it and merged in Flush.
+    // 0 means keep all items in memory.
+    void set_sort_memory_budget(int64_t bytes) {
+        sort_memory_budget_ = bytes;
+    }
+    int64_t sort_memory_budget() const {
+        return sort_memory_budget_;
+    }
+
+    // Bits of bloom filter for each key, readers check the filters before
+    // loading data blocks in Lookup. 10 bits gives about 1% false positive
+    // rate. 0 (the default) means no bloom filter, so the file layout is
+    // the same as before bloom filter is added.
+    void set_bloom_filter_bits_per_key(int bits) {
+        bloom_filter_bits_per_key_ = bits;
+    }
+    int bloom_filter_bits_per_key() const {
+        return bloom_filter_bits_per_key_;
+    }
+
+    // If positive, keys in data blocks are prefix compressed, and every
+    // interval keys there is a restart point which stores the whole key, so
+    // a block can be searched by binary search over restart points. 16 is
+    // good for most cases. Files written with it can't be read by readers
+    // before this option is added. 0 means store whole keys.
+    void set_key_restart_interval(int interval) {
+        key_restart_interval_ = interval;
+    }
+    int key_restart_interval() const {
+        return key_restart_interval_;
+    }
+
 private:
     int compress_type_;
     int64_t block_size_;
     std::string path_;
     std::string sharding_policy_;
+    ThreadPool* compress_thread_pool_;
+    int max_pending_blocks_;
+    int64_t sort_memory_budget_;
+    int bloom_filter_bits_per_key_;
+    int key_restart_interval_;
 };
 }  // namespace toft
 
@@ -8,6 +8,7 @@
 #include "toft/hash/fingerprint.h"
 #include "toft/storage/file/file.h"
 #include "toft/storage/path/path.h"
+#include "toft/storage/sstable/hfile/data_block.h"
 
 #include "thirdparty/gflags/gflags.h"
 #include "thirdparty/glog/logging.h"
@@ -35,6 +36,15 @@ std::string SSTableWriter::GetTempSSTablePath(const std::string &path) {
     return base_path + ".sstmp";
 }
 
+hfile::DataBlock *SSTableWriter::NewDataBlock() const {
+    CompressType codec = static_cast<CompressType>(option_.compress_type());
+    if (option_.key_restart_interval() <= 0)
+        return new hfile::DataBlock(codec);
+    hfile::DataBlock *block = new hfile::DataBlock(codec, hfile::DataBlock::kPrefixFormat);
+    block->set_restart_interval(option_.key_restart_interval());
+    return block;
+}
+
 bool SSTableWriter::MoveToRealPath(const std::string &path) {
     return File::Rename(GetTempSSTablePath(path), path);
 }
@@ -14,6 +14,7 @@
 namespace toft {
 namespace hfile {
 class ShardingPolicy;
+class BloomFilterBlock;
 class DataBlock;
 class DataIndex;
 } // namespace hfile
@@ -46,6 +47,10 @@ public:
     }
 
 protected:
+    // Create an empty data block by compress type and key restart interval
+    // in option.
+    hfile::DataBlock *NewDataBlock() const;
+
     SSTableWriteOption option_;
 };
 }  // namespace toft
@@ -0,0 +1,115 @@
+// Copyright (c) 2026, The Toft Authors.
+// All rights reserved.
+//
+// Compression tasks and ordered writing of BlockWritePipeline.
+
+#include "toft/storage/sstable/writer/block_write_pipeline.h"
+
+#include "toft/base/functional.h"
+#include "toft/compress/block/block_compression.h"
+#include "toft/storage/file/file.h"
+#include "toft/storage/sstable/hfile/data_block.h"
+#include "toft/storage/sstable/hfile/data_index.h"
+
+#include "thirdparty/glog/logging.h"
+
+namespace toft {
+
+BlockWritePipeline::BlockWritePipeline(const SSTableWriteOption &option, File *file,
+                                       hfile::DataIndex *index)
+                : codec_(static_cast<CompressType>(option.compress_type())),
+                  pool_(option.compress_thread_pool()),
+                  max_pending_blocks_(option.max_pending_blocks() > 0 ?
+                                      option.max_pending_blocks() : 1),
+                  file_(file),
+                  index_(index),
+                  failed_(false),
+                  block_count_(0),
+                  compressed_bytes_(0),
+                  uncompressed_bytes_(0) {
+}
+
+BlockWritePipeline::~BlockWritePipeline() {
+    // Running tasks are still using compressions.
+    for (size_t i = 0; i < pending_blocks_.size(); ++i)
+        pending_blocks_[i].encoded.Wait();
+    for (size_t i = 0; i < idle_compressions_.size(); ++i)
+        delete idle_compressions_[i];
+}
+
+bool BlockWritePipeline::AddBlock(hfile::DataBlock *block, const std::string &first_key) {
+    std::shared_ptr<std::string> buffer(new std::string);
+    block->SwapBuffer(buffer.get());
+
+    if (pool_ == NULL) {
+        WriteBlock(EncodeBlock(buffer), buffer->size(), first_key);
+        return !failed_;
+    }
+
+    PendingBlock pending;
+    pending.uncompressed_size = buffer->size();
+    pending.first_key = first_key;
+    pending.encoded = AsyncRun(pool_, std::function<std::string ()>(
+        std::bind(&BlockWritePipeline::EncodeBlock, this, buffer)));
+    pending_blocks_.push_back(pending);
+    WritePendingBlocks(max_pending_blocks_);
+    return !failed_;
+}
+
+bool BlockWritePipeline::Finish() {
+    WritePendingBlocks(0);
+    return !failed_;
+}
+
+std::string BlockWritePipeline::EncodeBlock(std::shared_ptr<std::string> buffer) {
+    BlockCompression *compression = AcquireCompression();
+    std::string encoded = hfile::DataBlock::EncodeBuffer(compression, *buffer);
+    ReleaseCompression(compression);
+    return encoded;
+}
+
+void BlockWritePipeline::WritePendingBlocks(size_t max_pending) {
+    while (!pending_blocks_.empty()) {
+        PendingBlock &front = pending_blocks_.front();
+        if (pending_blocks_.size() <= max_pending && !front.encoded.IsReady())
+            break;
+        WriteBlock(front.encoded.Get(), front.uncompressed_size, front.first_key);
+        pending_blocks_.pop_front();
+    }
+}
+
+void BlockWritePipeline::WriteBlock(const std::string &encoded, int64_t uncompressed_size,
+                                    const std::string &first_key) {
+    if (!encoded.empty()) {
+        int64_t size = file_->Write(encoded.data(), encoded.size());
+        if (size != static_cast<int64_t>(encoded.size())) {
+            LOG(ERROR)<< "fail to write block, size: " << encoded.size();
+            failed_ = true;
+        }
+    }
+    index_->AddDataBlockInfo(encoded.size(), uncompressed_size, first_key);
+    compressed_bytes_ += encoded.size();
+    uncompressed_bytes_ += uncompressed_size;
+    ++block_count_;
+}
+
+BlockCompression *BlockWritePipeline::AcquireCompression() {
+    {
+        MutexLocker locker(&mutex_);
+        if (!idle_compressions_.empty()) {
+            BlockCompression *compression = idle_compressions_.back();
+            idle_compressions_.pop_back();
+            return compression;
+        }
+    }
+    return hfile::DataBlock::CreateCompression(codec_);
+}
+
+void BlockWritePipeline::ReleaseCompression(BlockCompression *compression) {
+    if (compression == NULL)
+        return;
+    MutexLocker locker(&mutex_);
+    idle_compressions_.push_back(compression);
+}
+
+}  // namespace toft
@@ -0,0 +1,102 @@
+// Copyright (c) 2026, The Toft Authors.
+// All rights reserved.
+//
+// Compress data blocks on a thread pool while writing them in order.
+
+#ifndef TOFT_STORAGE_SSTABLE_WRITER_BLOCK_WRITE_PIPELINE_H
+#define TOFT_STORAGE_SSTABLE_WRITER_BLOCK_WRITE_PIPELINE_H
+
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "toft/base/shared_ptr.h"
+#include "toft/base/uncopyable.h"
+#include "toft/storage/sstable/types.h"
+#include "toft/system/threading/future.h"
+#include "toft/system/threading/mutex.h"
+
+namespace toft {
+class BlockCompression;
+class File;
+
+namespace hfile {
+class DataBlock;
+class DataIndex;
+} // namespace hfile
+
+// Write data blocks of a sstable to file in order and update the data index.
+//
+// If a compress thread pool is set in option, blocks are compressed in the
+// pool while the caller is filling later blocks, and the caller thread writes
+// the compressed blocks in their adding order, so the file content is exactly
+// the same as compressing them one by one.
+class BlockWritePipeline {
+    TOFT_DECLARE_UNCOPYABLE(BlockWritePipeline);
+
+public:
+    // file and index are not owned.
+    BlockWritePipeline(const SSTableWriteOption &option, File *file,
+                       hfile::DataIndex *index);
+    ~BlockWritePipeline();
+
+    // Take over items of the block and clear it, first_key is the first key
+    // in the block. Return false if any block failed to be written.
+    bool AddBlock(hfile::DataBlock *block, const std::string &first_key);
+
+    // Wait until all added blocks are written.
+    // Return false if any block failed to be written.
+    bool Finish();
+
+    int block_count() const {
+        return block_count_;
+    }
+    // Sum of compressed block size, it's also the offset of the next block.
+    int64_t compressed_bytes() const {
+        return compressed_bytes_;
+    }
+    int64_t uncompressed_bytes() const {
+        return uncompressed_bytes_;
+    }
+
+private:
+    struct PendingBlock {
+        Future<std::string> encoded;
+        int64_t uncompressed_size;
+        std::string first_key;
+    };
+
+    // Run in the compress thread pool.
+    std::string EncodeBlock(std::shared_ptr<std::string> buffer);
+
+    // Write pending blocks in order, wait for them if they are not encoded
+    // yet and there are more than max_pending pending blocks.
+    void WritePendingBlocks(size_t max_pending);
+
+    void WriteBlock(const std::string &encoded, int64_t uncompressed_size,
+                    const std::string &first_key);
+
+    BlockCompression *AcquireCompression();
+    void ReleaseCompression(BlockCompression *compression);
+
+    CompressType codec_;
+    ThreadPool *pool_;
+    size_t max_pending_blocks_;
+    File *file_;
+    hfile::DataIndex *index_;
+    std::deque<PendingBlock> pending_blocks_;
+
+    // BlockCompression is not thread safe, so each encoding thread takes an
+    // idle one.
+    Mutex mutex_;
+    std::vector<BlockCompression*> idle_compressions_;
+
+    bool failed_;
+    int block_count_;
+    int64_t compressed_bytes_;
+    int64_t uncompressed_bytes_;
+};
+
+}  // namespace toft
+
+#endif  // TOFT_STORAGE_SSTABLE_WRITER_BLOCK_WRITE_PIPELINE_H
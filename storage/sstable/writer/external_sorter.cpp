@@ -0,0 +1,491 @@
+// Copyright (c) 2026, The Toft Authors.
+// All rights reserved.
+//
+// Run spilling and k-way merging of ExternalSorter.
+
+#include "toft/storage/sstable/writer/external_sorter.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+#include "toft/base/scoped_ptr.h"
+#include "toft/base/string/number.h"
+#include "toft/storage/file/file.h"
+#include "toft/storage/sstable/hfile/coding.h"
+
+#include "thirdparty/glog/logging.h"
+
+namespace toft {
+
+namespace {
+
+// Bounds of the io buffer of each run file.
+const size_t kMinRunBufferSize = 4 * 1024;
+const size_t kMaxRunBufferSize = 1024 * 1024;
+
+// Max number of run files opened at once when merging.
+const size_t kMaxMergeFanIn = 64;
+
+// Each item in run file is: key size, value size, key, value.
+const size_t kItemHeaderSize = 2 * sizeof(uint32_t);
+
+size_t MergeFanIn(int64_t memory_budget) {
+    if (memory_budget <= 0)
+        return kMaxMergeFanIn;
+    int64_t fan_in = memory_budget / static_cast<int64_t>(kMinRunBufferSize);
+    return std::max<int64_t>(2, std::min<int64_t>(fan_in, kMaxMergeFanIn));
+}
+
+size_t RunBufferSize(int64_t memory_budget, size_t fan_in) {
+    if (memory_budget <= 0)
+        return kMaxRunBufferSize;
+    int64_t size = memory_budget / static_cast<int64_t>(fan_in);
+    return std::max<int64_t>(kMinRunBufferSize, std::min<int64_t>(size, kMaxRunBufferSize));
+}
+
+}  // namespace
+
+class ExternalSorter::EntryLess {
+public:
+    explicit EntryLess(const char *buffer) : buffer_(buffer) {}
+
+    bool operator()(const SortEntry &a, const SortEntry &b) const {
+        if (a.key_prefix != b.key_prefix)
+            return a.key_prefix < b.key_prefix;
+        int result;
+        if (a.key_size <= sizeof(a.key_prefix) && b.key_size <= sizeof(b.key_prefix)) {
+            // The whole keys are in prefix, but the shorter one is padded by 0.
+            result = static_cast<int>(a.key_size) - static_cast<int>(b.key_size);
+        } else {
+            result = StringPiece(buffer_ + a.offset, a.key_size).compare(
+                StringPiece(buffer_ + b.offset, b.key_size));
+        }
+        if (result != 0)
+            return result < 0;
+        // Items are appended, so offset is also the adding order.
+        return a.offset < b.offset;
+    }
+
+private:
+    const char *buffer_;
+};
+
+// A stream of sorted items.
+class ExternalSorter::ItemSource {
+public:
+    explicit ItemSource(int index) : index_(index) {}
+    virtual ~ItemSource() {}
+
+    // Move to the next item, return false if no more item or error.
+    virtual bool Next() = 0;
+    virtual bool failed() const {
+        return false;
+    }
+
+    int index() const {
+        return index_;
+    }
+    const StringPiece &key() const {
+        return key_;
+    }
+    const StringPiece &value() const {
+        return value_;
+    }
+
+protected:
+    int index_;  // The older source has less index
+    StringPiece key_;
+    StringPiece value_;
+};
+
+class ExternalSorter::BufferSource : public ItemSource {
+public:
+    BufferSource(int index, const std::string &buffer, const std::vector<SortEntry> &entries)
+        : ItemSource(index), buffer_(buffer), entries_(entries), position_(0) {}
+
+    virtual bool Next() {
+        if (position_ >= entries_.size())
+            return false;
+        const SortEntry &entry = entries_[position_++];
+        key_.set(buffer_.data() + entry.offset, entry.key_size);
+        value_.set(buffer_.data() + entry.offset + entry.key_size, entry.value_size);
+        return true;
+    }
+
+private:
+    const std::string &buffer_;
+    const std::vector<SortEntry> &entries_;
+    size_t position_;
+};
+
+class ExternalSorter::RunSource : public ItemSource {
+public:
+    RunSource(int index, const std::string &path, size_t buffer_size)
+        : ItemSource(index), path_(path), file_(File::Open(path, "r")),
+          begin_(0), end_(0), eof_(false), failed_(false) {
+        if (file_.get() == NULL) {
+            LOG(ERROR) << "failed to open run file: " << path;
+            failed_ = true;
+        }
+        buffer_.resize(buffer_size);
+    }
+
+    virtual bool Next() {
+        if (failed_)
+            return false;
+        if (!Fill(kItemHeaderSize))
+            return false;
+        const char *header = buffer_.data() + begin_;
+        size_t key_size = hfile::DecodeFixed32(header);
+        size_t value_size = hfile::DecodeFixed32(header + sizeof(uint32_t));
+        size_t item_size = kItemHeaderSize + key_size + value_size;
+        if (!Fill(item_size)) {
+            if (!failed_) {
+                LOG(ERROR) << "incomplete run file: " << path_;
+                failed_ = true;
+            }
+            return false;
+        }
+        const char *item = buffer_.data() + begin_ + kItemHeaderSize;
+        key_.set(item, key_size);
+        value_.set(item + key_size, value_size);
+        begin_ += item_size;
+        return true;
+    }
+
+    virtual bool failed() const {
+        return failed_;
+    }
+
+private:
+    // Make sure at least size bytes are buffered, return false if eof or
+    // error.
+    bool Fill(size_t size) {
+        if (end_ - begin_ >= size)
+            return true;
+        // Previous item is no longer used, move the remaining bytes to front.
+        memmove(&buffer_[0], buffer_.data() + begin_, end_ - begin_);
+        end_ -= begin_;
+        begin_ = 0;
+        if (buffer_.size() < size)
+            buffer_.resize(size);
+        while (end_ < size && !eof_) {
+            int64_t n = file_->Read(&buffer_[end_], buffer_.size() - end_);
+            if (n < 0) {
+                LOG(ERROR) << "failed to read run file: " << path_;
+                failed_ = true;
+                return false;
+            }
+            if (n == 0)
+                eof_ = true;
+            end_ += n;
+        }
+        return end_ >= size;
+    }
+
+    std::string path_;
+    toft::scoped_ptr<File> file_;
+    std::string buffer_;
+    size_t begin_;
+    size_t end_;
+    bool eof_;
+    bool failed_;
+};
+
+class ExternalSorter::RunWriter {
+public:
+    RunWriter(const std::string &path, size_t buffer_size)
+        : path_(path), file_(File::Open(path, "w")), buffer_size_(buffer_size) {
+        if (file_.get() == NULL)
+            LOG(ERROR) << "failed to open run file: " << path;
+        output_.reserve(buffer_size);
+    }
+
+    bool is_open() const {
+        return file_.get() != NULL;
+    }
+
+    bool Write(const StringPiece &key, const StringPiece &value) {
+        hfile::PutFixed32(&output_, key.size());
+        hfile::PutFixed32(&output_, value.size());
+        output_.append(key.data(), key.size());
+        output_.append(value.data(), value.size());
+        if (output_.size() >= buffer_size_)
+            return Flush();
+        return true;
+    }
+
+    bool Close() {
+        if (!Flush())
+            return false;
+        if (!file_->Close()) {
+            LOG(ERROR) << "failed to close run file: " << path_;
+            return false;
+        }
+        return true;
+    }
+
+private:
+    bool Flush() {
+        if (file_->Write(output_.data(), output_.size()) !=
+            static_cast<int64_t>(output_.size())) {
+            LOG(ERROR) << "failed to write run file: " << path_;
+            return false;
+        }
+        output_.clear();
+        return true;
+    }
+
+    std::string path_;
+    toft::scoped_ptr<File> file_;
+    size_t buffer_size_;
+    std::string output_;
+};
+
+// For min heap of sources by std heap algorithms.
+class ExternalSorter::SourceGreater {
+public:
+    bool operator()(const ItemSource *a, const ItemSource *b) const {
+        int result = a->key().compare(b->key());
+        if (result != 0)
+            return result > 0;
+        return a->index() > b->index();
+    }
+};
+
+// Merge sources by a min heap.
+class ExternalSorter::Merger {
+public:
+    Merger() : current_(NULL), failed_(false) {}
+    ~Merger() {
+        for (size_t i = 0; i < sources_.size(); ++i)
+            delete sources_[i];
+    }
+
+    // Take the ownership of source.
+    void AddSource(ItemSource *source) {
+        sources_.push_back(source);
+    }
+
+    // Prepare for iteration after all sources are added.
+    bool Start() {
+        for (size_t i = 0; i < sources_.size(); ++i) {
+            if (sources_[i]->Next()) {
+                heap_.push_back(sources_[i]);
+            } else if (sources_[i]->failed()) {
+                failed_ = true;
+                return false;
+            }
+        }
+        std::make_heap(heap_.begin(), heap_.end(), SourceGreater());
+        return true;
+    }
+
+    bool Next(StringPiece *key, StringPiece *value) {
+        if (current_ != NULL) {
+            // The item of current source is consumed, put it back with its
+            // next item.
+            if (current_->Next()) {
+                heap_.push_back(current_);
+                std::push_heap(heap_.begin(), heap_.end(), SourceGreater());
+            } else if (current_->failed()) {
+                failed_ = true;
+            }
+            current_ = NULL;
+        }
+        if (failed_ || heap_.empty())
+            return false;
+
+        std::pop_heap(heap_.begin(), heap_.end(), SourceGreater());
+        current_ = heap_.back();
+        heap_.pop_back();
+        *key = current_->key();
+        *value = current_->value();
+        return true;
+    }
+
+    bool failed() const {
+        return failed_;
+    }
+
+private:
+    std::vector<ItemSource*> sources_;
+    std::vector<ItemSource*> heap_;
+    ItemSource *current_;
+    bool failed_;
+};
+
+ExternalSorter::ExternalSorter(int64_t memory_budget, const std::string &run_path_prefix)
+                : memory_budget_(memory_budget),
+                  run_path_prefix_(run_path_prefix),
+                  merge_fan_in_(MergeFanIn(memory_budget)),
+                  run_buffer_size_(RunBufferSize(memory_budget, merge_fan_in_)),
+                  next_run_index_(0),
+                  item_count_(0),
+                  sorted_(false),
+                  failed_(false) {
+}
+
+ExternalSorter::~ExternalSorter() {
+    // Close run files before deleting them.
+    merger_.reset();
+    for (size_t i = 0; i < run_paths_.size(); ++i)
+        DeleteRunFile(run_paths_[i]);
+}
+
+void ExternalSorter::DeleteRunFile(const std::string &path) {
+    if (!File::Delete(path))
+        LOG(ERROR) << "delete file failed: " << path;
+}
+
+std::string ExternalSorter::NewRunPath() {
+    return run_path_prefix_ + ".run" + NumberToString(next_run_index_++);
+}
+
+uint64_t ExternalSorter::KeyPrefix(const StringPiece &key) {
+    uint64_t prefix = 0;
+    size_t size = std::min(key.size(), sizeof(prefix));
+    for (size_t i = 0; i < size; ++i)
+        prefix |= static_cast<uint64_t>(static_cast<unsigned char>(key[i])) << (56 - 8 * i);
+    return prefix;
+}
+
+bool ExternalSorter::Add(const StringPiece &key, const StringPiece &value) {
+    CHECK(!sorted_) << "can't add after sorted";
+    if (failed_)
+        return false;
+    SortEntry entry;
+    entry.key_prefix = KeyPrefix(key);
+    entry.offset = buffer_.size();
+    entry.key_size = key.size();
+    entry.value_size = value.size();
+    entries_.push_back(entry);
+    buffer_.append(key.data(), key.size());
+    buffer_.append(value.data(), value.size());
+    ++item_count_;
+
+    if (memory_budget_ > 0 && MemoryUsage() >= memory_budget_)
+        return SpillBuffer();
+    return true;
+}
+
+void ExternalSorter::SortBuffer() {
+    std::sort(entries_.begin(), entries_.end(), EntryLess(buffer_.data()));
+}
+
+bool ExternalSorter::SpillBuffer() {
+    SortBuffer();
+    std::string path = NewRunPath();
+    RunWriter writer(path, run_buffer_size_);
+    if (!writer.is_open()) {
+        failed_ = true;
+        return false;
+    }
+    run_paths_.push_back(path);
+
+    for (size_t i = 0; i < entries_.size(); ++i) {
+        const SortEntry &entry = entries_[i];
+        const char *item = buffer_.data() + entry.offset;
+        if (!writer.Write(StringPiece(item, entry.key_size),
+                          StringPiece(item + entry.key_size, entry.value_size))) {
+            failed_ = true;
+            return false;
+        }
+    }
+    if (!writer.Close()) {
+        failed_ = true;
+        return false;
+    }
+    buffer_.clear();
+    entries_.clear();
+    return true;
+}
+
+bool ExternalSorter::MergeRuns() {
+    std::vector<std::string> paths;
+    paths.swap(run_paths_);
+    // Groups are consecutive and keep their order, so merged runs are still
+    // ordered from old to new.
+    for (size_t begin = 0; begin < paths.size(); begin += merge_fan_in_) {
+        size_t end = std::min(begin + merge_fan_in_, paths.size());
+        if (!failed_ && end - begin > 1 && MergeRunGroup(paths, begin, end)) {
+            for (size_t i = begin; i < end; ++i)
+                DeleteRunFile(paths[i]);
+        } else {
+            run_paths_.insert(run_paths_.end(), paths.begin() + begin, paths.begin() + end);
+        }
+    }
+    return !failed_;
+}
+
+bool ExternalSorter::MergeRunGroup(const std::vector<std::string> &paths,
+                                   size_t begin, size_t end) {
+    std::string path = NewRunPath();
+    RunWriter writer(path, run_buffer_size_);
+    if (!writer.is_open()) {
+        failed_ = true;
+        return false;
+    }
+    run_paths_.push_back(path);
+
+    Merger merger;
+    for (size_t i = begin; i < end; ++i)
+        merger.AddSource(new RunSource(i - begin, paths[i], run_buffer_size_));
+    bool ok = merger.Start();
+    StringPiece key;
+    StringPiece value;
+    while (ok && merger.Next(&key, &value))
+        ok = writer.Write(key, value);
+    if (!ok || merger.failed() || !writer.Close()) {
+        failed_ = true;
+        return false;
+    }
+    return true;
+}
+
+bool ExternalSorter::Sort() {
+    CHECK(!sorted_) << "do not sort twice!";
+    sorted_ = true;
+    if (failed_)
+        return false;
+    SortBuffer();
+
+    if (!run_paths_.empty() && run_paths_.size() + 1 > merge_fan_in_) {
+        // Too many sources to merge at once, make the buffer a run too, and
+        // release its memory for merging.
+        if (!entries_.empty() && !SpillBuffer())
+            return false;
+        std::string().swap(buffer_);
+        std::vector<SortEntry>().swap(entries_);
+        while (run_paths_.size() > merge_fan_in_) {
+            if (!MergeRuns())
+                return false;
+        }
+    }
+
+    merger_.reset(new Merger());
+    // Runs are older than the buffer.
+    for (size_t i = 0; i < run_paths_.size(); ++i)
+        merger_->AddSource(new RunSource(i, run_paths_[i], run_buffer_size_));
+    merger_->AddSource(new BufferSource(run_paths_.size(), buffer_, entries_));
+    if (!merger_->Start()) {
+        failed_ = true;
+        return false;
+    }
+    return true;
+}
+
+bool ExternalSorter::GetNext(StringPiece *key, StringPiece *value) {
+    CHECK(sorted_) << "call Sort first";
+    if (failed_)
+        return false;
+    if (!merger_->Next(key, value)) {
+        if (merger_->failed())
+            failed_ = true;
+        return false;
+    }
+    return true;
+}
+
+}  // namespace toft
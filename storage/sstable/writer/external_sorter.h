@@ -0,0 +1,128 @@
+// Copyright (c) 2026, The Toft Authors.
+// All rights reserved.
+//
+// Sort items larger than memory by spilling sorted runs to files.
+
+#ifndef TOFT_STORAGE_SSTABLE_WRITER_EXTERNAL_SORTER_H
+#define TOFT_STORAGE_SSTABLE_WRITER_EXTERNAL_SORTER_H
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "toft/base/scoped_ptr.h"
+#include "toft/base/string/string_piece.h"
+#include "toft/base/uncopyable.h"
+
+namespace toft {
+
+// Sort key/value pairs by key, items with the same key keep their adding
+// order, so it works like std::stable_sort.
+//
+// Items are appended into one flat buffer, and sorted by an array of small
+// fixed size entries which hold the first 8 bytes of key and the offset of
+// item, so most comparisons don't touch the buffer.
+//
+// If memory_budget is not 0 and the buffer grows beyond it, sorted items are
+// spilled into a run file, and all runs are merged when iterating, so the
+// number of items is limited by disk instead of memory.
+//
+// At most a fixed number of runs are merged at once, each with a read buffer
+// of memory_budget / fan-in bytes, so merging needs a bounded number of files
+// and about memory_budget of extra memory. If there are more runs, groups of
+// them are merged into larger runs first.
+//
+// Usage:
+//   ExternalSorter sorter(64 * 1024 * 1024, "/tmp/sort");
+//   sorter.Add("b", "1");
+//   sorter.Add("a", "2");
+//   CHECK(sorter.Sort());
+//   StringPiece key, value;
+//   while (sorter.GetNext(&key, &value)) {
+//     ...
+//   }
+//   CHECK(!sorter.failed());
+class ExternalSorter {
+    TOFT_DECLARE_UNCOPYABLE(ExternalSorter);
+
+public:
+    // Run files are named run_path_prefix + ".run" + index, and are deleted
+    // in destructor. memory_budget is in bytes, 0 means never spill.
+    ExternalSorter(int64_t memory_budget, const std::string &run_path_prefix);
+    ~ExternalSorter();
+
+    // Return false if failed to spill.
+    bool Add(const StringPiece &key, const StringPiece &value);
+
+    // Finish adding and prepare for iteration.
+    bool Sort();
+
+    // Get the next item in order, return false if no more item or error.
+    // key and value are valid until the next call.
+    bool GetNext(StringPiece *key, StringPiece *value);
+
+    // Return true if any error occurred.
+    bool failed() const {
+        return failed_;
+    }
+
+    int64_t item_count() const {
+        return item_count_;
+    }
+    // Number of run files on disk.
+    int run_count() const {
+        return static_cast<int>(run_paths_.size());
+    }
+
+    // Memory used by the in memory buffer.
+    int64_t MemoryUsage() const {
+        return buffer_.size() + entries_.size() * sizeof(SortEntry);
+    }
+
+private:
+    struct SortEntry {
+        uint64_t key_prefix;  // First 8 bytes of key, in big endian
+        uint64_t offset;      // Offset of the item in buffer_
+        uint32_t key_size;
+        uint32_t value_size;
+    };
+    class EntryLess;
+    class ItemSource;
+    class BufferSource;
+    class RunSource;
+    class RunWriter;
+    class SourceGreater;
+    class Merger;
+
+    static uint64_t KeyPrefix(const StringPiece &key);
+    static void DeleteRunFile(const std::string &path);
+
+    std::string NewRunPath();
+    void SortBuffer();
+    bool SpillBuffer();
+
+    // Merge every group of merge_fan_in_ runs into one run.
+    bool MergeRuns();
+    bool MergeRunGroup(const std::vector<std::string> &paths, size_t begin, size_t end);
+
+private:
+    const int64_t memory_budget_;
+    const std::string run_path_prefix_;
+    const size_t merge_fan_in_;     // Max number of runs merged at once
+    const size_t run_buffer_size_;  // Size of the io buffer of each run file
+    std::string buffer_;
+    std::vector<SortEntry> entries_;
+    std::vector<std::string> run_paths_;
+    int next_run_index_;
+
+    toft::scoped_ptr<Merger> merger_;
+
+    int64_t item_count_;
+    bool sorted_;
+    bool failed_;
+};
+
+}  // namespace toft
+
+#endif  // TOFT_STORAGE_SSTABLE_WRITER_EXTERNAL_SORTER_H
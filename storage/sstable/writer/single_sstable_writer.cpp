@@ -9,6 +9,8 @@
 
 #include "toft/storage/file/file.h"
 #include "toft/storage/sstable/sstable.h"
+#include "toft/storage/sstable/writer/block_write_pipeline.h"
+#include "toft/storage/sstable/writer/external_sorter.h"
 
 namespace toft {
 
@@ -22,93 +24,95 @@ SingleSSTableWriter::SingleSSTableWriter(const SSTableWriteOption &option)
                   value_length_(0),
                   file_info_offset_(0),
                   flushed_(false) {
-    block_.reset(new hfile::DataBlock(static_cast<CompressType>(option.compress_type())));
+    block_.reset(NewDataBlock());
     index_.reset(new hfile::DataIndex);
+    if (option_.bloom_filter_bits_per_key() > 0)
+        bloom_filter_.reset(new hfile::BloomFilterBlock(option_.bloom_filter_bits_per_key()));
     CHECK(!option_.path().empty());
+    sorter_.reset(new ExternalSorter(option_.sort_memory_budget(),
+                                     GetTempSSTablePath(option_.path())));
 }
 
 SingleSSTableWriter::~SingleSSTableWriter() {
 }
 
 bool SingleSSTableWriter::Add(const std::string &key, const std::string &value) {
-    d_data_.push_back(make_pair(key, value));
-    return true;
+    return sorter_->Add(key, value);
 }
 
 void SingleSSTableWriter::AddMetaData(const std::string &key, const std::string &value) {
     file_info_meta_.insert(make_pair(key, value));
 }
 
-bool CompairString(std::deque<std::pair<std::string, std::string> >::iterator a,
-                   std::deque<std::pair<std::string, std::string> >::iterator b) {
-    return a->first < b->first;
-}
-
 bool SingleSSTableWriter::Flush() {
     CHECK(!flushed_) << "do not flush twice!";
     flushed_ = true;
-    data_index_.reserve(d_data_.size());
-    std::deque<std::pair<std::string, std::string> >::iterator it_d_data = d_data_.begin();
-    for (; it_d_data != d_data_.end(); it_d_data++) {
-        data_index_.push_back(it_d_data);
-    }
-    stable_sort(data_index_.begin(), data_index_.end(), CompairString);
 
     hfile::FileTrailer trailer;
     hfile::FileInfo fileInfo;
     std::map<std::string, std::string>::iterator it_fi_meta = file_info_meta_.begin();
-    std::vector<std::deque<std::pair<std::string, std::string> >::iterator>::iterator it_d_index =
-                    data_index_.begin();
+    StringPiece key;
+    StringPiece value;
 
-    if (data_index_.empty()) {
+    if (sorter_->item_count() == 0) {
         LOG(WARNING)<< "SingleSSTableWriter flush with no data, just ignore.";
         goto FAILED;
     }
+    if (!sorter_->Sort()) {
+        LOG(ERROR)<< "sort error.";
+        goto FAILED;
+    }
 
     file_base_.reset(File::Open(GetTempSSTablePath(option_.path()), "w"));
     CHECK(file_base_.get()) << "open file error: "
                             << GetTempSSTablePath(option_.path());
-    first_key_ = data_index_.front()->first;
-    last_key_ = data_index_.back()->first;
+    pipeline_.reset(new BlockWritePipeline(option_, file_base_.get(), index_.get()));
 
-    for (; it_d_index != data_index_.end(); it_d_index++) {
+    // Items are merged from sorted runs if spilled.
+    while (sorter_->GetNext(&key, &value)) {
+        if (entry_count_ == 0)
+            first_key_.assign(key.data(), key.size());
         size_t block_size = block_->GetUncompressedBufferSize();
         // write the block to disk
         if (block_size >= option_.block_size()) {
-            if (!block_->WriteToFile(file_base_.get())) {
+            if (!pipeline_->AddBlock(block_.get(), first_key_)) {
                 LOG(ERROR)<< "fwrite error.";
                 goto FAILED;
             }
-            index_->AddDataBlockInfo(block_->GetCompressedBufferSize(),
-                            block_->GetUncompressedBufferSize(), first_key_);
-            total_bytes_ += block_size;
-            first_key_ = (*it_d_index)->first;
-            index_offset_ += block_->GetCompressedBufferSize();
-            block_->ClearItems();
-            ++index_count_;
+            if (bloom_filter_.get())
+                bloom_filter_->FinishDataBlock();
+            first_key_.assign(key.data(), key.size());
         }
-        key_length_ += (*it_d_index)->first.size();
-        value_length_ += (*it_d_index)->second.size();
-        block_->AddItem((*it_d_index)->first, (*it_d_index)->second);
+        key_length_ += key.size();
+        value_length_ += value.size();
+        block_->AddItem(key, value);
+        if (bloom_filter_.get())
+            bloom_filter_->AddKey(key);
+        last_key_.assign(key.data(), key.size());
         ++entry_count_;
     }
+    if (sorter_->failed()) {
+        LOG(ERROR)<< "fail to read sorted items.";
+        goto FAILED;
+    }
 
     // add file info meta
     for (; it_fi_meta != file_info_meta_.end(); ++it_fi_meta) {
         fileInfo.AddItem(it_fi_meta->first, it_fi_meta->second);
     }
     // write the last block
-    if (!block_->WriteToFile(file_base_.get())) {
+    if (!pipeline_->AddBlock(block_.get(), first_key_) || !pipeline_->Finish()) {
         LOG(ERROR)<< "fwrite error.";
         goto FAILED;
     }
-    index_->AddDataBlockInfo(block_->GetCompressedBufferSize(), block_->GetUncompressedBufferSize(),
-                             first_key_);
-    total_bytes_ += block_->GetUncompressedBufferSize();
-    index_offset_ += block_->GetCompressedBufferSize();
-    ++index_count_;
+    if (bloom_filter_.get())
+        bloom_filter_->FinishDataBlock();
+    total_bytes_ = pipeline_->uncompressed_bytes();
+    index_offset_ = pipeline_->compressed_bytes();
+    index_count_ = pipeline_->block_count();
 
     fileInfo.set_last_key(last_key_);
+    fileInfo.set_data_block_format(block_->format());
     if (entry_count_ != 0) {
         fileInfo.set_avg_key_len(key_length_ / entry_count_);
         fileInfo.set_avg_value_len(value_length_ / entry_count_);
@@ -126,6 +130,17 @@ bool SingleSSTableWriter::Flush() {
         LOG(ERROR)<< "fwrite error, size: " << index_->EncodeToString().size();
         goto FAILED;
     }
+    if (bloom_filter_.get()) {
+        hfile::MetaIndex meta_index(index_offset_ + index_->EncodeToString().size());
+        meta_index.AddMetaBlock(hfile::BloomFilterBlock::kMetaBlockName,
+                                bloom_filter_->EncodeToString());
+        if (!meta_index.WriteToFile(file_base_.get())) {
+            LOG(ERROR)<< "fwrite error.";
+            goto FAILED;
+        }
+        trailer.set_meta_index_offset(meta_index.offset());
+        trailer.set_meta_index_count(meta_index.GetBlockCount());
+    }
     trailer.set_file_info_offset(file_info_offset_);
     trailer.set_data_index_offset(index_offset_);
     trailer.set_data_index_count(index_count_);
@@ -137,10 +152,14 @@ bool SingleSSTableWriter::Flush() {
         goto FAILED;
     }
     file_base_->Flush();
+    pipeline_.reset(NULL);
     file_base_.reset(NULL);
+    sorter_.reset(NULL);
     return MoveToRealPath(option_.path());
 
-    FAILED: file_base_.reset(NULL);
+    FAILED: pipeline_.reset(NULL);
+    sorter_.reset(NULL);
+    file_base_.reset(NULL);
     remove(GetTempSSTablePath(option_.path()).c_str());
     return false;
 }
@@ -6,17 +6,16 @@
 #ifndef TOFT_STORAGE_SSTABLE_WRITER_SINGLE_SSTABLE_WRITER_H
 #define TOFT_STORAGE_SSTABLE_WRITER_SINGLE_SSTABLE_WRITER_H
 
-#include <deque>
 #include <map>
 #include <string>
-#include <utility>
-#include <vector>
 
 #include "toft/base/scoped_ptr.h"
 #include "toft/storage/sstable/types.h"
 #include "toft/storage/sstable/writer/base_sstable_writer.h"
 
 namespace toft {
+class BlockWritePipeline;
+class ExternalSorter;
 class File;
 
 class SingleSSTableWriter : public SSTableWriter {
@@ -26,7 +25,9 @@ public:
     explicit SingleSSTableWriter(const SSTableWriteOption &option);
     ~SingleSSTableWriter();
 
-    //  add data block
+    //  add data block, items are sorted by key in Flush. If sort memory
+    //  budget is set, sorted items are spilled into temp files when memory
+    //  exceeds the budget.
     virtual bool Add(const std::string &key, const std::string &value);
     //  add meta data
     virtual void AddMetaData(const std::string &key, const std::string &value);
@@ -34,14 +35,16 @@ public:
     virtual bool Flush();
 
 private:
-    std::vector<std::deque<std::pair<std::string, std::string> >::iterator> data_index_;  // NOLINT
-    std::deque<std::pair<std::string, std::string> > d_data_;
+    toft::scoped_ptr<ExternalSorter> sorter_;
 
     std::map<std::string, std::string> file_info_meta_;
 
     toft::scoped_ptr<File> file_base_;
     toft::scoped_ptr<hfile::DataBlock> block_;
     toft::scoped_ptr<hfile::DataIndex> index_;
+    // NULL if bloom filter is disabled.
+    toft::scoped_ptr<hfile::BloomFilterBlock> bloom_filter_;
+    toft::scoped_ptr<BlockWritePipeline> pipeline_;
     std::string first_key_;
     int entry_count_;
     int64_t total_bytes_;
@@ -7,6 +7,7 @@
 
 #include "toft/storage/file/file.h"
 #include "toft/storage/sstable/sstable.h"
+#include "toft/storage/sstable/writer/block_write_pipeline.h"
 
 #include "thirdparty/gflags/gflags.h"
 
@@ -23,12 +24,15 @@ UnsortedSSTableWriter::UnsortedSSTableWriter(const SSTableWriteOption &option)
                   key_length_(0),
                   value_length_(0),
                   file_info_offset_(0) {
-    block_.reset(new hfile::DataBlock(static_cast<CompressType>(option.compress_type())));
+    block_.reset(NewDataBlock());
     index_.reset(new hfile::DataIndex);
+    if (option_.bloom_filter_bits_per_key() > 0)
+        bloom_filter_.reset(new hfile::BloomFilterBlock(option_.bloom_filter_bits_per_key()));
     CHECK(!option_.path().empty());
     std::string path = GetTempSSTablePath(option_.path());
     file_base_.reset(File::Open(path, "w"));
     CHECK(file_base_.get()) << "open file error: " << option_.path();
+    pipeline_.reset(new BlockWritePipeline(option_, file_base_.get(), index_.get()));
 }
 
 UnsortedSSTableWriter::~UnsortedSSTableWriter() {
@@ -52,6 +56,8 @@ bool UnsortedSSTableWriter::Add(const std::string &key, const std::string &value
         first_key_ = key;
     }
     block_->AddItem(key, value);
+    if (bloom_filter_.get())
+        bloom_filter_->AddKey(key);
     key_length_ += key.length();
     value_length_ += value.length();
     last_key_ = key;
@@ -69,8 +75,13 @@ bool UnsortedSSTableWriter::Flush() {
     CHECK(file_base_.get()) << "don't call Flush twice!";
 
     // Write the last block
-    if (!WriteBlockAndUpdateIndex())
+    if (!WriteBlockAndUpdateIndex() || !pipeline_->Finish()) {
+        failed_ = true;
         return false;
+    }
+    index_count_ = pipeline_->block_count();
+    total_bytes_ = pipeline_->uncompressed_bytes();
+    index_offset_ = pipeline_->compressed_bytes();
 
     hfile::FileInfo fileInfo;
     std::map<std::string, std::string>::iterator it_fi_meta = file_info_meta_.begin();
@@ -79,6 +90,7 @@ bool UnsortedSSTableWriter::Flush() {
         fileInfo.AddItem(it_fi_meta->first, it_fi_meta->second);
     }
     fileInfo.set_last_key(last_key_);
+    fileInfo.set_data_block_format(block_->format());
     if (entry_count_ != 0) {
         fileInfo.set_avg_key_len(key_length_ / entry_count_);
         fileInfo.set_avg_value_len(value_length_ / entry_count_);
@@ -98,6 +110,17 @@ bool UnsortedSSTableWriter::Flush() {
     }
 
     hfile::FileTrailer trailer;
+    if (bloom_filter_.get()) {
+        hfile::MetaIndex meta_index(index_offset_ + index_->EncodeToString().size());
+        meta_index.AddMetaBlock(hfile::BloomFilterBlock::kMetaBlockName,
+                                bloom_filter_->EncodeToString());
+        if (!meta_index.WriteToFile(file_base_.get())) {
+            LOG(ERROR)<< "fwrite error.";
+            return false;
+        }
+        trailer.set_meta_index_offset(meta_index.offset());
+        trailer.set_meta_index_count(meta_index.GetBlockCount());
+    }
     trailer.set_file_info_offset(file_info_offset_);
     trailer.set_data_index_offset(index_offset_);
     trailer.set_data_index_count(index_count_);
@@ -109,19 +132,16 @@ bool UnsortedSSTableWriter::Flush() {
         return false;
     }
     file_base_->Flush();
+    pipeline_.reset(NULL);
     file_base_.reset(NULL);
     return MoveToRealPath(option_.path());
 }
 
 bool UnsortedSSTableWriter::WriteBlockAndUpdateIndex() {
-    ++index_count_;
-    // Write the last block
-    bool result = block_->WriteToFile(file_base_.get());
-    index_->AddDataBlockInfo(block_->GetCompressedBufferSize(), block_->GetUncompressedBufferSize(),
-                             first_key_);
-    total_bytes_ += block_->GetUncompressedBufferSize();
-    index_offset_ += block_->GetCompressedBufferSize();
-    block_->ClearItems();
+    // The index is updated when the block is really written.
+    bool result = pipeline_->AddBlock(block_.get(), first_key_);
+    if (bloom_filter_.get())
+        bloom_filter_->FinishDataBlock();
     if (!result) {
         LOG(ERROR)<< "WriteToFile error.";
     }
@@ -14,6 +14,7 @@
 #include "toft/storage/sstable/writer/base_sstable_writer.h"
 
 namespace toft {
+class BlockWritePipeline;
 class DataBlock;
 class DataIndex;
 class File;
@@ -36,6 +37,9 @@ private:
     bool failed_;
     toft::scoped_ptr<hfile::DataBlock> block_;
     toft::scoped_ptr<hfile::DataIndex> index_;
+    // NULL if bloom filter is disabled.
+    toft::scoped_ptr<hfile::BloomFilterBlock> bloom_filter_;
+    toft::scoped_ptr<BlockWritePipeline> pipeline_;
     std::map<std::string, std::string> file_info_meta_;
     std::string first_key_;
     bool is_first_key_;
@@ -152,12 +152,13 @@ public:
     }
 
     void Set(int fd, int events) {
-        ev_io_set(c_watcher(), c_watcher()->fd, events);
+        ev_io_set(c_watcher(), fd, events);
     }
 
     void Set(int events) {
         struct ::ev_io* w = c_watcher();
-        if (events == w->events)
+        // ev_io_set also stores internal flags into w->events.
+        if (events == (w->events & (EV_READ | EV_WRITE)))
             return;
         bool active = IsActive();
         if (active)
@@ -168,6 +169,29 @@ public:
     }
 };
 
+// Watch wakeup from other threads, the callback is called in the thread
+// running the dispatcher.
+class AsyncEventWatcher : public EventWatcherBase<AsyncEventWatcher, ev_async> {
+public:
+    AsyncEventWatcher(EventDispatcher* dispatcher, const CallbackType& callback)
+        : EventWatcherBase(dispatcher, callback) {
+        ev_async_set(c_watcher());
+    }
+    void Start() {
+        ev_async_start(loop(), c_watcher());
+    }
+
+    void Stop() {
+        ev_async_stop(loop(), c_watcher());
+    }
+
+    // Thread safe. Multiple sends before the callback is called are merged
+    // into one call.
+    void Send() {
+        ev_async_send(loop(), c_watcher());
+    }
+};
+
 } // namespace toft
 
 #endif // TOFT_SYSTEM_EVENT_DISPATCHER_EVENT_DISPATCHER_H
@@ -8,6 +8,7 @@
 #include <signal.h>
 #include <stdio.h>
 #include <unistd.h>
+#include "toft/system/threading/thread.h"
 #include "thirdparty/gtest/gtest.h"
 
 namespace toft {
@@ -53,7 +54,7 @@ TEST(EventDispatcher, Signal) {
     EXPECT_TRUE(received);
 }
 
-static void OnIo(int fd, char* p, int events) {
+static void OnIo(int fd, char* p, int) {
     if (read(fd, p, 1) != 1) {
         // Do nothing.
     }
@@ -73,5 +74,27 @@ TEST(EventDispatcher, Io) {
     EXPECT_EQ(0, c);
 }
 
+static void OnAsync(EventDispatcher* dispatcher, bool* received, int) {
+    *received = true;
+    dispatcher->Break();
+}
+
+static void SendAsync(AsyncEventWatcher* watcher) {
+    watcher->Send();
+}
+
+TEST(EventDispatcher, Async) {
+    using namespace std::placeholders;
+    EventDispatcher dispatcher;
+    bool received = false;
+    AsyncEventWatcher watcher(&dispatcher, std::bind(OnAsync, &dispatcher,
+                                                     &received, _1));
+    watcher.Start();
+    Thread thread(std::bind(SendAsync, &watcher));
+    dispatcher.Run();
+    thread.Join();
+    EXPECT_TRUE(received);
+}
+
 } // namespace toft
 
@@ -129,6 +129,11 @@ public:
     bool GetReuseAddress(bool* value);
     bool SetReuseAddress(bool value = true);
 
+    /// Allow many sockets to bind the same address, the kernel distributes
+    /// incoming connections among them. Fail if not supported by the os.
+    bool GetReusePort(bool* value);
+    bool SetReusePort(bool value = true);
+
     bool SetLinger(bool onoff = true, int timeout = 0);
     bool SetKeepAlive(bool onoff = true);
 
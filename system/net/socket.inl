@@ -175,6 +175,26 @@ inline bool Socket::SetReuseAddress(bool value)
     return SetOption(SOL_SOCKET, SO_REUSEADDR, value);
 }
 
+inline bool Socket::GetReusePort(bool* value)
+{
+#ifdef SO_REUSEPORT
+    return GetOption(SOL_SOCKET, SO_REUSEPORT, value);
+#else
+    SetLastError(ENOPROTOOPT);
+    return false;
+#endif
+}
+
+inline bool Socket::SetReusePort(bool value)
+{
+#ifdef SO_REUSEPORT
+    return SetOption(SOL_SOCKET, SO_REUSEPORT, value);
+#else
+    SetLastError(ENOPROTOOPT);
+    return false;
+#endif
+}
+
 inline bool Socket::SetKeepAlive(bool onoff)
 {
     return SetOption(SOL_SOCKET, SO_KEEPALIVE, onoff);
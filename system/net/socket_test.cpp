@@ -22,6 +22,28 @@ TEST(Socket, ListenerSocket)
     EXPECT_ANY_THROW(ListenerSocket listener2(bind_address, SOCK_STREAM));
 }
 
+TEST(Socket, ReusePort)
+{
+    ListenerSocket listener;
+    EXPECT_TRUE(listener.Create(AF_INET, SOCK_STREAM));
+    if (!listener.SetReusePort())
+        return; // Not supported
+    bool reuse_port = false;
+    EXPECT_TRUE(listener.GetReusePort(&reuse_port));
+    EXPECT_TRUE(reuse_port);
+    SocketAddressInet address("127.0.0.1:0");
+    SocketAddressInet bind_address;
+    EXPECT_TRUE(listener.Bind(address));
+    EXPECT_TRUE(listener.GetLocalAddress(&bind_address));
+    EXPECT_TRUE(listener.Listen());
+
+    ListenerSocket listener2;
+    EXPECT_TRUE(listener2.Create(AF_INET, SOCK_STREAM));
+    EXPECT_TRUE(listener2.SetReusePort());
+    EXPECT_TRUE(listener2.Bind(bind_address));
+    EXPECT_TRUE(listener2.Listen());
+}
+
 TEST(Socket, SocketOption)
 {
     StreamSocket socket;
@@ -0,0 +1,121 @@
+// Copyright (C) 2026, The Toft Authors.
+//
+// Description: result handle of asynchronous tasks.
+
+#ifndef TOFT_SYSTEM_THREADING_FUTURE_H
+#define TOFT_SYSTEM_THREADING_FUTURE_H
+
+#include <stdint.h>
+
+#include "toft/base/functional.h"
+#include "toft/base/shared_ptr.h"
+#include "toft/system/threading/event.h"
+#include "toft/system/threading/thread_pool.h"
+
+#include "thirdparty/glog/logging.h"
+
+namespace toft {
+
+template <typename T> class Promise;
+
+namespace internal {
+
+template <typename T>
+struct FutureState {
+    FutureState() : ready(false) {}
+    ManualResetEvent event;
+    T value;
+    bool ready;  // Only set by the promise side, for debug check.
+};
+
+} // namespace internal
+
+// The read side of a value to be produced asynchronously, usually by a
+// task in ThreadPool, see AsyncRun. Copies of a future share the same value.
+//
+// Example:
+//   Future<int> result = AsyncRun(&pool, std::function<int ()>(Compute));
+//   ...
+//   int value = result.Get();
+template <typename T>
+class Future {
+public:
+    // An invalid future, which can be assigned later.
+    Future() {}
+
+    bool IsValid() const {
+        return m_state.get() != NULL;
+    }
+
+    // Return true if the value is ready, never block.
+    bool IsReady() const {
+        return m_state->event.TryWait();
+    }
+
+    void Wait() const {
+        m_state->event.Wait();
+    }
+
+    // Wait with timeout, in milliseconds.
+    // return true if the value is ready, false if timeout.
+    bool TimedWait(int64_t timeout) const {
+        return m_state->event.TimedWait(timeout);
+    }
+
+    // Wait and return the value.
+    const T& Get() const {
+        Wait();
+        return m_state->value;
+    }
+
+private:
+    friend class Promise<T>;
+    explicit Future(const std::shared_ptr<internal::FutureState<T> >& state)
+        : m_state(state) {}
+
+private:
+    std::shared_ptr<internal::FutureState<T> > m_state;
+};
+
+// The write side of a future, the value can only be set once.
+template <typename T>
+class Promise {
+public:
+    Promise() : m_state(new internal::FutureState<T>()) {}
+
+    Future<T> GetFuture() const {
+        return Future<T>(m_state);
+    }
+
+    void SetValue(const T& value) {
+        DCHECK(!m_state->ready) << "value can only be set once";
+        m_state->value = value;
+        m_state->ready = true;
+        // The event also publishes the value to waiting threads.
+        m_state->event.Set();
+    }
+
+private:
+    std::shared_ptr<internal::FutureState<T> > m_state;
+};
+
+namespace internal {
+
+template <typename T>
+void RunAndSetValue(Promise<T> promise, const std::function<T ()>& function) {
+    promise.SetValue(function());
+}
+
+} // namespace internal
+
+// Run function in the pool and return the future of its result.
+template <typename T>
+Future<T> AsyncRun(ThreadPool* pool, const std::function<T ()>& function) {
+    Promise<T> promise;
+    pool->AddTask(std::bind(&internal::RunAndSetValue<T>, promise, function));
+    return promise.GetFuture();
+}
+
+} // namespace toft
+
+#endif // TOFT_SYSTEM_THREADING_FUTURE_H
@@ -0,0 +1,68 @@
+// Copyright (C) 2026, The Toft Authors.
+//
+// Description: tests of Future and Promise.
+
+#include "toft/system/threading/future.h"
+
+#include <string>
+#include <vector>
+
+#include "toft/base/functional.h"
+#include "toft/system/threading/this_thread.h"
+#include "toft/system/threading/thread_pool.h"
+
+#include "thirdparty/gtest/gtest.h"
+
+namespace toft {
+
+static int Square(int x)
+{
+    return x * x;
+}
+
+static std::string SlowHello()
+{
+    ThisThread::Sleep(100);
+    return "hello";
+}
+
+TEST(Future, Promise)
+{
+    Future<int> invalid;
+    EXPECT_FALSE(invalid.IsValid());
+
+    Promise<int> promise;
+    Future<int> future = promise.GetFuture();
+    EXPECT_TRUE(future.IsValid());
+    EXPECT_FALSE(future.IsReady());
+    EXPECT_FALSE(future.TimedWait(1));
+    promise.SetValue(42);
+    EXPECT_TRUE(future.IsReady());
+    EXPECT_EQ(42, future.Get());
+
+    // Copies share the same value.
+    Future<int> copy = future;
+    EXPECT_EQ(42, copy.Get());
+}
+
+TEST(Future, AsyncRun)
+{
+    ThreadPool pool(4);
+    std::vector<Future<int> > results;
+    for (int i = 0; i < 100; ++i)
+        results.push_back(AsyncRun(&pool, std::function<int ()>(std::bind(Square, i))));
+    for (int i = 0; i < 100; ++i)
+        EXPECT_EQ(i * i, results[i].Get());
+}
+
+TEST(Future, Wait)
+{
+    ThreadPool pool(2, ThreadPool::kWorkStealing);
+    Future<std::string> result = AsyncRun(&pool, std::function<std::string ()>(SlowHello));
+    EXPECT_FALSE(result.IsReady());
+    result.Wait();
+    EXPECT_TRUE(result.IsReady());
+    EXPECT_EQ("hello", result.Get());
+}
+
+} // namespace toft
@@ -0,0 +1,136 @@
+// Copyright (C) 2026, The Toft Authors.
+//
+// Description: chunk scheduling of ParallelFor and ParallelReduce.
+
+#include "toft/system/threading/parallel_for.h"
+
+#include <algorithm>
+
+#include "toft/base/shared_ptr.h"
+#include "toft/system/threading/condition_variable.h"
+#include "toft/system/threading/mutex.h"
+#include "toft/system/threading/thread_pool.h"
+
+namespace toft {
+
+namespace {
+
+// Enough chunks per thread for load balance when chunks take different time.
+const size_t kChunksPerThread = 4;
+
+// Shared by the calling thread and helper tasks in the pool. A helper task
+// may start after the loop finished, so it's held by shared_ptr, and such
+// task never touches body since no chunk is left.
+struct ParallelLoop {
+    ParallelLoop(size_t b, size_t e, size_t size,
+                 const std::function<void (size_t, size_t, size_t)>& f,
+                 CancellationToken* t)
+        : begin(b), end(e), chunk_size(size),
+          num_chunks((e - b + size - 1) / size),
+          body(f), token(t), next_chunk(0), num_finished_chunks(0),
+          cond(&mutex) {}
+
+    // Take and run chunks until no chunk left.
+    void Run();
+
+    // Wait until all chunks are finished.
+    void Wait();
+
+    const size_t begin;
+    const size_t end;
+    const size_t chunk_size;
+    const size_t num_chunks;
+    const std::function<void (size_t, size_t, size_t)> body;
+    CancellationToken* token;
+    Atomic<size_t> next_chunk;
+    size_t num_finished_chunks;  // Under mutex
+    Mutex mutex;
+    ConditionVariable cond;
+};
+
+void ParallelLoop::Run() {
+    size_t num_run = 0;
+    for (;;) {
+        size_t index = next_chunk++;
+        if (index >= num_chunks)
+            break;
+        // Cancelled chunks are still counted as finished.
+        if (token == NULL || !token->IsCancelled()) {
+            size_t chunk_begin = begin + index * chunk_size;
+            size_t chunk_end = std::min(end, chunk_begin + chunk_size);
+            body(index, chunk_begin, chunk_end);
+        }
+        ++num_run;
+    }
+    if (num_run > 0) {
+        MutexLocker locker(&mutex);
+        num_finished_chunks += num_run;
+        if (num_finished_chunks == num_chunks)
+            cond.Broadcast();
+    }
+}
+
+void ParallelLoop::Wait() {
+    MutexLocker locker(&mutex);
+    while (num_finished_chunks < num_chunks)
+        cond.Wait();
+}
+
+void RunParallelLoop(std::shared_ptr<ParallelLoop> loop) {
+    loop->Run();
+}
+
+} // namespace
+
+namespace internal {
+
+size_t ParallelChunkSize(ThreadPool* pool, size_t size, size_t grain) {
+    if (grain == 0)
+        grain = 1;
+    if (pool == NULL)
+        return std::max(size, grain);
+    size_t num_threads = pool->num_threads() + 1;  // Include the calling thread
+    size_t chunk_size = size / (num_threads * kChunksPerThread);
+    return std::max(chunk_size, grain);
+}
+
+bool ParallelForChunks(ThreadPool* pool, size_t begin, size_t end, size_t chunk_size,
+                       const std::function<void (size_t, size_t, size_t)>& body,
+                       CancellationToken* token) {
+    if (begin >= end)
+        return token == NULL || !token->IsCancelled();
+
+    std::shared_ptr<ParallelLoop> loop(new ParallelLoop(begin, end, chunk_size, body, token));
+    if (pool != NULL && loop->num_chunks > 1) {
+        // The calling thread takes a part, so one helper less.
+        size_t num_helpers = std::min(pool->num_threads(), loop->num_chunks - 1);
+        std::vector<std::function<void ()> > helpers(
+            num_helpers, std::bind(RunParallelLoop, loop));
+        pool->AddTasks(helpers);
+    }
+    loop->Run();
+    loop->Wait();
+    return token == NULL || !token->IsCancelled();
+}
+
+} // namespace internal
+
+static void RunChunk(const std::function<void (size_t, size_t)>* body,
+                     size_t begin, size_t end) {
+    (*body)(begin, end);
+}
+
+bool ParallelFor(ThreadPool* pool, size_t begin, size_t end, size_t grain,
+                 const std::function<void (size_t, size_t)>& body,
+                 CancellationToken* token) {
+    if (begin >= end)
+        return token == NULL || !token->IsCancelled();
+    size_t chunk_size = internal::ParallelChunkSize(pool, end - begin, grain);
+    return internal::ParallelForChunks(
+        pool, begin, end, chunk_size,
+        // The chunk index is ignored.
+        std::bind(RunChunk, &body, std::placeholders::_2, std::placeholders::_3),
+        token);
+}
+
+} // namespace toft
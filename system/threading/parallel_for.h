@@ -0,0 +1,126 @@
+// Copyright (C) 2026, The Toft Authors.
+//
+// Description: parallel loop helpers on ThreadPool.
+
+#ifndef TOFT_SYSTEM_THREADING_PARALLEL_FOR_H
+#define TOFT_SYSTEM_THREADING_PARALLEL_FOR_H
+
+#include <stddef.h>
+
+#include <vector>
+
+#include "toft/base/functional.h"
+#include "toft/base/uncopyable.h"
+#include "toft/system/atomic/atomic.h"
+
+namespace toft {
+
+class ThreadPool;
+
+// Cancel a running ParallelFor or ParallelReduce, from the loop body or any
+// other thread. Chunks already started run to the end, chunks not started
+// yet are skipped. A token can be shared by nested loops to cancel them
+// all together.
+class CancellationToken {
+    TOFT_DECLARE_UNCOPYABLE(CancellationToken);
+
+public:
+    CancellationToken() : m_cancelled(false) {}
+
+    void Cancel() {
+        m_cancelled = true;
+    }
+
+    bool IsCancelled() const {
+        return m_cancelled;
+    }
+
+private:
+    Atomic<bool> m_cancelled;
+};
+
+// Call body(chunk_begin, chunk_end) for chunks covering [begin, end).
+//
+// Chunks are no smaller than grain (except the last one), and are made
+// larger if the range is large, so that each thread gets a few chunks,
+// enough for load balance without too many scheduling. Threads of pool
+// and the calling thread take chunks dynamically, so the loop can always
+// finish even if all threads of the pool are busy, for example, when it's
+// called from a task in the same pool.
+//
+// If pool is NULL, the whole range is run in the calling thread.
+//
+// Return false if cancelled by token.
+//
+// Example:
+//   ParallelFor(&pool, 0, files.size(), 1,
+//               std::bind(HashFiles, &files, &results, _1, _2));
+bool ParallelFor(ThreadPool* pool, size_t begin, size_t end, size_t grain,
+                 const std::function<void (size_t, size_t)>& body,
+                 CancellationToken* token = NULL);
+
+namespace internal {
+
+// Chunk size chosen by ParallelFor.
+size_t ParallelChunkSize(ThreadPool* pool, size_t size, size_t grain);
+
+// Call body(chunk_index, chunk_begin, chunk_end) for each chunk.
+bool ParallelForChunks(ThreadPool* pool, size_t begin, size_t end, size_t chunk_size,
+                       const std::function<void (size_t, size_t, size_t)>& body,
+                       CancellationToken* token);
+
+// Result of a chunk. Wrapped so that elements of std::vector<bool> are not
+// packed into shared words, which are written by different threads.
+template <typename T>
+struct ParallelReduceSlot {
+    explicit ParallelReduceSlot(const T& v) : value(v) {}
+    T value;
+};
+
+template <typename T>
+void ParallelMapChunk(const std::function<T (size_t, size_t)>* map,
+                      std::vector<ParallelReduceSlot<T> >* results,
+                      size_t index, size_t begin, size_t end) {
+    (*results)[index].value = (*map)(begin, end);
+}
+
+} // namespace internal
+
+// Compute map(chunk_begin, chunk_end) for chunks covering [begin, end) in
+// parallel like ParallelFor, then combine the results with reduce in the
+// order of chunks in the calling thread, so reduce need not be commutative,
+// for example, CRC32::Combine or string concatenation.
+//
+// identity is the result of an empty range. If cancelled, the result only
+// covers the finished chunks, and is usually meaningless.
+//
+// Example:
+//   uint64_t sum = ParallelReduce<uint64_t>(&pool, 0, v.size(), 1024, 0,
+//                                          std::bind(SumOf, &v, _1, _2),
+//                                          std::plus<uint64_t>());
+template <typename T>
+T ParallelReduce(ThreadPool* pool, size_t begin, size_t end, size_t grain,
+                 const T& identity,
+                 const std::function<T (size_t, size_t)>& map,
+                 const std::function<T (const T&, const T&)>& reduce,
+                 CancellationToken* token = NULL) {
+    if (begin >= end)
+        return identity;
+    size_t chunk_size = internal::ParallelChunkSize(pool, end - begin, grain);
+    size_t num_chunks = (end - begin + chunk_size - 1) / chunk_size;
+    std::vector<internal::ParallelReduceSlot<T> > results(
+        num_chunks, internal::ParallelReduceSlot<T>(identity));
+    internal::ParallelForChunks(
+        pool, begin, end, chunk_size,
+        std::bind(&internal::ParallelMapChunk<T>, &map, &results,
+                  std::placeholders::_1, std::placeholders::_2, std::placeholders::_3),
+        token);
+    T result = identity;
+    for (size_t i = 0; i < num_chunks; ++i)
+        result = reduce(result, results[i].value);
+    return result;
+}
+
+} // namespace toft
+
+#endif // TOFT_SYSTEM_THREADING_PARALLEL_FOR_H
@@ -0,0 +1,111 @@
+// Copyright (C) 2026, The Toft Authors.
+//
+// Description: ParallelFor and ParallelReduce on hashing large buffers.
+
+#include "toft/system/threading/parallel_for.h"
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "toft/base/functional.h"
+#include "toft/hash/crc32.h"
+#include "toft/hash/fingerprint.h"
+#include "toft/system/threading/thread_pool.h"
+
+#include "thirdparty/benchmark/benchmark.h"
+
+namespace {
+
+const size_t kBufferSize = 64 * 1024 * 1024;
+const size_t kBlockSize = 4096;
+
+const std::string& Buffer() {
+    static std::string buffer;
+    if (buffer.empty()) {
+        buffer.resize(kBufferSize);
+        uint32_t x = 1;
+        for (size_t i = 0; i < buffer.size(); ++i) {
+            x = x * 1103515245 + 12345;
+            buffer[i] = static_cast<char>(x >> 24);
+        }
+    }
+    return buffer;
+}
+
+// Crc32 with its length, so that pieces can be combined.
+struct Crc32Piece {
+    Crc32Piece() : crc(0), length(0) {}
+    uint32_t crc;
+    size_t length;
+};
+
+Crc32Piece Crc32OfRange(const std::string* buffer, size_t begin, size_t end) {
+    Crc32Piece piece;
+    piece.crc = toft::CRC32::Digest(toft::StringPiece(buffer->data() + begin, end - begin));
+    piece.length = end - begin;
+    return piece;
+}
+
+Crc32Piece CombineCrc32(const Crc32Piece& a, const Crc32Piece& b) {
+    Crc32Piece piece;
+    piece.crc = toft::CRC32::Combine(a.crc, b.crc, b.length);
+    piece.length = a.length + b.length;
+    return piece;
+}
+
+// Fingerprint every block, like building dedup index of a large file.
+void FingerprintBlocks(const std::string* buffer, std::vector<uint64_t>* fingerprints,
+                       size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i)
+        (*fingerprints)[i] = toft::Fingerprint64(buffer->data() + i * kBlockSize, kBlockSize);
+}
+
+}  // namespace
+
+static void Crc32Serial(benchmark::State& state) {
+    const std::string& buffer = Buffer();
+    for (auto _ : state)
+        benchmark::DoNotOptimize(toft::CRC32::Digest(buffer));
+    state.SetBytesProcessed(state.iterations() * buffer.size());
+}
+
+static void Crc32ParallelReduce(benchmark::State& state) {
+    const std::string& buffer = Buffer();
+    toft::ThreadPool pool(static_cast<int>(state.range(0)));
+    for (auto _ : state) {
+        Crc32Piece result = toft::ParallelReduce<Crc32Piece>(
+            &pool, 0, buffer.size(), 64 * 1024, Crc32Piece(),
+            std::bind(Crc32OfRange, &buffer, std::placeholders::_1, std::placeholders::_2),
+            CombineCrc32);
+        benchmark::DoNotOptimize(result.crc);
+    }
+    state.SetBytesProcessed(state.iterations() * buffer.size());
+}
+
+static void Fingerprint64Serial(benchmark::State& state) {
+    const std::string& buffer = Buffer();
+    std::vector<uint64_t> fingerprints(buffer.size() / kBlockSize);
+    for (auto _ : state)
+        FingerprintBlocks(&buffer, &fingerprints, 0, fingerprints.size());
+    state.SetBytesProcessed(state.iterations() * buffer.size());
+}
+
+static void Fingerprint64ParallelFor(benchmark::State& state) {
+    const std::string& buffer = Buffer();
+    std::vector<uint64_t> fingerprints(buffer.size() / kBlockSize);
+    toft::ThreadPool pool(static_cast<int>(state.range(0)));
+    for (auto _ : state) {
+        toft::ParallelFor(&pool, 0, fingerprints.size(), 16,
+                          std::bind(FingerprintBlocks, &buffer, &fingerprints,
+                                    std::placeholders::_1, std::placeholders::_2));
+    }
+    state.SetBytesProcessed(state.iterations() * buffer.size());
+}
+
+BENCHMARK(Crc32Serial)->UseRealTime();
+// Arg is the number of threads in pool, the calling thread also works.
+BENCHMARK(Crc32ParallelReduce)->Arg(1)->Arg(3)->Arg(7)->Arg(15)->UseRealTime();
+BENCHMARK(Fingerprint64Serial)->UseRealTime();
+BENCHMARK(Fingerprint64ParallelFor)->Arg(1)->Arg(3)->Arg(7)->Arg(15)->UseRealTime();
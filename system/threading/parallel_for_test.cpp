@@ -0,0 +1,227 @@
+// Copyright (C) 2026, The Toft Authors.
+//
+// Description: tests of ParallelFor and ParallelReduce.
+
+#include "toft/system/threading/parallel_for.h"
+
+#include <stdint.h>
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include "toft/base/functional.h"
+#include "toft/base/string/concat.h"
+#include "toft/system/atomic/atomic.h"
+#include "toft/system/threading/mutex.h"
+#include "toft/system/threading/this_thread.h"
+#include "toft/system/threading/thread_pool.h"
+
+#include "thirdparty/gtest/gtest.h"
+
+namespace toft {
+
+static void MarkRange(std::vector<int>* marks, size_t begin, size_t end)
+{
+    for (size_t i = begin; i < end; ++i)
+        ++(*marks)[i];
+}
+
+class ParallelForTest : public testing::TestWithParam<ThreadPool::SchedulePolicy> {};
+
+TEST_P(ParallelForTest, CoverRange)
+{
+    ThreadPool pool(4, GetParam());
+    const size_t sizes[] = { 0, 1, 2, 7, 100, 1000, 100000 };
+    const size_t grains[] = { 0, 1, 3, 64, 1000000 };
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i) {
+        for (size_t j = 0; j < sizeof(grains) / sizeof(grains[0]); ++j) {
+            std::vector<int> marks(sizes[i] + 10);
+            EXPECT_TRUE(ParallelFor(&pool, 5, 5 + sizes[i], grains[j],
+                                    std::bind(MarkRange, &marks, std::placeholders::_1,
+                                              std::placeholders::_2)));
+            for (size_t k = 0; k < marks.size(); ++k)
+                ASSERT_EQ(k >= 5 && k < 5 + sizes[i] ? 1 : 0, marks[k]) << k;
+        }
+    }
+}
+
+TEST(ParallelFor, NullPool)
+{
+    std::vector<int> marks(100);
+    EXPECT_TRUE(ParallelFor(NULL, 0, 100, 1,
+                            std::bind(MarkRange, &marks, std::placeholders::_1,
+                                      std::placeholders::_2)));
+    for (size_t k = 0; k < marks.size(); ++k)
+        ASSERT_EQ(1, marks[k]);
+}
+
+static void CheckGrain(size_t grain, size_t end, size_t begin, size_t chunk_end)
+{
+    EXPECT_TRUE(chunk_end - begin >= grain || chunk_end == end);
+}
+
+TEST(ParallelFor, Grain)
+{
+    ThreadPool pool(4);
+    ParallelFor(&pool, 0, 1000, 300,
+                std::bind(CheckGrain, 300, 1000, std::placeholders::_1, std::placeholders::_2));
+}
+
+static void RecordThread(Mutex* mutex, std::set<int>* threads, size_t, size_t)
+{
+    ThisThread::Sleep(1);
+    MutexLocker locker(mutex);
+    threads->insert(ThisThread::GetId());
+}
+
+TEST(ParallelFor, CallingThreadParticipates)
+{
+    ThreadPool pool(2);
+    Mutex mutex;
+    std::set<int> threads;
+    ParallelFor(&pool, 0, 100, 1,
+                std::bind(RecordThread, &mutex, &threads,
+                          std::placeholders::_1, std::placeholders::_2));
+    EXPECT_EQ(1U, threads.count(ThisThread::GetId()));
+}
+
+static void Block(int time_in_ms)
+{
+    ThisThread::Sleep(time_in_ms);
+}
+
+TEST(ParallelFor, AllThreadsBusy)
+{
+    // The loop is finished by the calling thread alone.
+    ThreadPool pool(2);
+    pool.AddTask(std::bind(Block, 500));
+    pool.AddTask(std::bind(Block, 500));
+    ThisThread::Sleep(10);
+    std::vector<int> marks(1000);
+    EXPECT_TRUE(ParallelFor(&pool, 0, 1000, 1,
+                            std::bind(MarkRange, &marks, std::placeholders::_1,
+                                      std::placeholders::_2)));
+    for (size_t k = 0; k < marks.size(); ++k)
+        ASSERT_EQ(1, marks[k]);
+}
+
+static void Increase(Atomic<int>* count, size_t begin, size_t end)
+{
+    *count += static_cast<int>(end - begin);
+}
+
+static void NestedBody(ThreadPool* pool, Atomic<int>* count, size_t begin, size_t end)
+{
+    for (size_t i = begin; i < end; ++i) {
+        ParallelFor(pool, 0, 100, 1, std::bind(Increase, count, std::placeholders::_1,
+                                               std::placeholders::_2));
+    }
+}
+
+TEST_P(ParallelForTest, Nested)
+{
+    ThreadPool pool(4, GetParam());
+    Atomic<int> count;
+    ParallelFor(&pool, 0, 20, 1,
+                std::bind(NestedBody, &pool, &count,
+                          std::placeholders::_1, std::placeholders::_2));
+    EXPECT_EQ(2000, count.Value());
+}
+
+static void CancelAt(CancellationToken* token, Atomic<int>* count, size_t cancel_at,
+                     size_t begin, size_t end)
+{
+    for (size_t i = begin; i < end; ++i) {
+        if (i == cancel_at)
+            token->Cancel();
+    }
+    ThisThread::Sleep(1);
+    *count += static_cast<int>(end - begin);
+}
+
+TEST_P(ParallelForTest, Cancel)
+{
+    ThreadPool pool(4, GetParam());
+    CancellationToken token;
+    Atomic<int> count;
+    EXPECT_FALSE(ParallelFor(&pool, 0, 10000, 1,
+                             std::bind(CancelAt, &token, &count, 10,
+                                       std::placeholders::_1, std::placeholders::_2),
+                             &token));
+    EXPECT_TRUE(token.IsCancelled());
+    EXPECT_LT(count.Value(), 10000);
+
+    // Cancelled before start.
+    std::vector<int> marks(100);
+    EXPECT_FALSE(ParallelFor(&pool, 0, 100, 1,
+                             std::bind(MarkRange, &marks, std::placeholders::_1,
+                                       std::placeholders::_2),
+                             &token));
+    for (size_t k = 0; k < marks.size(); ++k)
+        ASSERT_EQ(0, marks[k]);
+}
+
+static uint64_t Sum(size_t begin, size_t end)
+{
+    uint64_t sum = 0;
+    for (size_t i = begin; i < end; ++i)
+        sum += i;
+    return sum;
+}
+
+static uint64_t Add(const uint64_t& a, const uint64_t& b)
+{
+    return a + b;
+}
+
+static std::string Concat(const std::string& a, const std::string& b)
+{
+    return a + b;
+}
+
+static std::string ToString(size_t begin, size_t end)
+{
+    std::string result;
+    for (size_t i = begin; i < end; ++i)
+        StringAppend(&result, i, ",");
+    return result;
+}
+
+TEST_P(ParallelForTest, Reduce)
+{
+    ThreadPool pool(4, GetParam());
+    EXPECT_EQ(0U, ParallelReduce<uint64_t>(&pool, 0, 0, 1, 0, Sum, Add));
+    EXPECT_EQ(4950U, ParallelReduce<uint64_t>(&pool, 0, 100, 1, 0, Sum, Add));
+    EXPECT_EQ(499999500000ULL,
+              ParallelReduce<uint64_t>(&pool, 0, 1000000, 1000, 0, Sum, Add));
+    EXPECT_EQ(4950U, ParallelReduce<uint64_t>(NULL, 0, 100, 1, 0, Sum, Add));
+
+    // Reduced in order.
+    EXPECT_EQ(ToString(0, 1000),
+              ParallelReduce<std::string>(&pool, 0, 1000, 1, "", ToString, Concat));
+}
+
+static bool NotCover999(size_t begin, size_t end)
+{
+    return !(begin <= 999 && 999 < end);
+}
+
+static bool And(const bool& a, const bool& b)
+{
+    return a && b;
+}
+
+TEST_P(ParallelForTest, ReduceBool)
+{
+    // Results of adjacent chunks must not share a word.
+    ThreadPool pool(4, GetParam());
+    EXPECT_TRUE(ParallelReduce<bool>(&pool, 0, 999, 1, true, NotCover999, And));
+    EXPECT_FALSE(ParallelReduce<bool>(&pool, 0, 1000, 1, true, NotCover999, And));
+}
+
+INSTANTIATE_TEST_CASE_P(ParallelForTest, ParallelForTest,
+                        testing::Values(ThreadPool::kDispatchByKey,
+                                        ThreadPool::kWorkStealing));
+
+} // namespace toft
@@ -0,0 +1,100 @@
+// Copyright (C) 2026, The Toft Authors.
+//
+// Description: counting and waiting of TaskGroup.
+
+#include "toft/system/threading/task_group.h"
+
+#include "toft/system/threading/thread_pool.h"
+#include "toft/system/time/clock.h"
+
+namespace toft {
+
+TaskGroup::TaskGroup(ThreadPool* pool) :
+    m_pool(pool), m_cond(&m_mutex), m_num_pending_tasks(0)
+{
+}
+
+TaskGroup::~TaskGroup()
+{
+    Wait();
+}
+
+void TaskGroup::AddTask(Closure<void ()>* callback)
+{
+    {
+        MutexLocker locker(&m_mutex);
+        ++m_num_pending_tasks;
+    }
+    m_pool->AddTask(std::bind(&TaskGroup::RunClosure, this, callback));
+}
+
+void TaskGroup::AddTask(const std::function<void ()>& callback)
+{
+    {
+        MutexLocker locker(&m_mutex);
+        ++m_num_pending_tasks;
+    }
+    m_pool->AddTask(std::bind(&TaskGroup::RunFunction, this, callback));
+}
+
+void TaskGroup::AddTasks(const std::vector<std::function<void ()> >& callbacks)
+{
+    if (callbacks.empty())
+        return;
+    std::vector<std::function<void ()> > tasks;
+    tasks.reserve(callbacks.size());
+    for (size_t i = 0; i < callbacks.size(); ++i)
+        tasks.push_back(std::bind(&TaskGroup::RunFunction, this, callbacks[i]));
+    {
+        MutexLocker locker(&m_mutex);
+        m_num_pending_tasks += tasks.size();
+    }
+    m_pool->AddTasks(tasks);
+}
+
+void TaskGroup::RunClosure(Closure<void ()>* callback)
+{
+    callback->Run();
+    OnTaskDone();
+}
+
+void TaskGroup::RunFunction(const std::function<void ()>& callback)
+{
+    callback();
+    OnTaskDone();
+}
+
+void TaskGroup::OnTaskDone()
+{
+    MutexLocker locker(&m_mutex);
+    if (--m_num_pending_tasks == 0)
+        m_cond.Broadcast();
+}
+
+void TaskGroup::Wait()
+{
+    MutexLocker locker(&m_mutex);
+    while (m_num_pending_tasks > 0)
+        m_cond.Wait();
+}
+
+bool TaskGroup::TimedWait(int64_t timeout)
+{
+    int64_t deadline = RealtimeClock.MilliSeconds() + timeout;
+    MutexLocker locker(&m_mutex);
+    while (m_num_pending_tasks > 0) {
+        int64_t now = RealtimeClock.MilliSeconds();
+        if (now >= deadline)
+            return false;
+        m_cond.TimedWait(deadline - now);
+    }
+    return true;
+}
+
+size_t TaskGroup::PendingCount() const
+{
+    MutexLocker locker(&m_mutex);
+    return m_num_pending_tasks;
+}
+
+} // namespace toft
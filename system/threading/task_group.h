@@ -0,0 +1,74 @@
+// Copyright (C) 2026, The Toft Authors.
+//
+// Description: wait for a group of tasks in a thread pool.
+
+#ifndef TOFT_SYSTEM_THREADING_TASK_GROUP_H
+#define TOFT_SYSTEM_THREADING_TASK_GROUP_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "toft/base/closure.h"
+#include "toft/base/functional.h"
+#include "toft/base/uncopyable.h"
+#include "toft/system/threading/condition_variable.h"
+#include "toft/system/threading/mutex.h"
+
+namespace toft {
+
+class ThreadPool;
+
+// A group of tasks run in a ThreadPool, which can be waited for without
+// waiting other tasks in the same pool, unlike ThreadPool::WaitForIdle.
+//
+// Example:
+//   TaskGroup group(&pool);
+//   for (size_t i = 0; i < files.size(); ++i)
+//       group.AddTask(std::bind(ProcessFile, files[i]));
+//   group.Wait();
+//
+// A task can add more tasks into its own group. Waiting in a task of the
+// same pool occupies a thread, so the pool may be deadlocked if all threads
+// are waiting.
+class TaskGroup {
+    TOFT_DECLARE_UNCOPYABLE(TaskGroup);
+
+public:
+    explicit TaskGroup(ThreadPool* pool);
+
+    // Wait for all tasks.
+    ~TaskGroup();
+
+    void AddTask(Closure<void ()>* callback);
+    void AddTask(const std::function<void ()>& callback);
+
+    // Added by one ThreadPool::AddTasks call.
+    void AddTasks(const std::vector<std::function<void ()> >& callbacks);
+
+    // Wait until all tasks added are finished.
+    void Wait();
+
+    // Wait with timeout, in milliseconds.
+    // return true if all tasks are finished, false if timeout.
+    bool TimedWait(int64_t timeout);
+
+    // Number of added but not finished tasks.
+    size_t PendingCount() const;
+
+private:
+    void RunClosure(Closure<void ()>* callback);
+    void RunFunction(const std::function<void ()>& callback);
+    void OnTaskDone();
+
+private:
+    ThreadPool* m_pool;
+    mutable Mutex m_mutex;
+    ConditionVariable m_cond;
+    size_t m_num_pending_tasks;
+};
+
+} // namespace toft
+
+#endif // TOFT_SYSTEM_THREADING_TASK_GROUP_H
@@ -0,0 +1,114 @@
+// Copyright (C) 2026, The Toft Authors.
+//
+// Description: tests of TaskGroup.
+
+#include "toft/system/threading/task_group.h"
+
+#include <vector>
+
+#include "toft/base/closure.h"
+#include "toft/base/functional.h"
+#include "toft/system/atomic/atomic.h"
+#include "toft/system/threading/this_thread.h"
+#include "toft/system/threading/thread_pool.h"
+
+#include "thirdparty/gtest/gtest.h"
+
+namespace toft {
+
+static void Increase(Atomic<int>* count)
+{
+    ++*count;
+}
+
+static void SleepAndIncrease(Atomic<int>* count, int time_in_ms)
+{
+    ThisThread::Sleep(time_in_ms);
+    ++*count;
+}
+
+class TaskGroupTest : public testing::TestWithParam<ThreadPool::SchedulePolicy> {};
+
+TEST_P(TaskGroupTest, Wait)
+{
+    ThreadPool pool(4, GetParam());
+    Atomic<int> count;
+    TaskGroup group(&pool);
+    for (int i = 0; i < 1000; ++i)
+        group.AddTask(std::bind(Increase, &count));
+    for (int i = 0; i < 100; ++i)
+        group.AddTask(NewClosure(Increase, &count));
+    group.Wait();
+    EXPECT_EQ(1100, count.Value());
+    EXPECT_EQ(0U, group.PendingCount());
+}
+
+TEST_P(TaskGroupTest, AddTasks)
+{
+    ThreadPool pool(4, GetParam());
+    Atomic<int> count;
+    TaskGroup group(&pool);
+    std::vector<std::function<void ()> > tasks(1000, std::bind(Increase, &count));
+    group.AddTasks(tasks);
+    group.AddTasks(std::vector<std::function<void ()> >());
+    group.Wait();
+    EXPECT_EQ(1000, count.Value());
+}
+
+// Run with work stealing, or the fast tasks may be queued behind the slow
+// one in the same thread.
+TEST(TaskGroup, Independent)
+{
+    ThreadPool pool(4, ThreadPool::kWorkStealing);
+    Atomic<int> slow_count;
+    Atomic<int> fast_count;
+    TaskGroup slow_group(&pool);
+    TaskGroup fast_group(&pool);
+    slow_group.AddTask(std::bind(SleepAndIncrease, &slow_count, 500));
+    for (int i = 0; i < 10; ++i)
+        fast_group.AddTask(std::bind(Increase, &fast_count));
+    // Not blocked by the slow group.
+    EXPECT_TRUE(fast_group.TimedWait(400));
+    EXPECT_EQ(10, fast_count.Value());
+    EXPECT_FALSE(slow_group.TimedWait(1));
+    EXPECT_EQ(1U, slow_group.PendingCount());
+    slow_group.Wait();
+    EXPECT_EQ(1, slow_count.Value());
+}
+
+TEST_P(TaskGroupTest, WaitInDestructor)
+{
+    ThreadPool pool(4, GetParam());
+    Atomic<int> count;
+    {
+        TaskGroup group(&pool);
+        for (int i = 0; i < 10; ++i)
+            group.AddTask(std::bind(SleepAndIncrease, &count, 10));
+    }
+    EXPECT_EQ(10, count.Value());
+}
+
+static void AddChildren(TaskGroup* group, Atomic<int>* count, int depth)
+{
+    ++*count;
+    if (depth > 0) {
+        group->AddTask(std::bind(AddChildren, group, count, depth - 1));
+        group->AddTask(std::bind(AddChildren, group, count, depth - 1));
+    }
+}
+
+TEST_P(TaskGroupTest, Nested)
+{
+    ThreadPool pool(4, GetParam());
+    Atomic<int> count;
+    TaskGroup group(&pool);
+    group.AddTask(std::bind(AddChildren, &group, &count, 9));
+    group.Wait();
+    EXPECT_EQ(1023, count.Value());
+}
+
+INSTANTIATE_TEST_CASE_P(TaskGroupTest, TaskGroupTest,
+                        testing::Values(ThreadPool::kDispatchByKey,
+                                        ThreadPool::kWorkStealing));
+
+} // namespace toft
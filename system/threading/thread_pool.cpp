@@ -7,12 +7,15 @@
 
 #include "toft/system/threading/thread_pool.h"
 
+#include <algorithm>
+
 #include "thirdparty/glog/logging.h"
 
 #include "toft/base/scoped_ptr.h"
 #include "toft/base/string/concat.h"
 #include "toft/system/info/info.h"
 #include "toft/system/threading/this_thread.h"
+#include "toft/system/threading/work_stealing_queue.h"
 
 namespace toft {
 
@@ -21,6 +24,15 @@ struct ThreadPool::Task {
         callback(cb), function(f)
     {
     }
+    void Run() {
+        if (callback) {
+            callback->Run();
+            callback = NULL;
+        } else {
+            function();
+            function = NULL;
+        }
+    }
     list_node link;
     Closure<void()>* callback;
     std::function<void ()> function;
@@ -28,7 +40,9 @@ struct ThreadPool::Task {
 
 struct ThreadPool::ThreadContext {
     typedef intrusive_list<ThreadPool::Task> TaskList;
-    ThreadContext() : cond(&mutex), exit(false) {}
+    ThreadContext() :
+        cond(&mutex), exit(false), index(0), sleeping(false), searching(false),
+        random_seed(1), num_run_tasks(0) {}
     scoped_ptr<Thread> thread;
     mutable Mutex mutex;
     ConditionVariable cond;
@@ -36,9 +50,52 @@ struct ThreadPool::ThreadContext {
     TaskList free_tasks;  // __attribute__((aligned(64)));
     bool exit __attribute__((aligned(64)));
 
+    // The following members are only used by kWorkStealing policy.
+    size_t index;
+    WorkStealingQueue<ThreadPool::Task> local_tasks;  // Added by this thread
+    TaskList shared_tasks;  // Added by other threads, under mutex
+    bool sleeping;  // Under mutex
+    bool searching;  // Woken up to search tasks, see WakeUpIdleThread
+    // Only accessed by this thread.
+    TaskList affinity_tasks;  // Taken from pending_tasks
+    TaskList local_free_tasks;
+    unsigned int random_seed;
+    size_t num_run_tasks;
+
     bool GetPendingTask(TaskList* tasks);
+
+    // Reuse a task in free_tasks if any.
+    static Task* NewTask(TaskList* free_tasks,
+                         Closure<void()>* callback,
+                         const std::function<void ()>& function);
+
+    unsigned int NextRandom() {
+        // xorshift
+        random_seed ^= random_seed << 13;
+        random_seed ^= random_seed >> 17;
+        random_seed ^= random_seed << 5;
+        return random_seed;
+    }
 } __attribute__((aligned(64)));  // Make cache alignment.
 
+// Set in threads of work stealing pools, to find the context of current thread.
+static __thread ThreadPool* s_current_pool = NULL;
+static __thread size_t s_current_thread_index = 0;
+
+ThreadPool::Task* ThreadPool::ThreadContext::NewTask(
+    TaskList* free_tasks,
+    Closure<void()>* callback,
+    const std::function<void ()>& function)
+{
+    if (free_tasks->empty())
+        return new Task(callback, function);
+    Task* task = &free_tasks->front();
+    free_tasks->pop_front();
+    task->callback = callback;
+    task->function = function;
+    return task;
+}
+
 // Return whether should exit. Note even if return false, the task may be not
 // empty because of remaining tasks before exit was set.
 bool ThreadPool::ThreadContext::GetPendingTask(TaskList* tasks) {
@@ -51,8 +108,9 @@ bool ThreadPool::ThreadContext::GetPendingTask(TaskList* tasks) {
     return !exit;
 }
 
-ThreadPool::ThreadPool(int num_threads):
-    m_num_threads(0), m_num_busy_threads(0), m_exit_cond(&m_exit_lock), m_exit(false) {
+ThreadPool::ThreadPool(int num_threads, SchedulePolicy policy):
+    m_num_threads(0), m_num_busy_threads(0), m_policy(policy),
+    m_exit_cond(&m_exit_lock), m_exit(false) {
     if (num_threads < 0)
         m_num_threads = GetLogicalCpuNumber();
     else if (num_threads == 0)
@@ -61,11 +119,20 @@ ThreadPool::ThreadPool(int num_threads):
         m_num_threads = num_threads;
 
     m_thread_contexts = new ThreadContext[m_num_threads];
+    for (size_t i = 0; i < m_num_threads; ++i) {
+        m_thread_contexts[i].index = i;
+        m_thread_contexts[i].random_seed = i + 1;
+    }
     ThreadAttributes attr;
     for (size_t i = 0; i < m_num_threads; ++i) {
         attr.SetName(StringConcat("threadpool/", i));
-        m_thread_contexts[i].thread.reset(
-            new Thread(attr, std::bind(&ThreadPool::WorkRoutine, this, &m_thread_contexts[i])));
+        if (m_policy == kWorkStealing) {
+            m_thread_contexts[i].thread.reset(new Thread(attr,
+                std::bind(&ThreadPool::WorkStealingRoutine, this, &m_thread_contexts[i])));
+        } else {
+            m_thread_contexts[i].thread.reset(new Thread(attr,
+                std::bind(&ThreadPool::WorkRoutine, this, &m_thread_contexts[i])));
+        }
     }
     m_num_busy_threads = m_num_threads;
 }
@@ -81,25 +148,21 @@ void ThreadPool::AddTaskInternal(
     int dispatch_key)
 {
     DCHECK(!m_exit);
+    ++m_num_unfinished_tasks;
     ThreadContext& context = m_thread_contexts[dispatch_key % m_num_threads];
     {
-        Task* task;
         MutexLocker locker(&context.mutex);
-        if (!context.free_tasks.empty()) {
-            task = &context.free_tasks.front();
-            context.free_tasks.pop_front();
-            task->callback = callback;
-            task->function = function;
-        } else {
-            task = new Task(callback, function);
-        }
-
+        Task* task = ThreadContext::NewTask(&context.free_tasks, callback, function);
         context.pending_tasks.push_back(task);
         context.cond.Signal();
     }
 }
 
 void ThreadPool::AddTask(Closure<void()>* callback) {
+    if (m_policy == kWorkStealing) {
+        AddStealableTask(callback, NULL);
+        return;
+    }
     // The memory address is random enough for load balance, but need
     // remove low alignment part. (The lowest 5 bits of allocated object
     // address are always 0 for 64 bit system).
@@ -107,8 +170,6 @@ void ThreadPool::AddTask(Closure<void()>* callback) {
     AddTask(callback, dispatch_key);
 }
 
-int rdtsc() { return 0; }
-
 void ThreadPool::AddTask(Closure<void ()>* callback, int dispatch_key)
 {
     AddTaskInternal(callback, NULL, dispatch_key);
@@ -116,7 +177,12 @@ void ThreadPool::AddTask(Closure<void ()>* callback, int dispatch_key)
 
 void ThreadPool::AddTask(const std::function<void ()>& callback)
 {
-    AddTask(callback, rdtsc());
+    if (m_policy == kWorkStealing) {
+        AddStealableTask(NULL, callback);
+        return;
+    }
+    // Round robin, the same as batches of AddTasks.
+    AddTask(callback, static_cast<int>(m_next_thread++ % m_num_threads));
 }
 
 void ThreadPool::AddTask(const std::function<void ()>& callback, int dispatch_key)
@@ -124,19 +190,78 @@ void ThreadPool::AddTask(const std::function<void ()>& callback, int dispatch_ke
     AddTaskInternal(NULL, callback, dispatch_key);
 }
 
+void ThreadPool::AddTasks(const std::vector<Closure<void ()>*>& callbacks)
+{
+    AddTasksInternal(&callbacks, NULL);
+}
+
+void ThreadPool::AddTasks(const std::vector<std::function<void ()> >& callbacks)
+{
+    AddTasksInternal(NULL, &callbacks);
+}
+
+void ThreadPool::AddTasksInternal(
+    const std::vector<Closure<void ()>*>* callbacks,
+    const std::vector<std::function<void ()> >* functions)
+{
+    static const std::function<void ()> kNullFunction;
+    size_t num_tasks = callbacks ? callbacks->size() : functions->size();
+    if (num_tasks == 0)
+        return;
+    DCHECK(!m_exit || (m_policy == kWorkStealing && s_current_pool == this));
+    m_num_unfinished_tasks += num_tasks;
+
+    if (m_policy == kWorkStealing) {
+        m_num_stealable_tasks += num_tasks;
+        if (s_current_pool == this) {
+            // Lock free, other threads will steal them.
+            ThreadContext* context = &m_thread_contexts[s_current_thread_index];
+            for (size_t i = 0; i < num_tasks; ++i) {
+                context->local_tasks.Push(ThreadContext::NewTask(
+                    &context->local_free_tasks,
+                    callbacks ? (*callbacks)[i] : NULL,
+                    functions ? (*functions)[i] : kNullFunction));
+            }
+            if (m_num_sleeping_threads > 0)
+                WakeUpIdleThread();
+            return;
+        }
+    }
+
+    // Split into continuous batches, one for each thread.
+    size_t num_batches = std::min(num_tasks, m_num_threads);
+    size_t first_thread = m_next_thread.ExchangeAddWith(num_batches);
+    for (size_t batch = 0; batch < num_batches; ++batch) {
+        size_t begin = num_tasks * batch / num_batches;
+        size_t end = num_tasks * (batch + 1) / num_batches;
+        ThreadContext* context = &m_thread_contexts[(first_thread + batch) % m_num_threads];
+        MutexLocker locker(&context->mutex);
+        ThreadContext::TaskList* tasks =
+            m_policy == kWorkStealing ? &context->shared_tasks : &context->pending_tasks;
+        for (size_t i = begin; i < end; ++i) {
+            tasks->push_back(ThreadContext::NewTask(
+                &context->free_tasks,
+                callbacks ? (*callbacks)[i] : NULL,
+                functions ? (*functions)[i] : kNullFunction));
+        }
+        if (m_policy == kDispatchByKey) {
+            context->cond.Signal();
+        } else if (context->sleeping) {
+            context->sleeping = false;
+            --m_num_sleeping_threads;
+            context->cond.Signal();
+        }
+    }
+}
+
 void ThreadPool::WorkRoutine(ThreadContext* context) {
     ThreadContext::TaskList tasks;
     for (;;) {
         bool continued = context->GetPendingTask(&tasks);
         ThreadContext::TaskList::iterator i;
         for (i = tasks.begin(); i != tasks.end(); ++i) {
-            if (i->callback) {
-                i->callback->Run();
-                i->callback = NULL;
-            } else {
-                i->function();
-                i->function = NULL;
-            }
+            i->Run();
+            --m_num_unfinished_tasks;
         }
         if (!continued)
             break;
@@ -155,14 +280,185 @@ void ThreadPool::WorkRoutine(ThreadContext* context) {
         m_exit_cond.Signal();
 }
 
-bool ThreadPool::AnyTaskPending() const {
+void ThreadPool::AddStealableTask(Closure<void ()>* callback,
+                                  const std::function<void ()>& function)
+{
+    // Running tasks can still add tasks during terminating, they will be
+    // run by the adding thread before exit.
+    DCHECK(!m_exit || s_current_pool == this);
+    ++m_num_unfinished_tasks;
+    // Count before adding, so that a thief never see a negative number.
+    ++m_num_stealable_tasks;
+    if (s_current_pool == this) {
+        // Lock free fast path, added by a thread of this pool.
+        ThreadContext* context = &m_thread_contexts[s_current_thread_index];
+        Task* task = ThreadContext::NewTask(&context->local_free_tasks, callback, function);
+        context->local_tasks.Push(task);
+    } else {
+        // Added by other threads, distributed in round robin.
+        ThreadContext* context = &m_thread_contexts[m_next_thread++ % m_num_threads];
+        MutexLocker locker(&context->mutex);
+        Task* task = ThreadContext::NewTask(&context->free_tasks, callback, function);
+        context->shared_tasks.push_back(task);
+    }
+    if (m_num_sleeping_threads > 0)
+        WakeUpIdleThread();
+}
+
+// Wake up one sleeping thread to search tasks, unless there is already a
+// searching one, to avoid waking up all threads for each added task. The
+// searching thread wakes up another one after it found a task.
+void ThreadPool::WakeUpIdleThread() {
+    if (m_num_searching_threads > 0)
+        return;
+    size_t start = m_next_thread++;
     for (size_t i = 0; i < m_num_threads; ++i) {
-        MutexLocker locker(&m_thread_contexts[i].mutex);
-        if (!m_thread_contexts[i].pending_tasks.empty())
-            return true;
+        ThreadContext* context = &m_thread_contexts[(start + i) % m_num_threads];
+        MutexLocker locker(&context->mutex);
+        if (context->sleeping) {
+            context->sleeping = false;
+            --m_num_sleeping_threads;
+            context->searching = true;
+            ++m_num_searching_threads;
+            context->cond.Signal();
+            return;
+        }
     }
+}
 
-    return false;
+// Take tasks added by other threads. Tasks with dispatch key are moved to
+// affinity_tasks, others are moved to local deque so they can still be
+// stolen. Return one task to run, or NULL if none.
+ThreadPool::Task* ThreadPool::GetInboxTask(ThreadContext* context) {
+    {
+        MutexLocker locker(&context->mutex);
+        context->affinity_tasks.splice(context->pending_tasks);
+        if (!context->shared_tasks.empty()) {
+            while (!context->shared_tasks.empty()) {
+                Task* task = &context->shared_tasks.front();
+                context->shared_tasks.pop_front();
+                context->local_tasks.Push(task);
+            }
+            // Give back free tasks to the adding threads.
+            context->free_tasks.splice(context->local_free_tasks);
+        }
+    }
+    if (!context->affinity_tasks.empty()) {
+        Task* task = &context->affinity_tasks.front();
+        context->affinity_tasks.pop_front();
+        return task;
+    }
+    Task* task = context->local_tasks.Pop();
+    if (task != NULL)
+        --m_num_stealable_tasks;
+    return task;
+}
+
+ThreadPool::Task* ThreadPool::StealTask(ThreadContext* context) {
+    // Start from a random victim, so that idle threads don't contend on the
+    // same one.
+    size_t start = context->NextRandom() % m_num_threads;
+    for (size_t i = 0; i < m_num_threads; ++i) {
+        ThreadContext* victim = &m_thread_contexts[(start + i) % m_num_threads];
+        if (victim == context)
+            continue;
+        Task* task = victim->local_tasks.Steal();
+        if (task == NULL && victim->mutex.TryLock()) {
+            if (!victim->shared_tasks.empty()) {
+                task = &victim->shared_tasks.front();
+                victim->shared_tasks.pop_front();
+            }
+            victim->mutex.Unlock();
+        }
+        if (task != NULL) {
+            --m_num_stealable_tasks;
+            return task;
+        }
+    }
+    return NULL;
+}
+
+// Sleep until any task may be available, return false if should exit.
+bool ThreadPool::WaitForTask(ThreadContext* context) {
+    bool waited = false;
+    {
+        MutexLocker locker(&context->mutex);
+        context->sleeping = true;
+        // Pair with AddStealableTask, either the adding thread see this
+        // thread sleeping, or this thread see the added task.
+        ++m_num_sleeping_threads;
+        while (context->sleeping && !context->exit &&
+               context->pending_tasks.empty() && context->shared_tasks.empty() &&
+               m_num_stealable_tasks == 0) {
+            context->cond.Wait();
+            waited = true;
+        }
+        if (context->sleeping) {
+            context->sleeping = false;
+            --m_num_sleeping_threads;
+        }
+        // Remaining tasks are still run before exit.
+        if (context->exit && context->pending_tasks.empty() &&
+            context->shared_tasks.empty() && m_num_stealable_tasks == 0) {
+            return false;
+        }
+    }
+    // Stealable tasks exist but failed to steal, e.g., they are being added,
+    // give up cpu to other threads rather than busy looping.
+    if (!waited)
+        ThisThread::Yield();
+    return true;
+}
+
+void ThreadPool::WorkStealingRoutine(ThreadContext* context) {
+    s_current_pool = this;
+    s_current_thread_index = context->index;
+
+    for (;;) {
+        Task* task = NULL;
+        if (!context->affinity_tasks.empty()) {
+            task = &context->affinity_tasks.front();
+            context->affinity_tasks.pop_front();
+        } else if (++context->num_run_tasks % 64 != 0 &&
+                   (task = context->local_tasks.Pop()) != NULL) {
+            // Check inbox periodically even if the local deque is never
+            // empty, to avoid starving tasks with dispatch key.
+            --m_num_stealable_tasks;
+        } else {
+            task = GetInboxTask(context);
+            if (task == NULL)
+                task = StealTask(context);
+        }
+
+        if (context->searching) {
+            context->searching = false;
+            --m_num_searching_threads;
+            if (task != NULL && m_num_stealable_tasks > 0 && m_num_sleeping_threads > 0)
+                WakeUpIdleThread();
+        }
+
+        if (task != NULL) {
+            task->Run();
+            context->local_free_tasks.push_back(task);
+            --m_num_unfinished_tasks;
+        } else if (!WaitForTask(context)) {
+            break;
+        }
+    }
+
+    s_current_pool = NULL;
+    {
+        MutexLocker locker(&context->mutex);
+        context->free_tasks.splice(context->local_free_tasks);
+        while (!context->free_tasks.empty()) {
+            Task* task = &context->free_tasks.front();
+            context->free_tasks.pop_front();
+            delete task;
+        }
+    }
+    MutexLocker locker(&m_exit_lock);
+    if (--m_num_busy_threads == 0)
+        m_exit_cond.Signal();
 }
 
 bool ThreadPool::AnyThreadRunning() const {
@@ -197,7 +493,7 @@ void ThreadPool::Terminate() {
 
 void ThreadPool::WaitForIdle() {
     assert(!m_exit);
-    while (AnyTaskPending()) {
+    while (m_num_unfinished_tasks > 0) {
         ThisThread::Sleep(1);
     }
 }
@@ -8,9 +8,12 @@
 
 #include <stdint.h>
 
+#include <vector>
+
 #include "toft/base/closure.h"
 #include "toft/base/functional.h"
 #include "toft/base/intrusive_list.h"
+#include "toft/system/atomic/atomic.h"
 #include "toft/system/threading/event.h"
 #include "toft/system/threading/mutex.h"
 #include "toft/system/threading/thread.h"
@@ -19,8 +22,21 @@ namespace toft {
 
 class ThreadPool {
 public:
+    enum SchedulePolicy {
+        // Every task is dispatched to one thread by its dispatch key, tasks
+        // without dispatch key are dispatched by the address of the closure,
+        // or round robin for std::function.
+        kDispatchByKey,
+
+        // Every thread has its own lock free deque for tasks added by itself,
+        // and idle threads steal tasks from busy ones. Tasks with explicit
+        // dispatch key still always run in the thread chosen by the key.
+        // Good for fan out workloads where tasks add more tasks.
+        kWorkStealing,
+    };
+
     /// @param mun_threads number of threads, -1 means cpu number
-    explicit ThreadPool(int num_threads = -1);
+    explicit ThreadPool(int num_threads = -1, SchedulePolicy policy = kDispatchByKey);
     ~ThreadPool();
 
 
@@ -30,9 +46,24 @@ public:
     void AddTask(Closure<void ()>* callback, int dispatch_key);
     void AddTask(const std::function<void ()>& callback, int dispatch_key);
 
+    // Add many tasks at once, they are split into one batch per thread, and
+    // each batch takes one lock and one wakeup, much cheaper than adding
+    // them one by one. See also TaskGroup to wait for a group of tasks.
+    void AddTasks(const std::vector<Closure<void ()>*>& callbacks);
+    void AddTasks(const std::vector<std::function<void ()> >& callbacks);
+
+    // Wait until all added tasks are finished.
     void WaitForIdle();
     void Terminate();
 
+    SchedulePolicy schedule_policy() const {
+        return m_policy;
+    }
+
+    size_t num_threads() const {
+        return m_num_threads;
+    }
+
 private:
     struct Task;
     struct ThreadContext;
@@ -40,18 +71,35 @@ private:
     void AddTaskInternal(Closure<void ()>* callback,
                          const std::function<void ()>& function,
                          int dispatch_key);
+    // Only one of callbacks and functions is not NULL.
+    void AddTasksInternal(const std::vector<Closure<void ()>*>* callbacks,
+                          const std::vector<std::function<void ()> >* functions);
 
-    bool AnyTaskPending() const;
     void WorkRoutine(ThreadContext* thread);
     bool AnyThreadRunning() const;
 
+    // For kWorkStealing policy.
+    void AddStealableTask(Closure<void ()>* callback,
+                          const std::function<void ()>& function);
+    void WorkStealingRoutine(ThreadContext* context);
+    Task* GetInboxTask(ThreadContext* context);
+    Task* StealTask(ThreadContext* context);
+    bool WaitForTask(ThreadContext* context);
+    void WakeUpIdleThread();
+
 private:
     ThreadContext* m_thread_contexts;
     size_t m_num_threads;
     size_t m_num_busy_threads;
+    SchedulePolicy m_policy;
     Mutex m_exit_lock;
     ConditionVariable m_exit_cond;
     bool m_exit;
+    Atomic<size_t> m_num_unfinished_tasks;
+    Atomic<size_t> m_num_stealable_tasks;
+    Atomic<size_t> m_num_sleeping_threads;
+    Atomic<size_t> m_num_searching_threads;
+    Atomic<size_t> m_next_thread;
 };
 
 } // namespace toft
@@ -0,0 +1,109 @@
+// Copyright (C) 2026, The Toft Authors.
+//
+// Description: compare schedule policies of ThreadPool on fan out workloads.
+
+#include "toft/system/threading/thread_pool.h"
+
+#include <vector>
+
+#include "toft/base/functional.h"
+#include "toft/system/atomic/atomic.h"
+
+#include "thirdparty/benchmark/benchmark.h"
+
+namespace {
+
+const int kNumThreads = 8;
+
+// Simulate a small amount of cpu work.
+void Work(int iterations) {
+    unsigned int x = 1;
+    for (int i = 0; i < iterations; ++i)
+        x = x * 1103515245 + 12345;
+    benchmark::DoNotOptimize(x);
+}
+
+void LeafTask(toft::Atomic<int>* count, int work) {
+    Work(work);
+    ++*count;
+}
+
+// Each task adds fanout child tasks until depth reaches 0.
+void TreeTask(toft::ThreadPool* pool, toft::Atomic<int>* count,
+              int depth, int fanout, int work) {
+    Work(work);
+    ++*count;
+    if (depth == 0)
+        return;
+    for (int i = 0; i < fanout; ++i)
+        pool->AddTask(std::bind(TreeTask, pool, count, depth - 1, fanout, work));
+}
+
+}  // namespace
+
+// One producer thread adds many independent tasks. With kDispatchByKey they
+// are spread round robin, so it's the cost of a lock and a wakeup per task,
+// compared to the inboxes of kWorkStealing.
+static void FlatFanOut(benchmark::State& state, toft::ThreadPool::SchedulePolicy policy) {
+    const int num_tasks = 10000;
+    const int work = static_cast<int>(state.range(0));
+    toft::ThreadPool pool(kNumThreads, policy);
+    for (auto _ : state) {
+        toft::Atomic<int> count;
+        for (int i = 0; i < num_tasks; ++i)
+            pool.AddTask(std::bind(LeafTask, &count, work));
+        pool.WaitForIdle();
+    }
+    state.SetItemsProcessed(state.iterations() * num_tasks);
+}
+
+// Tasks recursively add child tasks, like a parallel divide and conquer.
+static void TreeFanOut(benchmark::State& state, toft::ThreadPool::SchedulePolicy policy) {
+    const int depth = 6;
+    const int fanout = 4;
+    const int work = static_cast<int>(state.range(0));
+    toft::ThreadPool pool(kNumThreads, policy);
+    int num_tasks = 0;
+    for (auto _ : state) {
+        toft::Atomic<int> count;
+        pool.AddTask(std::bind(TreeTask, &pool, &count, depth, fanout, work));
+        pool.WaitForIdle();
+        num_tasks = count;
+    }
+    state.SetItemsProcessed(state.iterations() * num_tasks);
+}
+
+// Add small tasks one by one or in a batch.
+static void AddSmallTasks(benchmark::State& state, toft::ThreadPool::SchedulePolicy policy) {
+    const int num_tasks = 100000;
+    const bool batch = state.range(0) != 0;
+    toft::ThreadPool pool(kNumThreads, policy);
+    std::vector<std::function<void ()> > tasks;
+    for (auto _ : state) {
+        toft::Atomic<int> count;
+        if (batch) {
+            tasks.assign(num_tasks, std::bind(LeafTask, &count, 10));
+            pool.AddTasks(tasks);
+        } else {
+            for (int i = 0; i < num_tasks; ++i)
+                pool.AddTask(std::bind(LeafTask, &count, 10));
+        }
+        pool.WaitForIdle();
+    }
+    state.SetItemsProcessed(state.iterations() * num_tasks);
+}
+
+BENCHMARK_CAPTURE(FlatFanOut, DispatchByKey, toft::ThreadPool::kDispatchByKey)
+    ->Arg(100)->Arg(10000)->UseRealTime();
+BENCHMARK_CAPTURE(FlatFanOut, WorkStealing, toft::ThreadPool::kWorkStealing)
+    ->Arg(100)->Arg(10000)->UseRealTime();
+BENCHMARK_CAPTURE(TreeFanOut, DispatchByKey, toft::ThreadPool::kDispatchByKey)
+    ->Arg(100)->Arg(10000)->UseRealTime();
+BENCHMARK_CAPTURE(TreeFanOut, WorkStealing, toft::ThreadPool::kWorkStealing)
+    ->Arg(100)->Arg(10000)->UseRealTime();
+
+// Arg(0) adds tasks one by one, Arg(1) adds them in a batch.
+BENCHMARK_CAPTURE(AddSmallTasks, DispatchByKey, toft::ThreadPool::kDispatchByKey)
+    ->Arg(0)->Arg(1)->UseRealTime();
+BENCHMARK_CAPTURE(AddSmallTasks, WorkStealing, toft::ThreadPool::kWorkStealing)
+    ->Arg(0)->Arg(1)->UseRealTime();
@@ -5,9 +5,14 @@
 
 #include "toft/system/threading/thread_pool.h"
 
+#include <map>
+#include <set>
+#include <vector>
+
 #include "toft/base/closure.h"
 #include "toft/base/functional.h"
 #include "toft/system/atomic/atomic.h"
+#include "toft/system/threading/event.h"
 #include "toft/system/threading/this_thread.h"
 #include "toft/system/time/clock.h"
 
@@ -124,6 +129,181 @@ TEST(ThreadPool, SlowCall)
     }
 }
 
+static void Increase(Atomic<int>* count)
+{
+    ++*count;
+}
+
+static void IncreaseAfterSleep(Atomic<int>* count)
+{
+    ThisThread::Sleep(10);
+    ++*count;
+}
+
+TEST(ThreadPool, WaitForIdle)
+{
+    ThreadPool threadpool(4);
+    Atomic<int> count;
+    for (int i = 0; i < 10; ++i)
+        threadpool.AddTask(std::bind(&IncreaseAfterSleep, &count));
+    threadpool.WaitForIdle();
+    EXPECT_EQ(10, count.Value());
+}
+
+TEST(ThreadPool, WorkStealing)
+{
+    ThreadPool threadpool(4, ThreadPool::kWorkStealing);
+    EXPECT_EQ(ThreadPool::kWorkStealing, threadpool.schedule_policy());
+    Atomic<int> count;
+    for (int i = 0; i < 10000; ++i)
+        threadpool.AddTask(std::bind(&Increase, &count));
+    Foo foo;
+    for (int i = 0; i < 100; ++i)
+        threadpool.AddTask(NewClosure(&foo, &Foo::test1));
+    threadpool.WaitForIdle();
+    EXPECT_EQ(10000, count.Value());
+}
+
+static void FanOut(ThreadPool* threadpool, Atomic<int>* count, int depth)
+{
+    ++*count;
+    if (depth == 0)
+        return;
+    for (int i = 0; i < 4; ++i)
+        threadpool->AddTask(std::bind(&FanOut, threadpool, count, depth - 1));
+}
+
+TEST(ThreadPool, WorkStealingFanOut)
+{
+    ThreadPool threadpool(4, ThreadPool::kWorkStealing);
+    Atomic<int> count;
+    threadpool.AddTask(std::bind(&FanOut, &threadpool, &count, 6));
+    threadpool.WaitForIdle();
+    // 1 + 4 + 4^2 + ... + 4^6
+    EXPECT_EQ(5461, count.Value());
+}
+
+// Tasks added by a task which is blocked until all of them are running, so
+// they must be stolen by as many other threads.
+struct StealState {
+    static const int kNumTasks = 4;
+    Mutex mutex;
+    std::set<int> thread_ids;  // Of the stolen tasks
+    int owner_id;
+    ManualResetEvent all_running;
+    bool all_run;
+};
+
+static void StolenTask(StealState* state)
+{
+    bool all_running;
+    {
+        MutexLocker locker(&state->mutex);
+        state->thread_ids.insert(ThisThread::GetId());
+        all_running = state->thread_ids.size() == static_cast<size_t>(StealState::kNumTasks);
+    }
+    if (all_running)
+        state->all_running.Set();
+    // The timeout only avoids hanging forever if it's broken.
+    state->all_running.TimedWait(10000);
+}
+
+static void BlockingFanOut(ThreadPool* threadpool, StealState* state)
+{
+    state->owner_id = ThisThread::GetId();
+    for (int i = 0; i < StealState::kNumTasks; ++i)
+        threadpool->AddTask(std::bind(&StolenTask, state));
+    state->all_run = state->all_running.TimedWait(10000);
+}
+
+TEST(ThreadPool, WorkStealingSteal)
+{
+    ThreadPool threadpool(8, ThreadPool::kWorkStealing);
+    StealState state;
+    threadpool.AddTask(std::bind(&BlockingFanOut, &threadpool, &state));
+    threadpool.WaitForIdle();
+    EXPECT_TRUE(state.all_run);
+    EXPECT_EQ(static_cast<size_t>(StealState::kNumTasks), state.thread_ids.size());
+    EXPECT_EQ(0U, state.thread_ids.count(state.owner_id));
+}
+
+static void RecordThreadId(Mutex* mutex, std::map<int, std::set<int> >* thread_ids, int key)
+{
+    MutexLocker locker(mutex);
+    (*thread_ids)[key].insert(ThisThread::GetId());
+}
+
+TEST(ThreadPool, WorkStealingDispatchKey)
+{
+    ThreadPool threadpool(4, ThreadPool::kWorkStealing);
+    Mutex mutex;
+    std::map<int, std::set<int> > thread_ids;
+    Atomic<int> count;
+    for (int i = 0; i < 1000; ++i) {
+        int key = i % 4;
+        threadpool.AddTask(std::bind(&RecordThreadId, &mutex, &thread_ids, key), key);
+        // Keep other threads busy with stealable tasks.
+        threadpool.AddTask(std::bind(&Increase, &count));
+    }
+    threadpool.WaitForIdle();
+    ASSERT_EQ(4U, thread_ids.size());
+    std::set<int> all_ids;
+    for (int key = 0; key < 4; ++key) {
+        ASSERT_EQ(1U, thread_ids[key].size());
+        all_ids.insert(*thread_ids[key].begin());
+    }
+    EXPECT_EQ(4U, all_ids.size());
+    EXPECT_EQ(1000, count.Value());
+}
+
+TEST(ThreadPool, WorkStealingTerminate)
+{
+    Atomic<int> count;
+    {
+        ThreadPool threadpool(4, ThreadPool::kWorkStealing);
+        for (int i = 0; i < 10000; ++i)
+            threadpool.AddTask(std::bind(&Increase, &count));
+        threadpool.AddTask(std::bind(&FanOut, &threadpool, &count, 3));
+        threadpool.Terminate();
+        threadpool.Terminate();
+    }
+    // All tasks added before or during terminating are run.
+    EXPECT_EQ(10000 + 85, count.Value());
+}
+
+TEST(ThreadPool, AddTasks)
+{
+    ThreadPool threadpool(4);
+    Atomic<int> count;
+    std::vector<std::function<void ()> > functions(1000, std::bind(&Increase, &count));
+    threadpool.AddTasks(functions);
+    std::vector<Closure<void ()>*> closures;
+    for (int i = 0; i < 10; ++i)
+        closures.push_back(NewClosure(&Increase, &count));
+    threadpool.AddTasks(closures);
+    threadpool.AddTasks(std::vector<Closure<void ()>*>());
+    threadpool.WaitForIdle();
+    EXPECT_EQ(1010, count.Value());
+}
+
+static void AddTasksInTask(ThreadPool* threadpool, Atomic<int>* count)
+{
+    std::vector<std::function<void ()> > functions(100, std::bind(&Increase, count));
+    threadpool->AddTasks(functions);
+}
+
+TEST(ThreadPool, WorkStealingAddTasks)
+{
+    ThreadPool threadpool(4, ThreadPool::kWorkStealing);
+    Atomic<int> count;
+    std::vector<std::function<void ()> > functions(1000, std::bind(&Increase, &count));
+    threadpool.AddTasks(functions);
+    for (int i = 0; i < 10; ++i)
+        threadpool.AddTask(std::bind(&AddTasksInTask, &threadpool, &count));
+    threadpool.WaitForIdle();
+    EXPECT_EQ(2000, count.Value());
+}
+
 const int kLoopCount = 500000;
 
 class ThreadPoolTest : public testing::TestWithParam<int> {};
@@ -138,6 +318,14 @@ TEST_P(ThreadPoolTest, Performance)
     // threadpool.WaitForIdle();
 }
 
+TEST_P(ThreadPoolTest, WorkStealingPerformance)
+{
+    int num_threads = GetParam();
+    ThreadPool threadpool(num_threads, ThreadPool::kWorkStealing);
+    for (int i = 0; i < kLoopCount; ++i)
+        threadpool.AddTask(DoNothong);
+}
+
 INSTANTIATE_TEST_CASE_P(ThreadPoolTest, ThreadPoolTest, testing::Values(1, 2, 4, 8, 16, 32));
 
 static void LatencyProc(void* p, int64_t issue_time)
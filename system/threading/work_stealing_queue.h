@@ -0,0 +1,174 @@
+// Copyright (C) 2026, The Toft Authors.
+//
+// Description: lock free work stealing deque of pointers.
+
+#ifndef TOFT_SYSTEM_THREADING_WORK_STEALING_QUEUE_H
+#define TOFT_SYSTEM_THREADING_WORK_STEALING_QUEUE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "toft/base/uncopyable.h"
+#include "toft/system/atomic/atomic.h"
+#include "toft/system/memory/barrier.h"
+
+#include "thirdparty/glog/logging.h"
+
+namespace toft {
+
+// The Chase-Lev work stealing deque.
+//
+// Only the owner thread can Push and Pop items at the bottom end, while any
+// other thread can Steal items from the top end. Push and Pop are wait free
+// except when the buffer grows, Steal is lock free.
+//
+// The buffer grows by doubling and old buffers are kept until destruction,
+// since a concurrent thief may still be reading them.
+template <typename T>
+class WorkStealingQueue {
+    TOFT_DECLARE_UNCOPYABLE(WorkStealingQueue);
+
+public:
+    explicit WorkStealingQueue(size_t initial_capacity = 256);
+    ~WorkStealingQueue();
+
+    // Owner only.
+    void Push(T* item);
+
+    // Owner only, return the last pushed item, or NULL if empty.
+    T* Pop();
+
+    // Any thread, return the first pushed item, or NULL if empty or lost
+    // the race with another thief or the owner.
+    T* Steal();
+
+    // Only a snapshot under concurrent operations.
+    size_t Size() const {
+        int64_t size = Load(&m_bottom) - Load(&m_top);
+        return size > 0 ? static_cast<size_t>(size) : 0;
+    }
+
+    bool IsEmpty() const {
+        return Size() == 0;
+    }
+
+private:
+    struct Buffer {
+        explicit Buffer(size_t capacity) : mask(capacity - 1), items(capacity) {}
+        T* Get(int64_t index) const {
+            return items[static_cast<size_t>(index) & mask];
+        }
+        void Set(int64_t index, T* item) {
+            items[static_cast<size_t>(index) & mask] = item;
+        }
+        size_t mask;
+        std::vector<T*> items;
+    };
+
+    static int64_t Load(const int64_t* p) {
+        return *static_cast<const volatile int64_t*>(p);
+    }
+    static void Store(int64_t* p, int64_t value) {
+        *static_cast<volatile int64_t*>(p) = value;
+    }
+    Buffer* LoadBuffer() const {
+        return *static_cast<Buffer* const volatile*>(&m_buffer);
+    }
+
+    Buffer* Grow(Buffer* buffer, int64_t top, int64_t bottom);
+
+private:
+    // Thieves contend on m_top while the owner updates m_bottom, keep them
+    // in different cache lines.
+    int64_t m_top __attribute__((aligned(64)));
+    int64_t m_bottom __attribute__((aligned(64)));
+    Buffer* m_buffer;
+    std::vector<Buffer*> m_retired_buffers;  // Owner only
+};
+
+template <typename T>
+WorkStealingQueue<T>::WorkStealingQueue(size_t initial_capacity)
+    : m_top(0), m_bottom(0), m_buffer(NULL) {
+    size_t capacity = 1;
+    while (capacity < initial_capacity)
+        capacity <<= 1;
+    m_buffer = new Buffer(capacity);
+}
+
+template <typename T>
+WorkStealingQueue<T>::~WorkStealingQueue() {
+    delete m_buffer;
+    for (size_t i = 0; i < m_retired_buffers.size(); ++i)
+        delete m_retired_buffers[i];
+}
+
+template <typename T>
+void WorkStealingQueue<T>::Push(T* item) {
+    int64_t bottom = Load(&m_bottom);
+    int64_t top = Load(&m_top);
+    Buffer* buffer = LoadBuffer();
+    if (bottom - top > static_cast<int64_t>(buffer->mask))
+        buffer = Grow(buffer, top, bottom);
+    buffer->Set(bottom, item);
+    // The item must be visible before the new bottom. x86 doesn't reorder
+    // stores, so only the compiler need to be stopped.
+    CompilerBarrier();
+    Store(&m_bottom, bottom + 1);
+}
+
+template <typename T>
+T* WorkStealingQueue<T>::Pop() {
+    int64_t bottom = Load(&m_bottom) - 1;
+    Buffer* buffer = LoadBuffer();
+    Store(&m_bottom, bottom);
+    // Publish the new bottom before reading top, or the owner and a thief
+    // may take the same last item.
+    MemoryBarrier();
+    int64_t top = Load(&m_top);
+    if (top > bottom) {
+        // Empty.
+        Store(&m_bottom, bottom + 1);
+        return NULL;
+    }
+    T* item = buffer->Get(bottom);
+    if (top == bottom) {
+        // The last item, race with thieves.
+        if (!AtomicCompareExchange(&m_top, top, top + 1))
+            item = NULL;
+        Store(&m_bottom, bottom + 1);
+    }
+    return item;
+}
+
+template <typename T>
+T* WorkStealingQueue<T>::Steal() {
+    int64_t top = Load(&m_top);
+    // x86 doesn't reorder loads, so only the compiler need to be stopped.
+    CompilerBarrier();
+    int64_t bottom = Load(&m_bottom);
+    if (top >= bottom)
+        return NULL;
+    Buffer* buffer = LoadBuffer();
+    T* item = buffer->Get(top);
+    if (!AtomicCompareExchange(&m_top, top, top + 1))
+        return NULL;
+    return item;
+}
+
+template <typename T>
+typename WorkStealingQueue<T>::Buffer* WorkStealingQueue<T>::Grow(
+        Buffer* buffer, int64_t top, int64_t bottom) {
+    Buffer* new_buffer = new Buffer(buffer->items.size() * 2);
+    for (int64_t i = top; i < bottom; ++i)
+        new_buffer->Set(i, buffer->Get(i));
+    m_retired_buffers.push_back(buffer);
+    CompilerBarrier();
+    *static_cast<Buffer* volatile*>(&m_buffer) = new_buffer;
+    return new_buffer;
+}
+
+} // namespace toft
+
+#endif // TOFT_SYSTEM_THREADING_WORK_STEALING_QUEUE_H
@@ -0,0 +1,93 @@
+// Copyright (C) 2026, The Toft Authors.
+//
+// Description: tests of WorkStealingQueue.
+
+#include "toft/system/threading/work_stealing_queue.h"
+
+#include <vector>
+
+#include "toft/base/functional.h"
+#include "toft/system/atomic/atomic.h"
+#include "toft/system/threading/thread_group.h"
+
+#include "thirdparty/gtest/gtest.h"
+
+namespace toft {
+
+TEST(WorkStealingQueue, PushPop)
+{
+    WorkStealingQueue<int> queue(2);
+    EXPECT_TRUE(queue.IsEmpty());
+    EXPECT_TRUE(queue.Pop() == NULL);
+    EXPECT_TRUE(queue.Steal() == NULL);
+
+    std::vector<int> items(100);
+    for (size_t i = 0; i < items.size(); ++i)
+        queue.Push(&items[i]);  // Grow several times
+    EXPECT_EQ(100U, queue.Size());
+
+    // Pop from bottom, steal from top.
+    EXPECT_EQ(&items[99], queue.Pop());
+    EXPECT_EQ(&items[0], queue.Steal());
+    EXPECT_EQ(&items[98], queue.Pop());
+    EXPECT_EQ(&items[1], queue.Steal());
+    EXPECT_EQ(96U, queue.Size());
+
+    for (size_t i = 2; i < 98; ++i)
+        EXPECT_EQ(&items[i], queue.Steal());
+    EXPECT_TRUE(queue.IsEmpty());
+    EXPECT_TRUE(queue.Pop() == NULL);
+}
+
+const int kNumItems = 1000000;
+
+static void Thief(WorkStealingQueue<int>* queue, Atomic<bool>* done, std::vector<int>* taken)
+{
+    for (;;) {
+        int* item = queue->Steal();
+        if (item != NULL) {
+            ++(*taken)[*item];
+        } else if (*done && queue->IsEmpty()) {
+            break;
+        }
+    }
+}
+
+TEST(WorkStealingQueue, ConcurrentSteal)
+{
+    WorkStealingQueue<int> queue;
+    std::vector<int> items(kNumItems);
+    for (int i = 0; i < kNumItems; ++i)
+        items[i] = i;
+
+    const int kNumThieves = 4;
+    std::vector<std::vector<int> > taken(kNumThieves + 1, std::vector<int>(kNumItems));
+    Atomic<bool> done(false);
+    ThreadGroup thieves;
+    for (int i = 0; i < kNumThieves; ++i)
+        thieves.Add(std::bind(Thief, &queue, &done, &taken[i]));
+
+    std::vector<int>& owner_taken = taken[kNumThieves];
+    for (int i = 0; i < kNumItems; ++i) {
+        queue.Push(&items[i]);
+        if (i % 3 == 0) {
+            int* item = queue.Pop();
+            if (item != NULL)
+                ++owner_taken[*item];
+        }
+    }
+    while (int* item = queue.Pop())
+        ++owner_taken[*item];
+    done = true;
+    thieves.Join();
+
+    // Every item is taken exactly once.
+    for (int i = 0; i < kNumItems; ++i) {
+        int count = 0;
+        for (size_t j = 0; j < taken.size(); ++j)
+            count += taken[j][i];
+        ASSERT_EQ(1, count) << i;
+    }
+}
+
+} // namespace toft
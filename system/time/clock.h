@@ -25,6 +25,7 @@ public:
 };
 
 extern Clock& RealtimeClock;
+extern Clock& MonotonicClock;
 
 } // namespace toft
 